@@ -39,6 +39,9 @@
 // Click Relay
 #define RELAY AVNET_MT3620_SK_GPIO0
 
+// LSM6DSO INT1, wired to the click socket INT pin
+#define LSM6DSO_INT1 AVNET_MT3620_SK_GPIO2
+
 // UART 0
 #define UART0 AVNET_MT3620_SK_ISU0_UART
 
@@ -0,0 +1,209 @@
+#ifndef INTERCORE_CODEC_H
+#define INTERCORE_CODEC_H
+
+// Compact encoding of IC_MSG_SAMPLE_FRAME_PACKED payloads, shared by both apps.
+//
+// Consecutive LSM6DSO readings differ by a few LSB, so each field of a sample is sent as the
+// zigzag encoded difference from the previous sample, packed with the fewest bits that hold
+// every difference of that field in the frame:
+//
+//   IC_SAMPLE_FRAME_HEADER       count, periodMs
+//   IC_SAMPLE                    first sample, as is
+//   uint8_t[IC_CODEC_CHANNELS]   bits per difference for each field, 0 if the field is constant
+//   bit stream                   field by field, count - 1 differences each, LSB first
+//
+// Timestamps are sent as the difference from periodMs, so a steady stream costs no bits.
+
+#include "intercore_msg.h"
+
+#define IC_CODEC_CHANNELS 9		// timestamp, acceleration[3], angularRate[3], temperature, flags
+
+/// <summary>Largest encoded frame, used to size encode buffers.</summary>
+#define IC_CODEC_MAX_SIZE (sizeof(IC_SAMPLE_FRAME_HEADER) + sizeof(IC_SAMPLE) + IC_CODEC_CHANNELS + \
+	((IC_SAMPLE_FRAME_MAX_SAMPLES - 1) * IC_CODEC_CHANNELS * 32 + 7) / 8)
+
+static inline uint32_t ic_codec_get(const IC_SAMPLE* sample, int channel)
+{
+	switch (channel) {
+	case 0:
+		return sample->timestamp;
+	case 1: case 2: case 3:
+		return (uint32_t)(int32_t)sample->acceleration[channel - 1];
+	case 4: case 5: case 6:
+		return (uint32_t)(int32_t)sample->angularRate[channel - 4];
+	case 7:
+		return (uint32_t)(int32_t)sample->temperature;
+	default:
+		return sample->flags;
+	}
+}
+
+static inline void ic_codec_set(IC_SAMPLE* sample, int channel, uint32_t value)
+{
+	switch (channel) {
+	case 0:
+		sample->timestamp = value;
+		break;
+	case 1: case 2: case 3:
+		sample->acceleration[channel - 1] = (int16_t)value;
+		break;
+	case 4: case 5: case 6:
+		sample->angularRate[channel - 4] = (int16_t)value;
+		break;
+	case 7:
+		sample->temperature = (int16_t)value;
+		break;
+	default:
+		sample->flags = (uint16_t)value;
+		break;
+	}
+}
+
+static inline uint32_t ic_codec_zigzag(uint32_t delta)
+{
+	return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+}
+
+static inline uint32_t ic_codec_unzigzag(uint32_t value)
+{
+	return (value >> 1) ^ (0U - (value & 1));
+}
+
+static inline uint32_t ic_codec_bits(uint32_t value)
+{
+	return value == 0 ? 0 : 32 - (uint32_t)__builtin_clz(value);
+}
+
+/// <summary>
+/// Encodes count samples into dest.
+/// </summary>
+/// <returns>Number of bytes written, or 0 if the encoding would not fit in destSize, in
+/// which case the frame should be sent unpacked.</returns>
+static inline uint32_t ic_codec_encode_frame(uint8_t* dest, uint32_t destSize, uint16_t periodMs,
+	const IC_SAMPLE* samples, uint16_t count)
+{
+	IC_SAMPLE_FRAME_HEADER header = { .count = count, .periodMs = periodMs };
+	uint8_t widths[IC_CODEC_CHANNELS];
+	uint32_t totalBits = 0;
+	uint32_t size;
+
+	if (count == 0 || count > IC_SAMPLE_FRAME_MAX_SAMPLES) {
+		return 0;
+	}
+
+	for (int c = 0; c < IC_CODEC_CHANNELS; c++) {
+		uint32_t bias = c == 0 ? periodMs : 0;
+		uint32_t all = 0;
+
+		for (uint16_t i = 1; i < count; i++) {
+			all |= ic_codec_zigzag(ic_codec_get(&samples[i], c) - ic_codec_get(&samples[i - 1], c) - bias);
+		}
+		widths[c] = (uint8_t)ic_codec_bits(all);
+		totalBits += widths[c] * (uint32_t)(count - 1);
+	}
+
+	size = sizeof(header) + sizeof(IC_SAMPLE) + sizeof(widths) + (totalBits + 7) / 8;
+	if (size > destSize) {
+		return 0;
+	}
+
+	memcpy(dest, &header, sizeof(header));
+	dest += sizeof(header);
+	memcpy(dest, &samples[0], sizeof(IC_SAMPLE));
+	dest += sizeof(IC_SAMPLE);
+	memcpy(dest, widths, sizeof(widths));
+	dest += sizeof(widths);
+
+	uint64_t acc = 0;
+	uint32_t accBits = 0;
+
+	for (int c = 0; c < IC_CODEC_CHANNELS; c++) {
+		uint32_t bias = c == 0 ? periodMs : 0;
+
+		if (widths[c] == 0) {
+			continue;
+		}
+
+		for (uint16_t i = 1; i < count; i++) {
+			acc |= (uint64_t)ic_codec_zigzag(ic_codec_get(&samples[i], c) - ic_codec_get(&samples[i - 1], c) - bias) << accBits;
+			accBits += widths[c];
+
+			while (accBits >= 8) {
+				*dest++ = (uint8_t)acc;
+				acc >>= 8;
+				accBits -= 8;
+			}
+		}
+	}
+
+	if (accBits > 0) {
+		*dest = (uint8_t)acc;
+	}
+
+	return size;
+}
+
+/// <summary>
+/// Decodes an encoded frame into samples, which must hold maxSamples.
+/// </summary>
+/// <returns>true if src holds exactly one well formed frame of at most maxSamples.</returns>
+static inline bool ic_codec_decode_frame(const uint8_t* src, uint32_t srcSize, IC_SAMPLE_FRAME_HEADER* header,
+	IC_SAMPLE* samples, uint16_t maxSamples)
+{
+	uint8_t widths[IC_CODEC_CHANNELS];
+	uint32_t totalBits = 0;
+
+	if (srcSize < sizeof(*header) + sizeof(IC_SAMPLE) + sizeof(widths)) {
+		return false;
+	}
+
+	memcpy(header, src, sizeof(*header));
+	src += sizeof(*header);
+	memcpy(&samples[0], src, sizeof(IC_SAMPLE));
+	src += sizeof(IC_SAMPLE);
+	memcpy(widths, src, sizeof(widths));
+	src += sizeof(widths);
+
+	if (header->count == 0 || header->count > maxSamples) {
+		return false;
+	}
+
+	for (int c = 0; c < IC_CODEC_CHANNELS; c++) {
+		if (widths[c] > 32) {
+			return false;
+		}
+		totalBits += widths[c] * (uint32_t)(header->count - 1);
+	}
+
+	if (srcSize != sizeof(*header) + sizeof(IC_SAMPLE) + sizeof(widths) + (totalBits + 7) / 8) {
+		return false;
+	}
+
+	uint64_t acc = 0;
+	uint32_t accBits = 0;
+
+	for (int c = 0; c < IC_CODEC_CHANNELS; c++) {
+		uint32_t bias = c == 0 ? header->periodMs : 0;
+		uint32_t mask = widths[c] == 32 ? 0xFFFFFFFFU : (1U << widths[c]) - 1;
+
+		for (uint16_t i = 1; i < header->count; i++) {
+			uint32_t zigzag = 0;
+
+			if (widths[c] > 0) {
+				while (accBits < widths[c]) {
+					acc |= (uint64_t)*src++ << accBits;
+					accBits += 8;
+				}
+				zigzag = (uint32_t)acc & mask;
+				acc >>= widths[c];
+				accBits -= widths[c];
+			}
+
+			ic_codec_set(&samples[i], c, ic_codec_get(&samples[i - 1], c) + bias + ic_codec_unzigzag(zigzag));
+		}
+	}
+
+	return true;
+}
+
+#endif // INTERCORE_CODEC_H
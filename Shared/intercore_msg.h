@@ -0,0 +1,207 @@
+#ifndef INTERCORE_MSG_H
+#define INTERCORE_MSG_H
+
+// Message schema shared by the real-time (Azure RTOS) and high-level apps.
+//
+// Every message starts with an IC_MSG_HEADER followed by header.length payload bytes.
+// On the real-time side the Azure Sphere runtime adds a 20 byte component ID header in
+// front of each block; the high-level socket only ever sees the messages themselves.
+// Both cores are little-endian Cortex-A7/M4, so the layouts below are used as is.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/// <summary>Bumped whenever a header or payload layout changes incompatibly.</summary>
+#define IC_MSG_VERSION 2
+
+/// <summary>Largest message, header included, carried by the inter-core socket.</summary>
+#define IC_MSG_MAX_SIZE 1024
+
+/// <summary>
+/// Message types. A request from the high-level app is answered with a message of the
+/// same type and sequence number. IC_MSG_SAMPLE_FRAME is pushed unrequested while a
+/// subscription is active; its sequence number counts frames, so gaps show lost frames.
+/// </summary>
+typedef enum {
+	IC_MSG_UNKNOWN = 0,
+	IC_MSG_GET_TEMPERATURE = 1,		// request: no payload, reply: IC_TEMPERATURE_PAYLOAD
+	IC_MSG_SUBSCRIBE = 2,			// request and reply: IC_SUBSCRIBE_PAYLOAD
+	IC_MSG_SAMPLE_FRAME = 3,		// pushed: IC_SAMPLE_FRAME_HEADER followed by count IC_SAMPLEs
+	IC_MSG_SAMPLE_FRAME_PACKED = 4,	// pushed: samples encoded as described in intercore_codec.h
+	IC_MSG_GET_STATS = 5,			// request: no payload, reply: IC_STATS_PAYLOAD
+	IC_MSG_SET_SAMPLER = 6,			// request and reply: IC_SAMPLER_PAYLOAD
+} IC_MSG_TYPE;
+
+/// <summary>Fixed header in front of every message.</summary>
+typedef struct {
+	uint8_t type;			// IC_MSG_TYPE
+	uint8_t version;		// IC_MSG_VERSION
+	uint16_t length;		// payload bytes following the header
+	uint32_t sequence;		// chosen by the requester, echoed in the reply
+} IC_MSG_HEADER;
+
+_Static_assert(sizeof(IC_MSG_HEADER) == 8, "IC_MSG_HEADER must not contain padding");
+
+#define IC_MSG_MAX_PAYLOAD (IC_MSG_MAX_SIZE - sizeof(IC_MSG_HEADER))
+
+/// <summary>Payload of an IC_MSG_GET_TEMPERATURE reply.</summary>
+typedef struct {
+	float temperature;		// degrees Celsius
+} IC_TEMPERATURE_PAYLOAD;
+
+/// <summary>
+/// Payload of an IC_MSG_GET_STATS reply: the real-time app's view of the shared buffers since
+/// it started. Message and byte counts cover what the app sent and received itself.
+/// </summary>
+typedef struct {
+	uint32_t bufferSize;		// bytes in each direction
+	uint32_t messagesOut;
+	uint32_t bytesOut;
+	uint32_t messagesIn;
+	uint32_t bytesIn;
+	uint32_t outboundHighWater;	// most bytes in use towards the high-level app
+	uint32_t inboundHighWater;	// most bytes waiting to be read by the real-time app
+	uint32_t outboundFull;		// sends which found the buffer full
+	uint32_t invalidPosition;	// out of range positions or block sizes seen
+	uint32_t maxLatencyMs;		// longest time a message waited to be read, 0 if not measured
+	uint32_t senderWaits;		// times a sender blocked until space was freed
+	uint32_t sendsDropped;		// messages abandoned because space was not freed in time
+} IC_STATS_PAYLOAD;
+
+/// <summary>Most samples carried by one IC_MSG_SAMPLE_FRAME.</summary>
+#define IC_SAMPLE_FRAME_MAX_SAMPLES 24
+
+// IC_SUBSCRIBE_PAYLOAD.options
+#define IC_SUBSCRIBE_PACKED		0x1		// send IC_MSG_SAMPLE_FRAME_PACKED whenever it is smaller
+
+/// <summary>
+/// Payload of IC_MSG_SUBSCRIBE. The request asks for a sample every periodMs, delivered
+/// samplesPerFrame at a time; a periodMs of 0 stops the stream. The reply carries the
+/// values the real-time app actually uses, after rounding to its sampling and frame limits.
+/// </summary>
+typedef struct {
+	uint16_t periodMs;
+	uint16_t samplesPerFrame;	// 1 to IC_SAMPLE_FRAME_MAX_SAMPLES
+	uint16_t options;			// IC_SUBSCRIBE_*
+} IC_SUBSCRIBE_PAYLOAD;
+
+/// <summary>
+/// Payload of IC_MSG_SET_SAMPLER. The real-time app samples the sensor every periodMs in the
+/// background and answers IC_MSG_GET_TEMPERATURE from the latest sample; a periodMs of 0 stops
+/// the sampler and requests read the sensor themselves. The reply carries the period used.
+/// </summary>
+typedef struct {
+	uint16_t periodMs;
+	uint16_t reserved;
+} IC_SAMPLER_PAYLOAD;
+
+// IC_SAMPLE.flags: which readings were new in this sample, the others repeat the last value.
+#define IC_SAMPLE_NEW_ACCELERATION	0x1
+#define IC_SAMPLE_NEW_ANGULAR_RATE	0x2
+#define IC_SAMPLE_NEW_TEMPERATURE	0x4
+// The sensor FIFO overran before this sample: readings were lost and the timestamps restart.
+#define IC_SAMPLE_FIFO_OVERRUN		0x8
+
+/// <summary>
+/// One raw LSM6DSO reading, accelerometer at +/-4 g and gyroscope at +/-2000 dps full scale.
+/// </summary>
+typedef struct {
+	uint32_t timestamp;			// milliseconds since the real-time app started
+	int16_t acceleration[3];	// LSB, see ic_sample_to_mg
+	int16_t angularRate[3];		// LSB, see ic_sample_to_dps
+	int16_t temperature;		// LSB, see ic_sample_to_celsius
+	uint16_t flags;				// IC_SAMPLE_NEW_*, IC_SAMPLE_FIFO_OVERRUN
+} IC_SAMPLE;
+
+_Static_assert(sizeof(IC_SAMPLE) == 20, "IC_SAMPLE must not contain padding");
+
+/// <summary>Start of an IC_MSG_SAMPLE_FRAME payload, followed by count samples.</summary>
+typedef struct {
+	uint16_t count;
+	uint16_t periodMs;			// sample period the frame was taken at
+} IC_SAMPLE_FRAME_HEADER;
+
+_Static_assert(sizeof(IC_SAMPLE_FRAME_HEADER) + IC_SAMPLE_FRAME_MAX_SAMPLES * sizeof(IC_SAMPLE) <= IC_MSG_MAX_PAYLOAD,
+	"IC_SAMPLE_FRAME_MAX_SAMPLES must fit in one message");
+
+static inline float ic_sample_to_mg(int16_t lsb)
+{
+	return (float)lsb * 0.122f;
+}
+
+static inline float ic_sample_to_dps(int16_t lsb)
+{
+	return (float)lsb * 0.070f;
+}
+
+static inline float ic_sample_to_celsius(int16_t lsb)
+{
+	return ((float)lsb / 256.0f) + 25.0f;
+}
+
+
+/// <summary>
+/// Writes only a header to dest, for producers which write the payload in place behind it.
+/// dest must have room for sizeof(IC_MSG_HEADER) bytes.
+/// </summary>
+static inline void ic_msg_encode_header(void* dest, uint8_t type, uint32_t sequence, uint16_t length)
+{
+	IC_MSG_HEADER header = { .type = type, .version = IC_MSG_VERSION, .length = length, .sequence = sequence };
+	memcpy(dest, &header, sizeof(header));
+}
+
+/// <summary>
+/// Writes a header and payload to dest.
+/// </summary>
+/// <returns>Number of bytes written, or 0 if the message does not fit in destSize.</returns>
+static inline uint32_t ic_msg_encode(void* dest, uint32_t destSize, uint8_t type, uint32_t sequence, const void* payload, uint16_t length)
+{
+	if (destSize < sizeof(IC_MSG_HEADER) + (uint32_t)length) {
+		return 0;
+	}
+
+	ic_msg_encode_header(dest, type, sequence, length);
+	if (length > 0) {
+		memcpy((uint8_t*)dest + sizeof(IC_MSG_HEADER), payload, length);
+	}
+	return sizeof(IC_MSG_HEADER) + length;
+}
+
+/// <summary>
+/// Reads the header of the message at the start of src, leaving the payload in place.
+/// </summary>
+/// <param name="payload">On success, points at the payload inside src.</param>
+/// <returns>Number of bytes the message occupies in src, so several messages can be
+/// decoded back to back, or 0 if src does not start with a complete message of this
+/// version.</returns>
+static inline uint32_t ic_msg_decode(const void* src, uint32_t srcSize, IC_MSG_HEADER* header, const uint8_t** payload)
+{
+	if (srcSize < sizeof(*header)) {
+		return 0;
+	}
+
+	memcpy(header, src, sizeof(*header));
+	if (header->version != IC_MSG_VERSION || srcSize - sizeof(*header) < header->length) {
+		return 0;
+	}
+
+	*payload = (const uint8_t*)src + sizeof(*header);
+	return sizeof(*header) + header->length;
+}
+
+/// <summary>
+/// Copies a fixed-size payload out of a decoded message.
+/// </summary>
+/// <returns>true if the payload is exactly size bytes long.</returns>
+static inline bool ic_msg_payload(const IC_MSG_HEADER* header, const uint8_t* payload, void* dest, uint16_t size)
+{
+	if (header->length != size) {
+		return false;
+	}
+
+	memcpy(dest, payload, size);
+	return true;
+}
+
+#endif // INTERCORE_MSG_H
@@ -0,0 +1,117 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// Lock-free ring of fixed-size records between one producer and one consumer, either of which
+// may be an interrupt handler. Neither side disables interrupts or takes an RTOS object: head
+// is written by the producer only and tail by the consumer only, and a barrier orders each
+// record copy against the index update that publishes or frees it.
+//
+// head and tail count records since start up and wrap at 2^32, so the ring holds up to
+// capacity records without a spare slot. capacity must be a power of two.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+// Cortex-M: aligned word loads and stores are single-copy atomic, a DMB orders them against
+// the record copies. One core, so no exclusive accesses are needed.
+typedef volatile uint32_t SPSC_INDEX;
+
+static inline uint32_t spsc_load_acquire(SPSC_INDEX* index)
+{
+	uint32_t value = *index;
+	__asm volatile ("dmb" ::: "memory");
+	return value;
+}
+
+static inline void spsc_store_release(SPSC_INDEX* index, uint32_t value)
+{
+	__asm volatile ("dmb" ::: "memory");
+	*index = value;
+}
+
+#else
+
+// Host and high-level builds: C11 atomics.
+#include <stdatomic.h>
+
+typedef _Atomic uint32_t SPSC_INDEX;
+
+static inline uint32_t spsc_load_acquire(SPSC_INDEX* index)
+{
+	return atomic_load_explicit(index, memory_order_acquire);
+}
+
+static inline void spsc_store_release(SPSC_INDEX* index, uint32_t value)
+{
+	atomic_store_explicit(index, value, memory_order_release);
+}
+
+#endif
+
+typedef struct {
+	uint8_t* records;
+	uint32_t recordSize;
+	uint32_t mask;		// capacity - 1
+	SPSC_INDEX head;	// records pushed, written by the producer only
+	SPSC_INDEX tail;	// records popped, written by the consumer only
+} SPSC_RING;
+
+/// <summary>
+/// Set up an empty ring over storage for capacity records of recordSize bytes.
+/// Returns false if capacity is not a power of two. Call before either side runs.
+/// </summary>
+static inline bool spsc_ring_init(SPSC_RING* ring, void* storage, uint32_t recordSize, uint32_t capacity)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		return false;
+	}
+
+	ring->records = storage;
+	ring->recordSize = recordSize;
+	ring->mask = capacity - 1;
+	spsc_store_release(&ring->head, 0);
+	spsc_store_release(&ring->tail, 0);
+	return true;
+}
+
+/// <summary>Copy a record in. Producer only, returns false if the ring is full.</summary>
+static inline bool spsc_ring_push(SPSC_RING* ring, const void* record)
+{
+	uint32_t head = ring->head;		// only this side writes it
+	uint32_t tail = spsc_load_acquire(&ring->tail);
+
+	if (head - tail > ring->mask) {
+		return false;
+	}
+
+	memcpy(&ring->records[(head & ring->mask) * ring->recordSize], record, ring->recordSize);
+	spsc_store_release(&ring->head, head + 1);
+	return true;
+}
+
+/// <summary>Copy the oldest record out. Consumer only, returns false if the ring is empty.</summary>
+static inline bool spsc_ring_pop(SPSC_RING* ring, void* record)
+{
+	uint32_t tail = ring->tail;		// only this side writes it
+	uint32_t head = spsc_load_acquire(&ring->head);
+
+	if (head == tail) {
+		return false;
+	}
+
+	memcpy(record, &ring->records[(tail & ring->mask) * ring->recordSize], ring->recordSize);
+	spsc_store_release(&ring->tail, tail + 1);
+	return true;
+}
+
+/// <summary>Records waiting, at least this many for the consumer and at most this many for the producer.</summary>
+static inline uint32_t spsc_ring_count(SPSC_RING* ring)
+{
+	return spsc_load_acquire(&ring->head) - spsc_load_acquire(&ring->tail);
+}
+
+#endif
@@ -50,6 +50,7 @@ static uint8_t whoamI, rst;
 int accelTimerFd;
 const uint8_t lsm6dsOAddress = LSM6DSO_ADDRESS;     // Addr = 0x6A
 lsm6dso_ctx_t dev_ctx;
+static lsm6dso_shadow_t dev_shadow;
 lps22hh_ctx_t pressure_ctx;
 bool lps22hhDetected;
 
@@ -87,18 +88,19 @@ void HAL_Delay(int delayTime) {
 bool AvnetSkSensorUpdate(void)
 {
 
-	uint8_t reg;
+	lsm6dso_output_block_t lsm6dsoOut;
 	lps22hh_reg_t lps22hhReg;
 
-	// Read the sensors on the lsm6dso device
+	// Read the sensors on the lsm6dso device, the status and all output registers in one transfer
+	if (lsm6dso_output_block_raw_get(&dev_ctx, &lsm6dsoOut) != 0) {
+		memset(&lsm6dsoOut, 0x00, sizeof(lsm6dsoOut));
+	}
 
-	//Read output only if new xl value is available
-	lsm6dso_xl_flag_data_ready_get(&dev_ctx, &reg);
-	if (reg)
+	//Use output only if new xl value is available
+	if (lsm6dsoOut.out.status_reg.xlda)
 	{
-		// Read acceleration field data
-		memset(data_raw_acceleration.u8bit, 0x00, 3 * sizeof(int16_t));
-		lsm6dso_acceleration_raw_get(&dev_ctx, data_raw_acceleration.u8bit);
+		// Acceleration field data
+		memcpy(data_raw_acceleration.i16bit, lsm6dsoOut.out.acceleration, 3 * sizeof(int16_t));
 		
 		accelerationMilligForce.x = lsm6dso_from_fs4_to_mg(data_raw_acceleration.i16bit[0]);
 		accelerationMilligForce.y = lsm6dso_from_fs4_to_mg(data_raw_acceleration.i16bit[1]);
@@ -108,12 +110,10 @@ bool AvnetSkSensorUpdate(void)
 		//	accelerationMilligForce.x, accelerationMilligForce.y, accelerationMilligForce.z);
 	}
 
-	lsm6dso_gy_flag_data_ready_get(&dev_ctx, &reg);
-	if (reg)
+	if (lsm6dsoOut.out.status_reg.gda)
 	{
-		// Read angular rate field data
-		memset(data_raw_angular_rate.u8bit, 0x00, 3 * sizeof(int16_t));
-		lsm6dso_angular_rate_raw_get(&dev_ctx, data_raw_angular_rate.u8bit);
+		// Angular rate field data
+		memcpy(data_raw_angular_rate.i16bit, lsm6dsoOut.out.angular_rate, 3 * sizeof(int16_t));
 
 		// Before we store the mdps values subtract the calibration data we captured at startup.
 		angularRateDps.x = (lsm6dso_from_fs2000_to_mdps(data_raw_angular_rate.i16bit[0] - raw_angular_rate_calibration.i16bit[0])) / 1000.0;
@@ -219,6 +219,9 @@ int initI2c(void) {
 	dev_ctx.read_reg = platform_read;
 	dev_ctx.handle = &i2cFd;
 
+	// Keep a copy of the configuration registers, setters then skip most bus reads
+	lsm6dso_shadow_set(&dev_ctx, &dev_shadow);
+
 	// Check device ID
 	lsm6dso_device_id_get(&dev_ctx, &whoamI);
 	if (whoamI != LSM6DSO_ID) {
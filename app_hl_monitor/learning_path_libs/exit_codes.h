@@ -21,6 +21,7 @@ typedef enum {
 
 	ExitCode_IsButtonPressed = 20,
 	ExitCode_ButtonPressCheckHandler = 21,
-	ExitCode_Led2OffHandler = 22
+	ExitCode_Led2OffHandler = 22,
+	ExitCode_StreamWatchdogHandler = 23
 
 } ExitCode;
\ No newline at end of file
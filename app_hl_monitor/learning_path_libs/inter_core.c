@@ -2,11 +2,56 @@
 
 void SocketEventHandler(EventLoop* el, int fd, EventLoop_IoEvents events, void* context);
 bool ProcessMsg(void);
+static void DecodeMsg(const IC_MSG_HEADER* header, LP_INTER_CORE_BLOCK* control_block);
+static int FindRequest(uint32_t sequence);
+static void CompleteRequest(int slot, LP_INTER_CORE_BLOCK* control_block);
+static void DeliverBlocks(size_t count);
+static void ArmRequestTimer(void);
+static void RequestTimeoutHandler(EventLoopTimer* eventLoopTimer);
+static void FlushHandler(EventLoopTimer* eventLoopTimer);
+static bool DecodeFrame(const IC_MSG_HEADER* header, const uint8_t* payload, LP_INTER_CORE_FRAME* frame);
 void (*_interCoreCallback)(struct LP_INTER_CORE_BLOCK*);
+static void (*_batchCallback)(LP_INTER_CORE_BLOCK*, size_t);
+static void (*_frameCallback)(LP_INTER_CORE_FRAME*);
+// Messages read by one socket event, each with its own buffer so payloads stay valid until delivered.
+static uint8_t rxBufs[LP_INTER_CORE_DRAIN_BUDGET][IC_MSG_MAX_SIZE];
+static LP_INTER_CORE_BLOCK rxBlocks[LP_INTER_CORE_DRAIN_BUDGET];
+static IC_SAMPLE frameSamples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+static uint32_t nextFrameSequence;
 int sockFd = -1;
 static EventRegistration* socketEventReg = NULL;
+static uint32_t nextSequence = 1;
 
+// Outbound messages queued during the current event loop turn, sent as one datagram
+static uint8_t txBuf[IC_MSG_MAX_SIZE];
+static uint32_t txLength;
+static uint32_t txMessages, txDatagrams;
+static LP_TIMER flushTimer = { .period = { 0, 0 }, .name = "flushTimer", .handler = FlushHandler };
+static const struct timespec flushDelay = { 0, 1 };
 
+// Requests awaiting a reply, expired by one one-shot timer armed for the earliest deadline
+static struct
+{
+	uint32_t sequence;			// 0 if the slot is free
+	int64_t deadlineNs;			// CLOCK_MONOTONIC
+	LP_INTER_CORE_REPLY_HANDLER callback;
+} inFlight[LP_INTER_CORE_MAX_IN_FLIGHT];
+static LP_TIMER requestTimeoutTimer = { .period = { 0, 0 }, .name = "requestTimeoutTimer", .handler = RequestTimeoutHandler };
+
+
+static int64_t MonotonicNs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+
+/// <summary>
+///     Queue a message for the real-time app. Messages queued during one event loop turn are
+///     sent together in a single datagram once the turn ends, or as soon as
+///     LP_INTER_CORE_FLUSH_THRESHOLD bytes are waiting.
+/// </summary>
 bool lp_sendInterCoreMessage(LP_INTER_CORE_BLOCK* control_block)
 {
 
@@ -16,7 +61,58 @@ bool lp_sendInterCoreMessage(LP_INTER_CORE_BLOCK* control_block)
 		return false;
 	}
 
-	int bytesSent = send(sockFd, (void*)control_block, sizeof(control_block), 0);
+	uint16_t length = control_block->payload == NULL ? 0 : control_block->length;
+	if (sizeof(IC_MSG_HEADER) + length > sizeof(txBuf))
+	{
+		Log_Debug("ERROR: Inter core message too large: %u bytes\n", control_block->length);
+		return false;
+	}
+
+	// Make room if this message would not fit behind those already queued.
+	if (txLength + sizeof(IC_MSG_HEADER) + length > sizeof(txBuf) && !lp_flushInterCoreMessages())
+	{
+		return false;
+	}
+
+	control_block->sequence = nextSequence++;
+	if (nextSequence == 0)
+	{
+		nextSequence = 1;	// 0 marks a free in flight slot
+	}
+
+	if (txLength == 0 && !lp_setOneShotTimer(&flushTimer, &flushDelay))
+	{
+		Log_Debug("ERROR: Unable to schedule inter core send\n");
+		return false;
+	}
+
+	txLength += ic_msg_encode(&txBuf[txLength], sizeof(txBuf) - txLength, (uint8_t)control_block->cmd,
+		control_block->sequence, control_block->payload, length);
+	txMessages++;
+
+	if (txLength >= LP_INTER_CORE_FLUSH_THRESHOLD)
+	{
+		return lp_flushInterCoreMessages();
+	}
+
+	return true;
+}
+
+
+/// <summary>
+///     Send any queued messages now.
+/// </summary>
+bool lp_flushInterCoreMessages(void)
+{
+	if (txLength == 0)
+	{
+		return true;
+	}
+
+	int bytesSent = send(sockFd, txBuf, txLength, 0);
+	txLength = 0;
+	txDatagrams++;
+
 	if (bytesSent == -1)
 	{
 		Log_Debug("ERROR: Unable to send message: %d (%s)\n", errno, strerror(errno));
@@ -27,6 +123,215 @@ bool lp_sendInterCoreMessage(LP_INTER_CORE_BLOCK* control_block)
 }
 
 
+/// <summary>
+///     Number of messages queued and datagrams sent so far, to see how well sends coalesce.
+/// </summary>
+void lp_getInterCoreSendStats(uint32_t* messages, uint32_t* datagrams)
+{
+	*messages = txMessages;
+	*datagrams = txDatagrams;
+}
+
+
+/// <summary>
+///     Send the messages queued during the event loop turn which has just finished.
+/// </summary>
+static void FlushHandler(EventLoopTimer* eventLoopTimer)
+{
+	if (ConsumeEventLoopTimerEvent(eventLoopTimer) != 0)
+	{
+		lp_terminate(ExitCode_InterCoreHandler);
+		return;
+	}
+
+	lp_flushInterCoreMessages();
+}
+
+
+/// <summary>
+///     Send a request without waiting for the reply. Several requests can be outstanding;
+///     callback is called with the reply matched by sequence number, or with NULL once
+///     timeoutMs has passed without one.
+/// </summary>
+/// <returns>The request's sequence number, or 0 if it could not be sent or
+///     LP_INTER_CORE_MAX_IN_FLIGHT requests are already outstanding.</returns>
+uint32_t lp_interCoreRequestAsync(enum LP_INTER_CORE_CMD cmd, const void* payload, uint16_t length, uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback)
+{
+	LP_INTER_CORE_BLOCK control_block = { .cmd = cmd, .payload = payload, .length = length };
+	size_t slot;
+
+	for (slot = 0; slot < LP_INTER_CORE_MAX_IN_FLIGHT; slot++)
+	{
+		if (inFlight[slot].sequence == 0)
+		{
+			break;
+		}
+	}
+
+	if (slot == LP_INTER_CORE_MAX_IN_FLIGHT)
+	{
+		Log_Debug("ERROR: Too many inter core requests in flight\n");
+		return 0;
+	}
+
+	if (!lp_sendInterCoreMessage(&control_block))
+	{
+		return 0;
+	}
+
+	inFlight[slot].sequence = control_block.sequence;
+	inFlight[slot].deadlineNs = MonotonicNs() + (int64_t)timeoutMs * 1000000;
+	inFlight[slot].callback = callback;
+
+	ArmRequestTimer();
+
+	return control_block.sequence;
+}
+
+
+/// <summary>
+///     Find the outstanding request a message answers.
+/// </summary>
+/// <returns>The request's slot in inFlight, or -1 if the message answers none.</returns>
+static int FindRequest(uint32_t sequence)
+{
+	for (int slot = 0; slot < LP_INTER_CORE_MAX_IN_FLIGHT; slot++)
+	{
+		if (inFlight[slot].sequence != 0 && inFlight[slot].sequence == sequence)
+		{
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+
+/// <summary>
+///     Hand a reply to the request it answers.
+/// </summary>
+static void CompleteRequest(int slot, LP_INTER_CORE_BLOCK* control_block)
+{
+	LP_INTER_CORE_REPLY_HANDLER callback = inFlight[slot].callback;
+
+	// Free the slot first, so the callback can issue the next request.
+	inFlight[slot].sequence = 0;
+	callback(control_block->sequence, control_block);
+}
+
+
+/// <summary>
+///     Arm the timeout timer for the earliest outstanding deadline.
+/// </summary>
+static void ArmRequestTimer(void)
+{
+	int64_t earliest = INT64_MAX;
+
+	for (size_t slot = 0; slot < LP_INTER_CORE_MAX_IN_FLIGHT; slot++)
+	{
+		if (inFlight[slot].sequence != 0 && inFlight[slot].deadlineNs < earliest)
+		{
+			earliest = inFlight[slot].deadlineNs;
+		}
+	}
+
+	if (earliest == INT64_MAX)
+	{
+		return;
+	}
+
+	// A zero delay would disarm the timer, so expire overdue requests on the next pass.
+	int64_t delay = earliest - MonotonicNs();
+	if (delay < 1000)
+	{
+		delay = 1000;
+	}
+
+	struct timespec delayTime = { .tv_sec = delay / 1000000000, .tv_nsec = delay % 1000000000 };
+	lp_setOneShotTimer(&requestTimeoutTimer, &delayTime);
+}
+
+
+/// <summary>
+///     Fail every request whose deadline has passed, then re-arm for the next one.
+/// </summary>
+static void RequestTimeoutHandler(EventLoopTimer* eventLoopTimer)
+{
+	if (ConsumeEventLoopTimerEvent(eventLoopTimer) != 0)
+	{
+		lp_terminate(ExitCode_InterCoreHandler);
+		return;
+	}
+
+	int64_t now = MonotonicNs();
+
+	for (size_t slot = 0; slot < LP_INTER_CORE_MAX_IN_FLIGHT; slot++)
+	{
+		if (inFlight[slot].sequence != 0 && inFlight[slot].deadlineNs <= now)
+		{
+			uint32_t sequence = inFlight[slot].sequence;
+			LP_INTER_CORE_REPLY_HANDLER callback = inFlight[slot].callback;
+
+			inFlight[slot].sequence = 0;
+			callback(sequence, NULL);
+		}
+	}
+
+	ArmRequestTimer();
+}
+
+
+/// <summary>
+///     Ask the real-time app to push a sample every periodMs, samplesPerFrame samples per message.
+///     frameCallback is called with each frame; a periodMs of 0 stops the stream.
+///     With packed set, frames cross the cores delta encoded (see intercore_codec.h) and
+///     are unpacked here, the callback sees the same samples either way.
+///     The real-time app acknowledges with LP_IC_SUBSCRIBE, with the period and frame size it
+///     actually uses, which is handed to callback as for lp_interCoreRequestAsync. Without the
+///     acknowledgement the real-time app may not have been listening yet, subscribe again.
+/// </summary>
+/// <returns>The request's sequence number, or 0 if it could not be sent.</returns>
+uint32_t lp_subscribeInterCoreSamples(uint16_t periodMs, uint16_t samplesPerFrame, bool packed, void (*frameCallback)(LP_INTER_CORE_FRAME*),
+	uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback)
+{
+	IC_SUBSCRIBE_PAYLOAD subscription = { .periodMs = periodMs, .samplesPerFrame = samplesPerFrame,
+		.options = packed ? IC_SUBSCRIBE_PACKED : 0 };
+
+	_frameCallback = frameCallback;
+	nextFrameSequence = 0;
+
+	return lp_interCoreRequestAsync(LP_IC_SUBSCRIBE, &subscription, sizeof(subscription), timeoutMs, callback);
+}
+
+
+/// <summary>
+///     Set how often the real-time app samples the sensor in the background. LP_IC_GET_TEMPERATURE
+///     is then answered from its latest sample instead of a bus read; a periodMs of 0 stops the
+///     sampler. The real-time app acknowledges with LP_IC_SET_SAMPLER, value_int holding the
+///     period it actually uses, which is handed to callback as for lp_interCoreRequestAsync.
+/// </summary>
+/// <returns>The request's sequence number, or 0 if it could not be sent.</returns>
+uint32_t lp_setInterCoreSamplerPeriod(uint16_t periodMs, uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback)
+{
+	IC_SAMPLER_PAYLOAD sampler = { .periodMs = periodMs };
+
+	return lp_interCoreRequestAsync(LP_IC_SET_SAMPLER, &sampler, sizeof(sampler), timeoutMs, callback);
+}
+
+
+/// <summary>
+///     Deliver the messages read by one socket event with a single call instead of one
+///     callback per message. Sample frames still go to the frame callback and replies to
+///     their request's callback. Everything is delivered in the order it arrived, so a frame
+///     or reply first delivers the messages read before it, and a batch ends there. NULL
+///     restores per-message delivery.
+/// </summary>
+void lp_setInterCoreBatchCallback(void (*batchCallback)(LP_INTER_CORE_BLOCK* blocks, size_t count))
+{
+	_batchCallback = batchCallback;
+}
+
+
 int lp_enableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(LP_INTER_CORE_BLOCK*))
 {
 	_interCoreCallback = interCoreCallback;
@@ -38,12 +343,12 @@ int lp_enableInterCoreCommunications(const char* rtAppComponentId, void (*interC
 		return -1;
 	}
 
-	// Set timeout, to handle case where real-time capable application does not respond.
-	static const struct timeval recvTimeout = { .tv_sec = 5, .tv_usec = 0 };
-	int result = setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, sizeof(recvTimeout));
-	if (result == -1)
+	// Reads never block, a real-time capable application which does not respond is caught by
+	// the per request timeouts of lp_interCoreRequestAsync instead.
+	if (!lp_startTimer(&requestTimeoutTimer) || !lp_startTimer(&flushTimer))
 	{
-		Log_Debug("ERROR: Unable to set socket timeout: %d (%s)\n", errno, strerror(errno));
+		Log_Debug("ERROR: Unable to create inter core timers\n");
+		lp_disableInterCoreCommunications();
 		return -1;
 	}
 
@@ -53,6 +358,7 @@ int lp_enableInterCoreCommunications(const char* rtAppComponentId, void (*interC
 	if (socketEventReg == NULL)
 	{
 		Log_Debug("ERROR: Unable to register socket event: %d (%s)\n", errno, strerror(errno));
+		lp_disableInterCoreCommunications();
 		return -1;
 	}
 
@@ -60,6 +366,37 @@ int lp_enableInterCoreCommunications(const char* rtAppComponentId, void (*interC
 }
 
 
+/// <summary>
+///     Send any queued messages, then close the connection to the real-time capable application
+///     and dispose of the inter core timers. Outstanding requests are dropped without calling
+///     their callbacks. Call before the event loop is closed.
+/// </summary>
+void lp_disableInterCoreCommunications(void)
+{
+	if (sockFd != -1)
+	{
+		lp_flushInterCoreMessages();
+	}
+	txLength = 0;
+
+	lp_stopTimer(&flushTimer);
+	lp_stopTimer(&requestTimeoutTimer);
+	memset(inFlight, 0, sizeof(inFlight));
+
+	if (socketEventReg != NULL)
+	{
+		EventLoop_UnregisterIo(lp_getTimerEventLoop(), socketEventReg);
+		socketEventReg = NULL;
+	}
+
+	if (sockFd != -1)
+	{
+		close(sockFd);
+		sockFd = -1;
+	}
+}
+
+
 /// <summary>
 ///     Handle socket event by reading incoming data from real-time capable application.
 /// </summary>
@@ -73,21 +410,168 @@ void SocketEventHandler(EventLoop* el, int fd, EventLoop_IoEvents events, void*
 
 
 /// <summary>
-///     Handle socket event by reading incoming data from real-time capable application.
+///     Handle socket event by reading every queued message from the real-time capable
+///     application, up to LP_INTER_CORE_DRAIN_BUDGET so a busy stream cannot starve the
+///     rest of the event loop. The socket stays readable if more are queued, so the event
+///     loop calls back for the remainder. Messages are delivered in the order they arrived.
 /// </summary>
 bool ProcessMsg()
 {
-	LP_INTER_CORE_BLOCK ic_control_block;
+	size_t count = 0;
+
+	for (size_t i = 0; i < LP_INTER_CORE_DRAIN_BUDGET; i++)
+	{
+		IC_MSG_HEADER header;
+		LP_INTER_CORE_BLOCK* control_block = &rxBlocks[count];
+
+		int bytesReceived = recv(sockFd, rxBufs[count], sizeof(rxBufs[count]), MSG_DONTWAIT);
 
-	int bytesReceived = recv(sockFd, (void*)&ic_control_block, sizeof(ic_control_block), 0);
+		if (bytesReceived == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				break;
+			}
 
-	if (bytesReceived == -1)
+			lp_terminate(ExitCode_InterCoreReceiveFailed);
+			return false;
+		}
+
+		if (ic_msg_decode(rxBufs[count], (uint32_t)bytesReceived, &header, &control_block->payload) == 0)
+		{
+			Log_Debug("Ignoring malformed inter core message (%d bytes)\n", bytesReceived);
+			continue;
+		}
+
+		if (header.type == IC_MSG_SAMPLE_FRAME || header.type == IC_MSG_SAMPLE_FRAME_PACKED)
+		{
+			LP_INTER_CORE_FRAME frame;
+
+			if (_frameCallback != NULL && DecodeFrame(&header, control_block->payload, &frame))
+			{
+				DeliverBlocks(count);
+				count = 0;
+				_frameCallback(&frame);
+			}
+			continue;
+		}
+
+		DecodeMsg(&header, control_block);
+
+		int slot = FindRequest(control_block->sequence);
+		if (slot != -1)
+		{
+			// The reply's buffer is not reused before the next read, which comes after the callback.
+			DeliverBlocks(count);
+			count = 0;
+			CompleteRequest(slot, control_block);
+			continue;
+		}
+		count++;
+	}
+
+	DeliverBlocks(count);
+	return true;
+}
+
+
+/// <summary>
+///     Hand the first count messages in rxBlocks to the batch callback, or one at a time
+///     to the message callback.
+/// </summary>
+static void DeliverBlocks(size_t count)
+{
+	if (count == 0)
 	{
-		lp_terminate(ExitCode_InterCoreReceiveFailed);
-		return false;
+		return;
+	}
+
+	if (_batchCallback != NULL)
+	{
+		_batchCallback(rxBlocks, count);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			_interCoreCallback(&rxBlocks[i]);
+		}
+	}
+}
+
+
+/// <summary>
+///     Fill in the control block from a decoded message, unpacking scalar replies by type.
+/// </summary>
+static void DecodeMsg(const IC_MSG_HEADER* header, LP_INTER_CORE_BLOCK* control_block)
+{
+	IC_TEMPERATURE_PAYLOAD temperature;
+	IC_SAMPLER_PAYLOAD sampler;
+
+	control_block->cmd = (enum LP_INTER_CORE_CMD)header->type;
+	control_block->sequence = header->sequence;
+	control_block->length = header->length;
+	control_block->value_int = 0;
+
+	switch (header->type)
+	{
+	case IC_MSG_GET_TEMPERATURE:
+		if (ic_msg_payload(header, control_block->payload, &temperature, sizeof(temperature)))
+		{
+			control_block->value_float = temperature.temperature;
+		}
+		break;
+	case IC_MSG_SET_SAMPLER:
+		if (ic_msg_payload(header, control_block->payload, &sampler, sizeof(sampler)))
+		{
+			control_block->value_int = sampler.periodMs;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+
+/// <summary>
+///     Unpack a raw or packed sample frame into frameSamples, which keeps the samples aligned for the callback.
+/// </summary>
+static bool DecodeFrame(const IC_MSG_HEADER* header, const uint8_t* payload, LP_INTER_CORE_FRAME* frame)
+{
+	IC_SAMPLE_FRAME_HEADER frameHeader;
+
+	if (header->type == IC_MSG_SAMPLE_FRAME_PACKED)
+	{
+		if (!ic_codec_decode_frame(payload, header->length, &frameHeader, frameSamples, IC_SAMPLE_FRAME_MAX_SAMPLES))
+		{
+			Log_Debug("Ignoring malformed packed sample frame (%u bytes)\n", header->length);
+			return false;
+		}
+	}
+	else
+	{
+		if (header->length < sizeof(frameHeader))
+		{
+			return false;
+		}
+
+		memcpy(&frameHeader, payload, sizeof(frameHeader));
+		if (frameHeader.count > IC_SAMPLE_FRAME_MAX_SAMPLES ||
+			header->length != sizeof(frameHeader) + frameHeader.count * sizeof(IC_SAMPLE))
+		{
+			Log_Debug("Ignoring malformed sample frame (%u bytes)\n", header->length);
+			return false;
+		}
+
+		memcpy(frameSamples, payload + sizeof(frameHeader), frameHeader.count * sizeof(IC_SAMPLE));
 	}
 
-	_interCoreCallback(&ic_control_block);
+	frame->sequence = header->sequence;
+	frame->lost = header->sequence > nextFrameSequence ? header->sequence - nextFrameSequence : 0;
+	frame->periodMs = frameHeader.periodMs;
+	frame->count = frameHeader.count;
+	frame->samples = frameSamples;
 
+	nextFrameSequence = header->sequence + 1;
 	return true;
 }
\ No newline at end of file
@@ -12,19 +12,39 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include "timer.h"
+#include "intercore_codec.h"
+#include "intercore_msg.h"
+
+// Most messages handled per socket event before returning to the event loop
+#ifndef LP_INTER_CORE_DRAIN_BUDGET
+#define LP_INTER_CORE_DRAIN_BUDGET 16
+#endif
+// Most requests made with lp_interCoreRequestAsync awaiting a reply at once
+#define LP_INTER_CORE_MAX_IN_FLIGHT 8
+// Queued outbound bytes which trigger an immediate send rather than waiting for the end of the turn
+#define LP_INTER_CORE_FLUSH_THRESHOLD 512
 
 enum LP_INTER_CORE_CMD
 {
-	LP_IC_UNKNOWN,
-	LP_IC_GET_TEMPERATURE
+	LP_IC_UNKNOWN = IC_MSG_UNKNOWN,
+	LP_IC_GET_TEMPERATURE = IC_MSG_GET_TEMPERATURE,
+	LP_IC_SUBSCRIBE = IC_MSG_SUBSCRIBE,
+	LP_IC_SAMPLE_FRAME = IC_MSG_SAMPLE_FRAME,
+	LP_IC_SAMPLE_FRAME_PACKED = IC_MSG_SAMPLE_FRAME_PACKED,
+	LP_IC_GET_STATS = IC_MSG_GET_STATS,
+	LP_IC_SET_SAMPLER = IC_MSG_SET_SAMPLER
 };
 
 typedef struct LP_INTER_CORE_BLOCK
 {
 	enum LP_INTER_CORE_CMD cmd;
-	union
+	uint32_t sequence;			// assigned by lp_sendInterCoreMessage, echoed in the reply
+	uint16_t length;			// payload length in bytes
+	const uint8_t* payload;		// payload to send, or received payload (valid during the callback only)
+	union						// received scalar payloads, decoded by message type
 	{
 		bool	value_bool;
 		float	value_float;
@@ -32,6 +52,26 @@ typedef struct LP_INTER_CORE_BLOCK
 	};
 } LP_INTER_CORE_BLOCK;
 
+typedef struct LP_INTER_CORE_FRAME
+{
+	uint32_t sequence;			// frame number since the subscription started
+	uint32_t lost;				// frames missing between the previous frame and this one
+	uint16_t periodMs;			// sample period
+	uint16_t count;				// number of samples
+	const IC_SAMPLE* samples;	// valid during the callback only
+} LP_INTER_CORE_FRAME;
+
+
+// Called with the reply to an asynchronous request, or with reply NULL if it timed out
+typedef void (*LP_INTER_CORE_REPLY_HANDLER)(uint32_t sequence, LP_INTER_CORE_BLOCK* reply);
 
 bool lp_sendInterCoreMessage(LP_INTER_CORE_BLOCK* control_block);
+bool lp_flushInterCoreMessages(void);
+void lp_getInterCoreSendStats(uint32_t* messages, uint32_t* datagrams);
+uint32_t lp_interCoreRequestAsync(enum LP_INTER_CORE_CMD cmd, const void* payload, uint16_t length, uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback);
 int lp_enableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(LP_INTER_CORE_BLOCK*));
+void lp_disableInterCoreCommunications(void);
+void lp_setInterCoreBatchCallback(void (*batchCallback)(LP_INTER_CORE_BLOCK* blocks, size_t count));
+uint32_t lp_subscribeInterCoreSamples(uint16_t periodMs, uint16_t samplesPerFrame, bool packed, void (*frameCallback)(LP_INTER_CORE_FRAME*),
+	uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback);
+uint32_t lp_setInterCoreSamplerPeriod(uint16_t periodMs, uint32_t timeoutMs, LP_INTER_CORE_REPLY_HANDLER callback);
@@ -64,10 +64,25 @@ static void ButtonPressCheckHandler(EventLoopTimer* eventLoopTimer);
 static void LedOn(LP_PERIPHERAL_GPIO* led);
 static void LedOffHandler(EventLoopTimer* eventLoopTimer);
 static bool IsButtonPressed(LP_PERIPHERAL_GPIO button, GPIO_Value_Type* oldState);
-static void InterCoreMsgHandler(EventLoopTimer* eventLoopTimer);
+static void ShowTemperature(float temperature);
+static void LogInterCoreStats(LP_INTER_CORE_BLOCK* control_block);
+static void InterCoreMessageHandler(LP_INTER_CORE_BLOCK* control_block);
+static void SubscribeSamples(void);
+static void SetSamplerPeriod(void);
+static void StreamWatchdogHandler(EventLoopTimer* eventLoopTimer);
 
 static const struct timespec ledStatusPeriod = { 2, 500 * 1000 * 1000 };
-LP_INTER_CORE_BLOCK ic_control_block;
+static const uint16_t samplePeriodMs = 100;
+static const uint16_t samplesPerFrame = 10;
+static const uint16_t samplerPeriodMs = 100;
+static const uint32_t requestTimeoutMs = 1000;
+static const uint32_t streamWatchdogFrames = 3;		// frame periods without a frame before subscribing again
+
+// Start up requests, repeated until the real-time app acknowledges them
+static uint32_t subscribeSequence;		// subscription awaiting its acknowledgement, 0 if none
+static uint32_t samplerSequence;		// sampler period awaiting its acknowledgement, 0 if none
+static bool samplerAcknowledged;
+static uint32_t framesReceived, framesAtLastCheck;
 
 // GPIO Output Peripherals
 static LP_PERIPHERAL_GPIO ledRed = { .pin = LED_RED, .direction = LP_OUTPUT, .initialState = GPIO_Value_Low, .invertPin = true, .initialise = lp_openPeripheralGpio, .name = "ledRed" };
@@ -78,20 +93,181 @@ static LP_PERIPHERAL_GPIO buttonA = { .pin = BUTTON_A, .direction = LP_INPUT, .i
 // Timers
 static LP_TIMER ledOffOneShotTimer = { .period = { 0, 0 }, .name = "ledOffOneShotTimer", .handler = LedOffHandler };
 static LP_TIMER buttonPressCheckTimer = { .period = { 0, 1000000 }, .name = "buttonPressCheckTimer", .handler = ButtonPressCheckHandler };
-static LP_TIMER InterCoreMsgTimer = { .period = { 1, 000000000 }, .name = "InterCoreMsgTimer", .handler = InterCoreMsgHandler };
+static LP_TIMER streamWatchdogTimer = { .period = { 0, 0 }, .name = "streamWatchdogTimer", .handler = StreamWatchdogHandler };	// period set from the frame rate
 
 // Initialize Sets
 LP_PERIPHERAL_GPIO* peripheralGpioSet[] = { &ledRed, &ledGreen, &ledBlue, &buttonA };
-LP_TIMER* timerSet[] = { &ledOffOneShotTimer, &buttonPressCheckTimer, &InterCoreMsgTimer };
+LP_TIMER* timerSet[] = { &ledOffOneShotTimer, &buttonPressCheckTimer, &streamWatchdogTimer };
 
 
 /// <summary>
 /// Callback handler for Inter-Core Messaging 
 /// </summary>
 static void InterCoreMessageHandler(LP_INTER_CORE_BLOCK* control_block) {
+	switch (control_block->cmd) {
+	case LP_IC_GET_TEMPERATURE:
+		ShowTemperature(control_block->value_float);
+		break;
+	case LP_IC_SUBSCRIBE:
+		Log_Debug("Sample stream subscription acknowledged\n");
+		break;
+	case LP_IC_SET_SAMPLER:
+		Log_Debug("Background sampler running every %d ms\n", control_block->value_int);
+		break;
+	case LP_IC_GET_STATS:
+		LogInterCoreStats(control_block);
+		break;
+	default:
+		break;
+	}
+}
+
+
+/// <summary>
+/// Callback handler for replies to asynchronous Inter-Core requests
+/// </summary>
+static void InterCoreReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK* reply) {
+	if (reply == NULL) {
+		Log_Debug("Inter core request %u timed out\n", sequence);
+		return;
+	}
+
+	InterCoreMessageHandler(reply);
+}
+
+
+/// <summary>
+/// Callback handler for streamed sensor sample frames
+/// </summary>
+static void InterCoreFrameHandler(LP_INTER_CORE_FRAME* frame) {
+	framesReceived++;
+
+	if (frame->lost > 0) {
+		Log_Debug("Lost %u sample frames\n", frame->lost);
+	}
+
+	if (frame->count == 0) {
+		return;
+	}
+
+	for (uint16_t i = 0; i < frame->count; i++) {
+		if (frame->samples[i].flags & IC_SAMPLE_FIFO_OVERRUN) {
+			Log_Debug("Frame %u: sensor FIFO overran, readings lost before %u ms\n", frame->sequence,
+				frame->samples[i].timestamp);
+		}
+	}
+
+	const IC_SAMPLE* last = &frame->samples[frame->count - 1];
+
+	Log_Debug("Frame %u: %u samples, acceleration [mg] %.1f, %.1f, %.1f\n", frame->sequence, frame->count,
+		ic_sample_to_mg(last->acceleration[0]), ic_sample_to_mg(last->acceleration[1]), ic_sample_to_mg(last->acceleration[2]));
+
+	ShowTemperature(ic_sample_to_celsius(last->temperature));
+}
+
+
+/// <summary>
+/// Acknowledgement of the sample stream subscription, subscribe again if there was none
+/// </summary>
+static void SubscribeReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK* reply) {
+	subscribeSequence = 0;
+
+	if (reply == NULL) {
+		Log_Debug("Sample stream subscription %u timed out, retrying\n", sequence);
+		SubscribeSamples();
+		return;
+	}
+
+	InterCoreMessageHandler(reply);
+}
+
+
+/// <summary>
+/// Acknowledgement of the background sampler period, set it again if there was none
+/// </summary>
+static void SamplerReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK* reply) {
+	samplerSequence = 0;
+
+	if (reply == NULL) {
+		Log_Debug("Background sampler request %u timed out, retrying\n", sequence);
+		SetSamplerPeriod();
+		return;
+	}
+
+	samplerAcknowledged = true;
+	InterCoreMessageHandler(reply);
+}
+
+
+/// <summary>
+/// Ask the real-time app for the sample stream. It may not be listening yet at start up, so
+/// this is repeated until acknowledged.
+/// </summary>
+static void SubscribeSamples(void) {
+	subscribeSequence = lp_subscribeInterCoreSamples(samplePeriodMs, samplesPerFrame, true, InterCoreFrameHandler,
+		requestTimeoutMs, SubscribeReplyHandler);
+}
+
+
+/// <summary>
+/// Start the real-time app's background sampler, repeated until acknowledged
+/// </summary>
+static void SetSamplerPeriod(void) {
+	samplerSequence = lp_setInterCoreSamplerPeriod(samplerPeriodMs, requestTimeoutMs, SamplerReplyHandler);
+}
+
+
+/// <summary>
+/// Subscribe again once an acknowledged stream has stopped, for instance after the real-time
+/// app restarted, and send start up requests which could not be sent at all
+/// </summary>
+static void StreamWatchdogHandler(EventLoopTimer* eventLoopTimer) {
+	if (ConsumeEventLoopTimerEvent(eventLoopTimer) != 0) {
+		lp_terminate(ExitCode_StreamWatchdogHandler);
+		return;
+	}
+
+	if (subscribeSequence == 0 && framesReceived == framesAtLastCheck) {
+		Log_Debug("No sample frames, subscribing again\n");
+		SubscribeSamples();
+	}
+	framesAtLastCheck = framesReceived;
+
+	if (samplerSequence == 0 && !samplerAcknowledged) {
+		SetSamplerPeriod();
+	}
+}
+
+
+/// <summary>
+/// Log the real-time app's shared buffer counters
+/// </summary>
+static void LogInterCoreStats(LP_INTER_CORE_BLOCK* control_block) {
+	IC_STATS_PAYLOAD stats;
+
+	if (control_block->length != sizeof(stats)) {
+		return;
+	}
+
+	memcpy(&stats, control_block->payload, sizeof(stats));
+
+	Log_Debug("Inter core: out %u msgs/%u bytes, in %u msgs/%u bytes, high water out %u in %u of %u bytes\n",
+		stats.messagesOut, stats.bytesOut, stats.messagesIn, stats.bytesIn,
+		stats.outboundHighWater, stats.inboundHighWater, stats.bufferSize);
+	Log_Debug("Inter core: %u full, %u invalid, %u waits, %u dropped, max latency %u ms\n",
+		stats.outboundFull, stats.invalidPosition, stats.senderWaits, stats.sendsDropped, stats.maxLatencyMs);
+}
+
+
+/// <summary>
+/// Show the temperature trend on the LEDs
+/// </summary>
+static void ShowTemperature(float temperature) {
 	static float previousTemperature = 0.0;
 
-	float temperature = control_block->value_float;
+	lp_gpioOff(&ledRed);
+	lp_gpioOff(&ledGreen);
+	lp_gpioOff(&ledBlue);
 
 	if (temperature == previousTemperature) {
 		LedOn(&ledGreen);
@@ -128,35 +304,12 @@ static void ButtonPressCheckHandler(EventLoopTimer* eventLoopTimer) {
 		lp_gpioOff(&ledGreen);
 		lp_gpioOff(&ledBlue);
 
-		ic_control_block.cmd = LP_IC_GET_TEMPERATURE;
-
-		lp_sendInterCoreMessage(&ic_control_block);
+		// Both requests are in flight at once, each reply is matched by its sequence number.
+		lp_interCoreRequestAsync(LP_IC_GET_TEMPERATURE, NULL, 0, requestTimeoutMs, InterCoreReplyHandler);
+		lp_interCoreRequestAsync(LP_IC_GET_STATS, NULL, 0, requestTimeoutMs, InterCoreReplyHandler);
 	}
 }
 
-/// <summary>
-/// Handler to check for Inter Core Msg Presses
-/// </summary>
-static void InterCoreMsgHandler(EventLoopTimer* eventLoopTimer)
-{
-	static GPIO_Value_Type buttonAState;
-
-	if (ConsumeEventLoopTimerEvent(eventLoopTimer) != 0)
-	{
-		lp_terminate(ExitCode_ButtonPressCheckHandler);
-		return;
-	}
-
-	lp_gpioOff(&ledRed);
-	lp_gpioOff(&ledGreen);
-	lp_gpioOff(&ledBlue);
-
-	ic_control_block.cmd = LP_IC_GET_TEMPERATURE;
-	lp_sendInterCoreMessage(&ic_control_block);
-}
-
-
-
 /// <summary>
 /// Turn on LED and set a one shot timer to turn LED2 off
 /// </summary>
@@ -204,15 +357,23 @@ static bool IsButtonPressed(LP_PERIPHERAL_GPIO button, GPIO_Value_Type* oldState
 ///  Initialize peripherals, device twins, direct methods, timers.
 /// </summary>
 static void InitPeripheralsAndHandlers(void) {
+	uint32_t watchdogMs = streamWatchdogFrames * samplePeriodMs * samplesPerFrame;
+
+	streamWatchdogTimer.period.tv_sec = watchdogMs / 1000;
+	streamWatchdogTimer.period.tv_nsec = (watchdogMs % 1000) * 1000000;
+
 	lp_openPeripheralGpioSet(peripheralGpioSet, NELEMS(peripheralGpioSet));
 	lp_startTimerSet(timerSet, NELEMS(timerSet));
 	lp_enableInterCoreCommunications(rtAppComponentId, InterCoreMessageHandler);
+	SubscribeSamples();
+	SetSamplerPeriod();
 }
 
 /// <summary>
 /// Close peripherals and handlers.
 /// </summary>
 static void ClosePeripheralsAndHandlers(void) {
+	lp_disableInterCoreCommunications();
 	lp_stopTimerSet();
 	lp_closePeripheralGpioSet();
 	lp_stopTimerEventLoop();
@@ -2,6 +2,7 @@
 #include "eventloop_timer_utilities.h"
 #include "exit_codes.h"
 #include "hw/azure_sphere_learning_path.h"
+#include "intercore_msg.h"
 #include "stdbool.h"
 #include <applibs/application.h>
 #include <applibs/eventloop.h>
@@ -78,13 +79,14 @@ EventLoop* eventLoop = NULL;
 // inter core support functions
 void SocketEventHandler(EventLoop* el, int fd, EventLoop_IoEvents events, void* context);
 bool ProcessMsg(void);
-void (*_interCoreCallback)(char*);
+void (*_interCoreCallback)(const IC_MSG_HEADER*, const uint8_t*);
 int sockFd = -1;
+static uint32_t nextSequence = 1;
 
 static EventRegistration* socketEventReg = NULL;
 
-bool SendInterCoreMessage(const char* msg);
-int EnableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(char*));
+bool SendInterCoreMessage(IC_MSG_TYPE type, const void* payload, uint16_t length);
+int EnableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(const IC_MSG_HEADER*, const uint8_t*));
 
 // Termination support functions
 volatile sig_atomic_t terminationRequired = false;
@@ -135,10 +137,15 @@ Timer* timerSet[] = { &ledOffOneShotTimer, &buttonPressCheckTimer };
 /// <summary>
 /// Callback handler for Inter-Core Messaging 
 /// </summary>
-static void InterCoreMessageHandler(char* msg) {
+static void InterCoreMessageHandler(const IC_MSG_HEADER* header, const uint8_t* payload) {
 	static float previousTemperature = 0.0;
+	IC_TEMPERATURE_PAYLOAD reply;
 
-	float temperature = strtof(msg, NULL);
+	if (header->type != IC_MSG_GET_TEMPERATURE || !ic_msg_payload(header, payload, &reply, sizeof(reply))) {
+		return;
+	}
+
+	float temperature = reply.temperature;
 
 	if (temperature == previousTemperature) {
 		LedOn(&ledGreen);
@@ -154,7 +161,7 @@ static void InterCoreMessageHandler(char* msg) {
 
 	previousTemperature = temperature;
 
-	Log_Debug(msg);
+	Log_Debug("Temperature: %f\n", temperature);
 }
 
 
@@ -175,7 +182,7 @@ static void ButtonPressCheckHandler(EventLoopTimer* eventLoopTimer) {
 		Gpio_Off(&ledGreen);
 		Gpio_Off(&ledBlue);
 
-		SendInterCoreMessage("GetTemperature");
+		SendInterCoreMessage(IC_MSG_GET_TEMPERATURE, NULL, 0);
 	}
 }
 
@@ -455,14 +462,21 @@ bool SetOneShotTimer(Timer* timer, const struct timespec* period) {
 
 // Inter core handlers
 
-bool SendInterCoreMessage(const char* msg) {
+bool SendInterCoreMessage(IC_MSG_TYPE type, const void* payload, uint16_t length) {
+	uint8_t msg[IC_MSG_MAX_SIZE];
 
 	if (sockFd == -1) {
 		Log_Debug("Socket not initialized");
 		return false;
 	}
 
-	int bytesSent = send(sockFd, msg, strlen(msg), 0);
+	uint32_t msgSize = ic_msg_encode(msg, sizeof(msg), (uint8_t)type, nextSequence++, payload, length);
+	if (msgSize == 0) {
+		Log_Debug("ERROR: Inter core message too large: %u bytes\n", length);
+		return false;
+	}
+
+	int bytesSent = send(sockFd, msg, msgSize, 0);
 	if (bytesSent == -1) {
 		Log_Debug("ERROR: Unable to send message: %d (%s)\n", errno, strerror(errno));
 		return false;
@@ -471,7 +485,7 @@ bool SendInterCoreMessage(const char* msg) {
 	return true;
 }
 
-int EnableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(char*)) {
+int EnableInterCoreCommunications(const char* rtAppComponentId, void (*interCoreCallback)(const IC_MSG_HEADER*, const uint8_t*)) {
 	_interCoreCallback = interCoreCallback;
 	// Open connection to real-time capable application.
 	sockFd = Application_Connect(rtAppComponentId);
@@ -514,11 +528,12 @@ void SocketEventHandler(EventLoop* el, int fd, EventLoop_IoEvents events, void*
 
 /// <summary>
 ///     Handle socket event by reading incoming data from real-time capable application.
+///     Messages follow the binary schema in Shared/intercore_msg.h and are decoded in place.
 /// </summary>
 bool ProcessMsg() {
-	char rxBuf[32];
-	char msg[32];
-	memset(msg, 0, sizeof msg);
+	uint8_t rxBuf[IC_MSG_MAX_SIZE];
+	IC_MSG_HEADER header;
+	const uint8_t* payload;
 
 	int bytesReceived = recv(sockFd, rxBuf, sizeof(rxBuf), 0);
 
@@ -527,13 +542,26 @@ bool ProcessMsg() {
 		return false;
 	}
 
-	//Log_Debug("Received %d bytes: ", bytesReceived);
-	for (int i = 0; i < bytesReceived; ++i) {
-		msg[i] = isprint(rxBuf[i]) ? rxBuf[i] : '.';
+	if (ic_msg_decode(rxBuf, (uint32_t)bytesReceived, &header, &payload) == 0) {
+#ifdef INTER_CORE_TEXT_DEBUG
+		// Show what arrived, for example text from an older real-time app.
+		char msg[64];
+		int length = bytesReceived < (int)sizeof(msg) - 1 ? bytesReceived : (int)sizeof(msg) - 1;
+		for (int i = 0; i < length; ++i) {
+			msg[i] = isprint(rxBuf[i]) ? rxBuf[i] : '.';
+		}
+		msg[length] = '\0';
+		Log_Debug("Ignoring malformed inter core message: %s\n", msg);
+#endif // INTER_CORE_TEXT_DEBUG
+		return true;
 	}
-	Log_Debug("\n%s\n\n", msg);
 
-	_interCoreCallback(msg);
+#ifdef INTER_CORE_TEXT_DEBUG
+	Log_Debug("Inter core message: type %u, version %u, sequence %u, %u payload bytes\n",
+		header.type, header.version, header.sequence, header.length);
+#endif // INTER_CORE_TEXT_DEBUG
+
+	_interCoreCallback(&header, payload);
 
 	return true;
 }
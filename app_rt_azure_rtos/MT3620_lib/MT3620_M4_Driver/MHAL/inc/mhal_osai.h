@@ -105,6 +105,79 @@ void osai_delay_us(u32 us);
  */
 void osai_delay_ms(u32 ms);
 
+/**
+ * It's the wait time passed to osai_wait_for_completion_timeout()
+ * to wait without a timeout.
+ */
+#define OSAI_WAIT_FOREVER	0xFFFFFFFF
+
+/**
+ * It's the mapping of completion type between different OS.
+ * A completion is signalled from an interrupt handler and waited for
+ * by the driver thread which started the hardware operation.
+ */
+#ifdef OSAI_THREADX
+/* Storage for a TX_SEMAPHORE. It is kept opaque here because the
+ * ThreadX basic types conflict with type_def.h used by the drivers.
+ */
+struct osai_completion {
+	bool created;
+	unsigned long sem[16];
+};
+#else
+struct osai_completion {
+	volatile u32 done;
+};
+#endif
+
+/**
+ *@brief  This function is used to initialize a completion.\n
+ *@brief Usage:
+ * It should be called once before the completion is used,
+ * the completion starts as not done.
+ *@param [in] comp : The completion.
+ *
+ *@return
+ * Return 0 if the completion is initialized successfully.\n
+ * Return -1 if errors occur.
+ */
+int osai_init_completion(struct osai_completion *comp);
+
+/**
+ *@brief  This function is used to delete a completion.\n
+ *@param [in] comp : The completion.
+ *
+ *@return None
+ */
+void osai_deinit_completion(struct osai_completion *comp);
+
+/**
+ *@brief  This function is used to signal a completion.\n
+ *@brief Usage:
+ * It can be called from an interrupt handler or callback, and wakes up
+ * the waiter of the completion.
+ *@param [in] comp : The completion.
+ *
+ *@return None
+ */
+void osai_complete(struct osai_completion *comp);
+
+/**
+ *@brief  This function is used to wait for a completion.\n
+ *@brief Usage:
+ * The calling thread sleeps until osai_complete() is called or time_ms
+ * millisecond elapsed. Outside of a thread it polls the completion.
+ *@param [in] comp : The completion.
+ *@param [in] time_ms : The timeout, unit is millisecond, or
+ * #OSAI_WAIT_FOREVER.
+ *
+ *@return
+ * Return 0 if the completion is done.\n
+ * Return -1 if timeout occurs.
+ */
+int osai_wait_for_completion_timeout(struct osai_completion *comp,
+				     u32 time_ms);
+
 /**
  *@brief  This function is used to read I/O memory.\n
  *@param [in] addr : The I/O memory address.
@@ -594,6 +594,10 @@ struct mtk_uart_private {
 	u32 tx_size;
 	/** tx transfer len */
 	u32 rx_size;
+	/** rx Virtual FIFO size, 0 means 0x4000 */
+	u32 rx_vff_size;
+	/** keep rx Virtual FIFO DMA running after threshold interrupt */
+	bool rx_vff_continuous;
 
 	/** user_data is a OS-HAL defined parameter provided
 	* by #mtk_mhal_uart_dma_done_callback_register().
@@ -646,6 +650,8 @@ struct mtk_uart_controller {
 #define UART_EPTR			(1)
 /**No such device or address*/
 #define UART_ENXIO			(6)
+/**Device or resource busy*/
+#define UART_EBUSY			(16)
 /**Invalid argument*/
 #define UART_EINVAL			(22)
 /**Transfer timed out*/
@@ -37,6 +37,8 @@
 #include "mhal_osai.h"
 #include "os_hal_dma.h"
 
+/* The ThreadX implementation is in mhal_osai_threadx.c */
+#ifndef OSAI_THREADX
 void osai_delay_us(u32 us)
 {
 	u32 current_tick;
@@ -93,6 +95,44 @@ void osai_delay_ms(u32 ms)
 }
 #endif
 
+int osai_init_completion(struct osai_completion *comp)
+{
+	comp->done = 0;
+	return 0;
+}
+
+void osai_deinit_completion(struct osai_completion *comp)
+{
+}
+
+void osai_complete(struct osai_completion *comp)
+{
+	comp->done++;
+}
+
+int osai_wait_for_completion_timeout(struct osai_completion *comp,
+				     u32 time_ms)
+{
+	extern volatile u32 sys_tick_in_ms;
+	u32 start_ms = sys_tick_in_ms;
+	u32 primask;
+
+	while (comp->done == 0) {
+		if ((time_ms != OSAI_WAIT_FOREVER) &&
+		    (sys_tick_in_ms - start_ms >= time_ms))
+			return -1;
+	}
+
+	/* the interrupt handler may complete again meanwhile */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	comp->done--;
+	__set_PRIMASK(primask);
+
+	return 0;
+}
+#endif /* OSAI_THREADX */
+
 u32 osai_readl(void __iomem *addr)
 {
 	return *(volatile u32 *)(addr);
@@ -0,0 +1,136 @@
+/*
+ * OSAI implementation for ThreadX.
+ *
+ * It is kept apart from mhal_osai.c because the ThreadX basic types
+ * conflict with type_def.h, which mt3620.h pulls in. The SysTick
+ * registers are therefore accessed directly.
+ */
+
+#ifdef OSAI_THREADX
+
+#include "mhal_osai.h"
+#include "tx_api.h"
+
+#define OSAI_MS_PER_TICK	(1000 / TX_TIMER_TICKS_PER_SECOND)
+
+/* the host tests supply their own SysTick */
+#ifndef OSAI_SYST_RVR
+#define OSAI_SYST_RVR		((volatile u32 *)0xE000E014)
+#define OSAI_SYST_CVR		((volatile u32 *)0xE000E018)
+#endif
+
+_Static_assert(sizeof(TX_SEMAPHORE) <= sizeof(struct osai_completion),
+	       "struct osai_completion is too small for a TX_SEMAPHORE");
+
+/* Only threads can sleep, ISRs and tx_application_define() have to poll */
+static bool _osai_in_thread(void)
+{
+	return (__get_ipsr_value() == 0) &&
+	       (tx_thread_identify() != TX_NULL);
+}
+
+/* SysTick reloads once per ThreadX tick, so a busy wait may span several
+ * reloads and the count per microsecond follows from the tick rate.
+ */
+static void _osai_busy_wait_us(u32 us)
+{
+	u32 reload = *OSAI_SYST_RVR + 1;
+	u64 remain = (u64)us * reload * TX_TIMER_TICKS_PER_SECOND / 1000000;
+	u32 last = *OSAI_SYST_CVR;
+	u32 now;
+	u32 elapsed;
+
+	while (remain) {
+		now = *OSAI_SYST_CVR;
+		elapsed = (last >= now) ? (last - now) : (last + reload - now);
+		last = now;
+		if (elapsed >= remain)
+			break;
+		remain -= elapsed;
+	}
+}
+
+void osai_delay_us(u32 us)
+{
+	if (us >= 1000) {
+		osai_delay_ms(us / 1000);
+		us %= 1000;
+	}
+	_osai_busy_wait_us(us);
+}
+
+void osai_delay_ms(u32 ms)
+{
+	/* sub-tick delays can not be slept */
+	if ((ms < OSAI_MS_PER_TICK) || !_osai_in_thread()) {
+		while (ms--)
+			_osai_busy_wait_us(1000);
+		return;
+	}
+
+	/* the current tick is partly over, sleep one more to never return early */
+	tx_thread_sleep(ms / OSAI_MS_PER_TICK + 1);
+}
+
+int osai_init_completion(struct osai_completion *comp)
+{
+	TX_SEMAPHORE *sem = (TX_SEMAPHORE *)comp->sem;
+
+	/* drivers may be initialized again without deinit, reuse the
+	 * semaphore and drop any stale completion
+	 */
+	if (comp->created) {
+		while (tx_semaphore_get(sem, TX_NO_WAIT) == TX_SUCCESS)
+			;
+		return 0;
+	}
+
+	if (tx_semaphore_create(sem, "osai_completion", 0) != TX_SUCCESS)
+		return -1;
+	comp->created = true;
+
+	return 0;
+}
+
+void osai_deinit_completion(struct osai_completion *comp)
+{
+	TX_SEMAPHORE *sem = (TX_SEMAPHORE *)comp->sem;
+
+	if (comp->created) {
+		tx_semaphore_delete(sem);
+		comp->created = false;
+	}
+}
+
+void osai_complete(struct osai_completion *comp)
+{
+	tx_semaphore_put((TX_SEMAPHORE *)comp->sem);
+}
+
+int osai_wait_for_completion_timeout(struct osai_completion *comp,
+				     u32 time_ms)
+{
+	TX_SEMAPHORE *sem = (TX_SEMAPHORE *)comp->sem;
+	u64 remain_us = (u64)time_ms * 1000;
+
+	if (_osai_in_thread()) {
+		if (tx_semaphore_get(sem, (time_ms == OSAI_WAIT_FOREVER) ?
+				     TX_WAIT_FOREVER :
+				     (time_ms / OSAI_MS_PER_TICK + 1))
+		    != TX_SUCCESS)
+			return -1;
+		return 0;
+	}
+
+	while (tx_semaphore_get(sem, TX_NO_WAIT) != TX_SUCCESS) {
+		if (time_ms != OSAI_WAIT_FOREVER) {
+			if (remain_us < 10)
+				return -1;
+			remain_us -= 10;
+		}
+		_osai_busy_wait_us(10);
+	}
+
+	return 0;
+}
+#endif /* OSAI_THREADX */
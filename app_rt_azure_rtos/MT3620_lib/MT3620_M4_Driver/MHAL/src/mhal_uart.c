@@ -288,7 +288,8 @@ static void _mtk_mhal_uart_dma_rx_callback(void *data)
 
 	uart_debug("_mtk_mhal_uart_dma_rx_callback\n");
 
-	mtk_mhal_uart_stop_dma_rx(ctlr);
+	if (!mdata->rx_vff_continuous)
+		mtk_mhal_uart_stop_dma_rx(ctlr);
 	mdata->uart_rx_dma_callback(mdata->user_data);
 }
 
@@ -410,7 +411,8 @@ int mtk_mhal_uart_dma_rx_config(struct mtk_uart_controller *ctlr)
 		/** for Virtual FIFO DMA */
 		rx_config.interrupt_flag = OSAI_DMA_INT_VFIFO_THRESHOLD;
 		rx_config.vfifo_thrsh = ctlr->mdata->rx_len;
-		rx_config.vfifo_size = 0x4000;
+		rx_config.vfifo_size = ctlr->mdata->rx_vff_size ?
+				       ctlr->mdata->rx_vff_size : 0x4000;
 	} else {
 		/** for Half-size DMA */
 		rx_config.interrupt_flag = OSAI_DMA_INT_COMPLETION;
@@ -56,6 +56,33 @@ typedef enum {
 	OS_HAL_UART_MAX_PORT
 } UART_PORT;
 
+/** Asynchronous DMA transmissions a port can hold, one on the DMA and
+ * one waiting, so that the caller can fill a buffer while the other is
+ * being sent.
+ */
+#define OS_HAL_UART_DMA_TX_QUEUE_LEN	2
+
+/**
+ * @brief  Asynchronous UART DMA transmission done callback.
+ *  It is called in the DMA interrupt handler and must not block or print.
+ *  @param [in] user_data : The user_data given with the transmission.
+ *  @param [in] len : Number of bytes sent, or a negative error code if
+ *  the transmission could not be started or timed out.
+ *  @return None.
+ */
+typedef void (*uart_dma_tx_callback)(void *user_data, int len);
+
+/**
+ * @brief  Continuous UART DMA reception callback.
+ *  It is called in the DMA interrupt handler when the threshold given to
+ *  mtk_os_hal_uart_dma_rx_start() is reached, and must not block or
+ *  print. Data is taken with mtk_os_hal_uart_dma_rx_read().
+ *  @param [in] user_data : The user_data given to
+ *  mtk_os_hal_uart_dma_rx_start().
+ *  @return None.
+ */
+typedef void (*uart_dma_rx_callback)(void *user_data);
+
 /**
  * @brief  Init UART controller.
  *
@@ -214,6 +241,7 @@ void mtk_os_hal_uart_set_irq(UART_PORT port_num, u8 irq_flag);
  *  @param [in] len : Data length.
  *  @param [in] vff_mode : true: VFF Mode; false: Half-Size Mode.
  *
+ *  @return -UART_EBUSY if asynchronous transmissions are pending.
  *  @return Number of bytes have been send.
  */
 int mtk_os_hal_uart_dma_send_data(UART_PORT port_num,
@@ -233,4 +261,64 @@ int mtk_os_hal_uart_dma_send_data(UART_PORT port_num,
 int mtk_os_hal_uart_dma_get_data(UART_PORT port_num,
 	u8 *data, u32 len, bool vff_mode);
 
+/**
+ * @brief  Queue UART data to send in DMA mode and return immediately.
+ *  The data must stay valid until callback is called.
+ *  @param [in] bus_num : UART Port number,
+ *  it can be OS_HAL_UART_ISU0~OS_HAL_UART_ISU4.
+ *  @param [in] data : Pointer to the data.
+ *  @param [in] len : Data length, less than 0x4000.
+ *  @param [in] vff_mode : true: VFF Mode; false: Half-Size Mode.
+ *  @param [in] callback : Called in interrupt context when the data is
+ *  sent, can be NULL.
+ *  @param [in] user_data : Passed to callback.
+ *  The TX channel stays allocated after the queue empties, until a
+ *  transmission in the other vff_mode or mtk_os_hal_uart_ctlr_deinit().
+ *  @return -UART_EBUSY if OS_HAL_UART_DMA_TX_QUEUE_LEN transmissions
+ *  are pending, or pending ones use the other vff_mode.
+ *  @return 0 means success.
+ */
+int mtk_os_hal_uart_dma_send_data_async(UART_PORT port_num,
+	u8 *data, u32 len, bool vff_mode,
+	uart_dma_tx_callback callback, void *user_data);
+
+/**
+ * @brief  Start continuous UART reception into a VFF DMA ring.
+ *  The DMA keeps receiving into ring until mtk_os_hal_uart_dma_rx_stop()
+ *  is called. Data which is not read in time is dropped by the hardware.
+ *  mtk_os_hal_uart_dma_get_data() is not available meanwhile.
+ *  @param [in] bus_num : UART Port number,
+ *  it can be OS_HAL_UART_ISU0~OS_HAL_UART_ISU4.
+ *  @param [in] ring : The ring buffer, 4-byte aligned.
+ *  @param [in] size : Size of ring, at most 0x4000.
+ *  @param [in] threshold : Number of received bytes which triggers
+ *  callback, at most size.
+ *  @param [in] callback : Called in interrupt context, can be NULL to
+ *  poll with mtk_os_hal_uart_dma_rx_read().
+ *  @param [in] user_data : Passed to callback.
+ *  @return -UART_EBUSY if reception is already running.
+ *  @return 0 means success.
+ */
+int mtk_os_hal_uart_dma_rx_start(UART_PORT port_num,
+	u8 *ring, u32 size, u32 threshold,
+	uart_dma_rx_callback callback, void *user_data);
+
+/**
+ * @brief  Take received data from the continuous reception ring.
+ *  @param [in] bus_num : UART Port number,
+ *  it can be OS_HAL_UART_ISU0~OS_HAL_UART_ISU4.
+ *  @param [in] data : Pointer to the data.
+ *  @param [in] len : Size of data.
+ *  @return Number of bytes copied to data, 0 if none was received.
+ */
+int mtk_os_hal_uart_dma_rx_read(UART_PORT port_num, u8 *data, u32 len);
+
+/**
+ * @brief  Stop continuous UART reception.
+ *  @param [in] bus_num : UART Port number,
+ *  it can be OS_HAL_UART_ISU0~OS_HAL_UART_ISU4.
+ *  @return 0 means success.
+ */
+int mtk_os_hal_uart_dma_rx_stop(UART_PORT port_num);
+
 #endif
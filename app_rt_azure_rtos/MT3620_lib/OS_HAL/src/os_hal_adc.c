@@ -43,7 +43,7 @@
 struct mtk_adc_controller_rtos {
 	struct mtk_adc_controller *ctlr;
 	/* the type based on OS */
-	volatile u8 rx_completion;
+	struct osai_completion rx_completion;
 };
 static struct adc_fsm_param adc_fsm_parameter;
 
@@ -97,17 +97,15 @@ static int _mtk_os_hal_adc_wait_for_completion_timeout(
 				struct mtk_adc_controller_rtos
 				*ctlr_rtos, int time_ms)
 {
-	while(ctlr_rtos->rx_completion==0){}
-	ctlr_rtos->rx_completion--;
-
-	return 0;
+	return osai_wait_for_completion_timeout(&ctlr_rtos->rx_completion,
+						time_ms);
 }
 
 static int _mtk_os_hal_adc_rx_done_callback(void *data)
 {
 	struct mtk_adc_controller_rtos *ctlr_rtos = data;
 
-	ctlr_rtos->rx_completion++;
+	osai_complete(&ctlr_rtos->rx_completion);
 
 	return 0;
 }
@@ -178,7 +176,9 @@ int mtk_os_hal_adc_ctlr_init(adc_pmode pmode, adc_fifo_mode fifo_mode,
 			return ret;
 	}
 
-	ctlr_rtos->rx_completion = 1;
+	if (osai_init_completion(&ctlr_rtos->rx_completion))
+		return -ADC_EPTR;
+	osai_complete(&ctlr_rtos->rx_completion);
 
 	ret = mtk_mhal_adc_rx_notify_callback_register(ctlr,
 					 _mtk_os_hal_adc_rx_done_callback,
@@ -243,6 +243,8 @@ int mtk_os_hal_adc_ctlr_deinit(void)
 	if (ret)
 		return ret;
 
+	osai_deinit_completion(&ctlr_rtos->rx_completion);
+
 	return 0;
 }
 
@@ -81,7 +81,7 @@ struct mtk_i2c_ctrl_rtos {
 	struct mtk_i2c_controller *i2c;
 
 	/* the type based on OS */
-	volatile u8 xfer_completion;
+	struct osai_completion xfer_completion;
 };
 
 static struct mtk_i2c_ctrl_rtos g_i2c_ctrl_rtos[OS_HAL_I2C_ISU_MAX];
@@ -99,9 +99,8 @@ static void _mtk_os_hal_i2c_irq_handler(int bus_num)
 	/* 1. FIFO mode: return completion done in I2C irq handler
 	 * 2. DMA mode: return completion done in DMA irq handler
 	 */
-	if (!ret) {
-		ctrl_rtos->xfer_completion++;
-	}
+	if (!ret)
+		osai_complete(&ctrl_rtos->xfer_completion);
 }
 
 static void _mtk_os_hal_i2c0_irq_event(void)
@@ -185,16 +184,16 @@ static int _mtk_os_hal_i2c_dma_done_callback(void *data)
 {
 	struct mtk_i2c_ctrl_rtos *ctrl_rtos = data;
 
-	ctrl_rtos->xfer_completion++;
+	/* while using DMA mode, complete the transfer in this callback */
+	osai_complete(&ctrl_rtos->xfer_completion);
 	return 0;
 }
 
 static int _mtk_os_hal_i2c_wait_for_completion_timeout(
 	struct mtk_i2c_ctrl_rtos *ctrl_rtos, int time_ms)
 {
-	while(ctrl_rtos->xfer_completion==0){}
-	ctrl_rtos->xfer_completion--;
-	return 0;
+	return osai_wait_for_completion_timeout(&ctrl_rtos->xfer_completion,
+						time_ms);
 }
 
 int _mtk_os_hal_i2c_transfer(struct mtk_i2c_ctrl_rtos *ctrl_rtos, int bus_num)
@@ -221,6 +220,10 @@ int _mtk_os_hal_i2c_transfer(struct mtk_i2c_ctrl_rtos *ctrl_rtos, int bus_num)
 	if (ret) {
 		mtk_mhal_i2c_dump_register(i2c);
 		mtk_mhal_i2c_init_hw(i2c);
+		/* drop a completion which arrived after the timeout, so that
+		 * it is not taken for the next transfer
+		 */
+		osai_init_completion(&ctrl_rtos->xfer_completion);
 	}
 
 err_exit:
@@ -251,8 +254,8 @@ int mtk_os_hal_i2c_ctrl_init(i2c_num bus_num)
 					     (void *)ctrl_rtos);
 
 	ctrl_rtos->i2c = i2c;
-	ctrl_rtos->xfer_completion = 0;
-
+	if (osai_init_completion(&ctrl_rtos->xfer_completion))
+		return -I2C_EPTR;
 
 	ret = mtk_mhal_i2c_request_dma(i2c);
 	if (ret < 0) {
@@ -286,6 +289,7 @@ int mtk_os_hal_i2c_ctrl_deinit(i2c_num bus_num)
 	_mtk_os_hal_i2c_free_irq(bus_num);
 	mtk_mhal_i2c_release_dma(i2c);
 	mtk_mhal_i2c_disable_clk(i2c);
+	osai_deinit_completion(&ctrl_rtos->xfer_completion);
 
 	i2c = NULL;
 	ctrl_rtos->i2c = i2c;
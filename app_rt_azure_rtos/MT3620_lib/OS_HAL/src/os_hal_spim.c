@@ -82,7 +82,7 @@ struct mtk_spi_controller_rtos {
 	struct mtk_spi_controller *ctlr;
 
 	/* the type based on OS */
-	volatile u8 xfer_completion;
+	struct osai_completion xfer_completion;
 
 	/* used for async API */
 	spi_usr_complete_callback complete;
@@ -159,7 +159,7 @@ static int _mtk_os_hal_spim_irq_handler(spim_num bus_num)
 			mtk_mhal_spim_disable_clk(ctlr_rtos->ctlr);
 		} else {
 			/* sync xfer */
-			ctlr_rtos->xfer_completion++;
+			osai_complete(&ctlr_rtos->xfer_completion);
 		}
 	}
 
@@ -256,7 +256,7 @@ static int _mtk_os_hal_spim_dma_done_callback(void *data)
 		/* while using DMA mode to do sync xfer,
 		 * release semaphore in this callback
 		 */
-		ctlr_rtos->xfer_completion++;
+		osai_complete(&ctlr_rtos->xfer_completion);
 	}
 
 	return 0;
@@ -271,6 +271,8 @@ int mtk_os_hal_spim_ctlr_init(spim_num bus_num)
 	if (!ctlr_rtos)
 		return -1;
 
+	/* the completion may still be registered with the OS */
+	osai_deinit_completion(&ctlr_rtos->xfer_completion);
 	memset(ctlr_rtos, 0, sizeof(struct mtk_spi_controller_rtos));
 
 	/* Must init first here  */
@@ -287,7 +289,8 @@ int mtk_os_hal_spim_ctlr_init(spim_num bus_num)
 	ctlr->dma_tx_chan = spim_dma_chan[bus_num][0];
 	ctlr->dma_rx_chan = spim_dma_chan[bus_num][1];
 
-	ctlr_rtos->xfer_completion = 0;
+	if (osai_init_completion(&ctlr_rtos->xfer_completion))
+		return -1;
 
 	mtk_mhal_spim_dma_done_callback_register(ctlr,
 					 _mtk_os_hal_spim_dma_done_callback,
@@ -313,6 +316,7 @@ int mtk_os_hal_spim_ctlr_deinit(spim_num bus_num)
 
 	_mtk_os_hal_spim_free_irq(bus_num);
 	mtk_mhal_spim_release_dma_chan(ctlr);
+	osai_deinit_completion(&ctlr_rtos->xfer_completion);
 
 	ctlr_rtos->ctlr = NULL;
 
@@ -323,9 +327,8 @@ static int _mtk_os_hal_spim_wait_for_completion_timeout(
 				struct mtk_spi_controller_rtos
 				*ctlr_rtos, int time_ms)
 {
-	while(ctlr_rtos->xfer_completion == 0) {}
-	ctlr_rtos->xfer_completion--;
-	return 0;
+	return osai_wait_for_completion_timeout(&ctlr_rtos->xfer_completion,
+						time_ms);
 }
 
 int mtk_os_hal_spim_transfer(spim_num bus_num,
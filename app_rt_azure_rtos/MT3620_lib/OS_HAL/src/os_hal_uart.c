@@ -33,6 +33,7 @@
  * MEDIATEK SOFTWARE AT ISSUE.
  */
 
+#include "nvic.h"
 #include "os_hal_uart.h"
 #include "os_hal_dma.h"
 
@@ -87,6 +88,17 @@ static u8 uart_vff_dma_chan[OS_HAL_UART_MAX_PORT-1][2] = {
 };
 
 
+/**
+ * an asynchronous DMA transmission
+ */
+struct mtk_uart_dma_tx_req {
+	u8 *data;
+	u32 len;
+	bool vff_mode;
+	uart_dma_tx_callback callback;
+	void *user_data;
+};
+
 /**
  * this os special UART structure, need mapping it to mtk_uart_controller
  */
@@ -94,8 +106,22 @@ struct mtk_uart_controller_rtos {
 	struct mtk_uart_controller *ctlr;
 
 	/* the type based on OS */
-	volatile u8 xTX_Queue;
-	volatile u8 xRX_Queue;
+	struct osai_completion tx_completion;
+	struct osai_completion rx_completion;
+	int tx_done_size;
+
+	/* tx_queue[tx_head] is on the DMA while tx_count is not 0 */
+	struct mtk_uart_dma_tx_req tx_queue[OS_HAL_UART_DMA_TX_QUEUE_LEN];
+	volatile u8 tx_head;
+	volatile u8 tx_count;
+	/* the TX channel of tx_vff_mode stays allocated between transmissions */
+	bool tx_vff_mode;
+	bool tx_chan_allocated;
+
+	/* continuous VFF reception */
+	volatile bool rx_running;
+	uart_dma_rx_callback rx_callback;
+	void *rx_user_data;
 };
 
 static struct mtk_uart_private
@@ -105,6 +131,8 @@ static struct mtk_uart_controller
 static struct mtk_uart_controller_rtos
 	g_uart_ctlr_rtos[OS_HAL_UART_MAX_PORT];
 
+static void _mtk_os_hal_uart_dma_release_tx(UART_PORT port_num);
+
 static struct mtk_uart_controller_rtos
 	*_mtk_os_hal_uart_get_ctlr(UART_PORT port_num)
 {
@@ -141,6 +169,15 @@ int mtk_os_hal_uart_ctlr_init(UART_PORT port_num)
 
 	mtk_mhal_uart_hw_init(ctlr_rtos->ctlr);
 
+	ctlr_rtos->tx_head = 0;
+	ctlr_rtos->tx_count = 0;
+	ctlr_rtos->tx_chan_allocated = false;
+	ctlr_rtos->rx_running = false;
+
+	if (osai_init_completion(&ctlr_rtos->tx_completion) ||
+	    osai_init_completion(&ctlr_rtos->rx_completion))
+		return -UART_EPTR;
+
 	return 0;
 }
 
@@ -152,8 +189,13 @@ int mtk_os_hal_uart_ctlr_deinit(UART_PORT port_num)
 	if (!ctlr_rtos)
 		return -UART_EPTR;
 
+	mtk_os_hal_uart_dma_rx_stop(port_num);
+	_mtk_os_hal_uart_dma_release_tx(port_num);
 	mtk_mhal_uart_disable_clk(ctlr_rtos->ctlr);
 
+	osai_deinit_completion(&ctlr_rtos->tx_completion);
+	osai_deinit_completion(&ctlr_rtos->rx_completion);
+
 	return 0;
 }
 
@@ -293,12 +335,166 @@ void mtk_os_hal_uart_set_sw_fc(UART_PORT port_num,
 		xon2, xoff2, escape_data);
 }
 
+
+static u32 _mtk_os_hal_uart_irq_save(void)
+{
+	u32 primask = __get_PRIMASK();
+
+	__disable_irq();
+	return primask;
+}
+
+static void _mtk_os_hal_uart_irq_restore(u32 primask)
+{
+	__set_PRIMASK(primask);
+}
+
+/* the UART DMA enable is shared by TX and RX */
+static void _mtk_os_hal_uart_dma_disable_if_idle(
+				struct mtk_uart_controller_rtos *ctlr_rtos)
+{
+	if (!ctlr_rtos->tx_count && !ctlr_rtos->rx_running)
+		mtk_mhal_uart_set_dma(ctlr_rtos->ctlr, false);
+}
+
+static struct mtk_uart_controller_rtos
+	*_mtk_os_hal_uart_get_dma_ctlr(UART_PORT port_num)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_ctlr(port_num);
+
+	/* the CM4 UART has no DMA channel */
+	if (!ctlr_rtos || port_num == OS_HAL_UART_PORT0 || !ctlr_rtos->ctlr)
+		return NULL;
+
+	return ctlr_rtos;
+}
+
+/* program tx_queue[tx_head] on the allocated TX channel and start it,
+ * called with interrupts disabled, also from the DMA interrupt
+ */
+static int _mtk_os_hal_uart_dma_program_tx(
+				struct mtk_uart_controller_rtos *ctlr_rtos)
+{
+	struct mtk_uart_controller *ctlr = ctlr_rtos->ctlr;
+	struct mtk_uart_dma_tx_req *req =
+		&ctlr_rtos->tx_queue[ctlr_rtos->tx_head];
+	int ret;
+
+	ctlr->vff_dma_mode = ctlr_rtos->tx_vff_mode;
+	ctlr->mdata->tx_len = req->len;
+	ctlr->mdata->tx_buf = req->data;
+	ctlr->mdata->tx_size = 0;
+
+	ret = mtk_mhal_uart_dma_tx_config(ctlr);
+	if (!ret)
+		ret = mtk_mhal_uart_start_dma_tx(ctlr);
+
+	return ret;
+}
+
+/* release the idle TX channel, called with interrupts disabled from
+ * thread context only: releasing a channel turns its clock off and clears
+ * its interrupt callback, which the DMA interrupt handler still uses
+ * after our callback has returned.
+ */
+static void _mtk_os_hal_uart_dma_release_tx_chan(
+				struct mtk_uart_controller_rtos *ctlr_rtos)
+{
+	struct mtk_uart_controller *ctlr = ctlr_rtos->ctlr;
+
+	if (!ctlr_rtos->tx_chan_allocated)
+		return;
+
+	ctlr->vff_dma_mode = ctlr_rtos->tx_vff_mode;
+	mtk_mhal_uart_release_dma_tx_ch(ctlr);
+	ctlr_rtos->tx_chan_allocated = false;
+}
+
+/* start tx_queue[tx_head] on the TX channel of its mode, called with
+ * interrupts disabled from thread context only: allocating a channel
+ * installs the DMA interrupt. The channel stays allocated once the queue
+ * is empty, so that neither the interrupt nor the next transmission in
+ * the same mode has to allocate it again.
+ */
+static int _mtk_os_hal_uart_dma_start_tx(
+				struct mtk_uart_controller_rtos *ctlr_rtos)
+{
+	struct mtk_uart_controller *ctlr = ctlr_rtos->ctlr;
+	struct mtk_uart_dma_tx_req *req =
+		&ctlr_rtos->tx_queue[ctlr_rtos->tx_head];
+	int ret;
+
+	if (ctlr_rtos->tx_chan_allocated &&
+	    ctlr_rtos->tx_vff_mode != req->vff_mode)
+		_mtk_os_hal_uart_dma_release_tx_chan(ctlr_rtos);
+
+	mtk_mhal_uart_set_dma(ctlr, true);
+
+	if (!ctlr_rtos->tx_chan_allocated) {
+		ctlr_rtos->tx_vff_mode = req->vff_mode;
+		ctlr->vff_dma_mode = req->vff_mode;
+		if (req->vff_mode)
+			ctlr->mdata->dma_tx_ch =
+				uart_vff_dma_chan[ctlr->port_num-1][0];
+		else
+			ctlr->mdata->dma_tx_ch =
+				uart_half_dma_chan[ctlr->port_num-1][0];
+
+		ret = mtk_mhal_uart_allocate_dma_tx_ch(ctlr);
+		if (ret)
+			return ret;
+		ctlr_rtos->tx_chan_allocated = true;
+	}
+
+	return _mtk_os_hal_uart_dma_program_tx(ctlr_rtos);
+}
+
+/* pop tx_queue[tx_head] and report len to its callback, after the next
+ * transmission is started on the same channel to keep the line busy.
+ * Called from the DMA interrupt, so the channel is not released here.
+ */
+static void _mtk_os_hal_uart_dma_tx_complete(
+				struct mtk_uart_controller_rtos *ctlr_rtos,
+				int len)
+{
+	struct mtk_uart_dma_tx_req done;
+	int ret;
+
+	do {
+		done = ctlr_rtos->tx_queue[ctlr_rtos->tx_head];
+		ctlr_rtos->tx_head = (ctlr_rtos->tx_head + 1) %
+				     OS_HAL_UART_DMA_TX_QUEUE_LEN;
+		ctlr_rtos->tx_count--;
+
+		ret = 0;
+		if (ctlr_rtos->tx_count)
+			ret = _mtk_os_hal_uart_dma_program_tx(ctlr_rtos);
+		else
+			_mtk_os_hal_uart_dma_disable_if_idle(ctlr_rtos);
+
+		if (done.callback)
+			done.callback(done.user_data, len);
+
+		/* the next one failed to start, report it as well */
+		len = ret;
+	} while (ret);
+}
+
 static int _mtk_os_hal_uart_dma_tx_callback(void *data)
 {
 	struct mtk_uart_controller_rtos *ctlr_rtos = data;
+	struct mtk_uart_controller *ctlr = ctlr_rtos->ctlr;
+
+	/* the transmission was aborted before its interrupt was taken */
+	if (!ctlr_rtos->tx_count)
+		return 0;
+
+	ctlr->vff_dma_mode = ctlr_rtos->tx_vff_mode;
+	mtk_mhal_uart_update_dma_tx_info(ctlr);
+
+	_mtk_os_hal_uart_dma_tx_complete(ctlr_rtos, ctlr->mdata->tx_size);
 
-	ctlr_rtos->xTX_Queue++;
-	printf("_mtk_os_hal_uart_dma_tx_callback\r\n");
 	return 0;
 }
 
@@ -306,116 +502,201 @@ static int _mtk_os_hal_uart_dma_rx_callback(void *data)
 {
 	struct mtk_uart_controller_rtos *ctlr_rtos = data;
 
-	ctlr_rtos->xRX_Queue++;
-	printf("_mtk_os_hal_uart_dma_rx_callback\r\n");
+	if (ctlr_rtos->rx_running) {
+		if (ctlr_rtos->rx_callback)
+			ctlr_rtos->rx_callback(ctlr_rtos->rx_user_data);
+	} else
+		osai_complete(&ctlr_rtos->rx_completion);
+
 	return 0;
 }
 
-static int _mtk_os_hal_uart_wait_for_tx_done(
-				struct mtk_uart_controller_rtos
-				*ctlr_rtos, int time_ms)
+static void _mtk_os_hal_uart_dma_tx_sync_done(void *user_data, int len)
 {
-	while(ctlr_rtos->xTX_Queue==0){}
-	ctlr_rtos->xTX_Queue--;
-	return 0;
+	struct mtk_uart_controller_rtos *ctlr_rtos = user_data;
+
+	ctlr_rtos->tx_done_size = len;
+	osai_complete(&ctlr_rtos->tx_completion);
 }
 
-static int _mtk_os_hal_uart_wait_for_rx_done(
-				struct mtk_uart_controller_rtos
-				*ctlr_rtos, int time_ms)
+/* stop the running transmission and fail the queued ones, the channel
+ * stays allocated
+ */
+static void _mtk_os_hal_uart_dma_tx_abort(
+				struct mtk_uart_controller_rtos *ctlr_rtos)
 {
-	while(ctlr_rtos->xRX_Queue==0){}
-	ctlr_rtos->xRX_Queue--;
-	return 0;
+	struct mtk_uart_controller *ctlr = ctlr_rtos->ctlr;
+	struct mtk_uart_dma_tx_req *req;
+	u32 primask;
+	int len;
+
+	primask = _mtk_os_hal_uart_irq_save();
+
+	if (ctlr_rtos->tx_count) {
+		ctlr->vff_dma_mode = ctlr_rtos->tx_vff_mode;
+		mtk_mhal_uart_stop_dma_tx(ctlr);
+		mtk_mhal_uart_update_dma_tx_info(ctlr);
+		len = ctlr->mdata->tx_size;
+
+		/* only one is on the DMA, fail the rest without starting */
+		while (ctlr_rtos->tx_count > 1) {
+			ctlr_rtos->tx_count--;
+			req = &ctlr_rtos->tx_queue[(ctlr_rtos->tx_head +
+						    ctlr_rtos->tx_count) %
+						   OS_HAL_UART_DMA_TX_QUEUE_LEN];
+
+			if (req->callback)
+				req->callback(req->user_data,
+					      -UART_ETIMEDOUT);
+		}
+		_mtk_os_hal_uart_dma_tx_complete(ctlr_rtos, len);
+	}
+
+	_mtk_os_hal_uart_irq_restore(primask);
 }
 
-int mtk_os_hal_uart_dma_send_data(UART_PORT port_num,
-	u8 *data, u32 len, bool vff_mode)
+/* release the TX channel once nothing is queued, for ctlr_deinit */
+static void _mtk_os_hal_uart_dma_release_tx(UART_PORT port_num)
 {
 	struct mtk_uart_controller_rtos *ctlr_rtos =
-		_mtk_os_hal_uart_get_ctlr(port_num);
-	struct mtk_uart_controller *ctlr;
-	int ret, cnt;
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
+	u32 primask;
 
 	if (!ctlr_rtos)
-		return -UART_EPTR;
+		return;
 
-	ctlr = ctlr_rtos->ctlr;
-	if (!ctlr)
-		return -UART_EPTR;
+	_mtk_os_hal_uart_dma_tx_abort(ctlr_rtos);
 
-	if (len >= 0x4000) {
-		printf("DMA max transfter size is 0x4000\n");
-		return -UART_EINVAL;
-	}
+	primask = _mtk_os_hal_uart_irq_save();
+	_mtk_os_hal_uart_dma_release_tx_chan(ctlr_rtos);
+	_mtk_os_hal_uart_irq_restore(primask);
+}
 
-	ctlr_rtos->xTX_Queue = 0;
+/* queue a transmission, or fail with -UART_EBUSY if alone is set and
+ * others are pending
+ */
+static int _mtk_os_hal_uart_dma_queue_tx(
+	struct mtk_uart_controller_rtos *ctlr_rtos,
+	u8 *data, u32 len, bool vff_mode, bool alone,
+	uart_dma_tx_callback callback, void *user_data)
+{
+	struct mtk_uart_dma_tx_req *req;
+	u32 primask;
+	int ret = 0;
 
-	mtk_mhal_uart_dma_tx_callback_register(ctlr,
+	if (!data || !len || len >= 0x4000)
+		return -UART_EINVAL;
+
+	mtk_mhal_uart_dma_tx_callback_register(ctlr_rtos->ctlr,
 				_mtk_os_hal_uart_dma_tx_callback,
 				(void *)ctlr_rtos);
 
-	mtk_mhal_uart_set_dma(ctlr, true);
+	primask = _mtk_os_hal_uart_irq_save();
 
-	ctlr->vff_dma_mode = vff_mode;
-	if (vff_mode)
-		ctlr->mdata->dma_tx_ch = uart_vff_dma_chan[port_num-1][0];
-	else
-		ctlr->mdata->dma_tx_ch = uart_half_dma_chan[port_num-1][0];
+	/* the interrupt cannot switch to the other mode's channel */
+	if (ctlr_rtos->tx_count == OS_HAL_UART_DMA_TX_QUEUE_LEN ||
+	    (ctlr_rtos->tx_count &&
+	     (alone || ctlr_rtos->tx_vff_mode != vff_mode))) {
+		_mtk_os_hal_uart_irq_restore(primask);
+		return -UART_EBUSY;
+	}
 
-	ctlr->mdata->tx_len = len;
-	ctlr->mdata->tx_buf = data;
-	ctlr->mdata->tx_size = 0;
+	req = &ctlr_rtos->tx_queue[(ctlr_rtos->tx_head + ctlr_rtos->tx_count) %
+				   OS_HAL_UART_DMA_TX_QUEUE_LEN];
+	req->data = data;
+	req->len = len;
+	req->vff_mode = vff_mode;
+	req->callback = callback;
+	req->user_data = user_data;
+
+	if (++ctlr_rtos->tx_count == 1) {
+		ret = _mtk_os_hal_uart_dma_start_tx(ctlr_rtos);
+		if (ret) {
+			ctlr_rtos->tx_count--;
+			_mtk_os_hal_uart_dma_disable_if_idle(ctlr_rtos);
+		}
+	}
 
-	mtk_mhal_uart_allocate_dma_tx_ch(ctlr);
-	mtk_mhal_uart_dma_tx_config(ctlr);
-	mtk_mhal_uart_start_dma_tx(ctlr);
+	_mtk_os_hal_uart_irq_restore(primask);
 
-	cnt = len / (ctlr->baudrate / 10) + 1000;
-	printf("UART TX DMA Len:%d, timeout:%dms\n", len, cnt);
+	return ret;
+}
 
-	ret = _mtk_os_hal_uart_wait_for_tx_done(ctlr_rtos, cnt);
-	if (ret) {
-		printf("Take UART TX Semaphore timeout!\n");
-		mtk_mhal_uart_stop_dma_tx(ctlr);
-	}
+int mtk_os_hal_uart_dma_send_data_async(UART_PORT port_num,
+	u8 *data, u32 len, bool vff_mode,
+	uart_dma_tx_callback callback, void *user_data)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
 
-	mtk_mhal_uart_update_dma_tx_info(ctlr);
-	mtk_mhal_uart_release_dma_tx_ch(ctlr);
+	if (!ctlr_rtos)
+		return -UART_EPTR;
+
+	return _mtk_os_hal_uart_dma_queue_tx(ctlr_rtos, data, len, vff_mode,
+					     false, callback, user_data);
+}
+
+int mtk_os_hal_uart_dma_send_data(UART_PORT port_num,
+	u8 *data, u32 len, bool vff_mode)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
+	int ret, cnt;
+
+	if (!ctlr_rtos)
+		return -UART_EPTR;
+
+	/* the timeout below only covers this transmission, so it must not
+	 * wait behind others
+	 */
+	ret = _mtk_os_hal_uart_dma_queue_tx(ctlr_rtos, data, len, vff_mode,
+			true, _mtk_os_hal_uart_dma_tx_sync_done,
+			(void *)ctlr_rtos);
+	if (ret)
+		return ret;
 
-	mtk_mhal_uart_set_dma(ctlr, false);
+	/* 10 bits per byte on the line, plus margin */
+	cnt = len * 10000 / ctlr_rtos->ctlr->baudrate + 1000;
 
-	printf("tx_size: %d\n", ctlr->mdata->tx_size);
+	ret = osai_wait_for_completion_timeout(&ctlr_rtos->tx_completion, cnt);
+	if (ret) {
+		printf("Take UART TX Semaphore timeout!\n");
+		_mtk_os_hal_uart_dma_tx_abort(ctlr_rtos);
+		/* drop the completion of the aborted transmission */
+		osai_init_completion(&ctlr_rtos->tx_completion);
+	}
 
-	return ctlr->mdata->tx_size;
+	return ctlr_rtos->tx_done_size;
 }
 
 int mtk_os_hal_uart_dma_get_data(UART_PORT port_num,
 	u8 *data, u32 len, bool vff_mode)
 {
 	struct mtk_uart_controller_rtos *ctlr_rtos =
-		_mtk_os_hal_uart_get_ctlr(port_num);
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
 	struct mtk_uart_controller *ctlr;
+	u32 primask;
 	int ret, cnt;
 
 	if (!ctlr_rtos)
 		return -UART_EPTR;
 
 	ctlr = ctlr_rtos->ctlr;
-	if (!ctlr)
-		return -UART_EPTR;
 
 	if (len >= 0x4000) {
 		printf("DMA max transfter size is 0x4000\n");
 		return -UART_EINVAL;
 	}
 
-	ctlr_rtos->xRX_Queue = 0;
+	if (ctlr_rtos->rx_running)
+		return -UART_EBUSY;
 
 	mtk_mhal_uart_dma_rx_callback_register(ctlr,
 				_mtk_os_hal_uart_dma_rx_callback,
 				(void *)ctlr_rtos);
 
+	primask = _mtk_os_hal_uart_irq_save();
+
 	mtk_mhal_uart_set_dma(ctlr, true);
 
 	ctlr->vff_dma_mode = vff_mode;
@@ -427,27 +708,145 @@ int mtk_os_hal_uart_dma_get_data(UART_PORT port_num,
 	ctlr->mdata->rx_len = len;
 	ctlr->mdata->rx_buf = data;
 	ctlr->mdata->rx_size = 0;
+	ctlr->mdata->rx_vff_size = 0;
+	ctlr->mdata->rx_vff_continuous = false;
 
 	mtk_mhal_uart_allocate_dma_rx_ch(ctlr);
 	mtk_mhal_uart_dma_rx_config(ctlr);
 	mtk_mhal_uart_start_dma_rx(ctlr);
 
-	cnt = len / (ctlr->baudrate / 10) + 5000;
-	printf("UART RX DMA Len:%d, timeout:%dms\n", len, cnt);
+	_mtk_os_hal_uart_irq_restore(primask);
 
-	ret = _mtk_os_hal_uart_wait_for_rx_done(ctlr_rtos, cnt);
-	if (ret) {
+	/* 10 bits per byte on the line, plus margin */
+	cnt = len * 10000 / ctlr->baudrate + 5000;
+
+	ret = osai_wait_for_completion_timeout(&ctlr_rtos->rx_completion, cnt);
+	if (ret)
 		printf("Take UART RX Semaphore timeout!\n");
-		mtk_mhal_uart_stop_dma_rx(ctlr);
-	}
 
+	primask = _mtk_os_hal_uart_irq_save();
+
+	mtk_mhal_uart_stop_dma_rx(ctlr);
+	ctlr->vff_dma_mode = vff_mode;
 	mtk_mhal_uart_update_dma_rx_info(ctlr);
 	mtk_mhal_uart_release_dma_rx_ch(ctlr);
 
-	mtk_mhal_uart_set_dma(ctlr, false);
+	_mtk_os_hal_uart_dma_disable_if_idle(ctlr_rtos);
+
+	_mtk_os_hal_uart_irq_restore(primask);
 
-	printf("rx_size: %d!\n", ctlr->mdata->rx_size);
+	if (ret)
+		osai_init_completion(&ctlr_rtos->rx_completion);
 
 	return ctlr->mdata->rx_size;
 }
 
+int mtk_os_hal_uart_dma_rx_start(UART_PORT port_num,
+	u8 *ring, u32 size, u32 threshold,
+	uart_dma_rx_callback callback, void *user_data)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
+	struct mtk_uart_controller *ctlr;
+	u32 primask;
+	int ret;
+
+	if (!ctlr_rtos)
+		return -UART_EPTR;
+
+	if (!ring || !size || size > 0x4000 || !threshold || threshold > size)
+		return -UART_EINVAL;
+
+	if (ctlr_rtos->rx_running)
+		return -UART_EBUSY;
+
+	ctlr = ctlr_rtos->ctlr;
+	ctlr_rtos->rx_callback = callback;
+	ctlr_rtos->rx_user_data = user_data;
+
+	mtk_mhal_uart_dma_rx_callback_register(ctlr,
+				_mtk_os_hal_uart_dma_rx_callback,
+				(void *)ctlr_rtos);
+
+	primask = _mtk_os_hal_uart_irq_save();
+
+	mtk_mhal_uart_set_dma(ctlr, true);
+
+	ctlr->vff_dma_mode = true;
+	ctlr->mdata->dma_rx_ch = uart_vff_dma_chan[port_num-1][1];
+	ctlr->mdata->rx_len = threshold;
+	ctlr->mdata->rx_buf = ring;
+	ctlr->mdata->rx_size = 0;
+	ctlr->mdata->rx_vff_size = size;
+	ctlr->mdata->rx_vff_continuous = true;
+	ctlr_rtos->rx_running = true;
+
+	ret = mtk_mhal_uart_allocate_dma_rx_ch(ctlr);
+	if (!ret) {
+		ret = mtk_mhal_uart_dma_rx_config(ctlr);
+		if (!ret)
+			ret = mtk_mhal_uart_start_dma_rx(ctlr);
+		if (ret)
+			mtk_mhal_uart_release_dma_rx_ch(ctlr);
+	}
+
+	if (ret) {
+		ctlr->mdata->rx_vff_continuous = false;
+		ctlr_rtos->rx_running = false;
+		_mtk_os_hal_uart_dma_disable_if_idle(ctlr_rtos);
+	}
+
+	_mtk_os_hal_uart_irq_restore(primask);
+
+	return ret;
+}
+
+int mtk_os_hal_uart_dma_rx_read(UART_PORT port_num, u8 *data, u32 len)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
+	int ret;
+
+	if (!ctlr_rtos)
+		return -UART_EPTR;
+
+	if (!ctlr_rtos->rx_running || !data || !len)
+		return -UART_EINVAL;
+
+	ret = osai_dma_vff_read_data(ctlr_rtos->ctlr->mdata->dma_rx_ch,
+				     data, len);
+	if (ret < 0)
+		return -UART_ENXIO;
+
+	return ret;
+}
+
+int mtk_os_hal_uart_dma_rx_stop(UART_PORT port_num)
+{
+	struct mtk_uart_controller_rtos *ctlr_rtos =
+		_mtk_os_hal_uart_get_dma_ctlr(port_num);
+	struct mtk_uart_controller *ctlr;
+	u32 primask;
+
+	if (!ctlr_rtos)
+		return -UART_EPTR;
+
+	if (!ctlr_rtos->rx_running)
+		return 0;
+
+	ctlr = ctlr_rtos->ctlr;
+
+	primask = _mtk_os_hal_uart_irq_save();
+
+	mtk_mhal_uart_stop_dma_rx(ctlr);
+	mtk_mhal_uart_release_dma_rx_ch(ctlr);
+
+	ctlr->mdata->rx_vff_size = 0;
+	ctlr->mdata->rx_vff_continuous = false;
+	ctlr_rtos->rx_running = false;
+	_mtk_os_hal_uart_dma_disable_if_idle(ctlr_rtos);
+
+	_mtk_os_hal_uart_irq_restore(primask);
+
+	return 0;
+}
@@ -1,53 +1,103 @@
 #include "hw/azure_sphere_learning_path.h"
 #include "i2c.h"
+#include "intercore_codec.h"
+#include "intercore_msg.h"
 #include "lsm6dso_driver.h"
 #include "lsm6dso_reg.h"
 #include "mt3620-intercore.h"
+#include "os_hal_eint.h"
 #include "os_hal_gpio.h"
 #include "os_hal_uart.h"
 #include "printf.h"
+#include "spsc_ring.h"
 #include "tx_api.h"
 #include <stdbool.h>
 
 
 #define DEMO_STACK_SIZE         1024
-#define DEMO_BYTE_POOL_SIZE     9120
-#define DEMO_BLOCK_POOL_SIZE    100
-#define DEMO_QUEUE_SIZE         100
+#define I2C_SERVICE_PRIORITY    3		// above the threads using the bus, so transactions complete promptly
+#define SAMPLER_PRIORITY        5		// below the threads answering the high-level app
+#define INTER_CORE_TX_PRIORITY  4
+#define DEMO_BYTE_POOL_SIZE     10240
+#define DEMO_THREADS            6		// stacks allocated from byte_pool_0
+#define BYTE_POOL_OVERHEAD      (sizeof(UCHAR*) + sizeof(ALIGN_TYPE))	// ThreadX header in front of every byte pool allocation, and once at the end of the pool
+#define INTER_CORE_TX_BLOCKS    4		// outbound messages which can wait for the TX thread at once
+#define INTER_CORE_BATCH_SIZE   8
+#define INTER_CORE_SEND_TIMEOUT 50		// ticks a message waits for the high-level app to free space, or a sender for a free block
+#define INTER_CORE_CREDIT_POLL  10		// ticks between credit re-checks if a doorbell is missed
+#define INTER_CORE_SPACE_FREED  0x1
+#define INTER_CORE_SETUP_WAITS  100		// ticks to wait for the mailbox setup before backing off
+#define INTER_CORE_SETUP_BACKOFF_MAX 1000	// longest pause, in ticks, between mailbox setup attempts
+#define SENSOR_REQUEST          0x1		// event_flags_0: requests are waiting in sensorRequests
+#define SENSOR_SUBSCRIPTION     0x2		// event_flags_0: the high-level app changed its sample subscription
+#define SENSOR_FIFO             0x4		// event_flags_0: INT1, the LSM6DSO FIFO reached its watermark
+#define SENSOR_SAMPLER          0x8		// event_flags_0: the high-level app changed the background sampling period
+#define SENSOR_FIFO_LATENCY_MS  100		// shortest time samples wait in the sensor FIFO, so at most 10 wake-ups a second
+#define SENSOR_FIFO_READ_WORDS  (4 * LSM6DSO_FIFO_BURST_WORDS)	// FIFO words read per lsm6dso_fifo_read
+#define SAMPLER_DEFAULT_PERIOD_MS 100	// background sampling period until the high-level app sets one
+#define SENSOR_REQUEST_QUEUE_SIZE 8		// requests from the high-level app which can be outstanding at once, a power of two
+#define MS_PER_TICK             (1000 / TX_TIMER_TICKS_PER_SECOND)
 
 
 // resources for inter core messaging
-static uint8_t buf[256];
-static uint32_t dataSize;
+static uint8_t buf[32 + IC_MSG_MAX_SIZE];		// component ID header and one datagram from the high-level app, receive only
+static uint8_t componentHeader[32];				// component ID header of the first datagram, put in front of every message sent
 static BufferHeader* outbound, * inbound;
 static uint32_t sharedBufSize = 0;
-static const size_t payloadStart = 20;
+static const size_t payloadStart = 20;		// component ID header added by the runtime, see intercore_msg.h
+static IC_SUBSCRIBE_PAYLOAD subscribeRequest;	// latest IC_MSG_SUBSCRIBE, handed to the read sensor thread
+static uint32_t subscribeSequence;
+static IC_SAMPLER_PAYLOAD samplerRequest;		// latest IC_MSG_SET_SAMPLER, handed to the read sensor thread
+static uint32_t samplerSequence;
 bool highLevelReady = false;
 
-enum IC_ID
-{
-	UNKNOWN,
-	GET_TEMPERATURE
-};
+// A request from the high-level app, passed from the inter core thread to the read sensor thread
+typedef struct {
+	uint32_t type;
+	uint32_t sequence;
+} SENSOR_REQUEST_RECORD;
 
-struct IC_CONTROL_BLOCK {
-	enum IC_ID id;
-	union
-	{
-		bool	value_bool;
-		float	value_float;
-		int		value_int;
-	};
-} ic_control_block;
+static SENSOR_REQUEST_RECORD sensorRequestStorage[SENSOR_REQUEST_QUEUE_SIZE];
+static SPSC_RING sensorRequests;
 
+// Outbound message waiting for the TX thread, in a block of block_pool_0
+typedef struct {
+	uint8_t type;
+	uint16_t length;
+	uint32_t sequence;
+	uint8_t payload[sizeof(IC_SAMPLE_FRAME_HEADER) + IC_SAMPLE_FRAME_MAX_SAMPLES * sizeof(IC_SAMPLE)];	// largest message sent, a raw frame
+} INTER_CORE_TX_MESSAGE;
+
+#define INTER_CORE_TX_POOL_SIZE  (INTER_CORE_TX_BLOCKS * (sizeof(INTER_CORE_TX_MESSAGE) + sizeof(void*)))	// block_pool_0, a pointer in front of every block
+#define INTER_CORE_TX_QUEUE_SIZE (INTER_CORE_TX_BLOCKS * sizeof(ULONG))	// queue_inter_core_tx, one block pointer per message
+
+// Everything tx_application_define allocates from byte_pool_0, about 9.2 KB.
+_Static_assert(DEMO_THREADS * (DEMO_STACK_SIZE + BYTE_POOL_OVERHEAD) + (INTER_CORE_TX_POOL_SIZE + BYTE_POOL_OVERHEAD) +
+	(INTER_CORE_TX_QUEUE_SIZE + BYTE_POOL_OVERHEAD) + BYTE_POOL_OVERHEAD <= DEMO_BYTE_POOL_SIZE,
+	"DEMO_BYTE_POOL_SIZE is too small for the stacks and inter core TX buffers");
+
+// Outbound flow control counters
+struct IC_TX_STATS {
+	ULONG sent;			// blocks committed to the outbound buffer
+	ULONG waits;		// times the TX thread blocked for lack of credit
+	ULONG dropped;		// messages abandoned after INTER_CORE_SEND_TIMEOUT
+} ic_tx_stats;
 
 
 // Define the ThreadX object control blocks...
 TX_THREAD               tx_thread_inter_core;
+TX_THREAD               tx_thread_inter_core_tx;
 TX_THREAD               tx_thread_read_button;
 TX_THREAD               tx_thread_read_sensor;
 TX_THREAD               tx_thread_blink_led;
+TX_THREAD               tx_thread_sampler;
+TX_TIMER                timer_sampler;
+TX_SEMAPHORE            semaphore_sampler;
+TX_MUTEX                mutex_sensor;
 TX_EVENT_FLAGS_GROUP    event_flags_0;
+TX_SEMAPHORE            semaphore_inter_core_rx;
+TX_EVENT_FLAGS_GROUP    event_flags_inter_core_tx;
+TX_QUEUE                queue_inter_core_tx;
 TX_BYTE_POOL            byte_pool_0;
 TX_BLOCK_POOL           block_pool_0;
 UCHAR                   memory_area[DEMO_BYTE_POOL_SIZE];
@@ -55,8 +105,33 @@ UCHAR                   memory_area[DEMO_BYTE_POOL_SIZE];
 
 // Define thread prototypes.
 void thread_inter_core(ULONG thread_input);
+void thread_inter_core_tx(ULONG thread_input);
 void thread_read_sensor(ULONG thread_input);
 void thread_blink_led(ULONG thread_blink);
+void thread_sampler(ULONG thread_input);
+static void inter_core_rx_handler(void);
+static void inter_core_space_handler(void);
+static void inter_core_setup_wait(void);
+static uint32_t inter_core_clock(void);
+static int inter_core_reserve(uint32_t dataSize, IntercoreBlock* block, ULONG wait_option);
+static void inter_core_commit(IntercoreBlock* block);
+static void inter_core_write(const INTER_CORE_TX_MESSAGE* message);
+static INTER_CORE_TX_MESSAGE* inter_core_alloc(void);
+static int inter_core_post(INTER_CORE_TX_MESSAGE* message, uint8_t type, uint32_t sequence, uint16_t length);
+static int inter_core_send(uint8_t type, uint32_t sequence, const void* payload, uint16_t length);
+static void sensor_subscribe(IC_SUBSCRIBE_PAYLOAD* subscription);
+static void sensor_update_rate(void);
+static uint16_t sensor_flags(uint32_t updated);
+static void sensor_sample(IC_SUBSCRIBE_PAYLOAD* subscription);
+static void sensor_fifo_isr(void);
+static void sensor_fifo_word(uint8_t tag, const int16_t data[3], void* context);
+static void sensor_fifo_drain(IC_SUBSCRIBE_PAYLOAD* subscription);
+static void sampler_timer_expired(ULONG timer_input);
+static void sampler_set_period(uint32_t periodMs);
+static void sampler_configure(void);
+static void sampler_publish(const IC_SAMPLE* sample);
+static uint32_t sampler_latest(IC_SAMPLE* sample);
+static void send_stats(uint32_t sequence);
 int gpio_output(u8 gpio_no, u8 level);
 
 
@@ -77,6 +152,11 @@ void tx_application_define(void* first_unused_memory) {
 		pointer, DEMO_STACK_SIZE, 4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
 	
 
+	tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, DEMO_STACK_SIZE, TX_NO_WAIT);			// Allocate the stack for inter core TX thread
+	tx_thread_create(&tx_thread_inter_core_tx, "thread inter core tx", thread_inter_core_tx, 0,	// Create the thread which writes every outbound message
+		pointer, DEMO_STACK_SIZE, INTER_CORE_TX_PRIORITY, INTER_CORE_TX_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+
+
 	tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, DEMO_STACK_SIZE, TX_NO_WAIT);			// Allocate the stack for thread_blink_led thread
 	tx_thread_create(&tx_thread_blink_led, "thread blink led", thread_blink_led, 0,			// Create button press thread */
 		pointer, DEMO_STACK_SIZE, 1, 1, TX_NO_TIME_SLICE, TX_AUTO_START);
@@ -87,38 +167,282 @@ void tx_application_define(void* first_unused_memory) {
 		pointer, DEMO_STACK_SIZE, 4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
 
 	
+	tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, DEMO_STACK_SIZE, TX_NO_WAIT);			// Allocate the stack for the I2C service thread
+	i2c_service_create(pointer, DEMO_STACK_SIZE, I2C_SERVICE_PRIORITY);						// Create the thread which owns the I2C bus
+
+
+	tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, DEMO_STACK_SIZE, TX_NO_WAIT);			// Allocate the stack for the background sampler thread
+	tx_thread_create(&tx_thread_sampler, "thread sampler", thread_sampler, 0,				// Create background sampler thread
+		pointer, DEMO_STACK_SIZE, SAMPLER_PRIORITY, SAMPLER_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+
+	
 	tx_event_flags_create(&event_flags_0, "event flags 0");									// Create event flag for thread sync
+	tx_semaphore_create(&semaphore_inter_core_rx, "semaphore inter core rx", 0);			// Signalled by the mailbox interrupt when a message arrives
+	tx_event_flags_create(&event_flags_inter_core_tx, "event flags inter core tx");			// Set by the mailbox interrupt when the high-level app frees space
+
+	// Without these every outbound message would be dropped, so say so instead of running quietly.
+	if (tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, INTER_CORE_TX_POOL_SIZE, TX_NO_WAIT) != TX_SUCCESS ||	// Outbound messages, block overhead included
+		tx_block_pool_create(&block_pool_0, "block pool 0", sizeof(INTER_CORE_TX_MESSAGE), pointer, INTER_CORE_TX_POOL_SIZE) != TX_SUCCESS) {
+		printf("ERROR: inter core TX block pool not created\n");
+	}
+	if (tx_byte_allocate(&byte_pool_0, (VOID**)&pointer, INTER_CORE_TX_QUEUE_SIZE, TX_NO_WAIT) != TX_SUCCESS ||	// Messages posted to the TX thread, one block pointer each
+		tx_queue_create(&queue_inter_core_tx, "queue inter core tx", TX_1_ULONG, pointer, INTER_CORE_TX_QUEUE_SIZE) != TX_SUCCESS) {
+		printf("ERROR: inter core TX queue not created\n");
+	}
+
+	tx_semaphore_create(&semaphore_sampler, "semaphore sampler", 0);						// Signalled by timer_sampler when a background sample is due
+	tx_timer_create(&timer_sampler, "timer sampler", sampler_timer_expired, 0,				// Started by the read sensor thread once the sensor is up
+		1, 1, TX_NO_ACTIVATE);
+	tx_mutex_create(&mutex_sensor, "mutex sensor", TX_INHERIT);								// Held around every LSM6DSO access, bank switches span several transactions
+
+	spsc_ring_init(&sensorRequests, sensorRequestStorage, sizeof(SENSOR_REQUEST_RECORD), SENSOR_REQUEST_QUEUE_SIZE);	// Requests answered by the read sensor thread
+}
+
+
+// Called from the mailbox interrupt when the high-level app has written a message.
+static void inter_core_rx_handler(void) {
+	tx_semaphore_put(&semaphore_inter_core_rx);
+}
+
+
+// Called from the mailbox interrupt when the high-level app has read a message.
+static void inter_core_space_handler(void) {
+	tx_event_flags_set(&event_flags_inter_core_tx, INTER_CORE_SPACE_FREED, TX_OR);
+}
+
+
+// Called while the mailbox is empty during setup, so the other threads run meanwhile.
+static void inter_core_setup_wait(void) {
+	tx_thread_sleep(1);
+}
+
+
+// Times outbound messages for the latency counter, in milliseconds.
+static uint32_t inter_core_clock(void) {
+	return tx_time_get() * MS_PER_TICK;
+}
+
+
+// Reserve an outbound block, waiting up to wait_option ticks for the high-level app to free space.
+static int inter_core_reserve(uint32_t dataSize, IntercoreBlock* block, ULONG wait_option) {
+	ULONG actual_flags;
+	ULONG start = tx_time_get();
+
+	for (;;) {
+		// Clear the flag before checking credit so a doorbell rung after the check is not lost.
+		tx_event_flags_get(&event_flags_inter_core_tx, INTER_CORE_SPACE_FREED, TX_OR_CLEAR, &actual_flags, TX_NO_WAIT);
+
+		if (Intercore_ReserveWrite(inbound, outbound, sharedBufSize, dataSize, block) == 0) {
+			return 0;
+		}
+
+		ULONG elapsed = tx_time_get() - start;
+
+		// Give up if the block can never fit, or the high-level app has not freed space in time.
+		if (dataSize + sizeof(uint32_t) + RINGBUFFER_ALIGNMENT > sharedBufSize || elapsed >= wait_option) {
+			ic_tx_stats.dropped++;
+			return -1;
+		}
+
+		ULONG wait = wait_option - elapsed;
+		if (wait > INTER_CORE_CREDIT_POLL) {
+			wait = INTER_CORE_CREDIT_POLL;
+		}
+
+		ic_tx_stats.waits++;
+		tx_event_flags_get(&event_flags_inter_core_tx, INTER_CORE_SPACE_FREED, TX_OR_CLEAR, &actual_flags, wait);
+	}
+}
+
+
+static void inter_core_commit(IntercoreBlock* block) {
+	Intercore_CommitWrite(outbound, sharedBufSize, block, Intercore_BlockSize(block));
+	ic_tx_stats.sent++;
+}
+
+
+// Frame a message behind the component ID header, straight into the shared buffer.
+// Runs on the TX thread, the only thread writing to the shared buffer.
+static void inter_core_write(const INTER_CORE_TX_MESSAGE* message) {
+	IntercoreBlock block;
+	uint8_t header[sizeof(IC_MSG_HEADER)];
+
+	if (inter_core_reserve(payloadStart + sizeof(header) + message->length, &block, INTER_CORE_SEND_TIMEOUT) != 0) {
+		return;
+	}
+
+	ic_msg_encode_header(header, message->type, message->sequence, message->length);
+	Intercore_CopyToBlock(&block, 0, componentHeader, payloadStart);
+	Intercore_CopyToBlock(&block, payloadStart, header, sizeof(header));
+	Intercore_CopyToBlock(&block, payloadStart + sizeof(header), message->payload, message->length);
+	inter_core_commit(&block);
+}
+
+
+// Take a block for an outbound message, waiting while the TX thread is behind. Returns NULL,
+// and counts the message as dropped, if none frees up within INTER_CORE_SEND_TIMEOUT.
+static INTER_CORE_TX_MESSAGE* inter_core_alloc(void) {
+	VOID* message;
+
+	if (tx_block_allocate(&block_pool_0, &message, INTER_CORE_SEND_TIMEOUT) != TX_SUCCESS) {
+		ic_tx_stats.dropped++;
+		return NULL;
+	}
+	return message;
+}
+
+
+// Hand a message filled in by the caller to the TX thread, which releases the block.
+static int inter_core_post(INTER_CORE_TX_MESSAGE* message, uint8_t type, uint32_t sequence, uint16_t length) {
+	ULONG pointer = (ULONG)message;
+
+	message->type = type;
+	message->sequence = sequence;
+	message->length = length;
+
+	// The queue holds a pointer for every block, so it is never full.
+	if (tx_queue_send(&queue_inter_core_tx, &pointer, TX_NO_WAIT) != TX_SUCCESS) {
+		tx_block_release(message);
+		ic_tx_stats.dropped++;
+		return -1;
+	}
+	return 0;
+}
+
+
+// Copy a message for the TX thread and return, the sender does not wait for credit.
+static int inter_core_send(uint8_t type, uint32_t sequence, const void* payload, uint16_t length) {
+	INTER_CORE_TX_MESSAGE* message;
+
+	if (length > sizeof(message->payload) || (message = inter_core_alloc()) == NULL) {
+		return -1;
+	}
+
+	memcpy(message->payload, payload, length);
+	return inter_core_post(message, type, sequence, length);
+}
+
+
+// Writes the posted messages to the shared buffer in order, so senders never wait for credit
+// and the receive path keeps running while the high-level app is slow to read.
+void thread_inter_core_tx(ULONG thread_input) {
+	ULONG message;
+
+	while (true) {
+		if (tx_queue_receive(&queue_inter_core_tx, &message, TX_WAIT_FOREVER) != TX_SUCCESS)
+			break;
+
+		inter_core_write((INTER_CORE_TX_MESSAGE*)message);
+		tx_block_release((VOID*)message);
+	}
 }
 
 
 void thread_inter_core(ULONG thread_input) {
 	UINT status;
-	
-	if (GetIntercoreBuffers(&outbound, &inbound, &sharedBufSize) == -1) {					// Initialize Inter-Core Communications
-		for (;;) { // empty.			
+	IntercoreBlock blocks[INTER_CORE_BATCH_SIZE];
+	uint32_t blockCount;
+	ULONG backoff = INTER_CORE_SETUP_WAITS;
+
+	// Initialize Inter-Core Communications. The high-level app may not have started yet, so wait
+	// in bounded attempts and back off between them rather than holding the CPU.
+	while (GetIntercoreBuffersWait(&outbound, &inbound, &sharedBufSize, inter_core_setup_wait, INTER_CORE_SETUP_WAITS) == -1) {
+		tx_thread_sleep(backoff);
+
+		backoff *= 2;
+		if (backoff > INTER_CORE_SETUP_BACKOFF_MAX) {
+			backoff = INTER_CORE_SETUP_BACKOFF_MAX;
 		}
 	}
 
+	SetIntercoreReceiveHandler(inter_core_rx_handler);
+	SetIntercoreSpaceHandler(inter_core_space_handler);
+	Intercore_SetClock(inter_core_clock);
+
 	// This thread monitors inter core messages.
 	while (1) {
-		dataSize = sizeof(buf);
-		int r = DequeueData(outbound, inbound, sharedBufSize, buf, &dataSize);
+		// Drain everything that has arrived, the interrupt may have coalesced several messages.
+		while ((blockCount = DequeueBatch(outbound, inbound, sharedBufSize, blocks, INTER_CORE_BATCH_SIZE)) > 0) {
+			ULONG sensorFlags = 0;
+
+			for (uint32_t i = 0; i < blockCount; i++) {
+				uint32_t blockSize = Intercore_BlockSize(&blocks[i]);
+				IC_MSG_HEADER header;
+				const uint8_t* payload;
+				uint32_t offset, consumed;
+				SENSOR_REQUEST_RECORD request;
+
+				if (blockSize > sizeof(buf)) {
+					continue;	// larger than any request this app handles
+				}
+
+				if (blockSize > payloadStart) {
+					// Decode the requests behind the component ID header.
+					// The high-level app coalesces requests, so one datagram can carry several.
+					Intercore_CopyFromBlock(&blocks[i], 0, buf, blockSize);
+
+					// Keep the component ID header for every message sent. It does not change,
+					// so it is copied once, before anything can be sent.
+					if (!highLevelReady) {
+						memcpy(componentHeader, buf, payloadStart);
+						highLevelReady = true;
+					}
+
+					for (offset = payloadStart; offset < blockSize; offset += consumed) {
+						consumed = ic_msg_decode(&buf[offset], blockSize - offset, &header, &payload);
+						if (consumed == 0) {
+							break;
+						}
+
+						switch (header.type) {
+						case IC_MSG_GET_TEMPERATURE:
+						case IC_MSG_GET_STATS:
+							// Every request is answered with its own sequence number, so the high-level
+							// app can have several outstanding. If the queue is full the request is
+							// dropped and times out on the high-level side.
+							request.type = header.type;
+							request.sequence = header.sequence;
+							if (spsc_ring_push(&sensorRequests, &request)) {
+								sensorFlags |= SENSOR_REQUEST;
+							}
+							break;
+						case IC_MSG_SUBSCRIBE:
+							if (ic_msg_payload(&header, payload, &subscribeRequest, sizeof(subscribeRequest))) {
+								subscribeSequence = header.sequence;
+								sensorFlags |= SENSOR_SUBSCRIPTION;
+							}
+							break;
+						case IC_MSG_SET_SAMPLER:
+							if (ic_msg_payload(&header, payload, &samplerRequest, sizeof(samplerRequest))) {
+								samplerSequence = header.sequence;
+								sensorFlags |= SENSOR_SAMPLER;
+							}
+							break;
+						default:
+							break;
+						}
+					}
+				}
+			}
 
-		if (r == 0 && dataSize > payloadStart) {
-			highLevelReady = true;
+			// Hand the whole batch back to the high-level app with one position update and doorbell.
+			Intercore_ReleaseRead(outbound, sharedBufSize, &blocks[blockCount - 1]);
 
-			memcpy(&ic_control_block, &buf[payloadStart],  sizeof(ic_control_block));
-			if (ic_control_block.id == GET_TEMPERATURE)
+			if (sensorFlags)
 			{
 				// Set event flag 0 to wakeup threads read sensor and blink led
-				status = tx_event_flags_set(&event_flags_0, 0x1, TX_OR);
+				status = tx_event_flags_set(&event_flags_0, sensorFlags, TX_OR);
 
 				if (status != TX_SUCCESS)
-					break;
+					return;
 			}
 		}
 
-		tx_thread_sleep(25);
+		// Block until the mailbox interrupt signals the next message.
+		status = tx_semaphore_get(&semaphore_inter_core_rx, TX_WAIT_FOREVER);
+
+		if (status != TX_SUCCESS)
+			break;
 	}
 }
 
@@ -136,10 +460,391 @@ void thread_blink_led(ULONG thread_blink) {
 }
 
 
+// Sample frame being filled while a subscription is active
+static struct {
+	IC_SAMPLE_FRAME_HEADER header;
+	IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+} frame;
+static uint32_t frameSequence;
+static uint32_t tickPeriodMs;	// subscribed period while sampling on the tick, else 0
+
+// Samples coming out of the sensor FIFO, taken into the frame every subscribed period
+static struct {
+	uint32_t intervalUs;	// FIFO batching interval, 0 while sampling on the tick
+	ULONG timeoutTicks;		// drain anyway after this long without INT1, one watermark's fill time
+	uint32_t startMs;		// timestamps are startMs + timeUs
+	uint32_t timeUs;		// batching time of the latest step
+	uint32_t nextUs;		// batching time of the next sample taken into the frame
+	uint16_t step;			// IC_SAMPLE_NEW_* words seen for the current batching step
+	uint16_t flags;			// IC_SAMPLE_NEW_* words seen since the last sample
+	IC_SAMPLE latest;
+} fifo;
+static uint8_t fifoWords[SENSOR_FIFO_READ_WORDS * LSM6DSO_FIFO_WORD_SIZE];
+
+// Background sample store. The sampler thread fills the slot readers are not directed to and
+// then flips latest, so a request never waits for the bus. A slot's version is odd while it
+// is written, a reader preempted by two publications sees it change and copies again.
+typedef struct {
+	uint32_t version;
+	uint32_t sequence;		// samples taken since start up, 0 until the slot is first written
+	IC_SAMPLE sample;
+} SAMPLER_SLOT;
+
+static struct {
+	uint32_t periodMs;			// 0 while stopped, changed by the read sensor thread only
+	uint32_t sequence;			// written by the sampler thread only
+	SAMPLER_SLOT slots[2];
+	volatile uint32_t latest;	// slot readers copy from
+} sampler;
+
+
+// Apply a new subscription and acknowledge it with the period and frame size actually used.
+// Runs on the read sensor thread, which owns the sensor and frame state.
+static void sensor_subscribe(IC_SUBSCRIBE_PAYLOAD* subscription) {
+	uint32_t maxSamples = IC_SAMPLE_FRAME_MAX_SAMPLES;
+
+	*subscription = subscribeRequest;
+
+	// Keep a frame below half the shared buffer, so one can be filled while the last is read.
+	while (maxSamples > 1 && payloadStart + sizeof(IC_MSG_HEADER) + sizeof(frame.header) +
+		maxSamples * sizeof(IC_SAMPLE) > sharedBufSize / 2) {
+		maxSamples--;
+	}
+
+	tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+
+	if (fifo.intervalUs != 0) {
+		lsm6dso_fifo_stop();
+		fifo.intervalUs = 0;
+	}
+
+	if (subscription->periodMs != 0) {
+		uint32_t latencyMs;
+
+		if (subscription->samplesPerFrame == 0) {
+			subscription->samplesPerFrame = 1;
+		}
+		if (subscription->samplesPerFrame > maxSamples) {
+			subscription->samplesPerFrame = maxSamples;
+		}
+
+		// The sensor batches samples in its FIFO and raises INT1 about once a frame, or every
+		// SENSOR_FIFO_LATENCY_MS for fast streams which then send several frames per wake-up.
+		// The driver shortens the latency of the fastest rates to keep the FIFO half free.
+		latencyMs = subscription->periodMs * subscription->samplesPerFrame;
+		if (latencyMs < SENSOR_FIFO_LATENCY_MS) {
+			latencyMs = SENSOR_FIFO_LATENCY_MS;
+		}
+
+		fifo.intervalUs = lsm6dso_fifo_start(subscription->periodMs, &latencyMs);
+
+		// Without INT1 the timeout paces every drain, so it must not outlast the watermark.
+		fifo.timeoutTicks = latencyMs / MS_PER_TICK;
+		if (fifo.timeoutTicks == 0) {
+			fifo.timeoutTicks = 1;
+		}
+		fifo.startMs = tx_time_get() * MS_PER_TICK;
+		fifo.timeUs = 0;
+		fifo.nextUs = 0;
+		fifo.step = 0;
+		fifo.flags = 0;
+
+		if (fifo.intervalUs == 0) {
+			// Without the FIFO the sensor is sampled on the ThreadX tick.
+			subscription->periodMs = ((subscription->periodMs + MS_PER_TICK - 1) / MS_PER_TICK) * MS_PER_TICK;
+		}
+	}
+
+	tickPeriodMs = fifo.intervalUs == 0 ? subscription->periodMs : 0;
+	sensor_update_rate();
+
+	tx_mutex_put(&mutex_sensor);
+
+	frame.header.count = 0;
+	frame.header.periodMs = subscription->periodMs;
+	frameSequence = 0;
+
+	inter_core_send(IC_MSG_SUBSCRIBE, subscribeSequence, subscription, sizeof(*subscription));
+}
+
+
+// Set the output data rate for the register reads, fast enough for both the tick sampled
+// subscription and the background sampler. A FIFO stream sets its own rate. Call with
+// mutex_sensor held.
+static void sensor_update_rate(void) {
+	uint32_t periodMs = sampler.periodMs;
+
+	if (fifo.intervalUs != 0) {
+		return;
+	}
+	if (tickPeriodMs != 0 && (periodMs == 0 || tickPeriodMs < periodMs)) {
+		periodMs = tickPeriodMs;
+	}
+	lsm6dso_set_sample_period(periodMs);
+}
+
+
+// IC_SAMPLE_NEW_* for the LSM6DSO_NEW_* readings of lsm6dso_read_raw.
+static uint16_t sensor_flags(uint32_t updated) {
+	return ((updated & LSM6DSO_NEW_ACCELERATION) ? IC_SAMPLE_NEW_ACCELERATION : 0) |
+		((updated & LSM6DSO_NEW_ANGULAR_RATE) ? IC_SAMPLE_NEW_ANGULAR_RATE : 0) |
+		((updated & LSM6DSO_NEW_TEMPERATURE) ? IC_SAMPLE_NEW_TEMPERATURE : 0);
+}
+
+
+// Take the sample written at frame.samples[frame.header.count], and push the frame to the
+// high-level app once it is full.
+static void sensor_frame_add(IC_SUBSCRIBE_PAYLOAD* subscription) {
+	if (++frame.header.count >= subscription->samplesPerFrame) {
+		uint16_t rawSize = sizeof(frame.header) + frame.header.count * sizeof(IC_SAMPLE);
+		uint32_t packedSize = 0;
+
+		// Encoded straight into the outbound block. Waits if the TX thread is behind, a frame
+		// without a block in time is dropped and shows up as a gap in the frame sequence.
+		INTER_CORE_TX_MESSAGE* message = inter_core_alloc();
+
+		if (message != NULL) {
+			if (subscription->options & IC_SUBSCRIBE_PACKED) {
+				// Only worth sending if smaller than the raw frame.
+				packedSize = ic_codec_encode_frame(message->payload, rawSize, frame.header.periodMs, frame.samples, frame.header.count);
+			}
+
+			if (packedSize > 0) {
+				inter_core_post(message, IC_MSG_SAMPLE_FRAME_PACKED, frameSequence, (uint16_t)packedSize);
+			} else {
+				memcpy(message->payload, &frame, rawSize);
+				inter_core_post(message, IC_MSG_SAMPLE_FRAME, frameSequence, rawSize);
+			}
+		}
+		frameSequence++;
+		frame.header.count = 0;
+	}
+}
+
+
+// Add one reading to the frame, taken on the ThreadX tick.
+static void sensor_sample(IC_SUBSCRIBE_PAYLOAD* subscription) {
+	IC_SAMPLE* sample = &frame.samples[frame.header.count];
+	uint32_t updated;
+
+	tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+	updated = lsm6dso_read_raw(sample->acceleration, sample->angularRate, &sample->temperature);
+	tx_mutex_put(&mutex_sensor);
+
+	sample->timestamp = tx_time_get() * MS_PER_TICK;
+	sample->flags = sensor_flags(updated);
+
+	sensor_frame_add(subscription);
+}
+
+
+// Called from the EINT interrupt when INT1 rises.
+static void sensor_fifo_isr(void) {
+	tx_event_flags_set(&event_flags_0, SENSOR_FIFO, TX_OR);
+}
+
+
+// Demultiplex one FIFO word. An accelerometer and a gyroscope word make up a batching step,
+// the step due at the subscribed period is added to the frame.
+static void sensor_fifo_word(uint8_t tag, const int16_t data[3], void* context) {
+	IC_SUBSCRIBE_PAYLOAD* subscription = context;
+	IC_SAMPLE* sample;
+
+	switch (tag) {
+	case LSM6DSO_XL_NC_TAG:
+		memcpy(fifo.latest.acceleration, data, sizeof(fifo.latest.acceleration));
+		fifo.step |= IC_SAMPLE_NEW_ACCELERATION;
+		break;
+	case LSM6DSO_GYRO_NC_TAG:
+		memcpy(fifo.latest.angularRate, data, sizeof(fifo.latest.angularRate));
+		fifo.step |= IC_SAMPLE_NEW_ANGULAR_RATE;
+		break;
+	case LSM6DSO_TEMPERATURE_TAG:
+		fifo.latest.temperature = data[0];
+		fifo.flags |= IC_SAMPLE_NEW_TEMPERATURE;
+		return;
+	default:
+		return;
+	}
+
+	if (fifo.step != (IC_SAMPLE_NEW_ACCELERATION | IC_SAMPLE_NEW_ANGULAR_RATE)) {
+		return;
+	}
+	fifo.flags |= fifo.step;
+	fifo.step = 0;
+	fifo.timeUs += fifo.intervalUs;
+
+	if (fifo.timeUs >= fifo.nextUs) {
+		sample = &frame.samples[frame.header.count];
+		*sample = fifo.latest;
+		sample->timestamp = fifo.startMs + fifo.timeUs / 1000;
+		sample->flags = fifo.flags;
+		fifo.flags = 0;
+
+		// Do not try to catch up on samples missed while waiting for credit.
+		fifo.nextUs += subscription->periodMs * 1000;
+		if (fifo.nextUs <= fifo.timeUs) {
+			fifo.nextUs = fifo.timeUs + subscription->periodMs * 1000;
+		}
+
+		sensor_frame_add(subscription);
+	}
+
+	// Move whole seconds into startMs, so the microsecond counters never wrap.
+	if (fifo.timeUs >= 1000000) {
+		fifo.startMs += 1000;
+		fifo.timeUs -= 1000000;
+		fifo.nextUs -= 1000000;
+	}
+}
+
+
+// Empty the sensor FIFO of the words waiting when called, a few bursts at a time. Words
+// batched meanwhile are left for the next drain. mutex_sensor is held for the bus reads only,
+// building and posting frames may wait for a free block.
+static void sensor_fifo_drain(IC_SUBSCRIBE_PAYLOAD* subscription) {
+	lsm6dso_fifo_status_t status;
+	uint32_t left = UINT32_MAX;		// words still to read, of those waiting at the first read
+	int32_t words;
+
+	do {
+		tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+		words = lsm6dso_fifo_read(fifoWords, left < SENSOR_FIFO_READ_WORDS ? (uint16_t)left : SENSOR_FIFO_READ_WORDS, &status);
+		tx_mutex_put(&mutex_sensor);
+
+		if (words <= 0) {
+			return;
+		}
+		if (left > status.waiting) {
+			left = status.waiting;
+		}
+
+		// The oldest words were overwritten, so batching time no longer matches the samples.
+		// Restart it where the waiting words begin, and flag the next sample taken.
+		if (status.overrun) {
+			fifo.startMs = tx_time_get() * MS_PER_TICK - status.waiting / 2 * fifo.intervalUs / 1000;
+			fifo.timeUs = 0;
+			fifo.nextUs = 0;
+			fifo.step = 0;
+			fifo.flags = IC_SAMPLE_FIFO_OVERRUN;
+		}
+
+		lsm6dso_fifo_decode(fifoWords, (uint16_t)words, sensor_fifo_word, subscription);
+		left -= words;
+	} while (left > 0);
+}
+
+
+// Called from the ThreadX timer when a background sample is due. A sample still pending is
+// not queued twice, a slow bus skips samples instead of bunching them up.
+static void sampler_timer_expired(ULONG timer_input) {
+	tx_semaphore_ceiling_put(&semaphore_sampler, 1);
+}
+
+
+// Run the sampler every periodMs, rounded up to whole ticks, or stop it for 0.
+static void sampler_set_period(uint32_t periodMs) {
+	ULONG ticks = (periodMs + MS_PER_TICK - 1) / MS_PER_TICK;
+
+	tx_timer_deactivate(&timer_sampler);
+	sampler.periodMs = ticks * MS_PER_TICK;
+
+	if (ticks != 0) {
+		tx_timer_change(&timer_sampler, ticks, ticks);
+		tx_timer_activate(&timer_sampler);
+	}
+
+	tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+	sensor_update_rate();
+	tx_mutex_put(&mutex_sensor);
+}
+
+
+// Apply a new sampling period and acknowledge it with the period actually used.
+static void sampler_configure(void) {
+	IC_SAMPLER_PAYLOAD reply = { .periodMs = 0 };
+	uint32_t periodMs = samplerRequest.periodMs;
+
+	// Rounding up to whole ticks must still fit the reply.
+	if (periodMs > UINT16_MAX / MS_PER_TICK * MS_PER_TICK) {
+		periodMs = UINT16_MAX / MS_PER_TICK * MS_PER_TICK;
+	}
+
+	sampler_set_period(periodMs);
+	reply.periodMs = (uint16_t)sampler.periodMs;
+
+	inter_core_send(IC_MSG_SET_SAMPLER, samplerSequence, &reply, sizeof(reply));
+}
+
+
+// Make a sample the latest. Called by the sampler thread only.
+static void sampler_publish(const IC_SAMPLE* sample) {
+	uint32_t next = sampler.latest ^ 1;
+	SAMPLER_SLOT* slot = &sampler.slots[next];
+
+	slot->version++;
+	__sync_synchronize();
+	slot->sample = *sample;
+	slot->sequence = ++sampler.sequence;
+	__sync_synchronize();
+	slot->version++;
+	__sync_synchronize();
+	sampler.latest = next;
+}
+
+
+// Copy the latest background sample without waiting for the sampler. Returns its sequence
+// number, or 0 if no sample was taken yet.
+static uint32_t sampler_latest(IC_SAMPLE* sample) {
+	SAMPLER_SLOT* slot;
+	uint32_t version, sequence;
+
+	do {
+		slot = &sampler.slots[sampler.latest];
+		version = slot->version;
+		__sync_synchronize();
+		*sample = slot->sample;
+		sequence = slot->sequence;
+		__sync_synchronize();
+	} while ((version & 1) != 0 || version != *(volatile uint32_t*)&slot->version);
+
+	return sequence;
+}
+
+
+// Report the shared buffer counters, answered by the read sensor thread like every other request.
+static void send_stats(uint32_t sequence) {
+	IntercoreStats stats;
+	IC_STATS_PAYLOAD reply;
+
+	Intercore_GetStats(&stats);
+
+	reply.bufferSize = sharedBufSize;
+	reply.messagesOut = stats.messagesOut;
+	reply.bytesOut = stats.bytesOut;
+	reply.messagesIn = stats.messagesIn;
+	reply.bytesIn = stats.bytesIn;
+	reply.outboundHighWater = stats.outboundHighWater;
+	reply.inboundHighWater = stats.inboundHighWater;
+	reply.outboundFull = stats.outboundFull;
+	reply.invalidPosition = stats.invalidPosition;
+	reply.maxLatencyMs = stats.maxLatency;
+	reply.senderWaits = ic_tx_stats.waits;
+	reply.sendsDropped = ic_tx_stats.dropped;
+
+	inter_core_send(IC_MSG_GET_STATS, sequence, &reply, sizeof(reply));
+}
+
+
 void thread_read_sensor(ULONG thread_input) {
 	UINT    status;
 	ULONG   actual_flags;
-	float temperature;
+	ULONG   wait_option;
+	ULONG   next_sample = 0;
+	SENSOR_REQUEST_RECORD request;
+	IC_TEMPERATURE_PAYLOAD reply;
+	IC_SAMPLE cached;
+	IC_SUBSCRIBE_PAYLOAD subscription = { .periodMs = 0 };
 
 	mtk_os_hal_i2c_ctrl_init(i2c_port_num);		// Initialize MT3620 I2C bus
 	i2c_enum();									// Enumerate I2C Bus
@@ -152,28 +857,110 @@ void thread_read_sensor(ULONG thread_input) {
 		return;
 	}
 
+	sampler_set_period(SAMPLER_DEFAULT_PERIOD_MS);
+
+	// INT1 wakes the thread to drain the sensor FIFO. Without it the FIFO is drained on a timeout.
+	mtk_os_hal_gpio_request(LSM6DSO_INT1);
+	mtk_os_hal_gpio_set_direction(LSM6DSO_INT1, OS_HAL_GPIO_DIR_INPUT);
+	if (mtk_os_hal_eint_register((eint_number)LSM6DSO_INT1, HAL_EINT_EDGE_RISING, sensor_fifo_isr) < 0) {
+		printf("LSM6DSO INT1 interrupt not available\n");
+	}
+
 	while (true) {
-		// waits here until flag set in inter core thread
-		status = tx_event_flags_get(&event_flags_0, 0x1, TX_OR_CLEAR, &actual_flags, TX_WAIT_FOREVER);  // wait until event set in the thread_inter_core thread
+		wait_option = TX_WAIT_FOREVER;
+
+		if (subscription.periodMs != 0 && fifo.intervalUs != 0) {
+			wait_option = fifo.timeoutTicks;
+		} else if (subscription.periodMs != 0) {
+			ULONG now = tx_time_get();
+			wait_option = (LONG)(next_sample - now) > 0 ? next_sample - now : TX_NO_WAIT;
+		}
 
-		if ((status != TX_SUCCESS) || (actual_flags != 0x1))
+		// waits here until flag set in inter core thread or by INT1, or the next sample is due
+		status = tx_event_flags_get(&event_flags_0, SENSOR_REQUEST | SENSOR_SUBSCRIPTION | SENSOR_FIFO | SENSOR_SAMPLER, TX_OR_CLEAR, &actual_flags, wait_option);
+
+		if (status == TX_NO_EVENTS && fifo.intervalUs != 0) {
+			actual_flags = SENSOR_FIFO;		// INT1 edge missed or not wired
+			status = TX_SUCCESS;
+		} else if (status == TX_NO_EVENTS) {
+			sensor_sample(&subscription);
+			next_sample += subscription.periodMs / MS_PER_TICK;
+
+			// Do not try to catch up on samples missed while waiting for credit.
+			if ((LONG)(tx_time_get() - next_sample) > 0) {
+				next_sample = tx_time_get();
+			}
+			continue;
+		}
+
+		if (status != TX_SUCCESS)
 			break;
 
-		if (highLevelReady) {
+		if (!highLevelReady)
+			continue;
+
+		// The whole FIFO in a few bursts, several samples per wake-up.
+		if ((actual_flags & SENSOR_FIFO) && subscription.periodMs != 0 && fifo.intervalUs != 0) {
+			sensor_fifo_drain(&subscription);
+		}
 
-			ic_control_block.id = GET_TEMPERATURE;
-			lsm6dso_show_result();
-			ic_control_block.value_float = get_temperature();
+		if (actual_flags & SENSOR_SUBSCRIPTION) {
+			sensor_subscribe(&subscription);
+			next_sample = tx_time_get();
+		}
 
-			memcpy((void*)&buf[payloadStart], (void*)&ic_control_block, sizeof(ic_control_block));
-			dataSize = payloadStart + sizeof(ic_control_block);
+		if (actual_flags & SENSOR_SAMPLER) {
+			sampler_configure();
+		}
 
-			EnqueueData(inbound, outbound, sharedBufSize, buf, dataSize);
+		// Answer every queued request in arrival order.
+		while ((actual_flags & SENSOR_REQUEST) && spsc_ring_pop(&sensorRequests, &request)) {
+			switch (request.type) {
+			case IC_MSG_GET_TEMPERATURE:
+				// From the background store while the sampler runs, else straight from the sensor.
+				if (sampler.periodMs != 0 && sampler_latest(&cached) != 0) {
+					reply.temperature = ic_sample_to_celsius(cached.temperature);
+				} else {
+					tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+					lsm6dso_show_result();
+					reply.temperature = get_temperature();
+					tx_mutex_put(&mutex_sensor);
+				}
+
+				inter_core_send(IC_MSG_GET_TEMPERATURE, request.sequence, &reply, sizeof(reply));
+				break;
+			case IC_MSG_GET_STATS:
+				send_stats(request.sequence);
+				break;
+			default:
+				break;
+			}
 		}
 	}
 }
 
 
+// Keeps the background store fresh, so requests are answered without touching the bus.
+void thread_sampler(ULONG thread_input) {
+	IC_SAMPLE sample;
+	uint32_t updated;
+
+	while (true) {
+		// waits here until timer_sampler signals the next sample is due
+		if (tx_semaphore_get(&semaphore_sampler, TX_WAIT_FOREVER) != TX_SUCCESS)
+			break;
+
+		tx_mutex_get(&mutex_sensor, TX_WAIT_FOREVER);
+		updated = lsm6dso_read_raw(sample.acceleration, sample.angularRate, &sample.temperature);
+		tx_mutex_put(&mutex_sensor);
+
+		sample.timestamp = tx_time_get() * MS_PER_TICK;
+		sample.flags = sensor_flags(updated);
+		sampler_publish(&sample);
+	}
+}
+
+
 int gpio_output(u8 gpio_no, u8 level) {
 	int ret;
 
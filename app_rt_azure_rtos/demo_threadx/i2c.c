@@ -1,60 +1,167 @@
 #include "i2c.h"
+#include "tx_api.h"
 
-static uint8_t i2c_tx_buf[I2C_MAX_LEN];
-static uint8_t i2c_rx_buf[I2C_MAX_LEN];
+static TX_THREAD i2c_service_thread;
+static TX_QUEUE i2c_service_queue;
+static ULONG i2c_service_queue_storage[I2C_SERVICE_QUEUE_SIZE];
+static bool i2c_service_running = false;
+
+static int i2c_xfer_run(i2c_xfer* xfer) {
+	switch (xfer->type) {
+	case I2C_XFER_WRITE:
+		return mtk_os_hal_i2c_write(i2c_port_num, xfer->addr, xfer->tx_buf, xfer->tx_len);
+	case I2C_XFER_READ:
+		return mtk_os_hal_i2c_read(i2c_port_num, xfer->addr, xfer->rx_buf, xfer->rx_len);
+	case I2C_XFER_WRITE_READ:
+		return mtk_os_hal_i2c_write_read(i2c_port_num, xfer->addr,
+			xfer->tx_buf, xfer->rx_buf, xfer->tx_len, xfer->rx_len);
+	}
+	return -I2C_EINVAL;
+}
+
+// Runs a batch back to back, the transactions after a failed one are not started.
+static void i2c_batch_run(i2c_xfer* batch) {
+	int result = 0;
+
+	while (batch != NULL) {
+		i2c_xfer* next = batch->next;	// the callback may reuse the descriptor
+
+		batch->result = result == 0 ? i2c_xfer_run(batch) : I2C_XFER_ABORTED;
+		if (result == 0) {
+			result = batch->result;
+		}
+		if (batch->callback != NULL) {
+			batch->callback(batch);
+		}
+		batch = next;
+	}
+}
+
+static void i2c_service(ULONG thread_input) {
+	ULONG batch;
+
+	while (true) {
+		tx_queue_receive(&i2c_service_queue, &batch, TX_WAIT_FOREVER);
+		i2c_batch_run((i2c_xfer*)batch);
+	}
+}
+
+static void i2c_transfer_done(i2c_xfer* xfer) {
+	tx_semaphore_put((TX_SEMAPHORE*)xfer->context);
+}
+
+// Queues a batch for the I2C service thread and returns, the callbacks report the results.
+int i2c_submit(i2c_xfer* batch) {
+	ULONG message = (ULONG)batch;
+
+	if (!i2c_service_running) {
+		i2c_batch_run(batch);
+		return 0;
+	}
+
+	return tx_queue_send(&i2c_service_queue, &message, TX_WAIT_FOREVER) == TX_SUCCESS ? 0 : -1;
+}
+
+// Runs a batch through the I2C service thread and waits for it, the callbacks of the
+// batch are replaced. Returns 0, or the result of the first failed transaction.
+int i2c_transfer(i2c_xfer* batch) {
+	TX_SEMAPHORE done;
+	i2c_xfer* last = batch;
+
+	// the service thread itself, or no service yet, owns the bus already
+	if (!i2c_service_running || tx_thread_identify() == &i2c_service_thread) {
+		i2c_batch_run(batch);
+	} else {
+		while (last->next != NULL) {
+			last->callback = NULL;
+			last = last->next;
+		}
+		last->callback = i2c_transfer_done;
+
+		tx_semaphore_create(&done, "i2c transfer", 0);
+		last->context = &done;
+		last->result = I2C_XFER_ABORTED;
+
+		if (i2c_submit(batch) == 0) {
+			tx_semaphore_get(&done, TX_WAIT_FOREVER);
+		}
+		tx_semaphore_delete(&done);
+	}
+
+	for (; batch != NULL; batch = batch->next) {
+		if (batch->result != 0) {
+			return batch->result;
+		}
+	}
+	return 0;
+}
 
 int32_t i2c_write(int* fD, uint8_t reg, uint8_t* buf, uint16_t len) {
+	uint8_t tx_buf[I2C_MAX_LEN];
+	i2c_xfer xfer = { .type = I2C_XFER_WRITE, .addr = i2c_lsm6dso_addr, .tx_buf = tx_buf, .tx_len = len + 1 };
+
 	if (buf == NULL)
 		return -1;
 
 	if (len > (I2C_MAX_LEN - 1))
 		return -1;
 
-	i2c_tx_buf[0] = reg;
+	tx_buf[0] = reg;
 	if (buf && len)
-		memcpy(&i2c_tx_buf[1], buf, len);
-	mtk_os_hal_i2c_write(i2c_port_num, i2c_lsm6dso_addr, i2c_tx_buf, len + 1);
-	return 0;
+		memcpy(&tx_buf[1], buf, len);
+	return i2c_transfer(&xfer);
 }
 
 int32_t i2c_read(int* fD, uint8_t reg, uint8_t* buf, uint16_t len) {
+	i2c_xfer xfer = { .type = I2C_XFER_WRITE_READ, .addr = i2c_lsm6dso_addr,
+		.tx_buf = &reg, .tx_len = 1, .rx_buf = buf, .rx_len = len };
+
 	if (buf == NULL)
 		return -1;
 
 	if (len > (I2C_MAX_LEN))
 		return -1;
 
-	mtk_os_hal_i2c_write_read(i2c_port_num, i2c_lsm6dso_addr,
-		&reg, i2c_rx_buf, 1, len);
-	memcpy(buf, i2c_rx_buf, len);
-	return 0;
+	return i2c_transfer(&xfer);
 }
 
 void i2c_enum(void) {
 	uint8_t i;
 	uint8_t data;
+	i2c_xfer xfer = { .type = I2C_XFER_READ, .rx_buf = &data, .rx_len = 1 };
 
 	printf("[ISU%d] Enumerate I2C Bus, Start\n", i2c_port_num);
 	for (i = 0; i < 0x80; i += 2) {
 		printf("[ISU%d] Address:0x%02X, ", i2c_port_num, i);
-		if (mtk_os_hal_i2c_read(i2c_port_num, i, &data, 1) == 0)
+		xfer.addr = i;
+		xfer.next = NULL;
+		if (i2c_transfer(&xfer) == 0)
 			printf("Found 0x%02X\n", i);
 	}
 	printf("[ISU%d] Enumerate I2C Bus, Finish\n\n", i2c_port_num);
 }
 
 int i2c_init(void) {
-	/* Allocate I2C buffer */
-	//i2c_tx_buf = pvPortMalloc(I2C_MAX_LEN);
-	//i2c_rx_buf = pvPortMalloc(I2C_MAX_LEN);
-	if (i2c_tx_buf == NULL || i2c_rx_buf == NULL) {
-		printf("Failed to allocate I2C buffer!\n");
-		return -1;
-	}
-
 	/* MT3620 I2C Init */
 	mtk_os_hal_i2c_ctrl_init(i2c_port_num);
 	mtk_os_hal_i2c_speed_init(i2c_port_num, i2c_speed);
 
 	return 0;
-}
\ No newline at end of file
+}
+
+// Creates the I2C service thread, from then on every transaction runs in it.
+int i2c_service_create(void* stack, uint32_t stack_size, uint32_t priority) {
+	if (tx_queue_create(&i2c_service_queue, "i2c service queue", TX_1_ULONG,
+		i2c_service_queue_storage, sizeof(i2c_service_queue_storage)) != TX_SUCCESS) {
+		return -1;
+	}
+
+	if (tx_thread_create(&i2c_service_thread, "thread i2c service", i2c_service, 0,
+		stack, stack_size, priority, priority, TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS) {
+		tx_queue_delete(&i2c_service_queue);
+		return -1;
+	}
+
+	i2c_service_running = true;
+	return 0;
+}
@@ -10,8 +10,39 @@ static const uint8_t i2c_port_num = OS_HAL_I2C_ISU2;
 static const uint8_t i2c_speed = I2C_SCL_1000kHz;
 static const uint8_t i2c_lsm6dso_addr = LSM6DSO_I2C_ADD_L >> 1;
 
+/* I2C transaction service, a thread which owns the bus and runs queued transactions */
+#define I2C_SERVICE_QUEUE_SIZE	8			// batches which can wait for the bus at once
+#define I2C_XFER_ABORTED		(-125)		// result of a transaction skipped after an earlier one of its batch failed
+
+typedef enum {
+	I2C_XFER_WRITE,
+	I2C_XFER_READ,
+	I2C_XFER_WRITE_READ
+} i2c_xfer_type;
+
+typedef struct i2c_xfer i2c_xfer;
+
+/* Called in the I2C service thread when a transaction is done, it may submit more */
+typedef void (*i2c_xfer_callback)(i2c_xfer* xfer);
+
+struct i2c_xfer {
+	i2c_xfer_type type;
+	uint8_t addr;				// 7-bit device address
+	uint8_t* tx_buf;			// written for I2C_XFER_WRITE and I2C_XFER_WRITE_READ
+	uint16_t tx_len;
+	uint8_t* rx_buf;			// read for I2C_XFER_READ and I2C_XFER_WRITE_READ
+	uint16_t rx_len;
+	i2c_xfer_callback callback;	// may be NULL
+	void* context;
+	int result;					// 0, an I2C error or I2C_XFER_ABORTED once done
+	i2c_xfer* next;				// next transaction of a batch, run without releasing the bus
+};
+
 
 int32_t i2c_write(int* fD, uint8_t reg, uint8_t* buf, uint16_t len);
 int32_t i2c_read(int* fD, uint8_t reg, uint8_t* buf, uint16_t len);
 void i2c_enum(void);
-int i2c_init(void);
\ No newline at end of file
+int i2c_init(void);
+int i2c_service_create(void* stack, uint32_t stack_size, uint32_t priority);
+int i2c_submit(i2c_xfer* batch);
+int i2c_transfer(i2c_xfer* batch);
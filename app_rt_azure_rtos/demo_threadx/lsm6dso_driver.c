@@ -44,6 +44,7 @@
 
 static int lsm6dso_handle;
 static lsm6dso_ctx_t dev_ctx;
+static lsm6dso_shadow_t dev_shadow;
 static axis3bit16_t data_raw_acceleration;
 static axis3bit16_t data_raw_angular_rate;
 static axis3bit16_t raw_angular_rate_calibration;
@@ -52,52 +53,59 @@ static float acceleration_mg[3];
 static float angular_rate_dps[3];
 static float lsm6dsoTemperature_degC;
 
+/* Output data rates used for FIFO streaming, slowest first */
+static const struct {
+	uint32_t interval_us;
+	lsm6dso_odr_xl_t xl_odr;
+	lsm6dso_odr_g_t gy_odr;
+	lsm6dso_bdr_xl_t xl_bdr;
+	lsm6dso_bdr_gy_t gy_bdr;
+} fifo_rates[] = {
+	{ 80000, LSM6DSO_XL_ODR_12Hz5, LSM6DSO_GY_ODR_12Hz5, LSM6DSO_XL_BATCHED_AT_12Hz5, LSM6DSO_GY_BATCHED_AT_12Hz5 },
+	{ 38462, LSM6DSO_XL_ODR_26Hz, LSM6DSO_GY_ODR_26Hz, LSM6DSO_XL_BATCHED_AT_26Hz, LSM6DSO_GY_BATCHED_AT_26Hz },
+	{ 19231, LSM6DSO_XL_ODR_52Hz, LSM6DSO_GY_ODR_52Hz, LSM6DSO_XL_BATCHED_AT_52Hz, LSM6DSO_GY_BATCHED_AT_52Hz },
+	{ 9615, LSM6DSO_XL_ODR_104Hz, LSM6DSO_GY_ODR_104Hz, LSM6DSO_XL_BATCHED_AT_104Hz, LSM6DSO_GY_BATCHED_AT_104Hz },
+	{ 4808, LSM6DSO_XL_ODR_208Hz, LSM6DSO_GY_ODR_208Hz, LSM6DSO_XL_BATCHED_AT_208Hz, LSM6DSO_GY_BATCHED_AT_208Hz },
+	{ 2398, LSM6DSO_XL_ODR_417Hz, LSM6DSO_GY_ODR_417Hz, LSM6DSO_XL_BATCHED_AT_417Hz, LSM6DSO_GY_BATCHED_AT_417Hz },
+	{ 1200, LSM6DSO_XL_ODR_833Hz, LSM6DSO_GY_ODR_833Hz, LSM6DSO_XL_BATCHED_AT_833Hz, LSM6DSO_GY_BATCHED_AT_833Hz },
+	{ 600, LSM6DSO_XL_ODR_1667Hz, LSM6DSO_GY_ODR_1667Hz, LSM6DSO_XL_BATCHED_AT_1667Hz, LSM6DSO_GY_BATCHED_AT_1667Hz },
+};
+
 
 /******************************************************************************/
 /* Functions */
 /******************************************************************************/
 void lsm6dso_show_result(void)
 {
-	uint8_t reg;
+	lsm6dso_output_block_t out;
 
-	/* Read output only if new xl value is available */
-	lsm6dso_xl_flag_data_ready_get(&dev_ctx, &reg);
-	if (reg) {
-		/* Read acceleration field data */
-		memset(data_raw_acceleration.u8bit, 0x00, 3 * sizeof(int16_t));
-		lsm6dso_acceleration_raw_get(&dev_ctx, data_raw_acceleration.u8bit);
+	/* Status and all output registers in one transfer */
+	if (lsm6dso_output_block_raw_get(&dev_ctx, &out) != 0)
+		return;
 
-		acceleration_mg[0] = lsm6dso_from_fs4_to_mg(data_raw_acceleration.i16bit[0]);
-		acceleration_mg[1] = lsm6dso_from_fs4_to_mg(data_raw_acceleration.i16bit[1]);
-		acceleration_mg[2] = lsm6dso_from_fs4_to_mg(data_raw_acceleration.i16bit[2]);
+	/* Use output only if new xl value is available */
+	if (out.out.status_reg.xlda) {
+		memcpy(data_raw_acceleration.i16bit, out.out.acceleration, 3 * sizeof(int16_t));
+
+		lsm6dso_convert_float(data_raw_acceleration.i16bit, NULL, LSM6DSO_FS4_UG_PER_LSB, 0.001f, acceleration_mg, 1);
 
 		//printf("\n[LSM6DSO] Acceleration [mg]  : %.4lf, %.4lf, %.4lf\n",
 		//	acceleration_mg[0], acceleration_mg[1], acceleration_mg[2]);
 	}
 
-	lsm6dso_gy_flag_data_ready_get(&dev_ctx, &reg);
-	if (reg) {
-		/* Read angular rate field data */
-		memset(data_raw_angular_rate.u8bit, 0x00, 3 * sizeof(int16_t));
-		lsm6dso_angular_rate_raw_get(&dev_ctx, data_raw_angular_rate.u8bit);
+	if (out.out.status_reg.gda) {
+		memcpy(data_raw_angular_rate.i16bit, out.out.angular_rate, 3 * sizeof(int16_t));
 
-		/* Before we store the mdps values subtract the calibration data we captured at startup. */
-		angular_rate_dps[0] = (lsm6dso_from_fs2000_to_mdps(data_raw_angular_rate.i16bit[0] -
-					raw_angular_rate_calibration.i16bit[0])) / 1000.0;
-		angular_rate_dps[1] = (lsm6dso_from_fs2000_to_mdps(data_raw_angular_rate.i16bit[1] -
-					raw_angular_rate_calibration.i16bit[1])) / 1000.0;
-		angular_rate_dps[2] = (lsm6dso_from_fs2000_to_mdps(data_raw_angular_rate.i16bit[2] -
-					raw_angular_rate_calibration.i16bit[2])) / 1000.0;
+		/* Before we store the dps values subtract the calibration data we captured at startup. */
+		lsm6dso_convert_float(data_raw_angular_rate.i16bit, raw_angular_rate_calibration.i16bit,
+			LSM6DSO_FS2000_MDPS_PER_LSB, 0.001f, angular_rate_dps, 1);
 
 		//printf("[LSM6DSO] Angular rate [dps] : %4.2f, %4.2f, %4.2f\n",
 		//	angular_rate_dps[0], angular_rate_dps[1], angular_rate_dps[2]);
 	}
 
-	lsm6dso_temp_flag_data_ready_get(&dev_ctx, &reg);
-	if (reg) {
-		/* Read temperature data */
-		memset(data_raw_temperature.u8bit, 0x00, sizeof(int16_t));
-		lsm6dso_temperature_raw_get(&dev_ctx, data_raw_temperature.u8bit);
+	if (out.out.status_reg.tda) {
+		data_raw_temperature.i16bit = out.out.temperature;
 		lsm6dsoTemperature_degC = lsm6dso_from_lsb_to_celsius(data_raw_temperature.i16bit);
 
 		//memset(data_raw_pressure.u8bit, 0x00, sizeof(int32_t));
@@ -107,10 +115,246 @@ void lsm6dso_show_result(void)
 	}
 }
 
+/* Converts count x, y, z triples: out = (raw - offset) * scale, offset may be NULL. The
+ * difference wraps to 16 bits as in the lsm6dso_from_* conversions, so the DSP and the C
+ * paths give the same results. scale must fit in 16 bits, see LSM6DSO_*_PER_LSB. */
+void lsm6dso_convert_fixed(const int16_t *raw, const int16_t offset[3], int16_t scale, int32_t *out, uint32_t count)
+{
+	static const int16_t no_offset[3];
+	uint32_t i = 0;
+
+	if (offset == NULL)
+		offset = no_offset;
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+	{
+		/* Two triples are three words, (x0, y0), (z0, x1) and (y1, z1): SSUB16 subtracts the
+		 * offsets of both halves at once, SMUAD scales one half as the other is multiplied by 0. */
+		uint32_t off[3], word;
+		uint32_t scale_lo = (uint16_t)scale;
+		uint32_t scale_hi = (uint32_t)(uint16_t)scale << 16;
+		int k;
+
+		off[0] = (uint16_t)offset[0] | ((uint32_t)(uint16_t)offset[1] << 16);
+		off[1] = (uint16_t)offset[2] | ((uint32_t)(uint16_t)offset[0] << 16);
+		off[2] = (uint16_t)offset[1] | ((uint32_t)(uint16_t)offset[2] << 16);
+
+		for (; i + 2 <= count; i += 2) {
+			for (k = 0; k < 3; k++) {
+				memcpy(&word, &raw[3 * i + 2 * k], sizeof(word));	/* raw may be only halfword aligned */
+				word = __SSUB16(word, off[k]);
+				out[3 * i + 2 * k] = (int32_t)__SMUAD(word, scale_lo);
+				out[3 * i + 2 * k + 1] = (int32_t)__SMUAD(word, scale_hi);
+			}
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		out[3 * i] = (int16_t)(raw[3 * i] - offset[0]) * scale;
+		out[3 * i + 1] = (int16_t)(raw[3 * i + 1] - offset[1]) * scale;
+		out[3 * i + 2] = (int16_t)(raw[3 * i + 2] - offset[2]) * scale;
+	}
+}
+
+/* As lsm6dso_convert_fixed(), then multiplied by unit, e.g. 0.001f for mg from ug. One
+ * float multiply per value replaces the per-axis float conversion and double division. */
+void lsm6dso_convert_float(const int16_t *raw, const int16_t offset[3], int16_t scale, float unit, float *out, uint32_t count)
+{
+	int32_t fixed[3 * LSM6DSO_CONVERT_CHUNK];
+	uint32_t n, j;
+
+	while (count > 0) {
+		n = count < LSM6DSO_CONVERT_CHUNK ? count : LSM6DSO_CONVERT_CHUNK;
+
+		lsm6dso_convert_fixed(raw, offset, scale, fixed, n);
+		for (j = 0; j < 3 * n; j++)
+			out[j] = (float)fixed[j] * unit;
+
+		raw += 3 * n;
+		out += 3 * n;
+		count -= n;
+	}
+}
+
 float get_temperature(void) {
 	return lsm6dsoTemperature_degC;
 }
 
+/* Reads the status and output registers in one transfer and keeps the readings that have
+ * new data, leaving the latest values of all three in the caller's buffers. Returns the LSM6DSO_NEW_* flags. */
+uint32_t lsm6dso_read_raw(int16_t acceleration[3], int16_t angular_rate[3], int16_t *temperature)
+{
+	uint32_t updated = 0;
+	lsm6dso_output_block_t out;
+
+	if (lsm6dso_output_block_raw_get(&dev_ctx, &out) == 0) {
+		if (out.out.status_reg.xlda) {
+			memcpy(data_raw_acceleration.i16bit, out.out.acceleration, 3 * sizeof(int16_t));
+			updated |= LSM6DSO_NEW_ACCELERATION;
+		}
+
+		if (out.out.status_reg.gda) {
+			memcpy(data_raw_angular_rate.i16bit, out.out.angular_rate, 3 * sizeof(int16_t));
+			updated |= LSM6DSO_NEW_ANGULAR_RATE;
+		}
+
+		if (out.out.status_reg.tda) {
+			data_raw_temperature.i16bit = out.out.temperature;
+			lsm6dsoTemperature_degC = lsm6dso_from_lsb_to_celsius(data_raw_temperature.i16bit);
+			updated |= LSM6DSO_NEW_TEMPERATURE;
+		}
+	}
+
+	memcpy(acceleration, data_raw_acceleration.i16bit, 3 * sizeof(int16_t));
+	memcpy(angular_rate, data_raw_angular_rate.i16bit, 3 * sizeof(int16_t));
+	*temperature = data_raw_temperature.i16bit;
+
+	return updated;
+}
+
+/* Picks the slowest output data rate that still produces a new reading every period_ms.
+ * A period of 0 returns to the 12.5 Hz rate used for on-demand reads. */
+void lsm6dso_set_sample_period(uint32_t period_ms)
+{
+	lsm6dso_odr_xl_t xl_odr = LSM6DSO_XL_ODR_12Hz5;
+	lsm6dso_odr_g_t gy_odr = LSM6DSO_GY_ODR_12Hz5;
+
+	if (period_ms == 0 || period_ms >= 80) {
+		/* 12.5 Hz */
+	} else if (period_ms >= 39) {
+		xl_odr = LSM6DSO_XL_ODR_26Hz;
+		gy_odr = LSM6DSO_GY_ODR_26Hz;
+	} else if (period_ms >= 20) {
+		xl_odr = LSM6DSO_XL_ODR_52Hz;
+		gy_odr = LSM6DSO_GY_ODR_52Hz;
+	} else {
+		xl_odr = LSM6DSO_XL_ODR_104Hz;
+		gy_odr = LSM6DSO_GY_ODR_104Hz;
+	}
+
+	lsm6dso_xl_data_rate_set(&dev_ctx, xl_odr);
+	lsm6dso_gy_data_rate_set(&dev_ctx, gy_odr);
+}
+
+/* Streams accelerometer and gyroscope samples through the sensor FIFO, batched at the slowest
+ * output data rate that still produces one every period_ms, and temperature at 12.5 Hz.
+ * INT1 rises once about *latency_ms of samples are waiting. The watermark is kept within
+ * LSM6DSO_FIFO_WATERMARK_SAFE words, *latency_ms is lowered to match, so a drain started up to
+ * that late again still finds every word. Returns the batching interval in microseconds, or 0
+ * if the sensor could not be set up. */
+uint32_t lsm6dso_fifo_start(uint32_t period_ms, uint32_t *latency_ms)
+{
+	lsm6dso_pin_int1_route_t int1_route;
+	uint32_t rate = 0;
+	uint64_t words_per_ks;
+	uint32_t watermark;
+	int32_t ret;
+
+	while (rate < sizeof(fifo_rates) / sizeof(fifo_rates[0]) - 1 &&
+		fifo_rates[rate].interval_us > period_ms * 1000)
+		rate++;
+
+	/* An accelerometer and a gyroscope word for every batching step, and 12.5 temperature
+	 * words a second */
+	words_per_ks = 2000000000ULL / fifo_rates[rate].interval_us + 12500;
+	if (*latency_ms * words_per_ks > LSM6DSO_FIFO_WATERMARK_SAFE * 1000000ULL)
+		*latency_ms = (uint32_t)(LSM6DSO_FIFO_WATERMARK_SAFE * 1000000ULL / words_per_ks);
+
+	watermark = (uint32_t)(*latency_ms * words_per_ks / 1000000);
+	if (watermark < 2)
+		watermark = 2;
+
+	/* Bypass mode empties the FIFO of anything batched before */
+	ret = lsm6dso_fifo_mode_set(&dev_ctx, LSM6DSO_BYPASS_MODE);
+	if (ret == 0)
+		ret = lsm6dso_xl_data_rate_set(&dev_ctx, fifo_rates[rate].xl_odr);
+	if (ret == 0)
+		ret = lsm6dso_gy_data_rate_set(&dev_ctx, fifo_rates[rate].gy_odr);
+	if (ret == 0)
+		ret = lsm6dso_fifo_xl_batch_set(&dev_ctx, fifo_rates[rate].xl_bdr);
+	if (ret == 0)
+		ret = lsm6dso_fifo_gy_batch_set(&dev_ctx, fifo_rates[rate].gy_bdr);
+	if (ret == 0)
+		ret = lsm6dso_fifo_temp_batch_set(&dev_ctx, LSM6DSO_TEMP_BATCHED_AT_12Hz5);
+	if (ret == 0)
+		ret = lsm6dso_fifo_watermark_set(&dev_ctx, (uint16_t)watermark);
+	if (ret == 0)
+		ret = lsm6dso_pin_int1_route_get(&dev_ctx, &int1_route);
+	if (ret == 0) {
+		int1_route.int1_ctrl.int1_fifo_th = PROPERTY_ENABLE;
+		ret = lsm6dso_pin_int1_route_set(&dev_ctx, &int1_route);
+	}
+	if (ret == 0)
+		ret = lsm6dso_fifo_mode_set(&dev_ctx, LSM6DSO_STREAM_MODE);
+
+	if (ret != 0) {
+		printf("LSM6DSO FIFO setup failed!\n");
+		return 0;
+	}
+	return fifo_rates[rate].interval_us;
+}
+
+/* Stops batching and releases INT1, the output data rate is left to lsm6dso_set_sample_period. */
+void lsm6dso_fifo_stop(void)
+{
+	lsm6dso_pin_int1_route_t int1_route;
+
+	lsm6dso_fifo_mode_set(&dev_ctx, LSM6DSO_BYPASS_MODE);
+	lsm6dso_fifo_xl_batch_set(&dev_ctx, LSM6DSO_XL_NOT_BATCHED);
+	lsm6dso_fifo_gy_batch_set(&dev_ctx, LSM6DSO_GY_NOT_BATCHED);
+	lsm6dso_fifo_temp_batch_set(&dev_ctx, LSM6DSO_TEMP_NOT_BATCHED);
+
+	if (lsm6dso_pin_int1_route_get(&dev_ctx, &int1_route) == 0) {
+		int1_route.int1_ctrl.int1_fifo_th = PROPERTY_DISABLE;
+		lsm6dso_pin_int1_route_set(&dev_ctx, &int1_route);
+	}
+}
+
+/* Reads up to max_words of the words waiting in the FIFO into words, LSM6DSO_FIFO_WORD_SIZE
+ * bytes each, in bursts of LSM6DSO_FIFO_BURST_WORDS per bus transfer. status tells how many
+ * were waiting and whether the FIFO overran, which lost the oldest words. Returns the number
+ * of words read, or -1 on a bus error. */
+int32_t lsm6dso_fifo_read(uint8_t *words, uint16_t max_words, lsm6dso_fifo_status_t *status)
+{
+	uint8_t reg[2];
+	uint16_t level, burst;
+	int32_t read = 0;
+
+	/* FIFO_STATUS1 and FIFO_STATUS2 in one transfer */
+	if (lsm6dso_read_reg(&dev_ctx, LSM6DSO_FIFO_STATUS1, reg, 2) != 0)
+		return -1;
+	status->waiting = ((uint16_t)((lsm6dso_fifo_status2_t *)&reg[1])->diff_fifo << 8) |
+		((lsm6dso_fifo_status1_t *)&reg[0])->diff_fifo;
+	status->overrun = ((lsm6dso_fifo_status2_t *)&reg[1])->fifo_ovr_ia;
+
+	level = status->waiting < max_words ? status->waiting : max_words;
+	while (level > 0) {
+		burst = level < LSM6DSO_FIFO_BURST_WORDS ? level : LSM6DSO_FIFO_BURST_WORDS;
+
+		/* The address rolls back from FIFO_DATA_OUT_Z_H to FIFO_DATA_OUT_TAG, so one
+		 * read returns consecutive words */
+		if (lsm6dso_read_reg(&dev_ctx, LSM6DSO_FIFO_DATA_OUT_TAG, &words[read * LSM6DSO_FIFO_WORD_SIZE],
+			burst * LSM6DSO_FIFO_WORD_SIZE) != 0)
+			return -1;
+
+		level -= burst;
+		read += burst;
+	}
+	return read;
+}
+
+/* Hands each of count words read by lsm6dso_fifo_read() to handler. Does not touch the bus. */
+void lsm6dso_fifo_decode(const uint8_t *words, uint16_t count, lsm6dso_fifo_handler handler, void *context)
+{
+	int16_t data[3];
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		memcpy(data, &words[i * LSM6DSO_FIFO_WORD_SIZE + 1], sizeof(data));
+		handler(words[i * LSM6DSO_FIFO_WORD_SIZE] >> 3, data, context);
+	}
+}
 
 int lsm6dso_init(void *i2c_write, void *i2c_read)
 {
@@ -125,6 +369,9 @@ int lsm6dso_init(void *i2c_write, void *i2c_read)
 	dev_ctx.read_reg = i2c_read;
 	dev_ctx.handle = &lsm6dso_handle;
 
+	/* Keep a copy of the configuration registers, setters then skip most bus reads */
+	lsm6dso_shadow_set(&dev_ctx, &dev_shadow);
+
 	/* Check Device ID */
 	lsm6dso_device_id_get(&dev_ctx, &reg);
 	if (reg == LSM6DSO_ID) {
@@ -40,9 +40,44 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
+/* lsm6dso_read_raw() result: which readings were updated by the call */
+#define LSM6DSO_NEW_ACCELERATION	0x1
+#define LSM6DSO_NEW_ANGULAR_RATE	0x2
+#define LSM6DSO_NEW_TEMPERATURE		0x4
+
+/* FIFO streaming */
+#define LSM6DSO_FIFO_WORD_SIZE		7		/* tag byte and three 16-bit values */
+#define LSM6DSO_FIFO_BURST_WORDS	9		/* words per bus transfer, 63 bytes keeps within I2C_MAX_LEN */
+#define LSM6DSO_FIFO_WATERMARK_MAX	511		/* largest watermark, in words, the sensor takes */
+#define LSM6DSO_FIFO_WATERMARK_SAFE	255		/* watermark cap, the rest of the FIFO covers a late drain */
+
+/* Fixed-point sensitivities for lsm6dso_convert_*(), at the full scales set by lsm6dso_init() */
+#define LSM6DSO_FS4_UG_PER_LSB		122		/* acceleration, ug */
+#define LSM6DSO_FS2000_MDPS_PER_LSB	70		/* angular rate, mdps */
+#define LSM6DSO_CONVERT_CHUNK		8		/* triples lsm6dso_convert_float() converts per pass */
+
+/* lsm6dso_fifo_decode() handler, called for every word with its lsm6dso_fifo_tag_t */
+typedef void (*lsm6dso_fifo_handler)(uint8_t tag, const int16_t data[3], void *context);
+
+/* lsm6dso_fifo_read() status, from FIFO_STATUS1 and FIFO_STATUS2 before the read */
+typedef struct {
+	uint16_t waiting;	/* words in the FIFO */
+	uint8_t overrun;	/* the FIFO was full and the oldest words were overwritten */
+} lsm6dso_fifo_status_t;
+
 void lsm6dso_show_result(void);
 int lsm6dso_init(void *i2c_write, void *i2c_read);
 float get_temperature(void);
+uint32_t lsm6dso_read_raw(int16_t acceleration[3], int16_t angular_rate[3], int16_t *temperature);
+void lsm6dso_set_sample_period(uint32_t period_ms);
+uint32_t lsm6dso_fifo_start(uint32_t period_ms, uint32_t *latency_ms);
+void lsm6dso_fifo_stop(void);
+int32_t lsm6dso_fifo_read(uint8_t *words, uint16_t max_words, lsm6dso_fifo_status_t *status);
+void lsm6dso_fifo_decode(const uint8_t *words, uint16_t count, lsm6dso_fifo_handler handler, void *context);
+void lsm6dso_convert_fixed(const int16_t *raw, const int16_t offset[3], int16_t scale, int32_t *out, uint32_t count);
+void lsm6dso_convert_float(const int16_t *raw, const int16_t offset[3], int16_t scale, float unit, float *out, uint32_t count);
 
 
 #ifdef __cplusplus
@@ -53,6 +53,131 @@
   *
 */
 
+#define LSM6DSO_SHADOW_BANK_UNKNOWN          0xFFU
+
+/**
+  * @brief  Registers held in the shadow cache: FUNC_CFG_ACCESS, and the
+  *         user bank configuration registers while that bank is selected.
+  *         Registers with self-clearing bits (COUNTER_BDR_REG1) are left
+  *         out, CTRL3_C is kept without its SW_RESET and BOOT bits.
+  *
+  * @param  shadow  register cache(ptr)
+  * @param  reg     register address
+  * @retval         1 when the register is cached
+  *
+  */
+static uint8_t lsm6dso_shadow_cached(lsm6dso_shadow_t *shadow, uint16_t reg)
+{
+  uint8_t ret;
+
+  if (reg == LSM6DSO_FUNC_CFG_ACCESS) {
+    ret = 1U;
+  }
+  else if (shadow->mem_bank != (uint8_t)LSM6DSO_USER_BANK) {
+    ret = 0U;
+  }
+  else if ( (reg == LSM6DSO_PIN_CTRL) ||
+            ( (reg >= LSM6DSO_FIFO_CTRL1) && (reg <= LSM6DSO_FIFO_CTRL4) ) ||
+            ( (reg >= LSM6DSO_COUNTER_BDR_REG2) && (reg <= LSM6DSO_INT2_CTRL) ) ||
+            ( (reg >= LSM6DSO_CTRL1_XL) && (reg <= LSM6DSO_CTRL10_C) ) ||
+            ( (reg >= LSM6DSO_TAP_CFG0) && (reg <= LSM6DSO_MD2_CFG) ) ||
+            (reg == LSM6DSO_I3C_BUS_AVB) ||
+            ( (reg >= LSM6DSO_X_OFS_USR) && (reg <= LSM6DSO_Z_OFS_USR) ) ) {
+    ret = 1U;
+  }
+  else {
+    ret = 0U;
+  }
+  return ret;
+}
+
+/**
+  * @brief  Drop all cached register values.
+  *
+  * @param  shadow  register cache(ptr)
+  *
+  */
+static void lsm6dso_shadow_invalidate(lsm6dso_shadow_t *shadow)
+{
+  uint8_t i;
+
+  for (i = 0U; i < (LSM6DSO_SHADOW_SIZE / 8U); i++) {
+    shadow->valid[i] = 0U;
+  }
+}
+
+/**
+  * @brief  Cached copy of consecutive registers.
+  *
+  * @param  shadow  register cache(ptr)
+  * @param  reg     first register
+  * @param  data    compared with the cached values when cmp is set,
+  *                 filled with them otherwise(ptr)
+  * @param  len     number of consecutive registers
+  * @param  cmp     compare instead of copy
+  * @retval         1 when all the registers are cached (and equal to
+  *                 data with cmp set)
+  *
+  */
+static uint8_t lsm6dso_shadow_get(lsm6dso_shadow_t *shadow, uint8_t reg,
+                                  uint8_t *data, uint16_t len, uint8_t cmp)
+{
+  uint16_t addr;
+  uint16_t i;
+
+  for (i = 0U; i < len; i++) {
+    addr = (uint16_t)reg + i;
+    if ( (lsm6dso_shadow_cached(shadow, addr) == 0U) ||
+         ( (shadow->valid[addr / 8U] & (1U << (addr % 8U))) == 0U ) ||
+         ( (cmp != 0U) && (shadow->reg[addr] != data[i]) ) ) {
+      return 0U;
+    }
+  }
+  if (cmp == 0U) {
+    for (i = 0U; i < len; i++) {
+      data[i] = shadow->reg[(uint16_t)reg + i];
+    }
+  }
+  return 1U;
+}
+
+/**
+  * @brief  Store consecutive registers read from or written to the device.
+  *
+  * @param  shadow  register cache(ptr)
+  * @param  reg     first register
+  * @param  data    register values(ptr)
+  * @param  len     number of consecutive registers
+  *
+  */
+static void lsm6dso_shadow_put(lsm6dso_shadow_t *shadow, uint8_t reg,
+                               uint8_t *data, uint16_t len)
+{
+  lsm6dso_ctrl3_c_t *ctrl3_c;
+  uint16_t addr;
+  uint16_t i;
+
+  for (i = 0U; i < len; i++) {
+    addr = (uint16_t)reg + i;
+    if (addr == LSM6DSO_FUNC_CFG_ACCESS) {
+      shadow->mem_bank = ((lsm6dso_func_cfg_access_t*)&data[i])->reg_access;
+    }
+    if (lsm6dso_shadow_cached(shadow, addr) == 0U) {
+      continue;
+    }
+    if (addr == LSM6DSO_CTRL3_C) {
+      ctrl3_c = (lsm6dso_ctrl3_c_t*)&data[i];
+      if ( (ctrl3_c->sw_reset != 0U) || (ctrl3_c->boot != 0U) ) {
+        /* restoring the default values, the device has to be read again */
+        lsm6dso_shadow_invalidate(shadow);
+        return;
+      }
+    }
+    shadow->reg[addr] = data[i];
+    shadow->valid[addr / 8U] |= (uint8_t)(1U << (addr % 8U));
+  }
+}
+
 /**
   * @brief  Read generic device register
   *
@@ -67,7 +192,16 @@ int32_t lsm6dso_read_reg(lsm6dso_ctx_t* ctx, uint8_t reg, uint8_t* data,
                          uint16_t len)
 {
   int32_t ret;
+
+  if (ctx->shadow != NULL) {
+    if (lsm6dso_shadow_get(ctx->shadow, reg, data, len, 0U) == 1U) {
+      return 0;
+    }
+  }
   ret = ctx->read_reg(ctx->handle, reg, data, len);
+  if ( (ret == 0) && (ctx->shadow != NULL) ) {
+    lsm6dso_shadow_put(ctx->shadow, reg, data, len);
+  }
   return ret;
 }
 
@@ -85,7 +219,52 @@ int32_t lsm6dso_write_reg(lsm6dso_ctx_t* ctx, uint8_t reg, uint8_t* data,
                           uint16_t len)
 {
   int32_t ret;
+
+  if (ctx->shadow != NULL) {
+    /* the device already holds these values */
+    if (lsm6dso_shadow_get(ctx->shadow, reg, data, len, 1U) == 1U) {
+      return 0;
+    }
+  }
   ret = ctx->write_reg(ctx->handle, reg, data, len);
+  if (ctx->shadow != NULL) {
+    if (ret == 0) {
+      lsm6dso_shadow_put(ctx->shadow, reg, data, len);
+    }
+    else {
+      /* unknown what the device got, stop using the cache until the
+         register bank is known again */
+      lsm6dso_shadow_invalidate(ctx->shadow);
+      ctx->shadow->mem_bank = LSM6DSO_SHADOW_BANK_UNKNOWN;
+    }
+  }
+  return ret;
+}
+
+/**
+  * @brief  Attach a write-through shadow of the configuration registers.
+  *         Setters then skip the register read of their read-modify-write
+  *         and skip the write when the value does not change. A software
+  *         reset or reboot through CTRL3_C empties the shadow. Call it
+  *         again after the device changed behind the driver's back
+  *         (power cycle, other bus master).[set]
+  *
+  * @param  ctx      read / write interface definitions
+  * @param  val      register cache, NULL to stop using it
+  *
+  */
+int32_t lsm6dso_shadow_set(lsm6dso_ctx_t *ctx, lsm6dso_shadow_t *val)
+{
+  lsm6dso_func_cfg_access_t reg;
+  int32_t ret = 0;
+
+  ctx->shadow = val;
+  if (val != NULL) {
+    lsm6dso_shadow_invalidate(val);
+    val->mem_bank = LSM6DSO_SHADOW_BANK_UNKNOWN;
+    /* learn the selected register bank */
+    ret = lsm6dso_read_reg(ctx, LSM6DSO_FUNC_CFG_ACCESS, (uint8_t*)&reg, 1);
+  }
   return ret;
 }
 
@@ -1075,6 +1254,25 @@ int32_t lsm6dso_acceleration_raw_get(lsm6dso_ctx_t *ctx, uint8_t *buff)
   return ret;
 }
 
+/**
+  * @brief  Status, temperature, angular rate and linear acceleration
+  *         output registers (STATUS_REG to OUTZ_H_A) in a single
+  *         multiple-byte read. Needs register address auto-increment
+  *         (IF_INC in CTRL3_C, enabled by default).[get]
+  *
+  * @param  ctx      read / write interface definitions
+  * @param  val      buffer that stores data read
+  *
+  */
+int32_t lsm6dso_output_block_raw_get(lsm6dso_ctx_t *ctx,
+                                     lsm6dso_output_block_t *val)
+{
+  int32_t ret;
+  ret = lsm6dso_read_reg(ctx, LSM6DSO_STATUS_REG, val->u8bit,
+                         LSM6DSO_OUTPUT_BLOCK_LEN);
+  return ret;
+}
+
 /**
   * @brief  FIFO data output [get]
   *
@@ -45,6 +45,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
+#include <stddef.h>
 #include <math.h>
 
 /** @addtogroup LSM6DSO
@@ -129,12 +130,22 @@ typedef struct{
 typedef int32_t (*lsm6dso_write_ptr)(int*, uint8_t, uint8_t*, uint16_t);
 typedef int32_t (*lsm6dso_read_ptr) (int*, uint8_t, uint8_t*, uint16_t);
 
+/** Write-through copy of the user bank configuration registers **/
+#define LSM6DSO_SHADOW_SIZE                  0x80U
+typedef struct {
+  uint8_t  reg[LSM6DSO_SHADOW_SIZE];        /* indexed by register address */
+  uint8_t  valid[LSM6DSO_SHADOW_SIZE / 8U];
+  uint8_t  mem_bank;                        /* reg_access of FUNC_CFG_ACCESS */
+} lsm6dso_shadow_t;
+
 typedef struct {
   /** Component mandatory fields **/
   lsm6dso_write_ptr  write_reg;
   lsm6dso_read_ptr   read_reg;
   /** Customizable optional pointer **/
   int *handle;
+  /** Optional register cache, NULL when not used (lsm6dso_shadow_set) **/
+  lsm6dso_shadow_t *shadow;
 } lsm6dso_ctx_t;
 
 /**
@@ -414,6 +425,19 @@ typedef struct {
 #define LSM6DSO_OUTY_H_A                     0x2BU
 #define LSM6DSO_OUTZ_L_A                     0x2CU
 #define LSM6DSO_OUTZ_H_A                     0x2DU
+
+/* STATUS_REG to OUTZ_H_A, read in one auto-increment transfer */
+#define LSM6DSO_OUTPUT_BLOCK_LEN             16U
+typedef union{
+  struct {
+    lsm6dso_status_reg_t           status_reg;
+    uint8_t                        not_used_01;
+    int16_t                        temperature;
+    int16_t                        angular_rate[3];
+    int16_t                        acceleration[3];
+  } out;
+  uint8_t u8bit[LSM6DSO_OUTPUT_BLOCK_LEN];
+} lsm6dso_output_block_t;
 #define LSM6DSO_EMB_FUNC_STATUS_MAINPAGE     0x35U
 typedef struct {
   uint8_t not_used_01             : 3;
@@ -1552,6 +1576,7 @@ int32_t lsm6dso_read_reg(lsm6dso_ctx_t *ctx, uint8_t reg, uint8_t* data,
                          uint16_t len);
 int32_t lsm6dso_write_reg(lsm6dso_ctx_t *ctx, uint8_t reg, uint8_t* data,
                           uint16_t len);
+int32_t lsm6dso_shadow_set(lsm6dso_ctx_t *ctx, lsm6dso_shadow_t *val);
 
 extern float_t lsm6dso_from_fs2_to_mg(int16_t lsb);
 extern float_t lsm6dso_from_fs4_to_mg(int16_t lsb);
@@ -1704,6 +1729,9 @@ int32_t lsm6dso_angular_rate_raw_get(lsm6dso_ctx_t *ctx, uint8_t *buff);
 
 int32_t lsm6dso_acceleration_raw_get(lsm6dso_ctx_t *ctx, uint8_t *buff);
 
+int32_t lsm6dso_output_block_raw_get(lsm6dso_ctx_t *ctx,
+                                     lsm6dso_output_block_t *val);
+
 int32_t lsm6dso_fifo_out_raw_get(lsm6dso_ctx_t *ctx, uint8_t *buff);
 
 int32_t lsm6dso_number_of_steps_get(lsm6dso_ctx_t *ctx, uint8_t *buff);
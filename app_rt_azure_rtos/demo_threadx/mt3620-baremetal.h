@@ -38,6 +38,15 @@ static inline void WriteReg8(uintptr_t baseAddr, size_t offset, uint8_t value)
     *(volatile uint8_t *)(baseAddr + offset) = value;
 }
 
+#ifdef INTERCORE_HOST_SIM
+
+// Host simulator build, see tools/intercore_sim: the register accesses go to a simulated
+// mailbox instead of memory.
+void WriteReg32(uintptr_t baseAddr, size_t offset, uint32_t value);
+uint32_t ReadReg32(uintptr_t baseAddr, size_t offset);
+
+#else
+
 /// <summary>
 /// Write the supplied 32-bit value to an address formed from the supplied base
 /// address and offset.
@@ -64,6 +73,8 @@ static inline uint32_t ReadReg32(uintptr_t baseAddr, size_t offset)
     return *(volatile uint32_t *)(baseAddr + offset);
 }
 
+#endif // #ifdef INTERCORE_HOST_SIM
+
 /// <summary>
 /// <para>Read a 32-bit register from the supplied address, clear the supplied bits,
 /// and write the new value back to the register.</para>
@@ -5,28 +5,74 @@
 
 #include "mt3620-baremetal.h"
 #include "mt3620-intercore.h"
+#include "mt3620.h"
 //#include "mt3620-uart-poll.h"
 
 static const uintptr_t MAILBOX_BASE = 0x21050000;
 
-static void ReceiveMessage(uint32_t *command, uint32_t *data);
+/// <summary>Raised by the high-level core when it has written a message (SW_RX_INT bit 0).</summary>
+#define MAILBOX_SW_INT_MSG_SENT (1U << 0)
+/// <summary>Raised by the high-level core when it has read a message (SW_RX_INT bit 1).</summary>
+#define MAILBOX_SW_INT_MSG_RECEIVED (1U << 1)
+
+/// <summary>Commits which are timed at once, later ones are not timed until a slot frees.</summary>
+#define LATENCY_SLOTS 8
+
+static volatile Callback receiveHandler = NULL;
+static volatile Callback spaceHandler = NULL;
+static bool mailboxIrqInstalled = false;
+
+static IntercoreStats stats;
+static BufferHeader *statsInbound, *statsOutbound;
+static uint32_t statsBufSize;
+// Next inbound block not yet counted, so blocks peeked more than once are counted once.
+static uint32_t countedReadPosition;
+
+// Commit times of outbound blocks not yet released, as a queue filled by the sender and
+// emptied by whichever context sees the high-level application's read position move.
+static uint32_t (*volatile latencyClock)(void) = NULL;
+static struct {
+    uint32_t end;       // committedBytes once this block was committed
+    uint32_t time;
+} latencySlots[LATENCY_SLOTS];
+static volatile uint32_t latencyHead, latencyTail;
+static volatile uint32_t committedBytes;    // ring bytes committed, wraps
+
+static void MailboxSwIrqHandler(void);
+static void SetMailboxSwIntHandler(volatile Callback *slot, uint32_t bit, Callback handler);
+static int ReceiveMessage(uint32_t *command, uint32_t *data, Callback wait, uint32_t maxWaits);
 static uint32_t GetBufferSize(uint32_t bufferBase);
 static BufferHeader *GetBufferHeader(uint32_t bufferBase);
 static uint8_t *DataAreaOffset8(BufferHeader *header, size_t offset);
 static uint32_t *DataAreaOffset32(BufferHeader *header, size_t offset);
 static uint32_t RoundUp(uint32_t value, uint32_t alignment);
+static int PeekBlock(BufferHeader *inbound, uint32_t bufSize, uint32_t remoteWritePosition,
+                     uint32_t localReadPosition, IntercoreBlock *block);
+static uint32_t NextBlockPosition(const IntercoreBlock *block, uint32_t bufSize);
+static void UpdateLatency(void);
 
-static void ReceiveMessage(uint32_t *command, uint32_t *data)
+static int ReceiveMessage(uint32_t *command, uint32_t *data, Callback wait, uint32_t maxWaits)
 {
+    uint32_t waits = 0;
+
     // FIFO_POP_CNT
     while (ReadReg32(MAILBOX_BASE, 0x58) == 0) {
-        // empty.
+        if (wait == NULL) {
+            continue;
+        }
+
+        if (maxWaits != 0 && waits++ == maxWaits) {
+            return -1;
+        }
+
+        wait();
     }
 
     // DATA_POP0
     *data = ReadReg32(MAILBOX_BASE, 0x54);
     // CMD_POP0
     *command = ReadReg32(MAILBOX_BASE, 0x50);
+    return 0;
 }
 
 static uint32_t GetBufferSize(uint32_t bufferBase)
@@ -41,11 +87,23 @@ static BufferHeader *GetBufferHeader(uint32_t bufferBase)
 
 int GetIntercoreBuffers(BufferHeader **outbound, BufferHeader **inbound, uint32_t *bufSize)
 {
+    return GetIntercoreBuffersWait(outbound, inbound, bufSize, NULL, 0);
+}
+
+int GetIntercoreBuffersWait(BufferHeader **outbound, BufferHeader **inbound, uint32_t *bufSize,
+                            Callback wait, uint32_t maxWaits)
+{
+    // Setup commands received so far, kept so that a call which times out part way through
+    // can be resumed by the next one.
+    static uint32_t baseRead = 0, baseWrite = 0;
+
     // Wait for the mailbox to be set up.
-    uint32_t baseRead = 0, baseWrite = 0;
     while (true) {
         uint32_t cmd, data;
-        ReceiveMessage(&cmd, &data);
+        if (ReceiveMessage(&cmd, &data, wait, maxWaits) == -1) {
+            return -1;
+        }
+
         if (cmd == 0xba5e0001) {
             baseWrite = data;
         } else if (cmd == 0xba5e0002) {
@@ -72,9 +130,60 @@ int GetIntercoreBuffers(BufferHeader **outbound, BufferHeader **inbound, uint32_
     *inbound = GetBufferHeader(baseRead);
     *outbound = GetBufferHeader(baseWrite);
 
+    statsInbound = *inbound;
+    statsOutbound = *outbound;
+    statsBufSize = *bufSize;
+    countedReadPosition = (*outbound)->readPosition;
+
     return 0;
 }
 
+static void MailboxSwIrqHandler(void)
+{
+    // SW_RX_INT_STS, write 1 to clear.
+    uint32_t status = ReadReg32(MAILBOX_BASE, 0x1C);
+    WriteReg32(MAILBOX_BASE, 0x1C, status);
+
+    if ((status & MAILBOX_SW_INT_MSG_SENT) && receiveHandler != NULL) {
+        receiveHandler();
+    }
+
+    if ((status & MAILBOX_SW_INT_MSG_RECEIVED) && spaceHandler != NULL) {
+        UpdateLatency();
+        spaceHandler();
+    }
+}
+
+static void SetMailboxSwIntHandler(volatile Callback *slot, uint32_t bit, Callback handler)
+{
+    *slot = handler;
+
+    if (!mailboxIrqInstalled) {
+        // SW_RX_INT_STS, discard anything raised before the handler was installed.
+        WriteReg32(MAILBOX_BASE, 0x1C, ReadReg32(MAILBOX_BASE, 0x1C));
+        CM4_Install_NVIC(CM4_IRQ_A7N2M4_SW, DEFAULT_PRI, IRQ_LEVEL_TRIGGER, MailboxSwIrqHandler,
+                         TRUE);
+        mailboxIrqInstalled = true;
+    }
+
+    // SW_RX_INT_EN
+    if (handler != NULL) {
+        SetReg32(MAILBOX_BASE, 0x18, bit);
+    } else {
+        ClearReg32(MAILBOX_BASE, 0x18, bit);
+    }
+}
+
+void SetIntercoreReceiveHandler(Callback handler)
+{
+    SetMailboxSwIntHandler(&receiveHandler, MAILBOX_SW_INT_MSG_SENT, handler);
+}
+
+void SetIntercoreSpaceHandler(Callback handler)
+{
+    SetMailboxSwIntHandler(&spaceHandler, MAILBOX_SW_INT_MSG_RECEIVED, handler);
+}
+
 static uint8_t *DataAreaOffset8(BufferHeader *header, size_t offset)
 {
     // Data storage area following header in buffer.
@@ -96,17 +205,95 @@ static uint32_t RoundUp(uint32_t value, uint32_t alignment)
     return (value + (alignment - 1)) & ~(alignment - 1);
 }
 
-int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize, const void *src,
-                uint32_t dataSize)
+void Intercore_GetStats(IntercoreStats *dest)
+{
+    *dest = stats;
+}
+
+void Intercore_SetClock(uint32_t (*clock)(void))
+{
+    latencyTail = latencyHead;
+    latencyClock = clock;
+}
+
+static void UpdateLatency(void)
+{
+    uint32_t (*clock)(void) = latencyClock;
+
+    if (clock == NULL || statsOutbound == NULL || latencyTail == latencyHead) {
+        return;
+    }
+
+    // Every committed byte which is no longer between the read and write positions has been
+    // released.  The sender updates committedBytes after the write position, so a commit in
+    // progress can only make this an underestimate.
+    uint32_t writePosition = statsOutbound->writePosition;
+    uint32_t readPosition = statsInbound->readPosition;
+    if (readPosition >= statsBufSize) {
+        return;
+    }
+
+    uint32_t used = writePosition >= readPosition ? writePosition - readPosition
+                                                  : writePosition - readPosition + statsBufSize;
+    uint32_t released = committedBytes - used;
+    uint32_t now = clock();
+
+    while (latencyTail != latencyHead) {
+        uint32_t slot = latencyTail % LATENCY_SLOTS;
+        if ((int32_t)(released - latencySlots[slot].end) < 0) {
+            break;
+        }
+
+        uint32_t latency = now - latencySlots[slot].time;
+        if (latency > stats.maxLatency) {
+            stats.maxLatency = latency;
+        }
+        latencyTail = latencyTail + 1;
+    }
+}
+
+uint32_t Intercore_FreeSpace(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize)
+{
+    uint32_t remoteReadPosition = inbound->readPosition;
+    uint32_t localWritePosition = outbound->writePosition;
+
+    if (remoteReadPosition >= bufSize || bufSize - localWritePosition < sizeof(uint32_t)) {
+        return 0;
+    }
+
+    // Same accounting as Intercore_ReserveWrite: the space the reader has released, less the
+    // block size word and the alignment slack which keeps the buffer from appearing empty.
+    uint32_t availSpace;
+    if (remoteReadPosition <= localWritePosition) {
+        availSpace = remoteReadPosition - localWritePosition + bufSize;
+    } else {
+        availSpace = remoteReadPosition - localWritePosition;
+    }
+
+    if (availSpace < sizeof(uint32_t) + RINGBUFFER_ALIGNMENT) {
+        return 0;
+    }
+
+    return availSpace - sizeof(uint32_t) - RINGBUFFER_ALIGNMENT;
+}
+
+int Intercore_ReserveWrite(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
+                           uint32_t dataSize, IntercoreBlock *block)
 {
     uint32_t remoteReadPosition = inbound->readPosition;
     uint32_t localWritePosition = outbound->writePosition;
 
     if (remoteReadPosition >= bufSize) {
         //Uart_WriteStringPoll("EnqueueData: remoteReadPosition invalid\r\n");
+        stats.invalidPosition++;
         return -1;
     }
 
+    // Without the space interrupt, releases are only noticed here.
+    if (spaceHandler == NULL) {
+        UpdateLatency();
+    }
+
     // If the read pointer is behind the write pointer, then the free space wraps around.
     uint32_t availSpace;
     if (remoteReadPosition <= localWritePosition) {
@@ -118,6 +305,7 @@ int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
     // If there isn't enough space to enqueue a block, then abort the operation.
     if (availSpace < sizeof(uint32_t) + dataSize + RINGBUFFER_ALIGNMENT) {
         //Uart_WriteStringPoll("EnqueueData: not enough space to enqueue block\r\n");
+        stats.outboundFull++;
         return -1;
     }
 
@@ -129,45 +317,75 @@ int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
     // block size as a contiguous 4-byte value. The remainder of message can wrap around.
     if (dataToEnd < sizeof(uint32_t)) {
         //Uart_WriteStringPoll("EnqueueData: not enough space for block size\r\n");
+        stats.invalidPosition++;
         return -1;
     }
 
-    uint32_t writeToEnd = sizeof(uint32_t) + dataSize;
-    if (dataToEnd < writeToEnd) {
-        writeToEnd = dataToEnd;
+    uint32_t occupancy =
+        bufSize - availSpace + RoundUp(sizeof(uint32_t) + dataSize, RINGBUFFER_ALIGNMENT);
+    if (occupancy > stats.outboundHighWater) {
+        stats.outboundHighWater = occupancy;
     }
 
-    // Write block size to first word in block.
-    *DataAreaOffset32(outbound, localWritePosition) = dataSize;
-    writeToEnd -= sizeof(uint32_t);
+    uint32_t writeToEnd = dataToEnd - sizeof(uint32_t);
+    if (dataSize < writeToEnd) {
+        writeToEnd = dataSize;
+    }
 
-    const uint8_t *src8 = src;
-    uint8_t *dest8 = DataAreaOffset8(outbound, localWritePosition + sizeof(uint32_t));
+    block->position = localWritePosition;
+    block->seg0 = DataAreaOffset8(outbound, localWritePosition + sizeof(uint32_t));
+    block->seg0Size = writeToEnd;
+    block->seg1 = DataAreaOffset8(outbound, 0);
+    block->seg1Size = dataSize - writeToEnd;
 
-    __builtin_memcpy(dest8, src8, writeToEnd);
-    __builtin_memcpy(DataAreaOffset8(outbound, 0), src8 + writeToEnd, dataSize - writeToEnd);
+    return 0;
+}
+
+int Intercore_CommitWrite(BufferHeader *outbound, uint32_t bufSize, const IntercoreBlock *block,
+                          uint32_t dataSize)
+{
+    if (dataSize > Intercore_BlockSize(block)) {
+        return -1;
+    }
+
+    // Write block size to first word in block.
+    *DataAreaOffset32(outbound, block->position) = dataSize;
 
     // Advance write position.
-    localWritePosition =
-        RoundUp(localWritePosition + sizeof(uint32_t) + dataSize, RINGBUFFER_ALIGNMENT);
+    uint32_t localWritePosition =
+        RoundUp(block->position + sizeof(uint32_t) + dataSize, RINGBUFFER_ALIGNMENT);
     if (localWritePosition >= bufSize) {
         localWritePosition -= bufSize;
     }
+
+    uint32_t (*clock)(void) = latencyClock;
+    uint32_t advance = RoundUp(sizeof(uint32_t) + dataSize, RINGBUFFER_ALIGNMENT);
+    if (clock != NULL && latencyHead - latencyTail < LATENCY_SLOTS) {
+        uint32_t slot = latencyHead % LATENCY_SLOTS;
+        latencySlots[slot].end = committedBytes + advance;
+        latencySlots[slot].time = clock();
+        latencyHead = latencyHead + 1;
+    }
+
+    // The block contents must be visible to the other core before the new write position.
+    __sync_synchronize();
     outbound->writePosition = localWritePosition;
+    committedBytes = committedBytes + advance;
+
+    stats.messagesOut++;
+    stats.bytesOut += dataSize;
 
     // SW_TX_INT_PORT[0] = 1 -> indicate message sent.
     WriteReg32(MAILBOX_BASE, 0x14, 1U << 0);
     return 0;
 }
 
-int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize, void *dest,
-                uint32_t *dataSize)
+static int PeekBlock(BufferHeader *inbound, uint32_t bufSize, uint32_t remoteWritePosition,
+                     uint32_t localReadPosition, IntercoreBlock *block)
 {
-    uint32_t remoteWritePosition = inbound->writePosition;
-    uint32_t localReadPosition = outbound->readPosition;
-
     if (remoteWritePosition >= bufSize) {
         //Uart_WriteStringPoll("DequeueData: remoteWritePosition invalid\r\n");
+        stats.invalidPosition++;
         return -1;
     }
 
@@ -185,6 +403,7 @@ int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
     if (availData < sizeof(uint32_t)) {
         if (availData > 0) {
             //Uart_WriteStringPoll("DequeueData: availData < 4 bytes\r\n");
+            stats.invalidPosition++;
         }
 
         return -1;
@@ -193,6 +412,7 @@ int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
     size_t dataToEnd = bufSize - localReadPosition;
     if (dataToEnd < sizeof(uint32_t)) {
         //Uart_WriteStringPoll("DequeueData: dataToEnd < 4 bytes\r\n");
+        stats.invalidPosition++;
         return -1;
     }
 
@@ -201,19 +421,10 @@ int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
     // Ensure the block size is no greater than the available data.
     if (blockSize + sizeof(uint32_t) > availData) {
         //Uart_WriteStringPoll("DequeueData: message size greater than available data\r\n");
+        stats.invalidPosition++;
         return -1;
     }
 
-    // Abort if the caller-supplied buffer is not large enough to hold the message.
-    if (blockSize > *dataSize) {
-        //Uart_WriteStringPoll("DequeueData: message too large for buffer\r\n");
-        *dataSize = blockSize;
-        return -1;
-    }
-
-    // Tell the caller the actual block size.
-    *dataSize = blockSize;
-
     // Read up to the end of the buffer. If the block ends before then, only read up to the end
     // of the block.
     uint32_t readFromEnd = dataToEnd - sizeof(uint32_t);
@@ -221,23 +432,151 @@ int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
         readFromEnd = blockSize;
     }
 
-    const uint8_t *src8 = DataAreaOffset8(inbound, localReadPosition + sizeof(uint32_t));
-    uint8_t *dest8 = dest;
-    __builtin_memcpy(dest8, src8, readFromEnd);
-    // If block wrapped around the end of the buffer, then read remainder from start.
-    __builtin_memcpy(dest8 + readFromEnd, DataAreaOffset8(inbound, 0), blockSize - readFromEnd);
+    block->position = localReadPosition;
+    block->seg0 = DataAreaOffset8(inbound, localReadPosition + sizeof(uint32_t));
+    block->seg0Size = readFromEnd;
+    // If block wrapped around the end of the buffer, then the remainder is at the start.
+    block->seg1 = DataAreaOffset8(inbound, 0);
+    block->seg1Size = blockSize - readFromEnd;
+
+    if (localReadPosition == countedReadPosition) {
+        countedReadPosition = NextBlockPosition(block, bufSize);
+        stats.messagesIn++;
+        stats.bytesIn += blockSize;
+        if (availData > stats.inboundHighWater) {
+            stats.inboundHighWater = availData;
+        }
+    }
+
+    return 0;
+}
 
-    // Round read position to next aligned block, and wraparound end of buffer if required.
-    localReadPosition =
-        RoundUp(localReadPosition + sizeof(uint32_t) + blockSize, RINGBUFFER_ALIGNMENT);
-    if (localReadPosition >= bufSize) {
-        localReadPosition -= bufSize;
+static uint32_t NextBlockPosition(const IntercoreBlock *block, uint32_t bufSize)
+{
+    // Round to next aligned block, and wraparound end of buffer if required.
+    uint32_t position = RoundUp(block->position + sizeof(uint32_t) + Intercore_BlockSize(block),
+                                RINGBUFFER_ALIGNMENT);
+    if (position >= bufSize) {
+        position -= bufSize;
+    }
+
+    return position;
+}
+
+int Intercore_PeekRead(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
+                       IntercoreBlock *block)
+{
+    return PeekBlock(inbound, bufSize, inbound->writePosition, outbound->readPosition, block);
+}
+
+uint32_t DequeueBatch(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
+                      IntercoreBlock *blocks, uint32_t maxBlocks)
+{
+    uint32_t remoteWritePosition = inbound->writePosition;
+    uint32_t localReadPosition = outbound->readPosition;
+    uint32_t count = 0;
+
+    while (count < maxBlocks && localReadPosition != remoteWritePosition) {
+        if (PeekBlock(inbound, bufSize, remoteWritePosition, localReadPosition, &blocks[count])
+            == -1) {
+            break;
+        }
+
+        localReadPosition = NextBlockPosition(&blocks[count], bufSize);
+        ++count;
     }
 
+    return count;
+}
+
+void Intercore_ReleaseRead(BufferHeader *outbound, uint32_t bufSize, const IntercoreBlock *block)
+{
+    uint32_t localReadPosition = NextBlockPosition(block, bufSize);
+
+    // Finish reading the block before the other core is allowed to overwrite it.
+    __sync_synchronize();
     outbound->readPosition = localReadPosition;
 
     // SW_TX_INT_PORT[1] = 1 -> indicate message received.
     WriteReg32(MAILBOX_BASE, 0x14, 1U << 1);
+}
+
+void Intercore_CopyToBlock(const IntercoreBlock *block, uint32_t offset, const void *src,
+                           uint32_t length)
+{
+    const uint8_t *src8 = src;
+    uint32_t toEnd = 0;
+
+    if (offset < block->seg0Size) {
+        toEnd = block->seg0Size - offset;
+        if (length < toEnd) {
+            toEnd = length;
+        }
+        __builtin_memcpy(block->seg0 + offset, src8, toEnd);
+        offset = 0;
+    } else {
+        offset -= block->seg0Size;
+    }
+
+    __builtin_memcpy(block->seg1 + offset, src8 + toEnd, length - toEnd);
+}
+
+void Intercore_CopyFromBlock(const IntercoreBlock *block, uint32_t offset, void *dest,
+                             uint32_t length)
+{
+    uint8_t *dest8 = dest;
+    uint32_t toEnd = 0;
+
+    if (offset < block->seg0Size) {
+        toEnd = block->seg0Size - offset;
+        if (length < toEnd) {
+            toEnd = length;
+        }
+        __builtin_memcpy(dest8, block->seg0 + offset, toEnd);
+        offset = 0;
+    } else {
+        offset -= block->seg0Size;
+    }
+
+    __builtin_memcpy(dest8 + toEnd, block->seg1 + offset, length - toEnd);
+}
+
+int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize, const void *src,
+                uint32_t dataSize)
+{
+    IntercoreBlock block;
+
+    if (Intercore_ReserveWrite(inbound, outbound, bufSize, dataSize, &block) == -1) {
+        return -1;
+    }
+
+    Intercore_CopyToBlock(&block, 0, src, dataSize);
+    return Intercore_CommitWrite(outbound, bufSize, &block, dataSize);
+}
+
+int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize, void *dest,
+                uint32_t *dataSize)
+{
+    IntercoreBlock block;
+
+    if (Intercore_PeekRead(outbound, inbound, bufSize, &block) == -1) {
+        return -1;
+    }
+
+    uint32_t blockSize = Intercore_BlockSize(&block);
+
+    // Abort if the caller-supplied buffer is not large enough to hold the message.
+    if (blockSize > *dataSize) {
+        //Uart_WriteStringPoll("DequeueData: message too large for buffer\r\n");
+        *dataSize = blockSize;
+        return -1;
+    }
+
+    // Tell the caller the actual block size.
+    *dataSize = blockSize;
+
+    Intercore_CopyFromBlock(&block, 0, dest, blockSize);
+    Intercore_ReleaseRead(outbound, bufSize, &block);
 
     return 0;
 }
@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include "mt3620-baremetal.h"
+
 /// <summary>
 /// There are two buffers, inbound and outbound, which are used to track
 /// how much data has been written to, and read from, each shared buffer.
@@ -27,8 +29,58 @@ typedef struct {
     uint32_t reserved[14];
 } BufferHeader;
 
-/// <summary>Blocks inside the shared buffer have this alignment.</summary>
+/// <summary>Blocks inside the shared buffer have this alignment.  The high-level application
+/// expects 16; only the host simulator in tools/intercore_sim builds other values.</summary>
+#ifndef RINGBUFFER_ALIGNMENT
 #define RINGBUFFER_ALIGNMENT 16
+#endif
+
+/// <summary>
+/// <para>Describes the data area of one block inside a shared buffer, so it can be written
+/// or read in place.  A block which wraps around the end of the buffer is split into two
+/// segments; otherwise the second segment is empty.</para>
+/// <para>Filled in by <see cref="Intercore_ReserveWrite" /> and
+/// <see cref="Intercore_PeekRead" />.</para>
+/// </summary>
+typedef struct {
+    /// <summary>Start of the block's data.</summary>
+    uint8_t *seg0;
+    /// <summary>Number of bytes at <see cref="seg0" />.</summary>
+    uint32_t seg0Size;
+    /// <summary>Continuation of the block's data at the start of the buffer.</summary>
+    uint8_t *seg1;
+    /// <summary>Number of bytes at <see cref="seg1" />, zero if the block does not wrap.</summary>
+    uint32_t seg1Size;
+    /// <summary>Offset of the block's size word within the shared buffer.</summary>
+    uint32_t position;
+} IntercoreBlock;
+
+/// <summary>
+/// Counters kept by the enqueue and dequeue functions, see <see cref="Intercore_GetStats" />.
+/// Byte counts are payload bytes; occupancy includes the block size words and alignment.
+/// </summary>
+typedef struct {
+    /// <summary>Blocks committed to the outbound buffer.</summary>
+    uint32_t messagesOut;
+    /// <summary>Payload bytes committed to the outbound buffer.</summary>
+    uint32_t bytesOut;
+    /// <summary>Blocks read from the inbound buffer.</summary>
+    uint32_t messagesIn;
+    /// <summary>Payload bytes read from the inbound buffer.</summary>
+    uint32_t bytesIn;
+    /// <summary>Most bytes in use in the outbound buffer, including a newly reserved block.</summary>
+    uint32_t outboundHighWater;
+    /// <summary>Most bytes waiting to be read in the inbound buffer.</summary>
+    uint32_t inboundHighWater;
+    /// <summary>Reservations refused because the outbound buffer was full.</summary>
+    uint32_t outboundFull;
+    /// <summary>Positions or block sizes from the other core which were out of range.</summary>
+    uint32_t invalidPosition;
+    /// <summary>Longest time from committing a block to the high-level application releasing
+    /// it, in units of the clock set with <see cref="Intercore_SetClock" />; 0 without a clock.
+    /// </summary>
+    uint32_t maxLatency;
+} IntercoreStats;
 
 /// <summary>
 /// <para>Gets the inbound and outbound buffers used to communicate with the high-level
@@ -44,6 +96,74 @@ typedef struct {
 /// <returns>0 on success, -1 on failure.</returns>
 int GetIntercoreBuffers(BufferHeader **outbound, BufferHeader **inbound, uint32_t *bufSize);
 
+/// <summary>
+/// <para>As <see cref="GetIntercoreBuffers" />, but calls wait whenever the mailbox is empty
+/// instead of spinning on it, so that an RTOS thread can sleep until the high-level
+/// application has set the mailbox up.</para>
+/// <para>If maxWaits is not 0 and the mailbox is still empty after that many calls to wait,
+/// returns -1; setup commands already received are kept, so a later call resumes.</para>
+/// </summary>
+/// <param name="outbound">See <see cref="GetIntercoreBuffers" />.</param>
+/// <param name="inbound">See <see cref="GetIntercoreBuffers" />.</param>
+/// <param name="bufSize">See <see cref="GetIntercoreBuffers" />.</param>
+/// <param name="wait">Called while the mailbox is empty, or NULL to spin.</param>
+/// <param name="maxWaits">Calls to wait before giving up, or 0 to wait indefinitely.</param>
+/// <returns>0 on success, -1 on timeout or if the buffers are invalid.</returns>
+int GetIntercoreBuffersWait(BufferHeader **outbound, BufferHeader **inbound, uint32_t *bufSize,
+                            Callback wait, uint32_t maxWaits);
+
+/// <summary>
+/// <para>Registers a handler which is called whenever the high-level application signals
+/// that it has written a message to the inbound buffer.  This installs the mailbox
+/// software interrupt, so readers can block until data arrives instead of polling.</para>
+/// <para>The handler runs in interrupt context.  It should only wake the thread which calls
+/// <see cref="DequeueData" />, for example by releasing a semaphore.</para>
+/// <para>Call this after <see cref="GetIntercoreBuffers" /> has succeeded.</para>
+/// </summary>
+/// <param name="handler">Function to call from the mailbox interrupt, or NULL to disable
+/// the notification.</param>
+void SetIntercoreReceiveHandler(Callback handler);
+
+/// <summary>
+/// <para>Registers a handler which is called whenever the high-level application signals
+/// that it has read a message from the outbound buffer, and so has freed space.  Senders
+/// which found the buffer full can wait for this instead of dropping data.</para>
+/// <para>The handler runs in interrupt context.</para>
+/// </summary>
+/// <param name="handler">Function to call from the mailbox interrupt, or NULL to disable
+/// the notification.</param>
+void SetIntercoreSpaceHandler(Callback handler);
+
+/// <summary>
+/// Copies the counters kept since <see cref="GetIntercoreBuffers" /> was called.
+/// </summary>
+void Intercore_GetStats(IntercoreStats *stats);
+
+/// <summary>
+/// <para>Sets the clock used to time blocks from <see cref="Intercore_CommitWrite" /> until
+/// the high-level application releases them, reported as
+/// <see cref="IntercoreStats.maxLatency" />.  Release is seen by the interrupt registered
+/// with <see cref="SetIntercoreSpaceHandler" />, or else on the next reservation.</para>
+/// <para>The clock is called from interrupt context.</para>
+/// </summary>
+/// <param name="clock">Free-running counter, or NULL to stop timing.</param>
+void Intercore_SetClock(uint32_t (*clock)(void));
+
+/// <summary>
+/// Gets the credit which the high-level application has advertised through its read
+/// position: the largest block which could be enqueued right now.
+/// </summary>
+/// <param name="inbound">The inbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">
+/// The total buffer size, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <returns>Free space in bytes, 0 if the buffer is full or the read position is invalid.
+/// </returns>
+uint32_t Intercore_FreeSpace(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize);
+
 /// <summary>
 /// Add data to the shared buffer, to be read by the high-level application.
 /// </summary>
@@ -76,4 +196,116 @@ int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
 int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize, void *dest,
                 uint32_t *dataSize);
 
+/// <summary>
+/// <para>Reserves space for a block in the shared buffer, without copying any data.  The
+/// caller writes the data in place, for example with <see cref="Intercore_CopyToBlock" />,
+/// and then publishes it with <see cref="Intercore_CommitWrite" />.</para>
+/// <para>Only one block can be reserved at a time.</para>
+/// </summary>
+/// <param name="inbound">The inbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">
+/// The total buffer size, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="dataSize">Maximum length of the block in bytes.</param>
+/// <param name="block">On success, describes where the data should be written.</param>
+/// <returns>0 if the space was reserved, -1 otherwise.</returns>
+int Intercore_ReserveWrite(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
+                           uint32_t dataSize, IntercoreBlock *block);
+
+/// <summary>
+/// Publishes a block obtained from <see cref="Intercore_ReserveWrite" /> to the high-level
+/// application.
+/// </summary>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">
+/// The total buffer size, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="block">The reserved block.</param>
+/// <param name="dataSize">Number of bytes which were written, which must not exceed the
+/// reserved size.</param>
+/// <returns>0 if the block was published, -1 otherwise.</returns>
+int Intercore_CommitWrite(BufferHeader *outbound, uint32_t bufSize, const IntercoreBlock *block,
+                          uint32_t dataSize);
+
+/// <summary>
+/// <para>Finds the next block written by the high-level application, without copying or
+/// removing it.  The data can be read in place until the block is released with
+/// <see cref="Intercore_ReleaseRead" />.</para>
+/// </summary>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="inbound">The inbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">Total size of shared buffer in bytes.</param>
+/// <param name="block">On success, describes where the block's data is.</param>
+/// <returns>0 if a block is available, -1 otherwise.</returns>
+int Intercore_PeekRead(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
+                       IntercoreBlock *block);
+
+/// <summary>
+/// <para>Finds every complete block written by the high-level application, up to a budget,
+/// without copying or removing them.</para>
+/// <para>Release the whole batch with a single call to <see cref="Intercore_ReleaseRead" />
+/// on the last block, which advances the read position and signals the high-level
+/// application once.</para>
+/// </summary>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="inbound">The inbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">Total size of shared buffer in bytes.</param>
+/// <param name="blocks">Array which receives a descriptor for each block, in order.</param>
+/// <param name="maxBlocks">Number of elements in blocks.</param>
+/// <returns>Number of blocks found, 0 if none are available.</returns>
+uint32_t DequeueBatch(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
+                      IntercoreBlock *blocks, uint32_t maxBlocks);
+
+/// <summary>
+/// Removes a block obtained from <see cref="Intercore_PeekRead" /> or
+/// <see cref="DequeueBatch" /> from the shared buffer, together with every block before it,
+/// and tells the high-level application that the space is free.
+/// </summary>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">Total size of shared buffer in bytes.</param>
+/// <param name="block">The block to release.</param>
+void Intercore_ReleaseRead(BufferHeader *outbound, uint32_t bufSize, const IntercoreBlock *block);
+
+/// <summary>Gets the number of data bytes in a block.</summary>
+/// <param name="block">A block obtained from <see cref="Intercore_ReserveWrite" /> or
+/// <see cref="Intercore_PeekRead" />.</param>
+/// <returns>Block size in bytes.</returns>
+static inline uint32_t Intercore_BlockSize(const IntercoreBlock *block)
+{
+    return block->seg0Size + block->seg1Size;
+}
+
+/// <summary>
+/// Copies data into a reserved block, handling a block which wraps around the end of the
+/// shared buffer.
+/// </summary>
+/// <param name="block">A block obtained from <see cref="Intercore_ReserveWrite" />.</param>
+/// <param name="offset">Offset within the block to write to.</param>
+/// <param name="src">Start of data to write.</param>
+/// <param name="length">Number of bytes to write.  offset + length must not exceed the
+/// block size.</param>
+void Intercore_CopyToBlock(const IntercoreBlock *block, uint32_t offset, const void *src,
+                           uint32_t length);
+
+/// <summary>
+/// Copies data out of a block, handling a block which wraps around the end of the shared
+/// buffer.
+/// </summary>
+/// <param name="block">A block obtained from <see cref="Intercore_PeekRead" />.</param>
+/// <param name="offset">Offset within the block to read from.</param>
+/// <param name="dest">Data is copied into this buffer.</param>
+/// <param name="length">Number of bytes to read.  offset + length must not exceed the
+/// block size.</param>
+void Intercore_CopyFromBlock(const IntercoreBlock *block, uint32_t offset, void *dest,
+                             uint32_t length);
+
 #endif // #ifndef MT3620_INTERCORE_H
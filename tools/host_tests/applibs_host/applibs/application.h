@@ -0,0 +1,13 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the Azure Sphere Application API. Application_Connect returns one end of
+// a SOCK_SEQPACKET socketpair, which keeps message boundaries as the inter-core socket does;
+// the test plays the real-time app on the other end, see applibs_host.h.
+
+#ifndef APPLIBS_APPLICATION_H
+#define APPLIBS_APPLICATION_H
+
+int Application_Connect(const char *componentId);
+
+#endif // #ifndef APPLIBS_APPLICATION_H
@@ -0,0 +1,12 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the Azure Sphere Log API. Output is dropped unless HOST_LOG is set in
+// the environment, so benchmarks are not slowed down by it.
+
+#ifndef APPLIBS_LOG_H
+#define APPLIBS_LOG_H
+
+int Log_Debug(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif // #ifndef APPLIBS_LOG_H
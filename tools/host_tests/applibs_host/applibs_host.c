@@ -0,0 +1,204 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-ins for the parts of applibs used by learning_path_libs. The event loop is a
+// level-triggered epoll set, as on the device, so a socket which still holds messages after
+// its callback returns is dispatched again on the next EventLoop_Run.
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <applibs/application.h>
+#include <applibs/eventloop.h>
+#include <applibs/log.h>
+
+#include "applibs_host.h"
+
+struct EventLoop {
+    int epollFd;
+};
+
+struct EventRegistration {
+    int fd;
+    EventLoopIoCallback *callback;
+    void *context;
+};
+
+static int peerFd = -1;
+static int registrations;
+static HostEventLoopStats loopStats;
+
+static uint32_t ToEpoll(EventLoop_IoEvents events)
+{
+    return ((events & EventLoop_Input) ? EPOLLIN : 0) |
+           ((events & EventLoop_Output) ? EPOLLOUT : 0);
+}
+
+static EventLoop_IoEvents FromEpoll(uint32_t events)
+{
+    return ((events & EPOLLIN) ? EventLoop_Input : 0) |
+           ((events & EPOLLOUT) ? EventLoop_Output : 0) |
+           ((events & (EPOLLERR | EPOLLHUP)) ? EventLoop_Error : 0);
+}
+
+EventLoop *EventLoop_Create(void)
+{
+    EventLoop *el = malloc(sizeof(EventLoop));
+    if (el == NULL) {
+        return NULL;
+    }
+
+    el->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (el->epollFd == -1) {
+        free(el);
+        return NULL;
+    }
+    return el;
+}
+
+void EventLoop_Close(EventLoop *el)
+{
+    if (el != NULL) {
+        close(el->epollFd);
+        free(el);
+    }
+}
+
+EventLoop_Run_Result EventLoop_Run(EventLoop *el, int duration_in_milliseconds,
+                                   bool process_one_event)
+{
+    struct epoll_event events[16];
+
+    int count = epoll_wait(el->epollFd, events, process_one_event ? 1 : 16,
+                           duration_in_milliseconds);
+    if (count == -1) {
+        return EventLoop_Run_Failed;
+    }
+    if (count == 0) {
+        return EventLoop_Run_FinishedEmpty;
+    }
+
+    loopStats.runs++;
+    for (int i = 0; i < count; i++) {
+        EventRegistration *reg = events[i].data.ptr;
+        loopStats.dispatches++;
+        reg->callback(el, reg->fd, FromEpoll(events[i].events), reg->context);
+    }
+    return EventLoop_Run_Finished;
+}
+
+int EventLoop_Stop(EventLoop *el)
+{
+    (void)el;
+    return 0;
+}
+
+int EventLoop_GetWaitDescriptor(EventLoop *el)
+{
+    return el->epollFd;
+}
+
+EventRegistration *EventLoop_RegisterIo(EventLoop *el, int fd, EventLoop_IoEvents eventBitmask,
+                                        EventLoopIoCallback *callback, void *context)
+{
+    EventRegistration *reg = malloc(sizeof(EventRegistration));
+    if (reg == NULL) {
+        return NULL;
+    }
+
+    reg->fd = fd;
+    reg->callback = callback;
+    reg->context = context;
+
+    struct epoll_event event = {.events = ToEpoll(eventBitmask), .data.ptr = reg};
+    if (epoll_ctl(el->epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        free(reg);
+        return NULL;
+    }
+    registrations++;
+    return reg;
+}
+
+int EventLoop_ModifyIoEvents(EventLoop *el, EventRegistration *reg,
+                             EventLoop_IoEvents eventBitmask)
+{
+    struct epoll_event event = {.events = ToEpoll(eventBitmask), .data.ptr = reg};
+    return epoll_ctl(el->epollFd, EPOLL_CTL_MOD, reg->fd, &event);
+}
+
+int EventLoop_UnregisterIo(EventLoop *el, EventRegistration *reg)
+{
+    if (reg == NULL) {
+        return 0;
+    }
+
+    int result = epoll_ctl(el->epollFd, EPOLL_CTL_DEL, reg->fd, NULL);
+    registrations--;
+    free(reg);
+    return result;
+}
+
+int Application_Connect(const char *componentId)
+{
+    int fds[2];
+
+    (void)componentId;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == -1) {
+        return -1;
+    }
+
+    HostApplibs_ClosePeer();
+    peerFd = fds[1];
+    return fds[0];
+}
+
+int Log_Debug(const char *fmt, ...)
+{
+    static int enabled = -1;
+
+    if (enabled == -1) {
+        enabled = getenv("HOST_LOG") != NULL;
+    }
+    if (!enabled) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int result = vfprintf(stderr, fmt, args);
+    va_end(args);
+    return result;
+}
+
+int HostApplibs_PeerFd(void)
+{
+    return peerFd;
+}
+
+void HostApplibs_ClosePeer(void)
+{
+    if (peerFd != -1) {
+        close(peerFd);
+        peerFd = -1;
+    }
+}
+
+int HostApplibs_Registrations(void)
+{
+    return registrations;
+}
+
+void HostApplibs_GetEventLoopStats(HostEventLoopStats *stats)
+{
+    *stats = loopStats;
+}
+
+void HostApplibs_ResetEventLoopStats(void)
+{
+    loopStats = (HostEventLoopStats){0};
+}
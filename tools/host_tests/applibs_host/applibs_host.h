@@ -0,0 +1,31 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// What the host stand-ins for applibs expose to tests: the real-time app's end of the
+// inter-core socket, and counts of what the event loop and the socket did.
+
+#ifndef APPLIBS_HOST_H
+#define APPLIBS_HOST_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t runs;        // EventLoop_Run calls which dispatched at least one event
+    uint64_t dispatches;  // callbacks made by EventLoop_Run
+} HostEventLoopStats;
+
+/// <summary>
+/// The real-time app's end of the socket last returned by Application_Connect, or -1.
+/// </summary>
+int HostApplibs_PeerFd(void);
+
+/// <summary>Closes the real-time app's end, as if the app had stopped.</summary>
+void HostApplibs_ClosePeer(void);
+
+/// <summary>Number of file descriptors registered with any event loop.</summary>
+int HostApplibs_Registrations(void);
+
+void HostApplibs_GetEventLoopStats(HostEventLoopStats *stats);
+void HostApplibs_ResetEventLoopStats(void);
+
+#endif // #ifndef APPLIBS_HOST_H
@@ -0,0 +1,282 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the I2C transaction service of the real-time demo, demo_threadx/i2c.c, on the
+// host ThreadX stand-in in threadx_host. The OS-HAL I2C calls are simulated: each transaction
+// holds the bus for 9 bits per byte at 1 MHz SCL, as the LSM6DSO's bus runs, and its
+// transfer waits for the bus like os_hal_i2c.c does. Every transaction reads 12 output bytes
+// from a register, as the sensor reads do.
+//
+//   spin      no service, the transfer spins until the bus is done, as the OS-HAL I2C driver
+//             did before it waited on a completion
+//   inline    no service, the transfer gives up the core while it waits
+//   service   i2c_read through the service thread
+//   2 clients two threads sharing the bus through the service
+//   batch 8   chains of eight transactions submitted with i2c_submit, results checked in the
+//             callbacks
+//
+// Reports transactions per second and the share of time no thread held the core, which is
+// left for other threads or for sleeping. Checks every transaction's data and that no two
+// transactions are ever on the bus at once.
+//
+// Usage: bench_i2c_service [--quick]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "i2c.h"
+#include "threadx_host.h"
+#include "tx_api.h"
+
+#define BENCH_TRANSACTIONS 4000
+#define READ_LEN 12
+#define BATCH_LEN 8
+#define BUS_US_PER_BYTE 9
+#define SERVICE_PRIORITY 3
+
+typedef struct {
+    const char *name;
+    int clients;
+    bool batched;
+} Mode;
+
+// The simulated bus.
+static bool spinning;
+static volatile bool onBus;
+static uint32_t transactions, overlaps, errors;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int BusTransfer(u16 bytes)
+{
+    unsigned busUs = bytes * BUS_US_PER_BYTE;
+
+    if (onBus) {
+        overlaps++;
+    }
+    onBus = true;
+    if (spinning) {
+        uint64_t end = NowNs() + (uint64_t)busUs * 1000;
+        while (NowNs() < end) {
+        }
+    } else {
+        HostTx_WaitUs(busUs);
+    }
+    onBus = false;
+    transactions++;
+    return 0;
+}
+
+// The device answers a read of reg with reg, reg + 1, ...
+static void Fill(u8 reg, u8 *buffer, u16 len)
+{
+    for (u16 i = 0; i < len; i++) {
+        buffer[i] = (u8)(reg + i);
+    }
+}
+
+static bool Filled(u8 reg, const u8 *buffer, u16 len)
+{
+    for (u16 i = 0; i < len; i++) {
+        if (buffer[i] != (u8)(reg + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int mtk_os_hal_i2c_ctrl_init(i2c_num bus_num)
+{
+    (void)bus_num;
+    return 0;
+}
+
+int mtk_os_hal_i2c_speed_init(i2c_num bus_num, enum i2c_speed_kHz speed)
+{
+    (void)bus_num;
+    (void)speed;
+    return 0;
+}
+
+int mtk_os_hal_i2c_write(i2c_num bus_num, u8 device_addr, u8 *buffer, u16 len)
+{
+    (void)bus_num;
+    (void)device_addr;
+    (void)buffer;
+    return BusTransfer(1 + len);
+}
+
+int mtk_os_hal_i2c_read(i2c_num bus_num, u8 device_addr, u8 *buffer, u16 len)
+{
+    (void)bus_num;
+    (void)device_addr;
+    Fill(0, buffer, len);
+    return BusTransfer(1 + len);
+}
+
+int mtk_os_hal_i2c_write_read(i2c_num bus_num, u8 device_addr, u8 *wr_buf, u8 *rd_buf,
+                              u16 wr_len, u16 rd_len)
+{
+    (void)bus_num;
+    (void)device_addr;
+    Fill(wr_buf[0], rd_buf, rd_len);
+    return BusTransfer(1 + wr_len + 1 + rd_len);
+}
+
+static void BatchDone(i2c_xfer *xfer)
+{
+    if (xfer->result != 0 || !Filled(xfer->tx_buf[0], xfer->rx_buf, xfer->rx_len)) {
+        errors++;
+    }
+}
+
+static void LastDone(i2c_xfer *xfer)
+{
+    BatchDone(xfer);
+    tx_semaphore_put((TX_SEMAPHORE *)xfer->context);
+}
+
+typedef struct {
+    const Mode *mode;
+    uint32_t count;
+    TX_SEMAPHORE *finished;
+    pthread_t thread;
+} Client;
+
+static void *ClientThread(void *arg)
+{
+    Client *client = arg;
+    u8 buffer[BATCH_LEN][READ_LEN], regs[BATCH_LEN];
+    i2c_xfer batch[BATCH_LEN];
+    TX_SEMAPHORE done;
+
+    if (!client->mode->batched) {
+        for (uint32_t i = 0; i < client->count; i++) {
+            u8 reg = (u8)(0x20 + i % 8);
+            if (i2c_read(NULL, reg, buffer[0], READ_LEN) != 0 ||
+                !Filled(reg, buffer[0], READ_LEN)) {
+                errors++;
+            }
+        }
+        tx_semaphore_put(client->finished);
+        return NULL;
+    }
+
+    tx_semaphore_create(&done, "batch done", 0);
+    for (uint32_t i = 0; i < client->count; i += BATCH_LEN) {
+        for (int t = 0; t < BATCH_LEN; t++) {
+            regs[t] = (u8)(0x20 + t);
+            batch[t] = (i2c_xfer){.type = I2C_XFER_WRITE_READ,
+                                  .addr = i2c_lsm6dso_addr,
+                                  .tx_buf = &regs[t],
+                                  .tx_len = 1,
+                                  .rx_buf = buffer[t],
+                                  .rx_len = READ_LEN,
+                                  .callback = t == BATCH_LEN - 1 ? LastDone : BatchDone,
+                                  .context = &done,
+                                  .next = t == BATCH_LEN - 1 ? NULL : &batch[t + 1]};
+        }
+        if (i2c_submit(batch) != 0) {
+            errors++;
+            break;
+        }
+        tx_semaphore_get(&done, TX_WAIT_FOREVER);
+    }
+    tx_semaphore_delete(&done);
+    tx_semaphore_put(client->finished);
+    return NULL;
+}
+
+typedef struct {
+    const Mode *mode;
+    uint32_t count;
+    int failed;
+} Run;
+
+// Runs in a ThreadX thread of its own, which waits for the clients.
+static void *RunMode(void *arg)
+{
+    Run *run = arg;
+    Client clients[2];
+    TX_SEMAPHORE finished;
+
+    transactions = overlaps = errors = 0;
+    tx_semaphore_create(&finished, "clients finished", 0);
+
+    uint64_t busyStart = HostTx_CoreBusyNs(), start = NowNs();
+    for (int c = 0; c < run->mode->clients; c++) {
+        clients[c].mode = run->mode;
+        clients[c].count = run->count / (uint32_t)run->mode->clients;
+        clients[c].finished = &finished;
+        HostTx_CreateThread(&clients[c].thread, ClientThread, &clients[c]);
+    }
+    // Gives up the core until the clients are done.
+    for (int c = 0; c < run->mode->clients; c++) {
+        tx_semaphore_get(&finished, TX_WAIT_FOREVER);
+    }
+    uint64_t elapsedNs = NowNs() - start, busyNs = HostTx_CoreBusyNs() - busyStart;
+
+    // They only have to exit, which does not need the core.
+    for (int c = 0; c < run->mode->clients; c++) {
+        pthread_join(clients[c].thread, NULL);
+    }
+    tx_semaphore_delete(&finished);
+
+    run->failed = transactions != run->count || overlaps != 0 || errors != 0;
+    printf("%-10s %12.0f %8.1f%s\n", run->mode->name, transactions * 1e9 / elapsedNs,
+           100.0 * (1.0 - (double)busyNs / elapsedNs), run->failed ? "  FAILED" : "");
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static const Mode modes[] = {
+        {"spin", 1, false},
+        {"inline", 1, false},
+        {"service", 1, false},
+        {"2 clients", 2, false},
+        {"batch 8", 1, true},
+    };
+    static ULONG serviceStack[256];
+    uint32_t count = BENCH_TRANSACTIONS;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            count = BENCH_TRANSACTIONS / 10;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    i2c_init();
+    printf("%" PRIu32 " transactions of %d bytes, %d us each on the bus\n", count, READ_LEN,
+           (1 + 1 + 1 + READ_LEN) * BUS_US_PER_BYTE);
+    printf("%-10s %12s %8s\n", "mode", "xfers/s", "idle %");
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        Run run = {.mode = &modes[m], .count = count};
+        pthread_t thread;
+
+        spinning = m == 0;
+        // The first modes run before the service exists, the rest through it.
+        if (strcmp(modes[m].name, "service") == 0 &&
+            i2c_service_create(serviceStack, sizeof(serviceStack), SERVICE_PRIORITY) != 0) {
+            return 1;
+        }
+
+        HostTx_CreateThread(&thread, RunMode, &run);
+        pthread_join(thread, NULL);
+        failed |= run.failed;
+    }
+
+    return failed;
+}
@@ -0,0 +1,215 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for lp_interCoreRequestAsync in learning_path_libs/inter_core.c. A thread plays
+// the real-time app on the other end of the socketpair behind Application_Connect, answering
+// every request PEER_DELAY_US after it arrived, however many are waiting, as a core serving
+// requests from its latest sensor sample would. The high-level side keeps a fixed number of
+// requests outstanding, issuing the next from each reply's callback. Reports requests per
+// second and p50/p99 request latency for each pipeline depth; with depth 1 every request
+// waits for the one before it. Every request must be answered, none may time out.
+//
+// Usage: bench_inter_core_async [--quick]
+
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "applibs_host.h"
+#include "inter_core.h"
+
+#define BENCH_REQUESTS 20000
+#define PEER_DELAY_US 200
+#define REQUEST_TIMEOUT_MS 1000
+/// <summary>Most requests the peer holds at once, well above LP_INTER_CORE_MAX_IN_FLIGHT.</summary>
+#define PEER_QUEUE 64
+
+static struct {
+    uint32_t sequence;
+    uint8_t type;
+    uint64_t dueNs;
+} peerQueue[PEER_QUEUE];
+static size_t peerHead, peerCount;
+
+static uint64_t sentNs[LP_INTER_CORE_MAX_IN_FLIGHT];
+static uint32_t sentSequence[LP_INTER_CORE_MAX_IN_FLIGHT];
+static uint64_t *latencies;
+static uint32_t issued, completed, failures, total;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Queues every request in one datagram; the high-level side may have coalesced several.
+static void PeerAccept(const uint8_t *buffer, uint32_t size)
+{
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+    uint32_t used;
+
+    while (size > 0 && (used = ic_msg_decode(buffer, size, &header, &payload)) != 0) {
+        if (peerCount < PEER_QUEUE) {
+            size_t tail = (peerHead + peerCount++) % PEER_QUEUE;
+            peerQueue[tail].sequence = header.sequence;
+            peerQueue[tail].type = header.type;
+            peerQueue[tail].dueNs = NowNs() + PEER_DELAY_US * 1000u;
+        }
+        buffer += used;
+        size -= used;
+    }
+}
+
+static void *PeerThread(void *arg)
+{
+    uint8_t buffer[IC_MSG_MAX_SIZE];
+    IC_TEMPERATURE_PAYLOAD temperature = {.temperature = 21.5f};
+    struct pollfd fd = {.fd = HostApplibs_PeerFd(), .events = POLLIN};
+
+    (void)arg;
+    for (;;) {
+        // poll only sleeps in whole milliseconds, so waits shorter than that spin.
+        int timeoutMs = -1;
+        if (peerCount != 0) {
+            uint64_t now = NowNs(), due = peerQueue[peerHead].dueNs;
+            timeoutMs = due > now ? (int)((due - now) / 1000000) : 0;
+        }
+
+        if (poll(&fd, 1, timeoutMs) == 1) {
+            ssize_t size = recv(fd.fd, buffer, sizeof(buffer), 0);
+            if (size <= 0) {
+                return NULL;
+            }
+            PeerAccept(buffer, (uint32_t)size);
+        }
+
+        while (peerCount != 0 && peerQueue[peerHead].dueNs <= NowNs()) {
+            uint32_t size = ic_msg_encode(buffer, sizeof(buffer), peerQueue[peerHead].type,
+                                          peerQueue[peerHead].sequence, &temperature,
+                                          sizeof(temperature));
+            send(fd.fd, buffer, size, 0);
+            peerHead = (peerHead + 1) % PEER_QUEUE;
+            peerCount--;
+        }
+    }
+}
+
+static void ReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK *reply);
+
+// Every reply should answer a request.
+static void MessageHandler(LP_INTER_CORE_BLOCK *block)
+{
+    (void)block;
+    failures++;
+}
+
+static void Issue(void)
+{
+    if (issued == total) {
+        return;
+    }
+
+    uint32_t sequence = lp_interCoreRequestAsync(LP_IC_GET_TEMPERATURE, NULL, 0,
+                                                 REQUEST_TIMEOUT_MS, ReplyHandler);
+    if (sequence == 0) {
+        failures++;
+        return;
+    }
+
+    size_t slot = sequence % LP_INTER_CORE_MAX_IN_FLIGHT;
+    sentNs[slot] = NowNs();
+    sentSequence[slot] = sequence;
+    issued++;
+}
+
+static void ReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK *reply)
+{
+    size_t slot = sequence % LP_INTER_CORE_MAX_IN_FLIGHT;
+
+    if (reply == NULL || reply->value_float != 21.5f || sentSequence[slot] != sequence) {
+        failures++;
+    } else {
+        latencies[completed] = NowNs() - sentNs[slot];
+    }
+    completed++;
+    Issue();
+}
+
+static int CompareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int RunDepth(uint32_t depth, uint32_t requests)
+{
+    issued = completed = failures = 0;
+    total = requests;
+    memset(latencies, 0, requests * sizeof(latencies[0]));
+
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < depth; i++) {
+        Issue();
+    }
+    while (completed < total && failures == 0 && !lp_isTerminationRequired()) {
+        EventLoop_Run(lp_getTimerEventLoop(), 1000, true);
+    }
+    uint64_t elapsedNs = NowNs() - start;
+
+    bool failed = completed != total || failures != 0;
+    qsort(latencies, completed, sizeof(latencies[0]), CompareU64);
+
+    printf("%6" PRIu32 " %10.0f %10.1f %10.1f%s\n", depth, completed * 1e9 / elapsedNs,
+           completed ? latencies[completed / 2] / 1e3 : 0.0,
+           completed ? latencies[completed * 99 / 100] / 1e3 : 0.0, failed ? "  FAILED" : "");
+
+    return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t depths[] = {1, 2, 4, LP_INTER_CORE_MAX_IN_FLIGHT};
+    uint32_t requests = BENCH_REQUESTS;
+    pthread_t peer;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            requests = BENCH_REQUESTS / 10;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    latencies = malloc(requests * sizeof(latencies[0]));
+    if (latencies == NULL || lp_enableInterCoreCommunications("bench", MessageHandler) != 0) {
+        return 1;
+    }
+    pthread_create(&peer, NULL, PeerThread, NULL);
+
+    printf("%" PRIu32 " requests per depth, peer answers after %d us, latency in us\n", requests,
+           PEER_DELAY_US);
+    printf("%6s %10s %10s %10s\n", "depth", "req/s", "p50", "p99");
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        if (RunDepth(depths[d], requests) != 0) {
+            failed = 1;
+        }
+    }
+
+    // The peer thread stops when it sees the socket close.
+    lp_disableInterCoreCommunications();
+    pthread_join(peer, NULL);
+    HostApplibs_ClosePeer();
+    free(latencies);
+
+    return failed;
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the high-level receive path in learning_path_libs/inter_core.c. The real-time
+// app is played on the other end of the socketpair behind Application_Connect: it queues
+// bursts of messages, and the event loop runs until all of them have been delivered. Reports
+// messages per second and event loop dispatches per message, which is 1 when every message
+// costs its own epoll round trip. Every message must arrive once and in order.
+//
+// Built twice: with the default LP_INTER_CORE_DRAIN_BUDGET, and with a budget of 1, which
+// reads one message per socket event as before the drain loop.
+//
+// Usage: bench_inter_core_drain [--quick]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "applibs_host.h"
+#include "inter_core.h"
+
+#define BENCH_MESSAGES 200000
+
+static uint32_t expectedSequence;
+static uint32_t received, batches, outOfOrder;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void BatchHandler(LP_INTER_CORE_BLOCK *blocks, size_t count)
+{
+    batches++;
+    for (size_t i = 0; i < count; i++) {
+        if (blocks[i].cmd != LP_IC_GET_STATS || blocks[i].sequence != expectedSequence) {
+            outOfOrder++;
+        }
+        expectedSequence = blocks[i].sequence + 1;
+        received++;
+    }
+}
+
+static void MessageHandler(LP_INTER_CORE_BLOCK *block)
+{
+    BatchHandler(block, 1);
+}
+
+static int RunBurst(uint32_t burst, uint32_t messages)
+{
+    uint8_t message[IC_MSG_MAX_SIZE];
+    IC_STATS_PAYLOAD stats = {.bufferSize = 1024};
+    HostEventLoopStats loopStats;
+    uint32_t bursts = messages / burst, sequence = 1;
+    uint64_t elapsedNs = 0;
+
+    received = batches = outOfOrder = 0;
+    expectedSequence = 1;
+    HostApplibs_ResetEventLoopStats();
+
+    for (uint32_t b = 0; b < bursts; b++) {
+        // The sequence numbers answer no request, so every message goes to the batch callback.
+        for (uint32_t i = 0; i < burst; i++) {
+            uint32_t size = ic_msg_encode(message, sizeof(message), IC_MSG_GET_STATS, sequence++,
+                                          &stats, sizeof(stats));
+            if (send(HostApplibs_PeerFd(), message, size, 0) != (ssize_t)size) {
+                perror("send");
+                return -1;
+            }
+        }
+
+        uint64_t start = NowNs();
+        while (received < sequence - 1 && !lp_isTerminationRequired()) {
+            EventLoop_Run(lp_getTimerEventLoop(), 1000, true);
+        }
+        elapsedNs += NowNs() - start;
+    }
+
+    HostApplibs_GetEventLoopStats(&loopStats);
+
+    // Each socket event reads up to the budget, so a burst takes ceil(burst / budget) events.
+    uint64_t expectedRuns =
+        (uint64_t)bursts * ((burst + LP_INTER_CORE_DRAIN_BUDGET - 1) / LP_INTER_CORE_DRAIN_BUDGET);
+    bool failed = received != bursts * burst || outOfOrder != 0 || loopStats.runs != expectedRuns;
+
+    printf("%6" PRIu32 " %12.0f %12.3f %12.3f%s\n", burst, received * 1e9 / elapsedNs,
+           (double)loopStats.dispatches / received, (double)batches / received,
+           failed ? "  FAILED" : "");
+
+    return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t bursts[] = {1, 8, 64};
+    uint32_t messages = BENCH_MESSAGES;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            messages = BENCH_MESSAGES / 10;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (lp_enableInterCoreCommunications("bench", MessageHandler) != 0) {
+        return 1;
+    }
+    lp_setInterCoreBatchCallback(BatchHandler);
+
+    printf("drain budget %d, %" PRIu32 " messages of %zu bytes per burst size\n",
+           LP_INTER_CORE_DRAIN_BUDGET, messages, sizeof(IC_MSG_HEADER) + sizeof(IC_STATS_PAYLOAD));
+    printf("%6s %12s %12s %12s\n", "burst", "msgs/s", "events/msg", "batches/msg");
+
+    for (size_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+        if (RunBurst(bursts[b], messages) != 0) {
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,153 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the outbound queue of lp_sendInterCoreMessage in learning_path_libs/inter_core.c.
+// Each event loop turn queues a number of small requests, then the loop runs until the flush
+// timer has sent them. The real-time app's end of the socketpair behind Application_Connect
+// reads every datagram and decodes every message in it, which must arrive once and in order.
+//
+//   coalesced  messages queued in one turn go out together at the end of the turn, or once
+//              LP_INTER_CORE_FLUSH_THRESHOLD bytes are waiting
+//   each       lp_flushInterCoreMessages after every message: one send() each, as before
+//
+// Reports messages per second and send() calls per message.
+//
+// Usage: bench_inter_core_send [--quick]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "applibs_host.h"
+#include "inter_core.h"
+
+#define BENCH_MESSAGES 200000
+
+// Sequence numbers lp_sendInterCoreMessage gives the next message, and the peer expects next.
+static uint32_t sendSequence, nextSequence;
+static uint32_t peerMessages, peerDatagrams, peerErrors;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void MessageHandler(LP_INTER_CORE_BLOCK *block)
+{
+    (void)block;
+}
+
+// Reads and decodes whatever the high-level side has sent.
+static void PeerDrain(void)
+{
+    uint8_t buffer[IC_MSG_MAX_SIZE];
+    IC_SUBSCRIBE_PAYLOAD subscription;
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+    ssize_t size;
+
+    while ((size = recv(HostApplibs_PeerFd(), buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        const uint8_t *next = buffer;
+        uint32_t left = (uint32_t)size, used;
+
+        peerDatagrams++;
+        while (left > 0 && (used = ic_msg_decode(next, left, &header, &payload)) != 0) {
+            if (header.sequence != nextSequence++ ||
+                !ic_msg_payload(&header, payload, &subscription, sizeof(subscription)) ||
+                subscription.periodMs != (uint16_t)header.sequence) {
+                peerErrors++;
+            }
+            peerMessages++;
+            next += used;
+            left -= used;
+        }
+        if (left != 0) {
+            peerErrors++;
+        }
+    }
+}
+
+static int RunMode(const char *mode, bool coalesce, uint32_t perTurn, uint32_t messages)
+{
+    IC_SUBSCRIBE_PAYLOAD subscription = {.samplesPerFrame = 1};
+    LP_INTER_CORE_BLOCK block = {.cmd = LP_IC_SUBSCRIBE, .payload = (const uint8_t *)&subscription,
+                                 .length = sizeof(subscription)};
+    uint32_t turns = messages / perTurn, sent = 0, sentBefore, datagramsBefore, sentAfter,
+             datagramsAfter;
+    bool failed = false;
+
+    lp_getInterCoreSendStats(&sentBefore, &datagramsBefore);
+    peerMessages = peerDatagrams = peerErrors = 0;
+
+    uint64_t start = NowNs();
+    for (uint32_t turn = 0; turn < turns; turn++) {
+        for (uint32_t i = 0; i < perTurn; i++) {
+            // Carries the message's sequence number, so the peer can check the payload.
+            subscription.periodMs = (uint16_t)sendSequence++;
+            if (!lp_sendInterCoreMessage(&block) || (!coalesce && !lp_flushInterCoreMessages())) {
+                failed = true;
+            }
+            sent++;
+        }
+
+        // The end of the turn: the flush timer sends whatever is still queued.
+        PeerDrain();
+        while (peerMessages < sent && !failed) {
+            failed = EventLoop_Run(lp_getTimerEventLoop(), 100, true) != EventLoop_Run_Finished;
+            PeerDrain();
+        }
+    }
+    uint64_t elapsedNs = NowNs() - start;
+
+    lp_getInterCoreSendStats(&sentAfter, &datagramsAfter);
+    uint32_t datagrams = datagramsAfter - datagramsBefore;
+
+    failed = failed || peerMessages != sent || peerErrors != 0 ||
+             sentAfter - sentBefore != sent || peerDatagrams != datagrams;
+    printf("%-10s %6" PRIu32 " %12.0f %12.3f%s\n", mode, perTurn, sent * 1e9 / elapsedNs,
+           (double)datagrams / sent, failed ? "  FAILED" : "");
+
+    return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t perTurn[] = {1, 4, 16, 64};
+    uint32_t messages = BENCH_MESSAGES;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            messages = BENCH_MESSAGES / 10;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (lp_enableInterCoreCommunications("bench", MessageHandler) != 0) {
+        return 1;
+    }
+    // lp_sendInterCoreMessage numbers messages from 1.
+    sendSequence = nextSequence = 1;
+
+    printf("%" PRIu32 " messages of %zu bytes, flush threshold %d bytes\n", messages,
+           sizeof(IC_MSG_HEADER) + sizeof(IC_SUBSCRIBE_PAYLOAD), LP_INTER_CORE_FLUSH_THRESHOLD);
+    printf("%-10s %6s %12s %12s\n", "mode", "turn", "msgs/s", "sends/msg");
+
+    for (size_t t = 0; t < sizeof(perTurn) / sizeof(perTurn[0]); t++) {
+        if (RunMode("coalesced", true, perTurn[t], messages) != 0) {
+            failed = 1;
+        }
+        if (RunMode("each", false, perTurn[t], messages) != 0) {
+            failed = 1;
+        }
+    }
+
+    lp_disableInterCoreCommunications();
+    return failed;
+}
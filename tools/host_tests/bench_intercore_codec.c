@@ -0,0 +1,217 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the sample frame codec in Shared/intercore_codec.h: compression ratio against
+// IC_MSG_SAMPLE_FRAME and encode/decode time per sample, over frames of
+// IC_SAMPLE_FRAME_MAX_SAMPLES samples. Every frame is decoded and compared with its input.
+//
+// The built-in traces model the LSM6DSO lying still, moved by hand, and shaken. A recorded
+// trace is a file of IC_SAMPLE records as they appear in IC_MSG_SAMPLE_FRAME payloads.
+//
+// Usage: bench_intercore_codec [--quick] [--trace FILE [--period MS]]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "intercore_codec.h"
+
+#define TRACE_SAMPLES 240000
+#define TRACE_PERIOD_MS 10
+/// <summary>Times each trace is encoded and decoded, to get measurable durations.</summary>
+#define BENCH_REPEATS 5
+
+typedef struct {
+    const char *name;
+    // Largest change between samples, in LSB.
+    int32_t accelerationStep;
+    int32_t angularRateStep;
+} TraceModel;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static int32_t Step(int32_t limit)
+{
+    return (int32_t)(Random() % (2 * (uint32_t)limit + 1)) - limit;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int16_t Clamp16(int32_t value)
+{
+    return (int16_t)(value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+}
+
+// Readings wander around 1 g on z, as the sensor sees gravity, and the temperature is read
+// every eighth sample.
+static void MakeTrace(const TraceModel *model, IC_SAMPLE *samples, uint32_t count)
+{
+    IC_SAMPLE sample = {.acceleration = {0, 0, 8197}, .temperature = 0x0500};
+
+    for (uint32_t i = 0; i < count; i++) {
+        sample.timestamp = i * TRACE_PERIOD_MS;
+        for (int axis = 0; axis < 3; axis++) {
+            sample.acceleration[axis] =
+                Clamp16(sample.acceleration[axis] + Step(model->accelerationStep));
+            sample.angularRate[axis] =
+                Clamp16(sample.angularRate[axis] + Step(model->angularRateStep));
+        }
+        sample.flags = IC_SAMPLE_NEW_ACCELERATION | IC_SAMPLE_NEW_ANGULAR_RATE;
+        if (i % 8 == 0) {
+            sample.temperature = Clamp16(sample.temperature + Step(2));
+            sample.flags |= IC_SAMPLE_NEW_TEMPERATURE;
+        }
+        samples[i] = sample;
+    }
+}
+
+static int RunTrace(const char *name, const IC_SAMPLE *samples, uint32_t count, uint16_t periodMs)
+{
+    static uint8_t encoded[IC_CODEC_MAX_SIZE];
+    IC_SAMPLE decoded[IC_SAMPLE_FRAME_MAX_SAMPLES];
+    IC_SAMPLE_FRAME_HEADER header;
+    uint64_t rawBytes = 0, packedBytes = 0, encodeNs = 0, decodeNs = 0;
+    uint32_t frames = 0, unpacked = 0, errors = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        for (uint32_t first = 0; first < count; first += IC_SAMPLE_FRAME_MAX_SAMPLES) {
+            uint16_t n = (uint16_t)(count - first < IC_SAMPLE_FRAME_MAX_SAMPLES
+                                        ? count - first
+                                        : IC_SAMPLE_FRAME_MAX_SAMPLES);
+            uint32_t raw = (uint32_t)(sizeof(IC_SAMPLE_FRAME_HEADER) + n * sizeof(IC_SAMPLE));
+
+            uint64_t start = NowNs();
+            uint32_t size = ic_codec_encode_frame(encoded, sizeof(encoded), periodMs,
+                                                  &samples[first], n);
+            encodeNs += NowNs() - start;
+
+            start = NowNs();
+            bool valid = ic_codec_decode_frame(encoded, size, &header, decoded,
+                                               IC_SAMPLE_FRAME_MAX_SAMPLES);
+            decodeNs += NowNs() - start;
+
+            if (!valid || header.count != n ||
+                memcmp(decoded, &samples[first], n * sizeof(IC_SAMPLE)) != 0) {
+                errors++;
+            }
+
+            if (repeat == 0) {
+                frames++;
+                rawBytes += raw;
+                // The real-time app sends the frame unpacked when packing does not save space.
+                if (size >= raw) {
+                    unpacked++;
+                    packedBytes += raw;
+                } else {
+                    packedBytes += size;
+                }
+            }
+        }
+    }
+
+    uint64_t coded = (uint64_t)count * BENCH_REPEATS;
+    printf("%-8s %8" PRIu32 " %9.1f %9.1f %7.2f %8" PRIu32 " %9.1f %9.1f%s\n", name, count,
+           (double)rawBytes / frames, (double)packedBytes / frames,
+           (double)rawBytes / packedBytes, unpacked, (double)encodeNs / coded,
+           (double)decodeNs / coded, errors ? "  FAILED" : "");
+
+    return errors ? -1 : 0;
+}
+
+static IC_SAMPLE *ReadTrace(const char *path, uint32_t *count)
+{
+    FILE *file = fopen(path, "rb");
+    IC_SAMPLE *samples = NULL;
+    long size;
+
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 &&
+        fseek(file, 0, SEEK_SET) == 0) {
+        *count = (uint32_t)((size_t)size / sizeof(IC_SAMPLE));
+        samples = malloc(*count * sizeof(IC_SAMPLE));
+        if (samples != NULL && fread(samples, sizeof(IC_SAMPLE), *count, file) != *count) {
+            free(samples);
+            samples = NULL;
+        }
+    }
+
+    if (samples == NULL || *count == 0) {
+        fprintf(stderr, "%s: cannot read IC_SAMPLE records\n", path);
+    }
+    fclose(file);
+    return samples;
+}
+
+int main(int argc, char **argv)
+{
+    static const TraceModel models[] = {
+        {"still", 3, 4},
+        {"moving", 40, 150},
+        {"shaken", 1500, 4000},
+    };
+    uint32_t count = TRACE_SAMPLES;
+    uint16_t periodMs = TRACE_PERIOD_MS;
+    const char *tracePath = NULL;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            count = TRACE_SAMPLES / 100;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            periodMs = (uint16_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--trace FILE [--period MS]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("frames of up to %d samples, sizes in bytes per frame, times in ns per sample\n",
+           IC_SAMPLE_FRAME_MAX_SAMPLES);
+    printf("%-8s %8s %9s %9s %7s %8s %9s %9s\n", "trace", "samples", "raw", "packed", "ratio",
+           "unpacked", "encode", "decode");
+
+    if (tracePath != NULL) {
+        IC_SAMPLE *samples = ReadTrace(tracePath, &count);
+        if (samples == NULL) {
+            return 1;
+        }
+        failed = RunTrace("file", samples, count, periodMs) != 0;
+        free(samples);
+        return failed;
+    }
+
+    IC_SAMPLE *samples = malloc(count * sizeof(IC_SAMPLE));
+    if (samples == NULL) {
+        return 1;
+    }
+    for (size_t m = 0; m < sizeof(models) / sizeof(models[0]); m++) {
+        MakeTrace(&models[m], samples, count);
+        if (RunTrace(models[m].name, samples, count, periodMs) != 0) {
+            failed = 1;
+        }
+    }
+    free(samples);
+
+    return failed;
+}
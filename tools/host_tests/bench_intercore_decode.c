@@ -0,0 +1,167 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for temperature replies as app_hl_monitor_expanded receives them: the binary
+// schema of Shared/intercore_msg.h against the text it used to expect. Reports bytes on the
+// wire and encode/decode time per message.
+//
+//   binary  ic_msg_encode on the real-time side; ic_msg_decode, a type check and
+//           ic_msg_payload into IC_TEMPERATURE_PAYLOAD, as ProcessMsg and
+//           InterCoreMessageHandler do now
+//   text    "%.2f" on the real-time side; the old ProcessMsg's copy through isprint into
+//           char msg[32], then strtof in the handler
+//
+// Every decoded temperature is compared with the one sent: exactly for binary, to the
+// printed precision for text.
+//
+// Usage: bench_intercore_decode [--quick]
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "intercore_msg.h"
+
+#define BENCH_MESSAGES 1000000
+#define TEXT_SIZE 32
+/// <summary>Room for either format's temperature reply.</summary>
+#define WIRE_SIZE 16
+
+typedef struct {
+    const char *name;
+    uint32_t (*encode)(uint8_t *buffer, uint32_t size, uint32_t sequence, float temperature);
+    bool (*decode)(const uint8_t *buffer, uint32_t size, float *temperature);
+    float tolerance;
+} Codec;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint32_t BinaryEncode(uint8_t *buffer, uint32_t size, uint32_t sequence, float temperature)
+{
+    IC_TEMPERATURE_PAYLOAD reply = {.temperature = temperature};
+    return ic_msg_encode(buffer, size, IC_MSG_GET_TEMPERATURE, sequence, &reply, sizeof(reply));
+}
+
+static bool BinaryDecode(const uint8_t *buffer, uint32_t size, float *temperature)
+{
+    IC_TEMPERATURE_PAYLOAD reply;
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+
+    if (ic_msg_decode(buffer, size, &header, &payload) == 0 ||
+        header.type != IC_MSG_GET_TEMPERATURE ||
+        !ic_msg_payload(&header, payload, &reply, sizeof(reply))) {
+        return false;
+    }
+    *temperature = reply.temperature;
+    return true;
+}
+
+static uint32_t TextEncode(uint8_t *buffer, uint32_t size, uint32_t sequence, float temperature)
+{
+    (void)sequence;
+    int length = snprintf((char *)buffer, size, "%.2f", temperature);
+    return length > 0 && (uint32_t)length < size ? (uint32_t)length : 0;
+}
+
+static bool TextDecode(const uint8_t *buffer, uint32_t size, float *temperature)
+{
+    char msg[TEXT_SIZE];
+
+    if (size >= sizeof(msg)) {
+        return false;
+    }
+    memset(msg, 0, sizeof(msg));
+    for (uint32_t i = 0; i < size; ++i) {
+        msg[i] = isprint(buffer[i]) ? (char)buffer[i] : '.';
+    }
+    *temperature = strtof(msg, NULL);
+    return true;
+}
+
+static int RunCodec(const Codec *codec, const float *temperatures, uint32_t count)
+{
+    static uint8_t wire[BENCH_MESSAGES][WIRE_SIZE];
+    static uint32_t sizes[BENCH_MESSAGES];
+    uint64_t bytes = 0;
+    uint32_t errors = 0;
+    float decoded;
+
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < count; i++) {
+        sizes[i] = codec->encode(wire[i], sizeof(wire[i]), i, temperatures[i]);
+    }
+    uint64_t encodeNs = NowNs() - start;
+
+    start = NowNs();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!codec->decode(wire[i], sizes[i], &decoded) ||
+            fabsf(decoded - temperatures[i]) > codec->tolerance) {
+            errors++;
+        }
+    }
+    uint64_t decodeNs = NowNs() - start;
+
+    for (uint32_t i = 0; i < count; i++) {
+        bytes += sizes[i];
+    }
+
+    printf("%-8s %8.2f %10.1f %10.1f%s\n", codec->name, (double)bytes / count,
+           (double)encodeNs / count, (double)decodeNs / count, errors ? "  FAILED" : "");
+    return errors ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const Codec codecs[] = {
+        {"binary", BinaryEncode, BinaryDecode, 0.0f},
+        {"text", TextEncode, TextDecode, 0.006f},
+    };
+    static float temperatures[BENCH_MESSAGES];
+    uint32_t count = BENCH_MESSAGES;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            count = BENCH_MESSAGES / 100;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Readings from -10 to 60 degrees Celsius, as the LSM6DSO reports them in 1/256 degree.
+    for (uint32_t i = 0; i < count; i++) {
+        temperatures[i] = (float)((int32_t)(Random() % (70 * 256)) - 10 * 256) / 256.0f;
+    }
+
+    printf("%" PRIu32 " temperature replies, bytes per message, times in ns per message\n", count);
+    printf("%-8s %8s %10s %10s\n", "format", "bytes", "encode", "decode");
+
+    for (size_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); c++) {
+        if (RunCodec(&codecs[c], temperatures, count) != 0) {
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
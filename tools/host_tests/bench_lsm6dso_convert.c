@@ -0,0 +1,159 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the batch conversions in the real-time demo's LSM6DSO driver, on the host's
+// portable C path: angular rates less their calibration offsets, to dps, as
+// lsm6dso_show_result converts them. Reports the time per triple of the per-axis
+// lsm6dso_from_fs2000_to_mdps calls with their double division that the kernels replaced, of
+// lsm6dso_convert_fixed to mdps, and of lsm6dso_convert_float to dps. The fixed-point results
+// must match the scalar reference exactly, the others to float precision. The M4's DSP path is
+// not timed here; the host has no Cortex-M core to time it on.
+//
+// Usage: bench_lsm6dso_convert [--quick]
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT "TSC cycles"
+#else
+#define CYCLES_UNIT "ns"
+#endif
+
+#include "lsm6dso_driver.h"
+#include "lsm6dso_reg.h"
+
+#define BATCH_TRIPLES 256
+#define BENCH_BATCHES 40000
+
+typedef enum { FROM_MDPS, CONVERT_FIXED, CONVERT_FLOAT } ModeKind;
+
+typedef struct {
+    const char *name;
+    ModeKind kind;
+} Mode;
+
+static const int16_t calibration[3] = {-12, 5, 3};
+static int16_t raw[3 * BATCH_TRIPLES];
+static int32_t fixed[3 * BATCH_TRIPLES];
+static float dps[3 * BATCH_TRIPLES];
+static uint32_t batches;
+static uint32_t seed = 1;
+
+// The BSP's printf, which the driver reports to.
+int printf_(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+static uint32_t Random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Time stamp counter where the host has one, otherwise nanoseconds.
+static uint64_t Cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return NowNs();
+#endif
+}
+
+static void Convert(ModeKind kind)
+{
+    switch (kind) {
+    case FROM_MDPS:
+        for (uint32_t i = 0; i < 3 * BATCH_TRIPLES; i++) {
+            dps[i] = lsm6dso_from_fs2000_to_mdps(raw[i] - calibration[i % 3]) / 1000.0;
+        }
+        break;
+    case CONVERT_FIXED:
+        lsm6dso_convert_fixed(raw, calibration, LSM6DSO_FS2000_MDPS_PER_LSB, fixed,
+                              BATCH_TRIPLES);
+        break;
+    case CONVERT_FLOAT:
+        lsm6dso_convert_float(raw, calibration, LSM6DSO_FS2000_MDPS_PER_LSB, 0.001f, dps,
+                              BATCH_TRIPLES);
+        break;
+    }
+}
+
+// Compares the last batch with the scalar reference.
+static bool Check(ModeKind kind)
+{
+    for (uint32_t i = 0; i < 3 * BATCH_TRIPLES; i++) {
+        int32_t mdps = (int32_t)(int16_t)(raw[i] - calibration[i % 3]) *
+                       LSM6DSO_FS2000_MDPS_PER_LSB;
+
+        if (kind == CONVERT_FIXED ? fixed[i] != mdps
+                                  : fabs(dps[i] - mdps / 1000.0) > fabs(mdps / 1000.0) * 1e-6) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int RunMode(const Mode *mode)
+{
+    for (uint32_t i = 0; i < 3 * BATCH_TRIPLES; i++) {
+        raw[i] = (int16_t)Random();
+    }
+
+    uint64_t startNs = NowNs(), startCycles = Cycles();
+    for (uint32_t i = 0; i < batches; i++) {
+        Convert(mode->kind);
+    }
+    uint64_t cycles = Cycles() - startCycles, elapsedNs = NowNs() - startNs;
+
+    bool passed = Check(mode->kind);
+    printf("%-22s %10.2f %10.1f%s\n", mode->name, (double)elapsedNs / batches / BATCH_TRIPLES,
+           (double)cycles / batches / BATCH_TRIPLES, passed ? "" : "  FAILED");
+
+    return passed ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    static const Mode modes[] = {
+        {"from_fs2000_to_mdps", FROM_MDPS},
+        {"convert_fixed", CONVERT_FIXED},
+        {"convert_float", CONVERT_FLOAT},
+    };
+    int failed = 0;
+
+    batches = BENCH_BATCHES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            batches = BENCH_BATCHES / 100;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%" PRIu32 " batches of %d triples, per triple\n", batches, BATCH_TRIPLES);
+    printf("%-22s %10s %10s\n", "mode", "ns", CYCLES_UNIT);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        failed |= RunMode(&modes[i]);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Benchmark for the record ring in Shared/spsc_ring.h, on its C11 atomics fallback, with the
+// demo's request records. Reports the cost of a push and a pop on one thread, where the
+// indexes stay in the cache, and of moving a record between a producer and a consumer thread,
+// where each index update crosses cores. A small ring keeps the two sides in step, a larger one
+// lets them run in batches. Every record must come out in order.
+//
+// Usage: bench_spsc_ring [--quick]
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT "TSC cycles"
+#else
+#define CYCLES_UNIT "ns"
+#endif
+
+#include "spsc_ring.h"
+
+#define BENCH_RECORDS 20000000
+#define LARGEST_CAPACITY 256
+
+// As the inter core thread passes requests to the read sensor thread.
+typedef struct {
+    uint32_t type;
+    uint32_t sequence;
+} Record;
+
+typedef struct {
+    const char *name;
+    uint32_t capacity;
+    bool threads;
+} Mode;
+
+static SPSC_RING ring;
+static Record storage[LARGEST_CAPACITY];
+static uint32_t records;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Time stamp counter where the host has one, otherwise nanoseconds.
+static uint64_t Cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return NowNs();
+#endif
+}
+
+static void *Producer(void *arg)
+{
+    Record record = {.type = 1};
+
+    (void)arg;
+    for (uint32_t i = 0; i < records; i++) {
+        record.sequence = i;
+        while (!spsc_ring_push(&ring, &record)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Pushes and pops every record on this thread, or pops them as another thread pushes them.
+// Returns the number of records out of order.
+static uint32_t Transfer(bool threads)
+{
+    Record record = {.type = 1};
+    uint32_t errors = 0;
+    pthread_t producer;
+
+    if (threads) {
+        pthread_create(&producer, NULL, Producer, NULL);
+    }
+    for (uint32_t i = 0; i < records; i++) {
+        if (!threads) {
+            record.sequence = i;
+            spsc_ring_push(&ring, &record);
+        }
+        while (!spsc_ring_pop(&ring, &record)) {
+            sched_yield();
+        }
+        errors += record.sequence != i;
+    }
+    if (threads) {
+        pthread_join(producer, NULL);
+    }
+    return errors;
+}
+
+static int RunMode(const Mode *mode)
+{
+    spsc_ring_init(&ring, storage, sizeof(Record), mode->capacity);
+
+    uint64_t startNs = NowNs(), startCycles = Cycles();
+    uint32_t errors = Transfer(mode->threads);
+    uint64_t cycles = Cycles() - startCycles, elapsedNs = NowNs() - startNs;
+
+    bool failed = errors != 0 || spsc_ring_count(&ring) != 0;
+    printf("%-12s %8" PRIu32 " %12.0f %10.1f%s\n", mode->name, mode->capacity,
+           records * 1e9 / elapsedNs, (double)cycles / records, failed ? "  FAILED" : "");
+
+    return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const Mode modes[] = {
+        {"one thread", 8, false},
+        {"two threads", 8, true},
+        {"two threads", LARGEST_CAPACITY, true},
+    };
+    int failed = 0;
+
+    records = BENCH_RECORDS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            records = BENCH_RECORDS / 100;
+        } else {
+            fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%" PRIu32 " records of %zu bytes, " CYCLES_UNIT " per record pushed and popped\n",
+           records, sizeof(Record));
+    printf("%-12s %8s %12s %10s\n", "mode", "capacity", "records/s", "cycles");
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        failed |= RunMode(&modes[i]);
+    }
+    return failed ? 1 : 0;
+}
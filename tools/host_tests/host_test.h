@@ -0,0 +1,31 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Minimal checks for the host tests. CHECK reports the failed condition with its location and
+// counts it; a test's main returns HostTest_Result() so that ctest sees every failure.
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            hostTestFailures++;                                                            \
+        }                                                                                  \
+    } while (0)
+
+static inline int HostTest_Result(void)
+{
+    if (hostTestFailures != 0) {
+        fprintf(stderr, "%d checks failed\n", hostTestFailures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif // #ifndef HOST_TEST_H
@@ -0,0 +1,184 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Simulated LSM6DSO, see lsm6dso_sim.h.
+
+#include <pthread.h>
+#include <string.h>
+
+#include "lsm6dso_reg.h"
+#include "lsm6dso_sim.h"
+
+#define CTRL3_C_SW_RESET 0x01
+#define CTRL3_C_IF_INC 0x04
+#define CTRL3_C_BOOT 0x80
+#define FUNC_CFG_ACCESS_BANKS 0xC0
+#define FIFO_CTRL4_MODE 0x07
+#define FIFO_STATUS2_OVR_IA 0x40
+
+Lsm6dsoSim lsm6dsoSim;
+
+// The board lying flat.
+const uint8_t lsm6dsoSimRecorded[LSM6DSO_SIM_RECORDED_WORDS][LSM6DSO_FIFO_WORD_SIZE] = {
+    {0x09, 0xF4, 0xFF, 0x05, 0x00, 0x03, 0x00}, {0x11, 0x29, 0x00, 0xB3, 0xFF, 0x0C, 0x20},
+    {0x0A, 0xF6, 0xFF, 0x06, 0x00, 0x02, 0x00}, {0x12, 0x26, 0x00, 0xB0, 0xFF, 0x07, 0x20},
+    {0x1D, 0x9C, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x0C, 0xF5, 0xFF, 0x04, 0x00, 0x03, 0x00},
+    {0x14, 0x2C, 0x00, 0xB5, 0xFF, 0x0F, 0x20}, {0x0F, 0xF3, 0xFF, 0x05, 0x00, 0x01, 0x00},
+    {0x17, 0x28, 0x00, 0xB1, 0xFF, 0x09, 0x20}, {0x09, 0xF4, 0xFF, 0x07, 0x00, 0x02, 0x00},
+    {0x11, 0x27, 0x00, 0xB4, 0xFF, 0x04, 0x20}, {0x1B, 0x9F, 0x01, 0x00, 0x00, 0x00, 0x00},
+    {0x0A, 0xF7, 0xFF, 0x05, 0x00, 0x04, 0x00}, {0x12, 0x2A, 0x00, 0xB2, 0xFF, 0x0B, 0x20},
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t fifo[LSM6DSO_SIM_FIFO_WORDS][LSM6DSO_FIFO_WORD_SIZE];
+static uint32_t fifoHead, fifoLevel;
+static bool fifoOverrun;
+
+// Power-on values of the registers the driver reads. A reboot (BOOT) reloads them as well as
+// the trimming values, which is all the driver can tell of it.
+static void ResetRegisters(void)
+{
+    memset(lsm6dsoSim.reg, 0, sizeof(lsm6dsoSim.reg));
+    memset(lsm6dsoSim.otherBank, 0, sizeof(lsm6dsoSim.otherBank));
+    lsm6dsoSim.reg[LSM6DSO_WHO_AM_I] = LSM6DSO_ID;
+    lsm6dsoSim.reg[LSM6DSO_CTRL3_C] = CTRL3_C_IF_INC;
+    fifoHead = fifoLevel = 0;
+    fifoOverrun = false;
+}
+
+static uint8_t *Register(uint8_t address)
+{
+    if (address != LSM6DSO_FUNC_CFG_ACCESS &&
+        (lsm6dsoSim.reg[LSM6DSO_FUNC_CFG_ACCESS] & FUNC_CFG_ACCESS_BANKS) != 0) {
+        return &lsm6dsoSim.otherBank[address];
+    }
+    return &lsm6dsoSim.reg[address];
+}
+
+// Moves the oldest FIFO word to the FIFO_DATA_OUT registers, zeroes if there is none.
+static void FifoPop(void)
+{
+    uint8_t *out = &lsm6dsoSim.reg[LSM6DSO_FIFO_DATA_OUT_TAG];
+
+    if (fifoLevel == 0) {
+        memset(out, 0, LSM6DSO_FIFO_WORD_SIZE);
+        return;
+    }
+    memcpy(out, fifo[fifoHead], LSM6DSO_FIFO_WORD_SIZE);
+    fifoHead = (fifoHead + 1) % LSM6DSO_SIM_FIFO_WORDS;
+    fifoLevel--;
+    fifoOverrun = false;
+}
+
+static void FifoStatus(void)
+{
+    lsm6dsoSim.reg[LSM6DSO_FIFO_STATUS1] = (uint8_t)fifoLevel;
+    lsm6dsoSim.reg[LSM6DSO_FIFO_STATUS2] =
+        (uint8_t)((fifoLevel >> 8) & 0x03) | (fifoOverrun ? FIFO_STATUS2_OVR_IA : 0);
+}
+
+void Lsm6dsoSim_Reset(void)
+{
+    pthread_mutex_lock(&lock);
+    ResetRegisters();
+    lsm6dsoSim.failWrites = false;
+    lsm6dsoSim.resetReads = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void Lsm6dsoSim_ResetCounts(void)
+{
+    pthread_mutex_lock(&lock);
+    lsm6dsoSim.transactions = lsm6dsoSim.writes = lsm6dsoSim.bytesOut = lsm6dsoSim.bytesIn = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+int32_t Lsm6dsoSim_Write(int *handle, uint8_t reg, uint8_t *data, uint16_t len)
+{
+    (void)handle;
+    pthread_mutex_lock(&lock);
+    lsm6dsoSim.transactions++;
+    lsm6dsoSim.writes++;
+    lsm6dsoSim.bytesOut += 1u + len;
+    if (lsm6dsoSim.failWrites) {
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t *target = Register((uint8_t)(reg + i));
+        if (target == &lsm6dsoSim.reg[LSM6DSO_CTRL3_C] &&
+            (data[i] & (CTRL3_C_SW_RESET | CTRL3_C_BOOT))) {
+            // Done at once, the bits read back clear.
+            ResetRegisters();
+            continue;
+        }
+        *target = data[i];
+        // Bypass mode empties the FIFO.
+        if (target == &lsm6dsoSim.reg[LSM6DSO_FIFO_CTRL4] && (data[i] & FIFO_CTRL4_MODE) == 0) {
+            fifoLevel = 0;
+            fifoOverrun = false;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int32_t Lsm6dsoSim_Read(int *handle, uint8_t reg, uint8_t *data, uint16_t len)
+{
+    uint8_t address = reg;
+
+    (void)handle;
+    pthread_mutex_lock(&lock);
+    lsm6dsoSim.transactions++;
+    lsm6dsoSim.bytesOut++;
+    lsm6dsoSim.bytesIn += len;
+    FifoStatus();
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t *source = Register(address);
+        if (source == &lsm6dsoSim.reg[LSM6DSO_FIFO_DATA_OUT_TAG]) {
+            FifoPop();
+        }
+        data[i] = *source;
+        if (source == &lsm6dsoSim.reg[LSM6DSO_CTRL3_C] && lsm6dsoSim.resetReads > 0) {
+            lsm6dsoSim.resetReads--;
+            data[i] |= CTRL3_C_SW_RESET;
+        }
+        // The address rolls back from FIFO_DATA_OUT_Z_H to FIFO_DATA_OUT_TAG.
+        address = source == &lsm6dsoSim.reg[LSM6DSO_FIFO_DATA_OUT_Z_H]
+                      ? LSM6DSO_FIFO_DATA_OUT_TAG
+                      : (uint8_t)(address + 1);
+    }
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+void Lsm6dsoSim_SetRegisters(uint8_t reg, const void *data, uint16_t len)
+{
+    pthread_mutex_lock(&lock);
+    memcpy(&lsm6dsoSim.reg[reg], data, len);
+    pthread_mutex_unlock(&lock);
+}
+
+void Lsm6dsoSim_FifoPush(const uint8_t *words, uint32_t count)
+{
+    pthread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < count; i++) {
+        if (fifoLevel == LSM6DSO_SIM_FIFO_WORDS) {
+            fifoHead = (fifoHead + 1) % LSM6DSO_SIM_FIFO_WORDS;
+            fifoLevel--;
+            fifoOverrun = true;
+        }
+        memcpy(fifo[(fifoHead + fifoLevel) % LSM6DSO_SIM_FIFO_WORDS],
+               &words[i * LSM6DSO_FIFO_WORD_SIZE], LSM6DSO_FIFO_WORD_SIZE);
+        fifoLevel++;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+uint32_t Lsm6dsoSim_FifoLevel(void)
+{
+    pthread_mutex_lock(&lock);
+    uint32_t level = fifoLevel;
+    pthread_mutex_unlock(&lock);
+    return level;
+}
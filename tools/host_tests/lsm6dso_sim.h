@@ -0,0 +1,63 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Simulated LSM6DSO for the host tests, behind the register read and write functions of
+// lsm6dso_ctx_t. It is a register file with address auto-increment, a second bank behind
+// FUNC_CFG_ACCESS, a software reset and reboot, and a FIFO which a test fills with recorded
+// words. Every access is counted as the I2C service moves it: the register address byte, then
+// the data. Accesses are serialized, so the sensor may be fed while another thread reads it.
+
+#ifndef LSM6DSO_SIM_H
+#define LSM6DSO_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lsm6dso_driver.h"
+
+/// <summary>FIFO depth in words, the largest watermark plus one.</summary>
+#define LSM6DSO_SIM_FIFO_WORDS (LSM6DSO_FIFO_WATERMARK_MAX + 1)
+
+/// <summary>Words in lsm6dsoSimRecorded.</summary>
+#define LSM6DSO_SIM_RECORDED_WORDS 14
+
+typedef struct {
+    uint8_t reg[256];
+    uint8_t otherBank[256]; // the embedded functions and sensor hub banks, as one
+    bool failWrites;
+    uint32_t resetReads; // reads of CTRL3_C which still show SW_RESET set
+
+    uint32_t transactions, writes, bytesOut, bytesIn;
+} Lsm6dsoSim;
+
+extern Lsm6dsoSim lsm6dsoSim;
+
+/// <summary>
+/// A FIFO as the sensor batched it with the demo's setup at 12.5 Hz: gyroscope and
+/// accelerometer words in turn, and a temperature word once a second.
+/// </summary>
+extern const uint8_t lsm6dsoSimRecorded[LSM6DSO_SIM_RECORDED_WORDS][LSM6DSO_FIFO_WORD_SIZE];
+
+/// <summary>Restores the power-on register values and empties the FIFO.</summary>
+void Lsm6dsoSim_Reset(void);
+
+/// <summary>Zeroes the transaction and byte counts.</summary>
+void Lsm6dsoSim_ResetCounts(void);
+
+/// <summary>Register access, for lsm6dso_ctx_t; the handle is not used.</summary>
+int32_t Lsm6dsoSim_Write(int *handle, uint8_t reg, uint8_t *data, uint16_t len);
+int32_t Lsm6dsoSim_Read(int *handle, uint8_t reg, uint8_t *data, uint16_t len);
+
+/// <summary>Sets registers the sensor updates itself, such as the outputs.</summary>
+void Lsm6dsoSim_SetRegisters(uint8_t reg, const void *data, uint16_t len);
+
+/// <summary>
+/// Batches count words of LSM6DSO_FIFO_WORD_SIZE bytes, tag first, into the FIFO. A full FIFO
+/// overwrites its oldest word and sets FIFO_OVR_IA until a word is read.
+/// </summary>
+void Lsm6dsoSim_FifoPush(const uint8_t *words, uint32_t count);
+
+/// <summary>Returns the number of words waiting in the FIFO.</summary>
+uint32_t Lsm6dsoSim_FifoLevel(void);
+
+#endif // #ifndef LSM6DSO_SIM_H
@@ -0,0 +1,35 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the MT3620 BSP's mt3620.h, which the real-time demo's drivers include for
+// the interrupt numbers and the NVIC. The Cortex-M4 core header it also pulls in has no host
+// counterpart, except for the SIMD intrinsics of the DSP extension: a host build which defines
+// __ARM_FEATURE_DSP runs the drivers' DSP paths on C versions of them.
+
+#ifndef MT3620_H
+#define MT3620_H
+
+#include "irq.h"
+#include "nvic.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+// Both halfwords of op1 less those of op2, each wrapping at 16 bits.
+static inline uint32_t __SSUB16(uint32_t op1, uint32_t op2)
+{
+    uint16_t low = (uint16_t)((uint16_t)op1 - (uint16_t)op2);
+    uint16_t high = (uint16_t)((uint16_t)(op1 >> 16) - (uint16_t)(op2 >> 16));
+    return (uint32_t)high << 16 | low;
+}
+
+// The signed products of the low and of the high halfwords, summed; an overflow wraps.
+static inline uint32_t __SMUAD(uint32_t op1, uint32_t op2)
+{
+    int32_t low = (int32_t)(int16_t)op1 * (int16_t)op2;
+    int32_t high = (int32_t)(int16_t)(op1 >> 16) * (int16_t)(op2 >> 16);
+    return (uint32_t)low + (uint32_t)high;
+}
+
+#endif
+
+#endif // #ifndef MT3620_H
@@ -0,0 +1,45 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the MT3620 BSP's nvic.h, for compiling the OS_HAL drivers on the host. It
+// keeps the handlers the drivers install, by the interrupt numbers of the BSP's irq.h, and runs
+// them when a test raises the interrupt with HostNvic_Raise. PRIMASK is a lock which handlers
+// run under, so that a thread which disables interrupts keeps them out as on the M4.
+
+#ifndef NVIC_H
+#define NVIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "irq.h"
+
+#define DEFAULT_PRI 5
+#define IRQ_LEVEL_TRIGGER 0x01
+
+#ifndef TRUE
+#define TRUE (1)
+#define FALSE (0)
+#endif
+
+typedef int IRQn_Type;
+typedef void (*NVIC_IRQ_Handler)(void);
+
+void CM4_Install_NVIC(int irqn, int prior, int edgetr, NVIC_IRQ_Handler handler, int enable);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+/// <summary>
+/// Runs the handler installed for irqn, if it is enabled, with interrupts disabled, and returns
+/// whether it ran. Waits while another thread has interrupts disabled.
+/// </summary>
+bool HostNvic_Raise(int irqn);
+
+/// <summary>Returns whether a handler is installed and enabled for irqn.</summary>
+bool HostNvic_IsEnabled(int irqn);
+
+#endif // #ifndef NVIC_H
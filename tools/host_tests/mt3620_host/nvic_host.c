@@ -0,0 +1,79 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the MT3620 NVIC, see nvic.h.
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "nvic.h"
+
+#define HOST_NVIC_IRQS 256
+
+static NVIC_IRQ_Handler handlers[HOST_NVIC_IRQS];
+static bool enabled[HOST_NVIC_IRQS];
+
+// Held by whichever thread has interrupts disabled, which PRIMASK records per thread.
+static pthread_mutex_t masked = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local uint32_t primask;
+
+void CM4_Install_NVIC(int irqn, int prior, int edgetr, NVIC_IRQ_Handler handler, int enable)
+{
+    (void)prior;
+    (void)edgetr;
+    if (irqn >= 0 && irqn < HOST_NVIC_IRQS) {
+        handlers[irqn] = handler;
+        enabled[irqn] = enable != 0;
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= 0 && IRQn < HOST_NVIC_IRQS) {
+        enabled[IRQn] = false;
+    }
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    if (priMask && !primask) {
+        pthread_mutex_lock(&masked);
+    } else if (!priMask && primask) {
+        pthread_mutex_unlock(&masked);
+    }
+    primask = priMask;
+}
+
+void __disable_irq(void)
+{
+    __set_PRIMASK(1);
+}
+
+void __enable_irq(void)
+{
+    __set_PRIMASK(0);
+}
+
+bool HostNvic_IsEnabled(int irqn)
+{
+    return irqn >= 0 && irqn < HOST_NVIC_IRQS && enabled[irqn] && handlers[irqn] != NULL;
+}
+
+bool HostNvic_Raise(int irqn)
+{
+    uint32_t saved = __get_PRIMASK();
+    bool ran = false;
+
+    __disable_irq();
+    if (HostNvic_IsEnabled(irqn)) {
+        handlers[irqn]();
+        ran = true;
+    }
+    __set_PRIMASK(saved);
+    return ran;
+}
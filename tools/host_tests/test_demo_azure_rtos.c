@@ -0,0 +1,466 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the real-time demo, demo_threadx/demo_azure_rtos.c, run whole on the host ThreadX
+// stand-in. The shared buffers and the mailbox are intercore_sim's, the sensor is the one in
+// lsm6dso_sim.c behind the demo's I2C service, and the test plays the high-level app. It
+// answers requests in order, and replays recorded FIFO contents through the sensor thread: the
+// samples must come out of the tagged words in frames at the subscribed period, and the first
+// sample after an overrun must carry IC_SAMPLE_FIFO_OVERRUN. While the test stops reading, the
+// inter core TX thread must keep the frames in order, wait for credit rather than the senders,
+// and count every frame it gives up on; its blocks must all be back in block_pool_0 after.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "i2c.h"
+#include "intercore_msg.h"
+#include "lsm6dso_driver.h"
+#include "lsm6dso_sim.h"
+#include "os_hal_eint.h"
+#include "os_hal_gpio.h"
+#include "sim_common.h"
+#include "threadx_host.h"
+#include "tx_api.h"
+
+#define PAYLOAD_START 20 // component ID header added by the runtime
+#define START_TIMEOUT_MS 2000
+#define REPLY_TIMEOUT_MS 1000
+#define FRAME_TIMEOUT_MS 1000
+#define SAMPLE_PERIOD_MS 80 // the recording's batching interval
+#define SAMPLES_PER_FRAME 4
+#define OVERRUN_WORDS (LSM6DSO_SIM_FIFO_WORDS + 8)
+#define BUFFER_LOG2 10 // a 1 KB ring, which a few frames fill
+#define FRAME_BLOCK_SIZE \
+    Sim_RoundUp(sizeof(uint32_t) + PAYLOAD_START + sizeof(IC_MSG_HEADER) + \
+                sizeof(IC_SAMPLE_FRAME_HEADER) + SAMPLES_PER_FRAME * sizeof(IC_SAMPLE))
+#define STALL_MS 200         // a slow reader, below INTER_CORE_SEND_TIMEOUT
+#define STALL_DROP_MS 1000   // a reader the TX thread gives up on
+#define TX_BLOCKS 4           // INTER_CORE_TX_BLOCKS
+
+int demo_main(void);
+
+extern TX_BLOCK_POOL block_pool_0;
+
+static void (*volatile int1Handler)(void);
+static uint32_t hlWrite, hlRead;
+
+// The BSP's printf, which the demo reports to.
+int printf_(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+// The OS-HAL I2C driver, on the simulated sensor.
+int mtk_os_hal_i2c_ctrl_init(i2c_num bus_num)
+{
+    (void)bus_num;
+    return 0;
+}
+
+int mtk_os_hal_i2c_speed_init(i2c_num bus_num, enum i2c_speed_kHz speed)
+{
+    (void)bus_num;
+    (void)speed;
+    return 0;
+}
+
+int mtk_os_hal_i2c_write(i2c_num bus_num, u8 device_addr, u8 *buffer, u16 len)
+{
+    (void)bus_num;
+    if (device_addr != i2c_lsm6dso_addr || len == 0) {
+        return -1;
+    }
+    return Lsm6dsoSim_Write(NULL, buffer[0], buffer + 1, (uint16_t)(len - 1));
+}
+
+int mtk_os_hal_i2c_read(i2c_num bus_num, u8 device_addr, u8 *buffer, u16 len)
+{
+    (void)bus_num;
+    memset(buffer, 0, len);
+    return device_addr == i2c_lsm6dso_addr ? 0 : -1;
+}
+
+int mtk_os_hal_i2c_write_read(i2c_num bus_num, u8 device_addr, u8 *wr_buf, u8 *rd_buf,
+                              u16 wr_len, u16 rd_len)
+{
+    (void)bus_num;
+    if (device_addr != i2c_lsm6dso_addr || wr_len != 1) {
+        return -1;
+    }
+    return Lsm6dsoSim_Read(NULL, wr_buf[0], rd_buf, rd_len);
+}
+
+// The OS-HAL GPIO and EINT drivers. INT1's handler is kept for the test to raise.
+int mtk_os_hal_gpio_request(os_hal_gpio_pin pin)
+{
+    (void)pin;
+    return 0;
+}
+
+int mtk_os_hal_gpio_free(os_hal_gpio_pin pin)
+{
+    (void)pin;
+    return 0;
+}
+
+int mtk_os_hal_gpio_set_output(os_hal_gpio_pin pin, os_hal_gpio_data out_val)
+{
+    (void)pin;
+    (void)out_val;
+    return 0;
+}
+
+int mtk_os_hal_gpio_set_direction(os_hal_gpio_pin pin, os_hal_gpio_direction dir)
+{
+    (void)pin;
+    (void)dir;
+    return 0;
+}
+
+int mtk_os_hal_eint_register(eint_number eint_num, eint_trigger_mode trigger_mode,
+                             void (*handle)(void))
+{
+    (void)eint_num;
+    (void)trigger_mode;
+    int1Handler = handle;
+    return 0;
+}
+
+static void Int1Interrupt(void *arg)
+{
+    (void)arg;
+    int1Handler();
+}
+
+// Raises INT1, as the sensor does at its FIFO watermark, and waits for the handler to have run.
+static void RaiseInt1(void)
+{
+    pthread_t interrupt;
+
+    if (HostTx_RaiseInterrupt(&interrupt, 0, Int1Interrupt, NULL) == 0) {
+        pthread_join(interrupt, NULL);
+    }
+}
+
+// Sends one request in a datagram of its own, behind the component ID header.
+static void SendRequest(uint8_t type, uint32_t sequence, const void *payload, uint16_t length)
+{
+    uint8_t datagram[PAYLOAD_START + IC_MSG_MAX_SIZE] = "test component id";
+    uint32_t size = ic_msg_encode(&datagram[PAYLOAD_START], IC_MSG_MAX_SIZE, type, sequence,
+                                  payload, length);
+
+    Sim_HlSend(&hlWrite, datagram, PAYLOAD_START + size);
+}
+
+// Waits up to timeoutMs for the next message from the demo, and copies its payload, of up to
+// IC_MSG_MAX_PAYLOAD bytes.
+static bool Receive(IC_MSG_HEADER *header, void *payload, uint32_t timeoutMs)
+{
+    uint8_t block[MAX_MESSAGE_SIZE];
+    uint64_t deadlineNs = NowNs() + (uint64_t)timeoutMs * 1000000;
+    const uint8_t *data;
+    uint32_t size;
+
+    while ((size = Sim_HlReceive(&hlRead, block)) == 0) {
+        if (NowNs() > deadlineNs) {
+            return false;
+        }
+        Event_Wait(&hlReceive);
+    }
+    if (size == UINT32_MAX || size < PAYLOAD_START) {
+        return false;
+    }
+    Sim_HlRelease(hlRead);
+
+    if (ic_msg_decode(&block[PAYLOAD_START], size - PAYLOAD_START, header, &data) !=
+        size - PAYLOAD_START) {
+        return false;
+    }
+    memcpy(payload, data, header->length);
+    return true;
+}
+
+// Receives raw sample frames until none arrives for FRAME_TIMEOUT_MS, checking they are
+// numbered from *frameSequence on, in order; a dropped frame leaves a gap. Sets *frameSequence
+// past the last frame, and returns the number of samples received. If other is not NULL, a
+// message of another type also ends the frames and is left in other and otherPayload.
+static uint32_t ReceiveFrames(IC_SAMPLE *samples, uint32_t maxSamples, uint32_t *frameSequence,
+                              IC_MSG_HEADER *other, void *otherPayload)
+{
+    uint8_t payload[IC_MSG_MAX_PAYLOAD];
+    IC_SAMPLE_FRAME_HEADER frame;
+    IC_MSG_HEADER header;
+    uint32_t count = 0;
+
+    if (other != NULL) {
+        other->type = IC_MSG_UNKNOWN;
+    }
+    while (Receive(&header, payload, FRAME_TIMEOUT_MS)) {
+        if (other != NULL && header.type != IC_MSG_SAMPLE_FRAME) {
+            *other = header;
+            memcpy(otherPayload, payload, header.length);
+            break;
+        }
+        memcpy(&frame, payload, sizeof(frame));
+        CHECK(header.type == IC_MSG_SAMPLE_FRAME);
+        CHECK(header.sequence >= *frameSequence);
+        CHECK(frame.count == SAMPLES_PER_FRAME && frame.periodMs == SAMPLE_PERIOD_MS);
+        CHECK(header.length == sizeof(frame) + frame.count * sizeof(IC_SAMPLE));
+        if (header.type != IC_MSG_SAMPLE_FRAME || count + frame.count > maxSamples) {
+            break;
+        }
+        memcpy(&samples[count], &payload[sizeof(frame)], frame.count * sizeof(IC_SAMPLE));
+        count += frame.count;
+        *frameSequence = header.sequence + 1;
+    }
+    return count;
+}
+
+static void Subscribe(uint32_t sequence, uint16_t periodMs)
+{
+    IC_SUBSCRIBE_PAYLOAD request = {.periodMs = periodMs, .samplesPerFrame = SAMPLES_PER_FRAME};
+    IC_SUBSCRIBE_PAYLOAD reply;
+    IC_MSG_HEADER header;
+
+    SendRequest(IC_MSG_SUBSCRIBE, sequence, &request, sizeof(request));
+    CHECK(Receive(&header, &reply, REPLY_TIMEOUT_MS));
+    CHECK(header.type == IC_MSG_SUBSCRIBE && header.sequence == sequence);
+    CHECK(header.length == sizeof(reply) && reply.periodMs == periodMs);
+    CHECK(periodMs == 0 || reply.samplesPerFrame == SAMPLES_PER_FRAME);
+}
+
+static void GetStats(uint32_t sequence, IC_STATS_PAYLOAD *stats)
+{
+    IC_MSG_HEADER header;
+
+    SendRequest(IC_MSG_GET_STATS, sequence, NULL, 0);
+    CHECK(Receive(&header, stats, REPLY_TIMEOUT_MS));
+    CHECK(header.type == IC_MSG_GET_STATS && header.sequence == sequence);
+}
+
+// Batches whole recordings, six steps each.
+static void PushRecordings(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        Lsm6dsoSim_FifoPush(lsm6dsoSimRecorded[0], LSM6DSO_SIM_RECORDED_WORDS);
+    }
+}
+
+static void TestRequests(void)
+{
+    static const int16_t temperature = 5 * 256; // 30 degrees Celsius
+    static const uint8_t temperatureReady = 0x04;
+    IC_TEMPERATURE_PAYLOAD temperatureReply;
+    IC_STATS_PAYLOAD stats;
+    IC_MSG_HEADER header;
+
+    // Read by the background sampler, every 100 ms.
+    Lsm6dsoSim_SetRegisters(LSM6DSO_OUT_TEMP_L, &temperature, sizeof(temperature));
+    Lsm6dsoSim_SetRegisters(LSM6DSO_STATUS_REG, &temperatureReady, 1);
+    SleepUs(300000);
+
+    // Answered in order, each with its own sequence number.
+    SendRequest(IC_MSG_GET_TEMPERATURE, 1, NULL, 0);
+    SendRequest(IC_MSG_GET_STATS, 2, NULL, 0);
+    CHECK(Receive(&header, &temperatureReply, REPLY_TIMEOUT_MS));
+    CHECK(header.type == IC_MSG_GET_TEMPERATURE && header.sequence == 1);
+    CHECK(temperatureReply.temperature == 30.0f);
+    CHECK(Receive(&header, &stats, REPLY_TIMEOUT_MS));
+    CHECK(header.type == IC_MSG_GET_STATS && header.sequence == 2);
+    CHECK(stats.bufferSize == bufSize && stats.messagesIn == 2 && stats.sendsDropped == 0);
+}
+
+static void CheckSample(const IC_SAMPLE *sample, uint32_t gyroscopeWord,
+                        uint32_t accelerometerWord, uint16_t flags)
+{
+    const uint8_t *gyroscope = lsm6dsoSimRecorded[gyroscopeWord];
+    const uint8_t *accelerometer = lsm6dsoSimRecorded[accelerometerWord];
+
+    CHECK(gyroscope[0] >> 3 == LSM6DSO_GYRO_NC_TAG && accelerometer[0] >> 3 == LSM6DSO_XL_NC_TAG);
+    CHECK(memcmp(sample->angularRate, &gyroscope[1], sizeof(sample->angularRate)) == 0);
+    CHECK(memcmp(sample->acceleration, &accelerometer[1], sizeof(sample->acceleration)) == 0);
+    CHECK(sample->flags == flags);
+}
+
+static void TestFifoReplay(void)
+{
+    // The recording's batching steps: its gyroscope and accelerometer words, and the
+    // temperature word received since the step before, if any.
+    static const struct {
+        uint8_t gyroscope, accelerometer;
+        int8_t temperature;
+    } steps[] = {{0, 1, -1}, {2, 3, -1}, {5, 6, 4}, {7, 8, -1}, {9, 10, -1}, {12, 13, 11}};
+    const uint32_t stepCount = sizeof(steps) / sizeof(steps[0]);
+    const uint16_t sampled = IC_SAMPLE_NEW_ACCELERATION | IC_SAMPLE_NEW_ANGULAR_RATE;
+    IC_SAMPLE samples[3 * SAMPLES_PER_FRAME];
+    uint32_t frameSequence = 0;
+
+    Subscribe(3, SAMPLE_PERIOD_MS);
+
+    // Twice through, 12 steps, taken as 3 frames at the batching interval.
+    PushRecordings(2);
+    RaiseInt1();
+    CHECK(ReceiveFrames(samples, 3 * SAMPLES_PER_FRAME, &frameSequence, NULL, NULL) ==
+          3 * SAMPLES_PER_FRAME);
+    CHECK(frameSequence == 3);
+    CHECK(Lsm6dsoSim_FifoLevel() == 0);
+
+    for (uint32_t i = 0; i < 2 * stepCount; i++) {
+        int8_t temperature = steps[i % stepCount].temperature;
+        uint16_t flags = sampled | (temperature >= 0 ? IC_SAMPLE_NEW_TEMPERATURE : 0);
+
+        CheckSample(&samples[i], steps[i % stepCount].gyroscope,
+                    steps[i % stepCount].accelerometer, flags);
+        if (temperature >= 0) {
+            CHECK(memcmp(&samples[i].temperature, &lsm6dsoSimRecorded[temperature][1],
+                         sizeof(samples[i].temperature)) == 0);
+        }
+        CHECK(samples[i].timestamp - samples[0].timestamp == i * SAMPLE_PERIOD_MS);
+    }
+}
+
+static void TestFifoOverrun(void)
+{
+    static uint8_t words[OVERRUN_WORDS][LSM6DSO_FIFO_WORD_SIZE];
+    static IC_SAMPLE samples[OVERRUN_WORDS / 2];
+    uint32_t frameSequence = 3, sensorWords = 0, expected, count;
+
+    // The recording again and again, more than the FIFO holds: the oldest words are lost.
+    for (uint32_t i = 0; i < OVERRUN_WORDS; i++) {
+        memcpy(words[i], lsm6dsoSimRecorded[i % LSM6DSO_SIM_RECORDED_WORDS],
+               LSM6DSO_FIFO_WORD_SIZE);
+        if (i >= OVERRUN_WORDS - LSM6DSO_SIM_FIFO_WORDS &&
+            words[i][0] >> 3 != LSM6DSO_TEMPERATURE_TAG) {
+            sensorWords++;
+        }
+    }
+    // Whole frames of the steps in the words kept.
+    expected = sensorWords / 2 / SAMPLES_PER_FRAME * SAMPLES_PER_FRAME;
+
+    Lsm6dsoSim_FifoPush(words[0], OVERRUN_WORDS);
+    RaiseInt1();
+    count = ReceiveFrames(samples, OVERRUN_WORDS / 2, &frameSequence, NULL, NULL);
+    CHECK(count == expected);
+    CHECK(frameSequence == 3 + count / SAMPLES_PER_FRAME);
+
+    // The first sample after the overrun is flagged, and only that one.
+    CHECK(count > 0);
+    CHECK((samples[0].flags & IC_SAMPLE_FIFO_OVERRUN) != 0);
+    for (uint32_t i = 1; i < count; i++) {
+        CHECK((samples[i].flags & IC_SAMPLE_FIFO_OVERRUN) == 0);
+        CHECK(samples[i].timestamp - samples[i - 1].timestamp == SAMPLE_PERIOD_MS);
+    }
+
+    Subscribe(4, 0);
+}
+
+// Pushes whole recordings for at least frames frames, and stops reading for stallMs meanwhile.
+// Then receives every frame that comes, and checks the TX thread's counters: it waited for
+// credit, and every frame it or the sensor thread gave up on left a gap in the sequence.
+static void StallReader(uint32_t sequence, uint32_t frames, uint32_t stallMs, bool drops)
+{
+    static IC_SAMPLE samples[LSM6DSO_SIM_FIFO_WORDS / 2]; // a FIFO's worth of steps
+    uint32_t recordings = frames * SAMPLES_PER_FRAME / 6 + 1, frameSequence = 0, count;
+    IC_STATS_PAYLOAD before, during, after;
+    IC_MSG_HEADER header;
+
+    frames = recordings * 6 / SAMPLES_PER_FRAME;
+    GetStats(sequence, &before);
+    Subscribe(sequence + 1, SAMPLE_PERIOD_MS);
+
+    PushRecordings(recordings);
+    RaiseInt1();
+    SleepUs(stallMs * 1000 / 2);
+    // Taken by the inter core thread while the TX thread waits, and answered behind the frames.
+    SendRequest(IC_MSG_GET_STATS, sequence + 2, NULL, 0);
+    SleepUs(stallMs * 1000 / 2);
+
+    count = ReceiveFrames(samples, frames * SAMPLES_PER_FRAME, &frameSequence, &header, &during);
+    if (!drops) {
+        CHECK(count == frames * SAMPLES_PER_FRAME && frameSequence == frames);
+        CHECK(header.type == IC_MSG_GET_STATS && header.sequence == sequence + 2);
+        CHECK(during.senderWaits > before.senderWaits);
+        CHECK(during.sendsDropped == before.sendsDropped);
+    } else {
+        // The stats reply may have been dropped too, and frames may follow it.
+        if (header.type != IC_MSG_UNKNOWN) {
+            CHECK(header.type == IC_MSG_GET_STATS && header.sequence == sequence + 2);
+            count += ReceiveFrames(&samples[count], frames * SAMPLES_PER_FRAME - count,
+                                   &frameSequence, NULL, NULL);
+        }
+        CHECK(count < frames * SAMPLES_PER_FRAME && frameSequence <= frames);
+    }
+    GetStats(sequence + 3, &after);
+    CHECK(after.senderWaits > before.senderWaits);
+    // Frames lost in the gaps and after the last one received, and the reply if it was lost.
+    CHECK(after.sendsDropped - before.sendsDropped ==
+          frames - count / SAMPLES_PER_FRAME + (header.type == IC_MSG_UNKNOWN ? 1 : 0));
+
+    Subscribe(sequence + 4, 0);
+}
+
+// A reader slower than the ring fills, but faster than INTER_CORE_SEND_TIMEOUT: nothing is
+// lost.
+static void TestSlowReader(void)
+{
+    StallReader(10, bufSize / FRAME_BLOCK_SIZE + 1, STALL_MS, false);
+}
+
+// A reader so slow that the TX thread gives up on frames, and the sensor thread on blocks.
+static void TestStalledReader(void)
+{
+    StallReader(20, bufSize / FRAME_BLOCK_SIZE + 2 * TX_BLOCKS, STALL_DROP_MS, true);
+}
+
+// Every message posted to the TX thread gave its block back.
+static void TestBlockPool(void)
+{
+    uint64_t deadlineNs = NowNs() + (uint64_t)REPLY_TIMEOUT_MS * 1000000;
+    ULONG available, total;
+
+    do {
+        tx_block_pool_info_get(&block_pool_0, NULL, &available, &total, NULL, NULL, NULL);
+    } while (available != total && NowNs() < deadlineNs);
+    CHECK(total == TX_BLOCKS && available == total);
+}
+
+static void *HighLevelApp(void *arg)
+{
+    uint64_t deadlineNs = NowNs() + (uint64_t)START_TIMEOUT_MS * 1000000;
+
+    (void)arg;
+    // The sensor thread registers INT1 once the sensor is set up.
+    while (int1Handler == NULL && NowNs() < deadlineNs) {
+        SleepUs(1000);
+    }
+    CHECK(int1Handler != NULL);
+    if (int1Handler != NULL) {
+        TestRequests();
+        TestFifoReplay();
+        TestFifoOverrun();
+        TestSlowReader();
+        TestStalledReader();
+        TestBlockPool();
+    }
+    exit(HostTest_Result());
+}
+
+int main(void)
+{
+    pthread_t highLevelApp;
+
+    Lsm6dsoSim_Reset();
+    bufferLog2 = BUFFER_LOG2;
+    if (Sim_Init() != 0 || Sim_SetUpRings() != 0) {
+        return 1;
+    }
+    // Set up again, for the demo's inter core thread.
+    Sim_PushSetup();
+
+    pthread_create(&highLevelApp, NULL, HighLevelApp, NULL);
+    demo_main();
+}
@@ -0,0 +1,256 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the high-level inter-core library in learning_path_libs/inter_core.c, with the
+// test playing the real-time app on the other end of the socketpair behind
+// Application_Connect: coalescing of outbound messages, replies matched to asynchronous
+// requests, delivery in arrival order, request timeouts, and closing the connection.
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "applibs_host.h"
+#include "host_test.h"
+#include "inter_core.h"
+
+#define LOG_MAX 16
+
+// What the library handed to the test's callbacks, in order.
+typedef enum { DELIVERED_MESSAGE, DELIVERED_REPLY, DELIVERED_TIMEOUT, DELIVERED_FRAME } Delivery;
+
+static struct {
+    Delivery kind;
+    uint32_t sequence;
+} deliveries[LOG_MAX];
+static size_t deliveryCount, batchCount;
+
+static void Record(Delivery kind, uint32_t sequence)
+{
+    if (deliveryCount < LOG_MAX) {
+        deliveries[deliveryCount].kind = kind;
+        deliveries[deliveryCount].sequence = sequence;
+    }
+    deliveryCount++;
+}
+
+static void MessageHandler(LP_INTER_CORE_BLOCK *block)
+{
+    Record(DELIVERED_MESSAGE, block->sequence);
+}
+
+static void BatchHandler(LP_INTER_CORE_BLOCK *blocks, size_t count)
+{
+    batchCount++;
+    for (size_t i = 0; i < count; i++) {
+        Record(DELIVERED_MESSAGE, blocks[i].sequence);
+    }
+}
+
+static void ReplyHandler(uint32_t sequence, LP_INTER_CORE_BLOCK *reply)
+{
+    Record(reply == NULL ? DELIVERED_TIMEOUT : DELIVERED_REPLY, sequence);
+}
+
+static void FrameHandler(LP_INTER_CORE_FRAME *frame)
+{
+    Record(DELIVERED_FRAME, frame->sequence);
+}
+
+static void ResetDeliveries(void)
+{
+    deliveryCount = batchCount = 0;
+}
+
+static uint64_t NowMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// Runs the event loop until the real-time side has received a message, and returns it.
+static bool PeerReceive(IC_MSG_HEADER *header)
+{
+    uint8_t buffer[IC_MSG_MAX_SIZE];
+    const uint8_t *payload;
+    uint64_t start = NowMs();
+
+    while (NowMs() - start < 1000) {
+        ssize_t size = recv(HostApplibs_PeerFd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (size > 0) {
+            return ic_msg_decode(buffer, (uint32_t)size, header, &payload) != 0;
+        }
+        EventLoop_Run(lp_getTimerEventLoop(), 10, true);
+    }
+    return false;
+}
+
+static void PeerSend(uint8_t type, uint32_t sequence, const void *payload, uint16_t length)
+{
+    uint8_t buffer[IC_MSG_MAX_SIZE];
+    uint32_t size = ic_msg_encode(buffer, sizeof(buffer), type, sequence, payload, length);
+
+    CHECK(send(HostApplibs_PeerFd(), buffer, size, 0) == (ssize_t)size);
+}
+
+// Runs the event loop until count deliveries have been made, or for up to timeoutMs.
+static void RunUntil(size_t count, uint32_t timeoutMs)
+{
+    uint64_t start = NowMs();
+
+    while (deliveryCount < count && NowMs() - start < timeoutMs) {
+        EventLoop_Run(lp_getTimerEventLoop(), 10, true);
+    }
+}
+
+static void TestCoalescing(void)
+{
+    uint8_t payload[200], buffer[IC_MSG_MAX_SIZE];
+    LP_INTER_CORE_BLOCK block = {.cmd = LP_IC_GET_STATS};
+    IC_MSG_HEADER header;
+    const uint8_t *decoded = NULL;
+    uint32_t messages, datagrams, sequences[3];
+
+    lp_getInterCoreSendStats(&messages, &datagrams);
+
+    // Messages queued in one turn go out as one datagram, each with its own header.
+    for (int i = 0; i < 3; i++) {
+        CHECK(lp_sendInterCoreMessage(&block));
+        sequences[i] = block.sequence;
+    }
+    CHECK(recv(HostApplibs_PeerFd(), buffer, sizeof(buffer), MSG_DONTWAIT) == -1);
+    // The flush timer, the only event pending, ends the turn.
+    CHECK(EventLoop_Run(lp_getTimerEventLoop(), 100, true) == EventLoop_Run_Finished);
+
+    ssize_t size = recv(HostApplibs_PeerFd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+    CHECK(size == 3 * sizeof(IC_MSG_HEADER));
+    for (int i = 0; i < 3 && size > 0; i++) {
+        CHECK(ic_msg_decode(buffer + i * sizeof(IC_MSG_HEADER), sizeof(IC_MSG_HEADER), &header,
+                            &decoded) == sizeof(IC_MSG_HEADER));
+        CHECK(header.type == IC_MSG_GET_STATS && header.sequence == sequences[i]);
+    }
+
+    // Reaching LP_INTER_CORE_FLUSH_THRESHOLD sends straight away.
+    memset(payload, 0x5A, sizeof(payload));
+    block.payload = payload;
+    block.length = sizeof(payload);
+    for (int i = 0; i < 3; i++) {
+        CHECK(lp_sendInterCoreMessage(&block));
+    }
+    size = recv(HostApplibs_PeerFd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+    CHECK(size == 3 * (sizeof(IC_MSG_HEADER) + sizeof(payload)));
+    CHECK(ic_msg_decode(buffer, (uint32_t)size, &header, &decoded) != 0);
+    CHECK(header.length == sizeof(payload) && memcmp(decoded, payload, sizeof(payload)) == 0);
+
+    uint32_t messagesAfter, datagramsAfter;
+    lp_getInterCoreSendStats(&messagesAfter, &datagramsAfter);
+    CHECK(messagesAfter - messages == 6);
+    CHECK(datagramsAfter - datagrams == 2);
+}
+
+static void TestArrivalOrder(void)
+{
+    IC_SUBSCRIBE_PAYLOAD subscription = {.periodMs = 10, .samplesPerFrame = 1};
+    IC_TEMPERATURE_PAYLOAD temperature = {.temperature = 21.5f};
+    struct {
+        IC_SAMPLE_FRAME_HEADER header;
+        IC_SAMPLE sample;
+    } frame = {.header = {.count = 1, .periodMs = 10}};
+    IC_MSG_HEADER request;
+
+    uint32_t subscribe = lp_subscribeInterCoreSamples(10, 1, false, FrameHandler, 1000,
+                                                      ReplyHandler);
+    CHECK(subscribe != 0);
+    CHECK(PeerReceive(&request) && request.type == IC_MSG_SUBSCRIBE);
+    PeerSend(IC_MSG_SUBSCRIBE, subscribe, &subscription, sizeof(subscription));
+    RunUntil(1, 1000);
+
+    uint32_t sequence = lp_interCoreRequestAsync(LP_IC_GET_TEMPERATURE, NULL, 0, 1000,
+                                                 ReplyHandler);
+    CHECK(PeerReceive(&request) && request.sequence == sequence);
+
+    // Read by one socket event: the reply and the frame split the messages into three batches.
+    ResetDeliveries();
+    PeerSend(IC_MSG_GET_STATS, 1000, NULL, 0);
+    PeerSend(IC_MSG_GET_STATS, 1001, NULL, 0);
+    PeerSend(IC_MSG_GET_TEMPERATURE, sequence, &temperature, sizeof(temperature));
+    PeerSend(IC_MSG_GET_STATS, 1002, NULL, 0);
+    PeerSend(IC_MSG_SAMPLE_FRAME, 0, &frame, sizeof(frame));
+    PeerSend(IC_MSG_GET_STATS, 1003, NULL, 0);
+    RunUntil(6, 1000);
+
+    CHECK(deliveryCount == 6);
+    CHECK(batchCount == 3);
+    CHECK(deliveries[0].kind == DELIVERED_MESSAGE && deliveries[0].sequence == 1000);
+    CHECK(deliveries[1].kind == DELIVERED_MESSAGE && deliveries[1].sequence == 1001);
+    CHECK(deliveries[2].kind == DELIVERED_REPLY && deliveries[2].sequence == sequence);
+    CHECK(deliveries[3].kind == DELIVERED_MESSAGE && deliveries[3].sequence == 1002);
+    CHECK(deliveries[4].kind == DELIVERED_FRAME && deliveries[4].sequence == 0);
+    CHECK(deliveries[5].kind == DELIVERED_MESSAGE && deliveries[5].sequence == 1003);
+}
+
+static void TestTimeout(void)
+{
+    IC_TEMPERATURE_PAYLOAD temperature = {.temperature = 21.5f};
+    IC_MSG_HEADER request;
+
+    ResetDeliveries();
+    uint64_t start = NowMs();
+    uint32_t sequence = lp_interCoreRequestAsync(LP_IC_GET_TEMPERATURE, NULL, 0, 50,
+                                                 ReplyHandler);
+    CHECK(PeerReceive(&request) && request.sequence == sequence);
+
+    RunUntil(1, 1000);
+    CHECK(deliveryCount == 1);
+    CHECK(deliveries[0].kind == DELIVERED_TIMEOUT && deliveries[0].sequence == sequence);
+    CHECK(NowMs() - start >= 50);
+
+    // A reply arriving too late answers no request any more.
+    PeerSend(IC_MSG_GET_TEMPERATURE, sequence, &temperature, sizeof(temperature));
+    RunUntil(2, 1000);
+    CHECK(deliveryCount == 2);
+    CHECK(deliveries[1].kind == DELIVERED_MESSAGE && deliveries[1].sequence == sequence);
+}
+
+static void TestDisable(void)
+{
+    LP_INTER_CORE_BLOCK block = {.cmd = LP_IC_GET_STATS};
+    IC_MSG_HEADER request;
+
+    // Queued messages are sent, outstanding requests dropped, and the socket and both
+    // timers are removed from the event loop.
+    ResetDeliveries();
+    CHECK(lp_interCoreRequestAsync(LP_IC_GET_TEMPERATURE, NULL, 0, 20, ReplyHandler) != 0);
+    lp_disableInterCoreCommunications();
+    CHECK(PeerReceive(&request) && request.type == IC_MSG_GET_TEMPERATURE);
+    CHECK(HostApplibs_Registrations() == 0);
+    CHECK(!lp_sendInterCoreMessage(&block));
+
+    RunUntil(1, 100);
+    CHECK(deliveryCount == 0);
+
+    // Closing twice is harmless, and the connection can be opened again.
+    lp_disableInterCoreCommunications();
+    CHECK(lp_enableInterCoreCommunications("test", MessageHandler) == 0);
+    CHECK(HostApplibs_Registrations() == 3);
+    CHECK(lp_sendInterCoreMessage(&block));
+    CHECK(PeerReceive(&request) && request.type == IC_MSG_GET_STATS);
+    lp_disableInterCoreCommunications();
+    CHECK(HostApplibs_Registrations() == 0);
+}
+
+int main(void)
+{
+    CHECK(lp_enableInterCoreCommunications("test", MessageHandler) == 0);
+    lp_setInterCoreBatchCallback(BatchHandler);
+
+    TestCoalescing();
+    TestArrivalOrder();
+    TestTimeout();
+    TestDisable();
+
+    CHECK(!lp_isTerminationRequired());
+    return HostTest_Result();
+}
@@ -0,0 +1,203 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Round trips through the delta/zigzag sample frame codec in Shared/intercore_codec.h, from
+// constant frames to frames whose differences need all 32 bits, and rejection of malformed
+// frames.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "intercore_codec.h"
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    // xorshift32, so the frames are the same on every host.
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// A frame where each field moves by up to +/-step from the previous sample.
+static void MakeFrame(IC_SAMPLE *samples, uint16_t count, uint16_t periodMs, int32_t step)
+{
+    memset(samples, 0, count * sizeof(IC_SAMPLE));
+    samples[0].timestamp = Random();
+    for (int axis = 0; axis < 3; axis++) {
+        samples[0].acceleration[axis] = (int16_t)Random();
+        samples[0].angularRate[axis] = (int16_t)Random();
+    }
+    samples[0].temperature = (int16_t)Random();
+    samples[0].flags = IC_SAMPLE_NEW_ACCELERATION | IC_SAMPLE_NEW_ANGULAR_RATE;
+
+    for (uint16_t i = 1; i < count; i++) {
+        samples[i] = samples[i - 1];
+        samples[i].timestamp += periodMs;
+        for (int axis = 0; axis < 3; axis++) {
+            if (step != 0) {
+                samples[i].acceleration[axis] +=
+                    (int16_t)((int32_t)(Random() % (2 * (uint32_t)step + 1)) - step);
+                samples[i].angularRate[axis] +=
+                    (int16_t)((int32_t)(Random() % (2 * (uint32_t)step + 1)) - step);
+            }
+        }
+    }
+}
+
+static void CheckRoundTrip(const IC_SAMPLE *samples, uint16_t count, uint16_t periodMs)
+{
+    uint8_t encoded[IC_CODEC_MAX_SIZE];
+    IC_SAMPLE decoded[IC_SAMPLE_FRAME_MAX_SAMPLES];
+    IC_SAMPLE_FRAME_HEADER header = {0};
+
+    uint32_t size = ic_codec_encode_frame(encoded, sizeof(encoded), periodMs, samples, count);
+    CHECK(size != 0);
+    CHECK(size <= IC_CODEC_MAX_SIZE);
+
+    memset(decoded, 0xA5, sizeof(decoded));
+    CHECK(ic_codec_decode_frame(encoded, size, &header, decoded, IC_SAMPLE_FRAME_MAX_SAMPLES));
+    CHECK(header.count == count);
+    CHECK(header.periodMs == periodMs);
+    CHECK(memcmp(decoded, samples, count * sizeof(IC_SAMPLE)) == 0);
+}
+
+static void TestZigzag(void)
+{
+    static const int32_t values[] = {0, 1, -1, 2, -2, 127, -128, 32767, -32768, INT32_MAX,
+                                     INT32_MIN};
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint32_t delta = (uint32_t)values[i];
+        CHECK(ic_codec_unzigzag(ic_codec_zigzag(delta)) == delta);
+    }
+
+    // Small differences of either sign get small codes.
+    CHECK(ic_codec_zigzag(0) == 0);
+    CHECK(ic_codec_zigzag((uint32_t)-1) == 1);
+    CHECK(ic_codec_zigzag(1) == 2);
+    CHECK(ic_codec_zigzag((uint32_t)-2) == 3);
+    CHECK(ic_codec_bits(ic_codec_zigzag((uint32_t)INT32_MIN)) == 32);
+}
+
+static void TestConstantFrame(void)
+{
+    IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+    uint8_t encoded[IC_CODEC_MAX_SIZE];
+
+    // Steady timestamps and unchanged readings cost no bits after the first sample.
+    MakeFrame(samples, IC_SAMPLE_FRAME_MAX_SAMPLES, 10, 0);
+    CHECK(ic_codec_encode_frame(encoded, sizeof(encoded), 10, samples,
+                                IC_SAMPLE_FRAME_MAX_SAMPLES) ==
+          sizeof(IC_SAMPLE_FRAME_HEADER) + sizeof(IC_SAMPLE) + IC_CODEC_CHANNELS);
+    CheckRoundTrip(samples, IC_SAMPLE_FRAME_MAX_SAMPLES, 10);
+}
+
+static void TestSmallSteps(void)
+{
+    IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+
+    for (int32_t step = 1; step <= 1024; step *= 4) {
+        for (uint16_t count = 1; count <= IC_SAMPLE_FRAME_MAX_SAMPLES; count++) {
+            MakeFrame(samples, count, 5, step);
+            CheckRoundTrip(samples, count, 5);
+        }
+    }
+}
+
+static void TestFullRange(void)
+{
+    IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+
+    // Readings swinging between the extremes, timestamps wrapping and jumping against the
+    // period, and flags changing: the widest differences every field can have.
+    MakeFrame(samples, IC_SAMPLE_FRAME_MAX_SAMPLES, 1000, 0);
+    for (uint16_t i = 0; i < IC_SAMPLE_FRAME_MAX_SAMPLES; i++) {
+        bool odd = (i & 1) != 0;
+        samples[i].timestamp = odd ? 0xFFFFFFF0u + i : (uint32_t)i * 0x10000000u;
+        for (int axis = 0; axis < 3; axis++) {
+            samples[i].acceleration[axis] = odd ? INT16_MAX : INT16_MIN;
+            samples[i].angularRate[axis] = odd ? INT16_MIN : INT16_MAX;
+        }
+        samples[i].temperature = (int16_t)Random();
+        samples[i].flags = (uint16_t)(odd ? IC_SAMPLE_FIFO_OVERRUN : 0xFFFF);
+    }
+    CheckRoundTrip(samples, IC_SAMPLE_FRAME_MAX_SAMPLES, 1000);
+
+    for (int trial = 0; trial < 100; trial++) {
+        for (uint16_t i = 0; i < IC_SAMPLE_FRAME_MAX_SAMPLES; i++) {
+            uint8_t *bytes = (uint8_t *)&samples[i];
+            for (size_t b = 0; b < sizeof(IC_SAMPLE); b++) {
+                bytes[b] = (uint8_t)Random();
+            }
+        }
+        CheckRoundTrip(samples, IC_SAMPLE_FRAME_MAX_SAMPLES, (uint16_t)Random());
+    }
+}
+
+static void TestEncodeLimits(void)
+{
+    IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES + 1];
+    uint8_t encoded[IC_CODEC_MAX_SIZE + sizeof(IC_SAMPLE)];
+
+    MakeFrame(samples, IC_SAMPLE_FRAME_MAX_SAMPLES + 1, 10, 100);
+    CHECK(ic_codec_encode_frame(encoded, sizeof(encoded), 10, samples, 0) == 0);
+    CHECK(ic_codec_encode_frame(encoded, sizeof(encoded), 10, samples,
+                                IC_SAMPLE_FRAME_MAX_SAMPLES + 1) == 0);
+
+    uint32_t size = ic_codec_encode_frame(encoded, sizeof(encoded), 10, samples, 8);
+    CHECK(size != 0);
+    CHECK(ic_codec_encode_frame(encoded, size - 1, 10, samples, 8) == 0);
+    CHECK(ic_codec_encode_frame(encoded, size, 10, samples, 8) == size);
+}
+
+static void TestDecodeRejects(void)
+{
+    IC_SAMPLE samples[IC_SAMPLE_FRAME_MAX_SAMPLES];
+    IC_SAMPLE decoded[IC_SAMPLE_FRAME_MAX_SAMPLES];
+    uint8_t encoded[IC_CODEC_MAX_SIZE + 1];
+    IC_SAMPLE_FRAME_HEADER header;
+    const uint32_t widthsOffset = sizeof(IC_SAMPLE_FRAME_HEADER) + sizeof(IC_SAMPLE);
+
+    MakeFrame(samples, 16, 10, 50);
+    uint32_t size = ic_codec_encode_frame(encoded, sizeof(encoded), 10, samples, 16);
+    CHECK(size != 0);
+
+    // Truncated or padded frames.
+    for (uint32_t cut = 0; cut < size; cut++) {
+        CHECK(!ic_codec_decode_frame(encoded, cut, &header, decoded, IC_SAMPLE_FRAME_MAX_SAMPLES));
+    }
+    CHECK(!ic_codec_decode_frame(encoded, size + 1, &header, decoded,
+                                 IC_SAMPLE_FRAME_MAX_SAMPLES));
+
+    // More samples than the caller has room for.
+    CHECK(!ic_codec_decode_frame(encoded, size, &header, decoded, 15));
+    CHECK(ic_codec_decode_frame(encoded, size, &header, decoded, 16));
+
+    // A field wider than 32 bits.
+    uint8_t width = encoded[widthsOffset];
+    encoded[widthsOffset] = 33;
+    CHECK(!ic_codec_decode_frame(encoded, size, &header, decoded, IC_SAMPLE_FRAME_MAX_SAMPLES));
+    encoded[widthsOffset] = width;
+
+    // A count of zero.
+    uint16_t count = 0;
+    memcpy(encoded, &count, sizeof(count));
+    CHECK(!ic_codec_decode_frame(encoded, size, &header, decoded, IC_SAMPLE_FRAME_MAX_SAMPLES));
+}
+
+int main(void)
+{
+    TestZigzag();
+    TestConstantFrame();
+    TestSmallSteps();
+    TestFullRange();
+    TestEncodeLimits();
+    TestDecodeRejects();
+
+    return HostTest_Result();
+}
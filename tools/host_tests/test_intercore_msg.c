@@ -0,0 +1,152 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Encode/decode round trips for the inter-core message schema in Shared/intercore_msg.h, and
+// rejection of messages from another schema version or cut short.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "intercore_msg.h"
+
+static void TestHeaderLayout(void)
+{
+    uint8_t buffer[sizeof(IC_MSG_HEADER)];
+
+    ic_msg_encode_header(buffer, IC_MSG_SUBSCRIBE, 0x12345678, 0x0206);
+
+    // The real-time and high-level apps both read the header as little-endian bytes.
+    CHECK(buffer[0] == IC_MSG_SUBSCRIBE);
+    CHECK(buffer[1] == IC_MSG_VERSION);
+    CHECK(buffer[2] == 0x06 && buffer[3] == 0x02);
+    CHECK(buffer[4] == 0x78 && buffer[5] == 0x56 && buffer[6] == 0x34 && buffer[7] == 0x12);
+}
+
+static void TestRoundTrip(void)
+{
+    uint8_t buffer[IC_MSG_MAX_SIZE];
+    IC_STATS_PAYLOAD stats, decodedStats;
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+
+    for (uint32_t i = 0; i < sizeof(stats) / sizeof(uint32_t); i++) {
+        ((uint32_t *)&stats)[i] = 0x01010101u * (i + 1);
+    }
+
+    uint32_t size = ic_msg_encode(buffer, sizeof(buffer), IC_MSG_GET_STATS, 42, &stats,
+                                  sizeof(stats));
+    CHECK(size == sizeof(IC_MSG_HEADER) + sizeof(stats));
+
+    CHECK(ic_msg_decode(buffer, size, &header, &payload) == size);
+    CHECK(header.type == IC_MSG_GET_STATS);
+    CHECK(header.version == IC_MSG_VERSION);
+    CHECK(header.length == sizeof(stats));
+    CHECK(header.sequence == 42);
+    CHECK(payload == buffer + sizeof(IC_MSG_HEADER));
+    CHECK(ic_msg_payload(&header, payload, &decodedStats, sizeof(decodedStats)));
+    CHECK(memcmp(&stats, &decodedStats, sizeof(stats)) == 0);
+
+    // A payload of another size is refused rather than partly copied.
+    IC_TEMPERATURE_PAYLOAD temperature;
+    CHECK(!ic_msg_payload(&header, payload, &temperature, sizeof(temperature)));
+}
+
+static void TestEmptyPayload(void)
+{
+    uint8_t buffer[sizeof(IC_MSG_HEADER)];
+    IC_MSG_HEADER header;
+    const uint8_t *payload = NULL;
+
+    CHECK(ic_msg_encode(buffer, sizeof(buffer), IC_MSG_GET_TEMPERATURE, 7, NULL, 0) ==
+          sizeof(IC_MSG_HEADER));
+    CHECK(ic_msg_decode(buffer, sizeof(buffer), &header, &payload) == sizeof(IC_MSG_HEADER));
+    CHECK(header.type == IC_MSG_GET_TEMPERATURE && header.length == 0 && header.sequence == 7);
+}
+
+static void TestBackToBack(void)
+{
+    uint8_t buffer[64];
+    IC_SUBSCRIBE_PAYLOAD subscribe = {.periodMs = 10, .samplesPerFrame = 8,
+                                      .options = IC_SUBSCRIBE_PACKED};
+    IC_SAMPLER_PAYLOAD sampler = {.periodMs = 100};
+    IC_SUBSCRIBE_PAYLOAD decodedSubscribe;
+    IC_SAMPLER_PAYLOAD decodedSampler;
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+
+    uint32_t first = ic_msg_encode(buffer, sizeof(buffer), IC_MSG_SUBSCRIBE, 1, &subscribe,
+                                   sizeof(subscribe));
+    uint32_t second = ic_msg_encode(buffer + first, sizeof(buffer) - first, IC_MSG_SET_SAMPLER,
+                                    2, &sampler, sizeof(sampler));
+    CHECK(first != 0 && second != 0);
+
+    uint32_t used = ic_msg_decode(buffer, first + second, &header, &payload);
+    CHECK(used == first);
+    CHECK(header.type == IC_MSG_SUBSCRIBE && header.sequence == 1);
+    CHECK(ic_msg_payload(&header, payload, &decodedSubscribe, sizeof(decodedSubscribe)));
+    CHECK(decodedSubscribe.periodMs == 10 && decodedSubscribe.samplesPerFrame == 8 &&
+          decodedSubscribe.options == IC_SUBSCRIBE_PACKED);
+
+    CHECK(ic_msg_decode(buffer + used, first + second - used, &header, &payload) == second);
+    CHECK(header.type == IC_MSG_SET_SAMPLER && header.sequence == 2);
+    CHECK(ic_msg_payload(&header, payload, &decodedSampler, sizeof(decodedSampler)));
+    CHECK(decodedSampler.periodMs == 100);
+}
+
+static void TestEncodeTooSmall(void)
+{
+    uint8_t buffer[sizeof(IC_MSG_HEADER) + sizeof(IC_TEMPERATURE_PAYLOAD)];
+    IC_TEMPERATURE_PAYLOAD temperature = {.temperature = 21.5f};
+
+    CHECK(ic_msg_encode(buffer, sizeof(buffer) - 1, IC_MSG_GET_TEMPERATURE, 3, &temperature,
+                        sizeof(temperature)) == 0);
+    CHECK(ic_msg_encode(buffer, sizeof(buffer), IC_MSG_GET_TEMPERATURE, 3, &temperature,
+                        sizeof(temperature)) == sizeof(buffer));
+}
+
+static void TestRejectVersion(void)
+{
+    uint8_t buffer[sizeof(IC_MSG_HEADER) + sizeof(IC_TEMPERATURE_PAYLOAD)];
+    IC_TEMPERATURE_PAYLOAD temperature = {.temperature = 21.5f};
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+
+    uint32_t size = ic_msg_encode(buffer, sizeof(buffer), IC_MSG_GET_TEMPERATURE, 3,
+                                  &temperature, sizeof(temperature));
+
+    buffer[1] = IC_MSG_VERSION - 1;
+    CHECK(ic_msg_decode(buffer, size, &header, &payload) == 0);
+    buffer[1] = IC_MSG_VERSION + 1;
+    CHECK(ic_msg_decode(buffer, size, &header, &payload) == 0);
+    buffer[1] = IC_MSG_VERSION;
+    CHECK(ic_msg_decode(buffer, size, &header, &payload) == size);
+}
+
+static void TestRejectTruncated(void)
+{
+    uint8_t buffer[sizeof(IC_MSG_HEADER) + sizeof(IC_SAMPLER_PAYLOAD)];
+    IC_SAMPLER_PAYLOAD sampler = {.periodMs = 50};
+    IC_MSG_HEADER header;
+    const uint8_t *payload;
+
+    uint32_t size = ic_msg_encode(buffer, sizeof(buffer), IC_MSG_SET_SAMPLER, 9, &sampler,
+                                  sizeof(sampler));
+
+    for (uint32_t cut = 0; cut < size; cut++) {
+        CHECK(ic_msg_decode(buffer, cut, &header, &payload) == 0);
+    }
+}
+
+int main(void)
+{
+    TestHeaderLayout();
+    TestRoundTrip();
+    TestEmptyPayload();
+    TestBackToBack();
+    TestEncodeTooSmall();
+    TestRejectVersion();
+    TestRejectTruncated();
+
+    return HostTest_Result();
+}
@@ -0,0 +1,365 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the real-time demo's LSM6DSO driver, demo_threadx/lsm6dso_driver.c and
+// lsm6dso_reg.c, against the simulated sensor in lsm6dso_sim.c. The shadow of the
+// configuration registers must save bus reads and writes without the driver ever acting on a
+// value the sensor no longer holds. Recorded FIFO contents are replayed through the FIFO
+// read, which must take them in bursts, keep their order and tags, and report an overrun.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "lsm6dso_driver.h"
+#include "lsm6dso_reg.h"
+#include "lsm6dso_sim.h"
+
+#define BUS_US_PER_BYTE 9
+
+// The BSP's printf, which the driver reports to.
+int printf_(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+// Time on a 1 MHz bus since Lsm6dsoSim_ResetCounts: the device address byte of each
+// transaction, once more for the repeated start of a read, and the bytes counted.
+static uint32_t BusUs(void)
+{
+    uint32_t reads = lsm6dsoSim.transactions - lsm6dsoSim.writes;
+    return (lsm6dsoSim.writes + 2 * reads + lsm6dsoSim.bytesOut + lsm6dsoSim.bytesIn) *
+           BUS_US_PER_BYTE;
+}
+
+// Presents a sample; the output registers are little-endian, as the host and the M4 are.
+static void SetSample(uint8_t status, int16_t temperature, const int16_t angularRate[3],
+                      const int16_t acceleration[3])
+{
+    lsm6dsoSim.reg[LSM6DSO_STATUS_REG] = status;
+    memcpy(&lsm6dsoSim.reg[LSM6DSO_OUT_TEMP_L], &temperature, sizeof(temperature));
+    memcpy(&lsm6dsoSim.reg[LSM6DSO_OUTX_L_G], angularRate, 3 * sizeof(int16_t));
+    memcpy(&lsm6dsoSim.reg[LSM6DSO_OUTX_L_A], acceleration, 3 * sizeof(int16_t));
+}
+
+// A sample read as lsm6dso_read_raw did before the burst read: the data-ready flag of each
+// sensor, then its output registers if it had new data.
+static uint32_t ReadPerSensor(lsm6dso_ctx_t *ctx, int16_t acceleration[3],
+                              int16_t angularRate[3], int16_t *temperature)
+{
+    uint32_t updated = 0;
+    uint8_t ready;
+
+    lsm6dso_xl_flag_data_ready_get(ctx, &ready);
+    if (ready) {
+        lsm6dso_acceleration_raw_get(ctx, (uint8_t *)acceleration);
+        updated |= LSM6DSO_NEW_ACCELERATION;
+    }
+    lsm6dso_gy_flag_data_ready_get(ctx, &ready);
+    if (ready) {
+        lsm6dso_angular_rate_raw_get(ctx, (uint8_t *)angularRate);
+        updated |= LSM6DSO_NEW_ANGULAR_RATE;
+    }
+    lsm6dso_temp_flag_data_ready_get(ctx, &ready);
+    if (ready) {
+        lsm6dso_temperature_raw_get(ctx, (uint8_t *)temperature);
+        updated |= LSM6DSO_NEW_TEMPERATURE;
+    }
+    return updated;
+}
+
+static void TestSampleTransactions(void)
+{
+    static const int16_t angularRate[3] = {-300, 2, 7000};
+    static const int16_t acceleration[3] = {16, -8200, 1};
+    int16_t readAcceleration[3], readAngularRate[3], readTemperature;
+    lsm6dso_ctx_t ctx = {.write_reg = Lsm6dsoSim_Write, .read_reg = Lsm6dsoSim_Read};
+
+    SetSample(0x07, 0x1234, angularRate, acceleration);
+
+    // Before: three flag reads of one byte and the 14 output bytes, in six transactions.
+    Lsm6dsoSim_ResetCounts();
+    CHECK(ReadPerSensor(&ctx, readAcceleration, readAngularRate, &readTemperature) ==
+          (LSM6DSO_NEW_ACCELERATION | LSM6DSO_NEW_ANGULAR_RATE | LSM6DSO_NEW_TEMPERATURE));
+    CHECK(lsm6dsoSim.transactions == 6 && lsm6dsoSim.bytesOut == 6 && lsm6dsoSim.bytesIn == 17);
+
+    // After: STATUS_REG to OUTZ_H_A in one transaction.
+    memset(readAcceleration, 0, sizeof(readAcceleration));
+    memset(readAngularRate, 0, sizeof(readAngularRate));
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_read_raw(readAcceleration, readAngularRate, &readTemperature) ==
+          (LSM6DSO_NEW_ACCELERATION | LSM6DSO_NEW_ANGULAR_RATE | LSM6DSO_NEW_TEMPERATURE));
+    CHECK(lsm6dsoSim.transactions == 1 && lsm6dsoSim.bytesOut == 1 &&
+          lsm6dsoSim.bytesIn == LSM6DSO_OUTPUT_BLOCK_LEN);
+    CHECK(memcmp(readAcceleration, acceleration, sizeof(acceleration)) == 0);
+    CHECK(memcmp(readAngularRate, angularRate, sizeof(angularRate)) == 0);
+    CHECK(readTemperature == 0x1234);
+
+    // Nothing new still takes the one transaction, and keeps the last readings.
+    SetSample(0x00, 0, (const int16_t[3]){0}, (const int16_t[3]){0});
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_read_raw(readAcceleration, readAngularRate, &readTemperature) == 0);
+    CHECK(lsm6dsoSim.transactions == 1);
+    CHECK(memcmp(readAcceleration, acceleration, sizeof(acceleration)) == 0);
+    CHECK(readTemperature == 0x1234);
+}
+
+static void TestSampleStatus(void)
+{
+    static const int16_t angularRate[3] = {1, 2, 3};
+    static const int16_t acceleration[3] = {4, 5, 6};
+    int16_t readAcceleration[3], readAngularRate[3], readTemperature;
+
+    // Only the accelerometer (XLDA) has new data: the other readings stay as they were.
+    SetSample(0x01, -5, angularRate, acceleration);
+    CHECK(lsm6dso_read_raw(readAcceleration, readAngularRate, &readTemperature) ==
+          LSM6DSO_NEW_ACCELERATION);
+    CHECK(memcmp(readAcceleration, acceleration, sizeof(acceleration)) == 0);
+    CHECK(readAngularRate[0] != 1 && readTemperature != -5);
+
+    // Then the gyroscope (GDA) and temperature (TDA).
+    SetSample(0x06, -5, angularRate, (const int16_t[3]){0});
+    CHECK(lsm6dso_read_raw(readAcceleration, readAngularRate, &readTemperature) ==
+          (LSM6DSO_NEW_ANGULAR_RATE | LSM6DSO_NEW_TEMPERATURE));
+    CHECK(memcmp(readAcceleration, acceleration, sizeof(acceleration)) == 0);
+    CHECK(memcmp(readAngularRate, angularRate, sizeof(angularRate)) == 0);
+    CHECK(readTemperature == -5);
+}
+
+// The register setup of lsm6dso_init, for a ctx with or without a shadow.
+static void Configure(lsm6dso_ctx_t *ctx, lsm6dso_shadow_t *shadow)
+{
+    uint8_t reg;
+
+    lsm6dso_shadow_set(ctx, shadow);
+    lsm6dso_device_id_get(ctx, &reg);
+    lsm6dso_reset_set(ctx, PROPERTY_ENABLE);
+    do {
+        lsm6dso_reset_get(ctx, &reg);
+    } while (reg);
+    lsm6dso_i3c_disable_set(ctx, LSM6DSO_I3C_DISABLE);
+    lsm6dso_block_data_update_set(ctx, PROPERTY_ENABLE);
+    lsm6dso_xl_data_rate_set(ctx, LSM6DSO_XL_ODR_12Hz5);
+    lsm6dso_gy_data_rate_set(ctx, LSM6DSO_GY_ODR_12Hz5);
+    lsm6dso_xl_full_scale_set(ctx, LSM6DSO_4g);
+    lsm6dso_gy_full_scale_set(ctx, LSM6DSO_2000dps);
+    lsm6dso_xl_hp_path_on_out_set(ctx, LSM6DSO_LP_ODR_DIV_100);
+    lsm6dso_xl_filter_lp2_set(ctx, PROPERTY_ENABLE);
+}
+
+static void TestStartup(void)
+{
+    lsm6dso_ctx_t ctx = {.write_reg = Lsm6dsoSim_Write, .read_reg = Lsm6dsoSim_Read};
+    lsm6dso_shadow_t shadow;
+    uint8_t configured[256];
+    uint32_t transactions, writes, busUs;
+
+    // Without the shadow every setter reads its register back first.
+    Lsm6dsoSim_Reset();
+    Lsm6dsoSim_ResetCounts();
+    Configure(&ctx, NULL);
+    transactions = lsm6dsoSim.transactions;
+    writes = lsm6dsoSim.writes;
+    busUs = BusUs();
+    memcpy(configured, lsm6dsoSim.reg, sizeof(configured));
+    CHECK(transactions == 22 && writes == 10);
+
+    // With it, the registers set before are known, and rewriting a value is dropped.
+    Lsm6dsoSim_Reset();
+    Lsm6dsoSim_ResetCounts();
+    Configure(&ctx, &shadow);
+    CHECK(lsm6dsoSim.transactions == 17 && lsm6dsoSim.writes == 8);
+    CHECK(BusUs() < busUs);
+    CHECK(memcmp(lsm6dsoSim.reg, configured, sizeof(configured)) == 0);
+
+    // lsm6dso_init does the same.
+    Lsm6dsoSim_Reset();
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_init(Lsm6dsoSim_Write, Lsm6dsoSim_Read) == 0);
+    CHECK(lsm6dsoSim.transactions == 17 && lsm6dsoSim.writes == 8);
+    CHECK(memcmp(lsm6dsoSim.reg, configured, sizeof(configured)) == 0);
+}
+
+static void TestShadow(void)
+{
+    lsm6dso_ctx_t ctx = {.write_reg = Lsm6dsoSim_Write, .read_reg = Lsm6dsoSim_Read};
+    lsm6dso_shadow_t shadow;
+    lsm6dso_odr_xl_t odr;
+    uint8_t reg;
+
+    Lsm6dsoSim_Reset();
+    Configure(&ctx, &shadow);
+
+    // A change is the write alone, the same value again nothing.
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_104Hz) == 0);
+    CHECK(lsm6dsoSim.transactions == 1 && lsm6dsoSim.writes == 1);
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_104Hz) == 0);
+    CHECK(lsm6dso_xl_data_rate_get(&ctx, &odr) == 0 && odr == LSM6DSO_XL_ODR_104Hz);
+    CHECK(lsm6dsoSim.transactions == 1);
+
+    // A software reset restores the defaults, which the driver has to read again.
+    CHECK(lsm6dso_reset_set(&ctx, PROPERTY_ENABLE) == 0);
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_xl_data_rate_get(&ctx, &odr) == 0 && odr == LSM6DSO_XL_ODR_OFF);
+    CHECK(lsm6dsoSim.transactions == 1);
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_104Hz) == 0);
+    CHECK(lsm6dsoSim.reg[LSM6DSO_CTRL1_XL] >> 4 == LSM6DSO_XL_ODR_104Hz);
+
+    // So does a reboot.
+    CHECK(lsm6dso_boot_set(&ctx, PROPERTY_ENABLE) == 0);
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_104Hz) == 0);
+    CHECK(lsm6dsoSim.reg[LSM6DSO_CTRL1_XL] >> 4 == LSM6DSO_XL_ODR_104Hz);
+
+    // The reset poll reads the sensor until the reset is done.
+    CHECK(lsm6dso_reset_set(&ctx, PROPERTY_ENABLE) == 0);
+    lsm6dsoSim.resetReads = 2;
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_reset_get(&ctx, &reg) == 0 && reg == 1);
+    CHECK(lsm6dso_reset_get(&ctx, &reg) == 0 && reg == 1);
+    CHECK(lsm6dso_reset_get(&ctx, &reg) == 0 && reg == 0);
+    CHECK(lsm6dsoSim.transactions == 3);
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_104Hz) == 0);
+    CHECK(lsm6dsoSim.reg[LSM6DSO_CTRL1_XL] >> 4 == LSM6DSO_XL_ODR_104Hz);
+
+    // The other banks' registers at the same addresses go to the bus.
+    CHECK(lsm6dso_mem_bank_set(&ctx, LSM6DSO_EMBEDDED_FUNC_BANK) == 0);
+    lsm6dsoSim.otherBank[LSM6DSO_CTRL1_XL] = 0x5A;
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_read_reg(&ctx, LSM6DSO_CTRL1_XL, &reg, 1) == 0 && reg == 0x5A);
+    CHECK(lsm6dsoSim.transactions == 1);
+    CHECK(lsm6dso_mem_bank_set(&ctx, LSM6DSO_USER_BANK) == 0);
+    CHECK(lsm6dso_xl_data_rate_get(&ctx, &odr) == 0 && odr == LSM6DSO_XL_ODR_104Hz);
+
+    // After a failed write the sensor's registers are unknown, and read again.
+    lsm6dsoSim.failWrites = true;
+    CHECK(lsm6dso_xl_data_rate_set(&ctx, LSM6DSO_XL_ODR_208Hz) != 0);
+    lsm6dsoSim.failWrites = false;
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_xl_data_rate_get(&ctx, &odr) == 0 && odr == LSM6DSO_XL_ODR_104Hz);
+    CHECK(lsm6dsoSim.transactions != 0);
+}
+
+
+#define RECORDED_WORDS LSM6DSO_SIM_RECORDED_WORDS
+static const uint8_t (*const recorded)[LSM6DSO_FIFO_WORD_SIZE] = lsm6dsoSimRecorded;
+
+typedef struct {
+    uint32_t count;
+    uint8_t tags[RECORDED_WORDS];
+    int16_t data[RECORDED_WORDS][3];
+} Decoded;
+
+static void Decode(uint8_t tag, const int16_t data[3], void *context)
+{
+    Decoded *decoded = context;
+
+    if (decoded->count < RECORDED_WORDS) {
+        decoded->tags[decoded->count] = tag;
+        memcpy(decoded->data[decoded->count], data, sizeof(decoded->data[0]));
+    }
+    decoded->count++;
+}
+
+// Bus transactions of a FIFO read of count words: the status, then the bursts.
+static uint32_t FifoTransactions(uint32_t count)
+{
+    return 1 + (count + LSM6DSO_FIFO_BURST_WORDS - 1) / LSM6DSO_FIFO_BURST_WORDS;
+}
+
+static void TestFifoReplay(void)
+{
+    static const uint8_t tags[RECORDED_WORDS] = {1, 2, 1, 2, 3, 1, 2, 1, 2, 1, 2, 3, 1, 2};
+    uint8_t words[LSM6DSO_SIM_FIFO_WORDS * LSM6DSO_FIFO_WORD_SIZE];
+    lsm6dso_fifo_status_t status;
+    Decoded decoded = {0};
+    uint32_t latencyMs = 1000;
+
+    // Batching as the demo sets it up, at 12.5 Hz.
+    CHECK(lsm6dso_fifo_start(80, &latencyMs) != 0);
+    CHECK((lsm6dsoSim.reg[LSM6DSO_FIFO_CTRL4] & 0x07) == LSM6DSO_STREAM_MODE);
+
+    // An empty FIFO costs the status read alone.
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == 0);
+    CHECK(status.waiting == 0 && !status.overrun);
+    CHECK(lsm6dsoSim.transactions == 1);
+
+    // All of it, in bursts of LSM6DSO_FIFO_BURST_WORDS.
+    Lsm6dsoSim_FifoPush(recorded[0], RECORDED_WORDS);
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == RECORDED_WORDS);
+    CHECK(status.waiting == RECORDED_WORDS && !status.overrun);
+    CHECK(lsm6dsoSim.transactions == FifoTransactions(RECORDED_WORDS));
+    CHECK(lsm6dsoSim.bytesIn == 2 + RECORDED_WORDS * LSM6DSO_FIFO_WORD_SIZE);
+    CHECK(memcmp(words, recorded, RECORDED_WORDS * LSM6DSO_FIFO_WORD_SIZE) == 0);
+    CHECK(Lsm6dsoSim_FifoLevel() == 0);
+
+    // The decode hands on each word's tag and data, in order, without the bus.
+    Lsm6dsoSim_ResetCounts();
+    lsm6dso_fifo_decode(words, RECORDED_WORDS, Decode, &decoded);
+    CHECK(decoded.count == RECORDED_WORDS);
+    CHECK(memcmp(decoded.tags, tags, sizeof(tags)) == 0);
+    CHECK(decoded.data[1][0] == 41 && decoded.data[1][1] == -77 && decoded.data[1][2] == 8204);
+    CHECK(decoded.data[4][0] == 412 && decoded.data[12][0] == -9 && decoded.data[12][2] == 4);
+    CHECK(lsm6dsoSim.transactions == 0);
+
+    // A read takes no more than it is given room for; the rest waits for the next.
+    Lsm6dsoSim_FifoPush(recorded[0], RECORDED_WORDS);
+    CHECK(lsm6dso_fifo_read(words, 5, &status) == 5);
+    CHECK(status.waiting == RECORDED_WORDS);
+    CHECK(memcmp(words, recorded, 5 * LSM6DSO_FIFO_WORD_SIZE) == 0);
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == RECORDED_WORDS - 5);
+    CHECK(status.waiting == RECORDED_WORDS - 5);
+    CHECK(memcmp(words, recorded[5], (RECORDED_WORDS - 5) * LSM6DSO_FIFO_WORD_SIZE) == 0);
+}
+
+static void TestFifoOverrun(void)
+{
+    uint8_t words[LSM6DSO_SIM_FIFO_WORDS * LSM6DSO_FIFO_WORD_SIZE];
+    lsm6dso_fifo_status_t status;
+    uint32_t pushed = 0;
+
+    // The recording again and again, until the FIFO is full and its oldest words are lost.
+    while (pushed < LSM6DSO_SIM_FIFO_WORDS + 3) {
+        Lsm6dsoSim_FifoPush(recorded[pushed % RECORDED_WORDS], 1);
+        pushed++;
+    }
+    Lsm6dsoSim_ResetCounts();
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == LSM6DSO_SIM_FIFO_WORDS);
+    CHECK(status.waiting == LSM6DSO_SIM_FIFO_WORDS && status.overrun);
+    CHECK(lsm6dsoSim.transactions == FifoTransactions(LSM6DSO_SIM_FIFO_WORDS));
+    CHECK(memcmp(words, recorded[3], LSM6DSO_FIFO_WORD_SIZE) == 0);
+    CHECK(memcmp(&words[(LSM6DSO_SIM_FIFO_WORDS - 1) * LSM6DSO_FIFO_WORD_SIZE],
+                 recorded[(pushed - 1) % RECORDED_WORDS], LSM6DSO_FIFO_WORD_SIZE) == 0);
+
+    // Reading clears it.
+    Lsm6dsoSim_FifoPush(recorded[0], 2);
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == 2);
+    CHECK(status.waiting == 2 && !status.overrun);
+
+    // So does bypass mode, which stops the FIFO and empties it.
+    pushed = 0;
+    while (pushed < LSM6DSO_SIM_FIFO_WORDS + 1) {
+        Lsm6dsoSim_FifoPush(recorded[pushed++ % RECORDED_WORDS], 1);
+    }
+    lsm6dso_fifo_stop();
+    CHECK(lsm6dso_fifo_read(words, LSM6DSO_SIM_FIFO_WORDS, &status) == 0);
+    CHECK(status.waiting == 0 && !status.overrun);
+}
+
+int main(void)
+{
+    TestStartup();
+    TestShadow();
+
+    Lsm6dsoSim_Reset();
+    CHECK(lsm6dso_init(Lsm6dsoSim_Write, Lsm6dsoSim_Read) == 0);
+    TestSampleTransactions();
+    TestSampleStatus();
+    TestFifoReplay();
+    TestFifoOverrun();
+    return HostTest_Result();
+}
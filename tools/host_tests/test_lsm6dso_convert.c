@@ -0,0 +1,130 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the batch conversions in the real-time demo's LSM6DSO driver against the scalar
+// reference, the 16-bit wrapped difference times the scale that the lsm6dso_from_* conversions
+// compute: lsm6dso_convert_fixed must match it bit for bit, and lsm6dso_convert_float must be
+// it times the unit. The batches have odd and even counts, start on odd halfwords, and include
+// the extreme readings, offsets and scales. Built once with the portable C path and once with
+// the DSP path on the C intrinsics of mt3620_host.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "lsm6dso_driver.h"
+
+#define MAX_TRIPLES 40 // several float chunks
+#define RANDOM_BATCHES 2000
+
+static uint32_t seed = 1;
+
+// The BSP's printf, which the driver reports to.
+int printf_(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+static uint32_t Random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static int16_t RandomReading(void)
+{
+    static const int16_t extremes[] = {INT16_MIN, INT16_MIN + 1, -1, 0, 1, INT16_MAX};
+
+    // Mostly anything, sometimes an extreme one.
+    if (Random() % 8 == 0) {
+        return extremes[Random() % (sizeof(extremes) / sizeof(extremes[0]))];
+    }
+    return (int16_t)Random();
+}
+
+static int32_t Reference(int16_t raw, int16_t offset, int16_t scale)
+{
+    return (int32_t)(int16_t)(raw - offset) * scale;
+}
+
+// Converts count triples starting at halfword first of the input, and compares both kernels
+// with the reference.
+static void CheckBatch(const int16_t *offset, int16_t scale, uint32_t first, uint32_t count)
+{
+    int16_t raw[3 * MAX_TRIPLES + 1];
+    int32_t fixed[3 * MAX_TRIPLES];
+    float converted[3 * MAX_TRIPLES];
+    const float unit = 0.001f;
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < sizeof(raw) / sizeof(raw[0]); i++) {
+        raw[i] = RandomReading();
+    }
+    memset(fixed, 0x55, sizeof(fixed));
+
+    lsm6dso_convert_fixed(&raw[first], offset, scale, fixed, count);
+    lsm6dso_convert_float(&raw[first], offset, scale, unit, converted, count);
+
+    for (uint32_t i = 0; i < 3 * count; i++) {
+        int32_t expected = Reference(raw[first + i], offset != NULL ? offset[i % 3] : 0, scale);
+        mismatches += fixed[i] != expected || converted[i] != (float)expected * unit;
+    }
+    CHECK(mismatches == 0);
+    // Nothing is written past the last triple.
+    CHECK(count == MAX_TRIPLES || fixed[3 * count] == 0x55555555);
+}
+
+static void TestScales(void)
+{
+    static const int16_t scales[] = {
+        LSM6DSO_FS4_UG_PER_LSB, LSM6DSO_FS2000_MDPS_PER_LSB, 1, -1, INT16_MAX, INT16_MIN,
+    };
+    static const int16_t offset[3] = {12, -7, 3};
+
+    for (uint32_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        for (uint32_t count = 0; count <= 5; count++) {
+            CheckBatch(NULL, scales[i], 0, count);
+            CheckBatch(offset, scales[i], 1, count);
+        }
+    }
+}
+
+// The difference wraps to 16 bits before it is scaled.
+static void TestWrap(void)
+{
+    static const int16_t offset[3] = {1, -1, INT16_MIN};
+    const int16_t raw[6] = {INT16_MIN, INT16_MAX, INT16_MAX, INT16_MIN, INT16_MAX, 0};
+    int32_t fixed[6];
+
+    lsm6dso_convert_fixed(raw, offset, LSM6DSO_FS2000_MDPS_PER_LSB, fixed, 2);
+    CHECK(fixed[0] == INT16_MAX * LSM6DSO_FS2000_MDPS_PER_LSB);
+    CHECK(fixed[1] == INT16_MIN * LSM6DSO_FS2000_MDPS_PER_LSB);
+    CHECK(fixed[2] == -1 * LSM6DSO_FS2000_MDPS_PER_LSB);
+    CHECK(fixed[3] == INT16_MAX * LSM6DSO_FS2000_MDPS_PER_LSB);
+    CHECK(fixed[4] == INT16_MIN * LSM6DSO_FS2000_MDPS_PER_LSB);
+    CHECK(fixed[5] == INT16_MIN * LSM6DSO_FS2000_MDPS_PER_LSB);
+}
+
+static void TestRandomBatches(void)
+{
+    int16_t offset[3];
+
+    for (uint32_t i = 0; i < RANDOM_BATCHES; i++) {
+        offset[0] = RandomReading();
+        offset[1] = RandomReading();
+        offset[2] = RandomReading();
+        CheckBatch(i % 2 ? offset : NULL, (int16_t)Random(), Random() % 2,
+                   Random() % (MAX_TRIPLES + 1));
+    }
+}
+
+int main(void)
+{
+    TestScales();
+    TestWrap();
+    TestRandomBatches();
+    return HostTest_Result();
+}
@@ -0,0 +1,309 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the OS_HAL I2C driver, os_hal_i2c.c, on the host ThreadX stand-in in threadx_host,
+// with the test playing the MHAL I2C layer and the bus behind it. A transfer must let another
+// thread run while it waits for the I2C interrupt or the DMA done callback, a stuck bus must
+// time out and be recovered with mtk_mhal_i2c_init_hw, and an interrupt arriving after the
+// timeout must not complete the next transfer.
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "nvic.h"
+#include "os_hal_i2c.h"
+#include "threadx_host.h"
+
+#define TICK_MS 10
+#define DEVICE_ADDRESS 0x6A
+#define SLAVE_TIMEOUT_MS 100
+
+typedef enum { BUS_ACK, BUS_NACK, BUS_STUCK } BusBehaviour;
+
+// The MHAL layer and the bus, as the test sets them up for the next transfer.
+static struct {
+    BusBehaviour behaviour;
+    uint32_t delayMs;
+    bool viaDma;        // completes through the DMA done callback instead of the I2C interrupt
+    bool lateInterrupt; // the interrupt arrives after the timeout, before the recovery
+
+    uint32_t triggers, initHw, dumps, releases;
+    i2c_dma_done_callback dmaCallback;
+    void *dmaData;
+    pthread_t interrupt;
+    bool interruptRaised;
+} bus;
+
+static volatile bool blinking;
+static volatile uint32_t blinks;
+static uint8_t readBuffer[4];
+
+static uint64_t NowMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+static void BusInterrupt(void *arg)
+{
+    (void)arg;
+    if (bus.viaDma) {
+        bus.dmaCallback(bus.dmaData);
+    } else {
+        HostNvic_Raise(CM4_IRQ_ISU_G0_I2C);
+    }
+}
+
+int mtk_mhal_i2c_trigger_transfer(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    bus.triggers++;
+    if (bus.behaviour != BUS_STUCK) {
+        HostTx_RaiseInterrupt(&bus.interrupt, bus.delayMs * 1000, BusInterrupt, NULL);
+        bus.interruptRaised = true;
+    }
+    return 0;
+}
+
+int mtk_mhal_i2c_irq_handle(struct mtk_i2c_controller *i2c)
+{
+    for (u8 m = 0; m < i2c->msg_num; m++) {
+        struct i2c_msg *msg = &i2c->msg[m];
+        if (msg->flags == I2C_MASTER_RD || msg->flags == I2C_SLAVE_RX) {
+            for (u16 i = 0; i < msg->len; i++) {
+                msg->buf[i] = (u8)(0xA0 + i);
+            }
+        }
+    }
+    return 0;
+}
+
+int mtk_mhal_i2c_result_handle(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    return bus.behaviour == BUS_NACK ? -I2C_ENXIO : 0;
+}
+
+int mtk_mhal_i2c_dump_register(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    bus.dumps++;
+    if (bus.lateInterrupt) {
+        HostNvic_Raise(CM4_IRQ_ISU_G0_I2C);
+    }
+    return 0;
+}
+
+int mtk_mhal_i2c_init_hw(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    bus.initHw++;
+    return 0;
+}
+
+int mtk_mhal_i2c_dma_done_callback_register(struct mtk_i2c_controller *i2c,
+                                            i2c_dma_done_callback callback, void *user_data)
+{
+    (void)i2c;
+    bus.dmaCallback = callback;
+    bus.dmaData = user_data;
+    return 0;
+}
+
+int mtk_mhal_i2c_release_dma(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    bus.releases++;
+    return 0;
+}
+
+int mtk_mhal_i2c_request_dma(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    return 0;
+}
+
+int mtk_mhal_i2c_enable_clk(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    return 0;
+}
+
+int mtk_mhal_i2c_disable_clk(struct mtk_i2c_controller *i2c)
+{
+    (void)i2c;
+    return 0;
+}
+
+int mtk_mhal_i2c_init_speed(struct mtk_i2c_controller *i2c, enum i2c_speed_kHz speed)
+{
+    (void)i2c;
+    (void)speed;
+    return 0;
+}
+
+int mtk_mhal_i2c_init_slv_addr(struct mtk_i2c_controller *i2c, u8 slv_addr)
+{
+    (void)i2c;
+    (void)slv_addr;
+    return 0;
+}
+
+static void ResetBus(BusBehaviour behaviour, uint32_t delayMs)
+{
+    bus.behaviour = behaviour;
+    bus.delayMs = delayMs;
+    bus.viaDma = bus.lateInterrupt = false;
+    bus.triggers = bus.initHw = bus.dumps = 0;
+    bus.interruptRaised = false;
+}
+
+static int ReadRegisters(void)
+{
+    u8 reg = 0x22;
+    return mtk_os_hal_i2c_write_read(OS_HAL_I2C_ISU0, DEVICE_ADDRESS, &reg, readBuffer, 1,
+                                     sizeof(readBuffer));
+}
+
+static int SlaveReceive(void)
+{
+    return mtk_os_hal_i2c_slave_rx(OS_HAL_I2C_ISU0, readBuffer, sizeof(readBuffer),
+                                   SLAVE_TIMEOUT_MS);
+}
+
+// Counts every time it gets the core, standing in for thread_blink_led.
+static void *BlinkThread(void *arg)
+{
+    (void)arg;
+    while (blinking) {
+        blinks++;
+        osai_delay_ms(TICK_MS);
+    }
+    return NULL;
+}
+
+typedef struct {
+    int (*transfer)(void);
+
+    int result;
+    uint64_t elapsedMs;
+    uint32_t blinks;
+    pthread_t blink;
+} DriverRun;
+
+// The driver thread: takes the core before the blink thread starts, then transfers.
+static void *DriverThread(void *arg)
+{
+    DriverRun *run = arg;
+
+    blinking = true;
+    blinks = 0;
+    HostTx_CreateThread(&run->blink, BlinkThread, NULL);
+
+    uint64_t start = NowMs();
+    run->result = run->transfer();
+    run->elapsedMs = NowMs() - start;
+    run->blinks = blinks;
+
+    blinking = false;
+    return NULL;
+}
+
+static void RunDriver(DriverRun *run)
+{
+    pthread_t driver;
+
+    memset(readBuffer, 0, sizeof(readBuffer));
+    HostTx_CreateThread(&driver, DriverThread, run);
+
+    // Joined from outside, as the blink thread needs the core to finish.
+    pthread_join(driver, NULL);
+    pthread_join(run->blink, NULL);
+    if (bus.interruptRaised) {
+        pthread_join(bus.interrupt, NULL);
+    }
+}
+
+static void TestTransferYields(void)
+{
+    DriverRun run = {.transfer = ReadRegisters};
+
+    ResetBus(BUS_ACK, 50);
+    RunDriver(&run);
+    CHECK(run.result == 0);
+    CHECK(run.elapsedMs >= 50 - 1 && run.elapsedMs < 1000);
+    CHECK(run.blinks >= 3);
+    CHECK(readBuffer[0] == 0xA0 && readBuffer[3] == 0xA3);
+    CHECK(bus.triggers == 1 && bus.initHw == 0);
+}
+
+static void TestDmaDone(void)
+{
+    DriverRun run = {.transfer = SlaveReceive};
+
+    ResetBus(BUS_ACK, 20);
+    bus.viaDma = true;
+    RunDriver(&run);
+    CHECK(run.result == 0);
+    CHECK(run.elapsedMs >= 20 - 1 && run.elapsedMs < SLAVE_TIMEOUT_MS);
+    CHECK(bus.initHw == 0);
+}
+
+static void TestTimeout(void)
+{
+    DriverRun run = {.transfer = SlaveReceive};
+
+    // A stuck bus times out without holding up other threads, and the controller is reset.
+    ResetBus(BUS_STUCK, 0);
+    RunDriver(&run);
+    CHECK(run.result == -I2C_ETIMEDOUT);
+    CHECK(run.elapsedMs >= SLAVE_TIMEOUT_MS && run.elapsedMs < 10 * SLAVE_TIMEOUT_MS);
+    CHECK(run.blinks >= 3);
+    CHECK(bus.dumps == 1 && bus.initHw == 1);
+}
+
+static void TestLateInterruptDropped(void)
+{
+    DriverRun run = {.transfer = SlaveReceive};
+
+    ResetBus(BUS_STUCK, 0);
+    bus.lateInterrupt = true;
+    RunDriver(&run);
+    CHECK(run.result == -I2C_ETIMEDOUT);
+
+    // The next transfer on the stuck bus must wait for its own interrupt, not take that one.
+    ResetBus(BUS_STUCK, 0);
+    RunDriver(&run);
+    CHECK(run.result == -I2C_ETIMEDOUT);
+    CHECK(run.elapsedMs >= SLAVE_TIMEOUT_MS);
+}
+
+static void TestNack(void)
+{
+    DriverRun run = {.transfer = ReadRegisters};
+
+    ResetBus(BUS_NACK, 10);
+    RunDriver(&run);
+    CHECK(run.result == -I2C_ENXIO);
+    CHECK(bus.dumps == 1 && bus.initHw == 1);
+}
+
+int main(void)
+{
+    CHECK(mtk_os_hal_i2c_ctrl_init(OS_HAL_I2C_ISU0) == 0);
+    CHECK(HostNvic_IsEnabled(CM4_IRQ_ISU_G0_I2C));
+
+    TestTransferYields();
+    TestDmaDone();
+    TestTimeout();
+    TestLateInterruptDropped();
+    TestNack();
+
+    CHECK(mtk_os_hal_i2c_ctrl_deinit(OS_HAL_I2C_ISU0) == 0);
+    CHECK(!HostNvic_IsEnabled(CM4_IRQ_ISU_G0_I2C));
+    CHECK(bus.releases == 1);
+    return HostTest_Result();
+}
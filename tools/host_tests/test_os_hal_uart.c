@@ -0,0 +1,389 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the DMA transmit queue of the OS_HAL UART driver, os_hal_uart.c, on the host ThreadX
+// and NVIC stand-ins, with the test playing the MHAL UART layer and the M4 DMA behind it. The
+// DMA interrupt acknowledges the channel after the driver's callback returns, as the MHAL DMA
+// dispatcher does, so the channel must still be allocated then: it may only be released in
+// thread context. Also checks that queued transmissions go out in order on one allocation,
+// that a synchronous send does not wait behind asynchronous ones, and that a stuck line times
+// out without failing anyone else's transmission.
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "nvic.h"
+#include "os_hal_uart.h"
+#include "threadx_host.h"
+#include "tx_api.h"
+
+#define TICK_MS 10
+#define PORT OS_HAL_UART_ISU0
+#define LINE_SIZE 256
+#define MAX_INTERRUPTS 64
+#define MAX_SENDS 8
+
+// The M4 DMA's TX channel, and the UART line behind it.
+static struct {
+    bool allocated, running, stuck;
+    uint32_t generation, delayUs;
+    struct mtk_uart_controller *ctlr;
+    uart_dma_done_callback callback;
+    void *callbackData;
+
+    uint32_t allocations, releases, releasesInInterrupt, acksOnReleased, staleInterrupts;
+    uint8_t line[LINE_SIZE];
+    size_t lineLength;
+
+    pthread_t interrupts[MAX_INTERRUPTS];
+    uint32_t interruptCount;
+} dma;
+
+// Results of asynchronous sends, by the index passed as user_data.
+static struct {
+    volatile bool done;
+    int len;
+    bool inInterrupt;
+} sends[MAX_SENDS];
+
+static uint64_t NowMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// The MHAL DMA interrupt: the channel's callback, then the acknowledgement on the channel.
+static void DmaIrq(void)
+{
+    struct mtk_uart_private *mdata = dma.ctlr->mdata;
+
+    if (!dma.allocated || !dma.running) {
+        dma.staleInterrupts++;
+        return;
+    }
+
+    dma.running = false;
+    mdata->tx_size = mdata->tx_len;
+    if (dma.lineLength + mdata->tx_len <= LINE_SIZE) {
+        memcpy(dma.line + dma.lineLength, mdata->tx_buf, mdata->tx_len);
+        dma.lineLength += mdata->tx_len;
+    }
+    dma.callback(dma.callbackData);
+
+    if (!dma.allocated) {
+        dma.acksOnReleased++;
+    }
+}
+
+static void DmaDone(void *arg)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    // Only the transmission which raised it, unless it has been stopped meanwhile.
+    __disable_irq();
+    if ((uintptr_t)arg == dma.generation) {
+        HostNvic_Raise(CM4_IRQ_M4DMA);
+    }
+    __set_PRIMASK(primask);
+}
+
+int mtk_mhal_uart_allocate_dma_tx_ch(struct mtk_uart_controller *ctlr)
+{
+    if (dma.allocated) {
+        return -UART_EBUSY;
+    }
+    dma.allocated = true;
+    dma.allocations++;
+    dma.ctlr = ctlr;
+    CM4_Install_NVIC(CM4_IRQ_M4DMA, DEFAULT_PRI, IRQ_LEVEL_TRIGGER, DmaIrq, TRUE);
+    return 0;
+}
+
+int mtk_mhal_uart_release_dma_tx_ch(struct mtk_uart_controller *ctlr)
+{
+    (void)ctlr;
+    if (__get_ipsr_value() != 0) {
+        dma.releasesInInterrupt++;
+    }
+    dma.allocated = dma.running = false;
+    dma.releases++;
+    return 0;
+}
+
+int mtk_mhal_uart_dma_tx_callback_register(struct mtk_uart_controller *ctlr,
+                                           uart_dma_done_callback callback, void *user_data)
+{
+    (void)ctlr;
+    dma.callback = callback;
+    dma.callbackData = user_data;
+    return 0;
+}
+
+int mtk_mhal_uart_dma_tx_config(struct mtk_uart_controller *ctlr)
+{
+    (void)ctlr;
+    return dma.allocated ? 0 : -UART_EPTR;
+}
+
+int mtk_mhal_uart_start_dma_tx(struct mtk_uart_controller *ctlr)
+{
+    (void)ctlr;
+    if (!dma.allocated) {
+        return -UART_EPTR;
+    }
+    dma.running = true;
+    dma.generation++;
+    if (!dma.stuck && dma.interruptCount < MAX_INTERRUPTS) {
+        HostTx_RaiseInterrupt(&dma.interrupts[dma.interruptCount++], dma.delayUs, DmaDone,
+                              (void *)(uintptr_t)dma.generation);
+    }
+    return 0;
+}
+
+int mtk_mhal_uart_stop_dma_tx(struct mtk_uart_controller *ctlr)
+{
+    // Half of it made it onto the line.
+    if (dma.running) {
+        ctlr->mdata->tx_size = ctlr->mdata->tx_len / 2;
+    }
+    dma.running = false;
+    dma.generation++;
+    return 0;
+}
+
+int mtk_mhal_uart_update_dma_tx_info(struct mtk_uart_controller *ctlr)
+{
+    (void)ctlr;
+    return 0;
+}
+
+int mtk_mhal_uart_set_sw_fc(struct mtk_uart_controller *ctlr, u8 xon1, u8 xoff1, u8 xon2,
+                            u8 xoff2, u8 escape_data)
+{
+    (void)ctlr;
+    (void)xon1;
+    (void)xoff1;
+    (void)xon2;
+    (void)xoff2;
+    (void)escape_data;
+    return 0;
+}
+
+int mtk_mhal_uart_set_dma(struct mtk_uart_controller *ctlr, bool enable_dma)
+{
+    (void)ctlr;
+    (void)enable_dma;
+    return 0;
+}
+
+int mtk_mhal_uart_set_hw_fc(struct mtk_uart_controller *ctlr, u8 hw_fc)
+{
+    (void)ctlr;
+    (void)hw_fc;
+    return 0;
+}
+
+int mtk_mhal_uart_set_irq(struct mtk_uart_controller *ctlr, u8 int_flag)
+{
+    (void)ctlr;
+    (void)int_flag;
+    return 0;
+}
+
+int mtk_mhal_uart_putc(struct mtk_uart_controller *ctlr, u8 data)
+{
+    (void)ctlr;
+    (void)data;
+    return 0;
+}
+
+int mtk_mhal_uart_dma_rx_callback_register(struct mtk_uart_controller *ctlr,
+                                           uart_dma_done_callback callback, void *user_data)
+{
+    (void)ctlr;
+    (void)callback;
+    (void)user_data;
+    return 0;
+}
+
+int osai_dma_vff_read_data(u8 chn, u8 *buffer, u32 length)
+{
+    (void)chn;
+    (void)buffer;
+    (void)length;
+    return 0;
+}
+
+// The rest of the MHAL UART layer, which these checks do not need.
+#define MHAL_UART_STUB(name)                        \
+    int name(struct mtk_uart_controller *ctlr)      \
+    {                                               \
+        (void)ctlr;                                 \
+        return 0;                                   \
+    }
+
+MHAL_UART_STUB(mtk_mhal_uart_enable_clk)
+MHAL_UART_STUB(mtk_mhal_uart_disable_clk)
+MHAL_UART_STUB(mtk_mhal_uart_sw_reset)
+MHAL_UART_STUB(mtk_mhal_uart_dumpreg)
+MHAL_UART_STUB(mtk_mhal_uart_hw_init)
+MHAL_UART_STUB(mtk_mhal_uart_set_baudrate)
+MHAL_UART_STUB(mtk_mhal_uart_set_format)
+MHAL_UART_STUB(mtk_mhal_uart_disable_sw_fc)
+MHAL_UART_STUB(mtk_mhal_uart_clear_irq_status)
+MHAL_UART_STUB(mtk_mhal_uart_getc)
+MHAL_UART_STUB(mtk_mhal_uart_getc_nowait)
+MHAL_UART_STUB(mtk_mhal_uart_allocate_dma_rx_ch)
+MHAL_UART_STUB(mtk_mhal_uart_release_dma_rx_ch)
+MHAL_UART_STUB(mtk_mhal_uart_dma_rx_config)
+MHAL_UART_STUB(mtk_mhal_uart_start_dma_rx)
+MHAL_UART_STUB(mtk_mhal_uart_stop_dma_rx)
+MHAL_UART_STUB(mtk_mhal_uart_update_dma_rx_info)
+
+static void SendDone(void *user_data, int len)
+{
+    uintptr_t index = (uintptr_t)user_data;
+
+    sends[index].len = len;
+    sends[index].inInterrupt = __get_ipsr_value() != 0;
+    sends[index].done = true;
+}
+
+static int SendAsync(uintptr_t index, const char *text, bool vff_mode)
+{
+    sends[index].done = false;
+    return mtk_os_hal_uart_dma_send_data_async(PORT, (u8 *)text, (u32)strlen(text), vff_mode,
+                                               SendDone, (void *)index);
+}
+
+// Sleeps, giving up the core, until send index has completed, or for up to a second.
+static bool WaitForSend(uintptr_t index)
+{
+    uint64_t start = NowMs();
+
+    while (!sends[index].done && NowMs() - start < 1000) {
+        osai_delay_ms(TICK_MS);
+    }
+    return sends[index].done;
+}
+
+static void ResetLine(uint32_t delayUs)
+{
+    dma.delayUs = delayUs;
+    dma.stuck = false;
+    dma.lineLength = 0;
+}
+
+static void TestAsyncQueue(void)
+{
+    static const char first[] = "temperature ", second[] = "21.50\n";
+
+    // Both on one allocation, in order; the channel stays allocated once the queue is empty.
+    ResetLine(20000);
+    CHECK(SendAsync(0, first, false) == 0);
+    CHECK(SendAsync(1, second, false) == 0);
+    CHECK(SendAsync(2, second, false) == -UART_EBUSY);
+    CHECK(WaitForSend(0) && WaitForSend(1));
+
+    CHECK(sends[0].len == (int)strlen(first) && sends[0].inInterrupt);
+    CHECK(sends[1].len == (int)strlen(second) && sends[1].inInterrupt);
+    CHECK(dma.lineLength == strlen(first) + strlen(second));
+    CHECK(memcmp(dma.line, "temperature 21.50\n", dma.lineLength) == 0);
+    CHECK(dma.allocations == 1 && dma.allocated);
+
+    // The next one in the same mode reuses the channel.
+    CHECK(SendAsync(2, second, false) == 0);
+    CHECK(WaitForSend(2) && sends[2].len == (int)strlen(second));
+    CHECK(dma.allocations == 1);
+}
+
+static void TestModeSwitch(void)
+{
+    static const char text[] = "vff\n";
+
+    // The idle channel of the other mode is released, from this thread.
+    ResetLine(1000);
+    uint32_t releases = dma.releases;
+    CHECK(SendAsync(0, text, true) == 0);
+    CHECK(dma.releases == releases + 1 && dma.allocations == 2);
+    CHECK(WaitForSend(0) && sends[0].len == (int)strlen(text));
+
+    CHECK(SendAsync(1, text, false) == 0);
+    CHECK(WaitForSend(1) && dma.allocations == 3);
+}
+
+static void TestSyncBusy(void)
+{
+    static const char queued[] = "queued\n", text[] = "sync\n";
+
+    // A synchronous send would time out on the queued one's time, and then abort it.
+    ResetLine(50000);
+    CHECK(SendAsync(0, queued, false) == 0);
+    CHECK(mtk_os_hal_uart_dma_send_data(PORT, (u8 *)text, sizeof(text) - 1, false) ==
+          -UART_EBUSY);
+    CHECK(WaitForSend(0) && sends[0].len == (int)strlen(queued));
+
+    ResetLine(1000);
+    CHECK(mtk_os_hal_uart_dma_send_data(PORT, (u8 *)text, sizeof(text) - 1, false) ==
+          (int)sizeof(text) - 1);
+    CHECK(dma.lineLength == sizeof(text) - 1);
+}
+
+static void TestSyncTimeout(void)
+{
+    static const char text[] = "stuck line\n";
+
+    // The line stalls: the send times out with what made it out, and the channel is only
+    // stopped, so the next send starts on it straight away.
+    ResetLine(0);
+    dma.stuck = true;
+    uint64_t start = NowMs();
+    CHECK(mtk_os_hal_uart_dma_send_data(PORT, (u8 *)text, sizeof(text) - 1, false) ==
+          (int)(sizeof(text) - 1) / 2);
+    CHECK(NowMs() - start >= 1000);
+    CHECK(dma.allocated && !dma.running);
+
+    // An interrupt the abort raced with finds nothing to complete.
+    uint32_t stale = dma.staleInterrupts;
+    HostNvic_Raise(CM4_IRQ_M4DMA);
+    CHECK(dma.staleInterrupts == stale + 1);
+
+    ResetLine(1000);
+    uint32_t allocations = dma.allocations;
+    CHECK(mtk_os_hal_uart_dma_send_data(PORT, (u8 *)text, sizeof(text) - 1, false) ==
+          (int)sizeof(text) - 1);
+    CHECK(dma.allocations == allocations);
+}
+
+static void *TestThread(void *arg)
+{
+    (void)arg;
+    TestAsyncQueue();
+    TestModeSwitch();
+    TestSyncBusy();
+    TestSyncTimeout();
+
+    // Deinit releases the idle channel.
+    CHECK(mtk_os_hal_uart_ctlr_deinit(PORT) == 0);
+    CHECK(!dma.allocated);
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t thread;
+
+    CHECK(mtk_os_hal_uart_ctlr_init(PORT) == 0);
+    HostTx_CreateThread(&thread, TestThread, NULL);
+    pthread_join(thread, NULL);
+    for (uint32_t i = 0; i < dma.interruptCount; i++) {
+        pthread_join(dma.interrupts[i], NULL);
+    }
+
+    CHECK(dma.releasesInInterrupt == 0);
+    CHECK(dma.acksOnReleased == 0);
+    return HostTest_Result();
+}
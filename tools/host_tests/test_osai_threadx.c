@@ -0,0 +1,163 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the ThreadX backend of the MHAL OS abstraction layer, mhal_osai_threadx.c, on the
+// host ThreadX stand-in in threadx_host: while a driver thread waits in osai_delay_ms or for a
+// completion, a second thread, standing in for thread_blink_led, must get the core and make
+// progress. Sub-tick delays, which busy-wait, must hold it. Timeouts must be honoured.
+
+#include <stdint.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "mhal_osai.h"
+#include "threadx_host.h"
+
+#define TICK_MS 10
+
+static struct osai_completion completion;
+static volatile bool blinking;
+static volatile uint32_t blinks;
+
+static uint64_t NowMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// Counts every time it gets the core; osai_delay_ms sleeps two ticks for one tick's delay.
+static void *BlinkThread(void *arg)
+{
+    (void)arg;
+    while (blinking) {
+        blinks++;
+        osai_delay_ms(TICK_MS);
+    }
+    return NULL;
+}
+
+static void CompleteInterrupt(void *arg)
+{
+    osai_complete(arg);
+}
+
+typedef struct {
+    enum { WAIT_DELAY, WAIT_COMPLETION } kind;
+    uint32_t timeMs;          // delay, or completion timeout
+    uint32_t completeAfterMs; // 0 if never completed
+
+    int result;
+    uint64_t elapsedMs;
+    uint32_t blinks;
+    pthread_t blink, interrupt;
+} DriverWait;
+
+// The driver thread: takes the core before the blink thread starts, then waits.
+static void *DriverThread(void *arg)
+{
+    DriverWait *wait = arg;
+
+    blinking = true;
+    blinks = 0;
+    HostTx_CreateThread(&wait->blink, BlinkThread, NULL);
+    if (wait->completeAfterMs != 0) {
+        HostTx_RaiseInterrupt(&wait->interrupt, wait->completeAfterMs * 1000, CompleteInterrupt,
+                              &completion);
+    }
+
+    uint64_t start = NowMs();
+    if (wait->kind == WAIT_DELAY) {
+        osai_delay_ms(wait->timeMs);
+    } else {
+        wait->result = osai_wait_for_completion_timeout(&completion, wait->timeMs);
+    }
+    wait->elapsedMs = NowMs() - start;
+    wait->blinks = blinks;
+
+    blinking = false;
+    return NULL;
+}
+
+static void RunDriver(DriverWait *wait)
+{
+    pthread_t driver;
+
+    CHECK(osai_init_completion(&completion) == 0);
+    HostTx_CreateThread(&driver, DriverThread, wait);
+
+    // Joined from outside, as the blink thread needs the core to finish.
+    pthread_join(driver, NULL);
+    pthread_join(wait->blink, NULL);
+    if (wait->completeAfterMs != 0) {
+        pthread_join(wait->interrupt, NULL);
+    }
+}
+
+static void TestDelaySleeps(void)
+{
+    DriverWait wait = {.kind = WAIT_DELAY, .timeMs = 100};
+
+    RunDriver(&wait);
+    CHECK(wait.elapsedMs >= 100);
+    CHECK(wait.blinks >= 3);
+}
+
+static void TestSubTickDelayHoldsCore(void)
+{
+    DriverWait wait = {.kind = WAIT_DELAY, .timeMs = TICK_MS / 2};
+
+    RunDriver(&wait);
+    CHECK(wait.elapsedMs >= TICK_MS / 2 - 1);
+    CHECK(wait.blinks == 0);
+}
+
+static void TestCompletionYields(void)
+{
+    DriverWait wait = {.kind = WAIT_COMPLETION, .timeMs = 1000, .completeAfterMs = 100};
+
+    RunDriver(&wait);
+    CHECK(wait.result == 0);
+    CHECK(wait.elapsedMs >= 100 - 1 && wait.elapsedMs < 1000);
+    CHECK(wait.blinks >= 3);
+}
+
+static void TestCompletionTimeout(void)
+{
+    DriverWait wait = {.kind = WAIT_COMPLETION, .timeMs = 100};
+
+    RunDriver(&wait);
+    CHECK(wait.result == -1);
+    CHECK(wait.elapsedMs >= 100);
+    CHECK(wait.blinks >= 3);
+}
+
+static void TestOutsideThread(void)
+{
+    // Before the scheduler runs, or in an interrupt handler, waits poll the completion.
+    CHECK(osai_init_completion(&completion) == 0);
+    uint64_t start = NowMs();
+    CHECK(osai_wait_for_completion_timeout(&completion, 20) == -1);
+    CHECK(NowMs() - start >= 20 - 1);
+
+    osai_complete(&completion);
+    CHECK(osai_wait_for_completion_timeout(&completion, 20) == 0);
+
+    // Initializing again drops a completion nobody waited for.
+    osai_complete(&completion);
+    CHECK(osai_init_completion(&completion) == 0);
+    CHECK(osai_wait_for_completion_timeout(&completion, 0) == -1);
+
+    osai_deinit_completion(&completion);
+}
+
+int main(void)
+{
+    TestDelaySleeps();
+    TestSubTickDelayHoldsCore();
+    TestCompletionYields();
+    TestCompletionTimeout();
+    TestOutsideThread();
+
+    return HostTest_Result();
+}
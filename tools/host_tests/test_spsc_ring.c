@@ -0,0 +1,176 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Checks of the record ring in Shared/spsc_ring.h, on its C11 atomics fallback: capacity
+// checks, full and empty rings, indexes wrapping at 2^32, and a producer and a consumer thread
+// racing through a small ring. Every record must come out once, in order and whole.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "spsc_ring.h"
+
+#define STRESS_RECORDS 2000000
+#define STRESS_CAPACITY 8
+#define WRAP_START (UINT32_MAX - STRESS_RECORDS / 2) // the indexes wrap halfway through
+#define STALL_TIMEOUT_NS 1000000000ull                 // without a record, both sides give up
+
+// Larger than a word and not a multiple of one, so a torn copy shows up in the check words.
+typedef struct {
+    uint32_t sequence;
+    uint32_t check[3];
+    uint8_t tail;
+} Record;
+
+static SPSC_RING stressRing;
+static Record stressStorage[STRESS_CAPACITY];
+static atomic_bool stalled;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void FillRecord(Record *record, uint32_t sequence)
+{
+    memset(record, 0, sizeof(*record));
+    record->sequence = sequence;
+    record->check[0] = ~sequence;
+    record->check[1] = sequence * 2654435761u;
+    record->check[2] = sequence ^ 0x5A5A5A5Au;
+    record->tail = (uint8_t)(sequence >> 3);
+}
+
+static bool RecordIs(const Record *record, uint32_t sequence)
+{
+    Record expected;
+
+    FillRecord(&expected, sequence);
+    return memcmp(record, &expected, sizeof(expected)) == 0;
+}
+
+static void TestInit(void)
+{
+    SPSC_RING ring;
+    Record storage[8];
+
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(Record), 0));
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(Record), 3));
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(Record), 6));
+    CHECK(spsc_ring_init(&ring, storage, sizeof(Record), 1));
+    CHECK(spsc_ring_init(&ring, storage, sizeof(Record), 8));
+    CHECK(spsc_ring_count(&ring) == 0);
+}
+
+// Fills and empties a ring of capacity records whose indexes start at start.
+static void CheckFillAndDrain(uint32_t capacity, uint32_t start)
+{
+    SPSC_RING ring;
+    Record storage[8], record;
+
+    CHECK(spsc_ring_init(&ring, storage, sizeof(Record), capacity));
+    spsc_store_release(&ring.head, start);
+    spsc_store_release(&ring.tail, start);
+
+    // Every slot is used, there is no spare one.
+    for (uint32_t i = 0; i < capacity; i++) {
+        FillRecord(&record, i);
+        CHECK(spsc_ring_push(&ring, &record));
+    }
+    FillRecord(&record, capacity);
+    CHECK(!spsc_ring_push(&ring, &record));
+    CHECK(spsc_ring_count(&ring) == capacity);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        CHECK(spsc_ring_pop(&ring, &record) && RecordIs(&record, i));
+    }
+    CHECK(!spsc_ring_pop(&ring, &record));
+    CHECK(spsc_ring_count(&ring) == 0);
+}
+
+static void TestFillAndDrain(void)
+{
+    CheckFillAndDrain(1, 0);
+    CheckFillAndDrain(8, 0);
+}
+
+// Indexes count records since start up, and must keep working once they wrap.
+static void TestIndexWrap(void)
+{
+    CheckFillAndDrain(8, UINT32_MAX - 3);
+    CheckFillAndDrain(8, UINT32_MAX);
+    CheckFillAndDrain(1, UINT32_MAX);
+}
+
+static void *Producer(void *arg)
+{
+    Record record;
+
+    (void)arg;
+    for (uint32_t i = 0; i < STRESS_RECORDS; i++) {
+        FillRecord(&record, i);
+        while (!spsc_ring_push(&stressRing, &record)) {
+            if (atomic_load(&stalled)) {
+                return NULL;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void TestTwoThreads(void)
+{
+    uint32_t received = 0, outOfOrder = 0, overfull = 0;
+    uint64_t progressNs = NowNs();
+    pthread_t producer;
+    Record record;
+
+    CHECK(spsc_ring_init(&stressRing, stressStorage, sizeof(Record), STRESS_CAPACITY));
+    spsc_store_release(&stressRing.head, WRAP_START);
+    spsc_store_release(&stressRing.tail, WRAP_START);
+    pthread_create(&producer, NULL, Producer, NULL);
+
+    // The consumer, counting problems rather than checking them, on the hot path.
+    while (received < STRESS_RECORDS) {
+        if (spsc_ring_count(&stressRing) > STRESS_CAPACITY) {
+            overfull++;
+        }
+        if (!spsc_ring_pop(&stressRing, &record)) {
+            if (NowNs() - progressNs > STALL_TIMEOUT_NS) {
+                atomic_store(&stalled, true);
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        progressNs = NowNs();
+        if (!RecordIs(&record, received)) {
+            outOfOrder++;
+        }
+        received++;
+    }
+    pthread_join(producer, NULL);
+
+    CHECK(received == STRESS_RECORDS);
+    CHECK(outOfOrder == 0);
+    CHECK(overfull == 0);
+    CHECK(!spsc_ring_pop(&stressRing, &record));
+    CHECK(stressRing.head == WRAP_START + STRESS_RECORDS);
+}
+
+int main(void)
+{
+    TestInit();
+    TestFillAndDrain();
+    TestIndexWrap();
+    TestTwoThreads();
+    return HostTest_Result();
+}
@@ -0,0 +1,707 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for ThreadX, see tx_api.h. The core is a mutex: a ThreadX thread holds it
+// while it runs, and releases it only in tx_thread_sleep and while blocked on a ThreadX
+// object. A thread which busy-waits therefore keeps every other thread from running, as on the
+// M4. The time the core is held is accumulated for HostTx_CoreBusyNs.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "threadx_host.h"
+#include "tx_api.h"
+
+#define SYSTICK_RELOAD 999
+#define TICK_NS (1000000000ull / TX_TIMER_TICKS_PER_SECOND)
+
+typedef struct {
+    unsigned delayUs;
+    void (*handler)(void *);
+    void *arg;
+} Interrupt;
+
+static pthread_mutex_t core = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t coreTakenNs, coreBusyNs, kernelEnteredNs;
+static _Thread_local TX_THREAD *currentThread;
+static _Thread_local unsigned int currentIpsr;
+static _Thread_local volatile uint32_t sysTickCurrent;
+static volatile uint32_t sysTickReload = SYSTICK_RELOAD;
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void SleepNs(uint64_t ns)
+{
+    struct timespec delay = {.tv_sec = ns / 1000000000u, .tv_nsec = ns % 1000000000u};
+    while (nanosleep(&delay, &delay) == -1 && errno == EINTR) {
+    }
+}
+
+static void TakeCore(void)
+{
+    pthread_mutex_lock(&core);
+    coreTakenNs = NowNs();
+}
+
+static void GiveCore(void)
+{
+    coreBusyNs += NowNs() - coreTakenNs;
+    pthread_mutex_unlock(&core);
+}
+
+// Waits on condition, giving up the core while a ThreadX thread blocks, until it is signalled
+// or deadline, if not NULL, has passed. Returns false on timeout.
+static bool Block(pthread_cond_t *condition, pthread_mutex_t *lock,
+                  const struct timespec *deadline)
+{
+    bool signalled = true;
+
+    if (currentThread != NULL) {
+        GiveCore();
+    }
+    if (deadline == NULL) {
+        pthread_cond_wait(condition, lock);
+    } else {
+        signalled = pthread_cond_timedwait(condition, lock, deadline) != ETIMEDOUT;
+    }
+    if (currentThread != NULL) {
+        // Not while holding lock, which the thread that takes the core next may need.
+        pthread_mutex_unlock(lock);
+        TakeCore();
+        pthread_mutex_lock(lock);
+    }
+    return signalled;
+}
+
+static struct timespec Deadline(ULONG timer_ticks)
+{
+    uint64_t deadlineNs = NowNs() + (uint64_t)timer_ticks * TICK_NS;
+    struct timespec deadline = {.tv_sec = deadlineNs / 1000000000u,
+                                .tv_nsec = deadlineNs % 1000000000u};
+    return deadline;
+}
+
+static void InitCondition(pthread_cond_t *condition)
+{
+    pthread_condattr_t attributes;
+
+    // Timeouts are measured on the monotonic clock, as the ticks are.
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(condition, &attributes);
+    pthread_condattr_destroy(&attributes);
+}
+
+static void *ThreadEntry(void *arg)
+{
+    TX_THREAD *thread = arg;
+    void *result = NULL;
+
+    TakeCore();
+    currentThread = thread;
+    if (thread->entry != NULL) {
+        result = thread->entry(thread->arg);
+    } else {
+        thread->txEntry(thread->txInput);
+    }
+    currentThread = NULL;
+    GiveCore();
+
+    if (thread->allocated) {
+        free(thread);
+    }
+    return result;
+}
+
+int HostTx_CreateThread(pthread_t *thread, void *(*entry)(void *), void *arg)
+{
+    TX_THREAD *txThread = calloc(1, sizeof(TX_THREAD));
+    if (txThread == NULL) {
+        return -1;
+    }
+
+    txThread->entry = entry;
+    txThread->arg = arg;
+    txThread->allocated = true;
+    if (pthread_create(thread, NULL, ThreadEntry, txThread) != 0) {
+        free(txThread);
+        return -1;
+    }
+    return 0;
+}
+
+void HostTx_WaitUs(unsigned delayUs)
+{
+    if (currentThread != NULL) {
+        GiveCore();
+    }
+    SleepNs((uint64_t)delayUs * 1000);
+    if (currentThread != NULL) {
+        TakeCore();
+    }
+}
+
+uint64_t HostTx_CoreBusyNs(void)
+{
+    // The caller holds the core, so nothing else updates the count meanwhile.
+    return coreBusyNs + (NowNs() - coreTakenNs);
+}
+
+static void *InterruptEntry(void *arg)
+{
+    Interrupt *interrupt = arg;
+
+    SleepNs((uint64_t)interrupt->delayUs * 1000);
+    // Any exception number will do, only zero means thread mode.
+    currentIpsr = 16;
+    interrupt->handler(interrupt->arg);
+
+    free(interrupt);
+    return NULL;
+}
+
+int HostTx_RaiseInterrupt(pthread_t *interrupt, unsigned delayUs, void (*handler)(void *),
+                          void *arg)
+{
+    Interrupt *pending = malloc(sizeof(Interrupt));
+    if (pending == NULL) {
+        return -1;
+    }
+
+    pending->delayUs = delayUs;
+    pending->handler = handler;
+    pending->arg = arg;
+    if (pthread_create(interrupt, NULL, InterruptEntry, pending) != 0) {
+        free(pending);
+        return -1;
+    }
+    return 0;
+}
+
+// Weak, only the tests which enter the kernel define the application.
+#pragma weak tx_application_define
+
+VOID tx_kernel_enter(VOID)
+{
+    kernelEnteredNs = NowNs();
+    TakeCore();
+    tx_application_define(NULL);
+    GiveCore();
+    pthread_exit(NULL);
+}
+
+ULONG tx_time_get(VOID)
+{
+    return (ULONG)((NowNs() - kernelEnteredNs) / TICK_NS);
+}
+
+UINT tx_thread_create(TX_THREAD *thread_ptr, CHAR *name_ptr, VOID (*entry_function)(ULONG),
+                      ULONG entry_input, VOID *stack_start, ULONG stack_size, UINT priority,
+                      UINT preempt_threshold, ULONG time_slice, UINT auto_start)
+{
+    (void)name_ptr;
+    (void)stack_start;
+    (void)stack_size;
+    (void)priority;
+    (void)preempt_threshold;
+    (void)time_slice;
+    (void)auto_start;
+
+    thread_ptr->entry = NULL;
+    thread_ptr->txEntry = entry_function;
+    thread_ptr->txInput = entry_input;
+    thread_ptr->allocated = false;
+    if (pthread_create(&thread_ptr->thread, NULL, ThreadEntry, thread_ptr) != 0) {
+        return TX_THREAD_ERROR;
+    }
+    pthread_detach(thread_ptr->thread);
+    return TX_SUCCESS;
+}
+
+TX_THREAD *tx_thread_identify(void)
+{
+    return currentThread;
+}
+
+UINT tx_thread_sleep(ULONG timer_ticks)
+{
+    GiveCore();
+    SleepNs(timer_ticks * TICK_NS);
+    TakeCore();
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_create(TX_SEMAPHORE *semaphore_ptr, CHAR *name_ptr, ULONG initial_count)
+{
+    (void)name_ptr;
+    pthread_mutex_init(&semaphore_ptr->lock, NULL);
+    InitCondition(&semaphore_ptr->available);
+    semaphore_ptr->count = initial_count;
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_delete(TX_SEMAPHORE *semaphore_ptr)
+{
+    pthread_cond_destroy(&semaphore_ptr->available);
+    pthread_mutex_destroy(&semaphore_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_get(TX_SEMAPHORE *semaphore_ptr, ULONG wait_option)
+{
+    // Only ThreadX threads block, anywhere else a get polls.
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    UINT result;
+
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    while (semaphore_ptr->count == 0 && blocking) {
+        if (!Block(&semaphore_ptr->available, &semaphore_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (semaphore_ptr->count != 0) {
+        semaphore_ptr->count--;
+        result = TX_SUCCESS;
+    } else {
+        result = TX_NO_INSTANCE;
+    }
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return result;
+}
+
+UINT tx_semaphore_put(TX_SEMAPHORE *semaphore_ptr)
+{
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    semaphore_ptr->count++;
+    pthread_cond_signal(&semaphore_ptr->available);
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_ceiling_put(TX_SEMAPHORE *semaphore_ptr, ULONG ceiling)
+{
+    UINT result = TX_CEILING_EXCEEDED;
+
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    if (semaphore_ptr->count < ceiling) {
+        semaphore_ptr->count++;
+        pthread_cond_signal(&semaphore_ptr->available);
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return result;
+}
+
+UINT tx_queue_create(TX_QUEUE *queue_ptr, CHAR *name_ptr, UINT message_size,
+                     VOID *queue_start, ULONG queue_size)
+{
+    (void)name_ptr;
+    pthread_mutex_init(&queue_ptr->lock, NULL);
+    InitCondition(&queue_ptr->changed);
+    queue_ptr->storage = queue_start;
+    queue_ptr->messageSize = message_size;
+    queue_ptr->capacity = queue_size / (message_size * sizeof(ULONG));
+    queue_ptr->head = queue_ptr->count = 0;
+    return TX_SUCCESS;
+}
+
+UINT tx_queue_delete(TX_QUEUE *queue_ptr)
+{
+    pthread_cond_destroy(&queue_ptr->changed);
+    pthread_mutex_destroy(&queue_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_queue_send(TX_QUEUE *queue_ptr, VOID *source_ptr, ULONG wait_option)
+{
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    UINT result = TX_QUEUE_FULL;
+
+    pthread_mutex_lock(&queue_ptr->lock);
+    while (queue_ptr->count == queue_ptr->capacity && blocking) {
+        if (!Block(&queue_ptr->changed, &queue_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (queue_ptr->count < queue_ptr->capacity) {
+        ULONG tail = (queue_ptr->head + queue_ptr->count) % queue_ptr->capacity;
+        memcpy(&queue_ptr->storage[tail * queue_ptr->messageSize], source_ptr,
+               queue_ptr->messageSize * sizeof(ULONG));
+        queue_ptr->count++;
+        pthread_cond_broadcast(&queue_ptr->changed);
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&queue_ptr->lock);
+    return result;
+}
+
+UINT tx_queue_receive(TX_QUEUE *queue_ptr, VOID *destination_ptr, ULONG wait_option)
+{
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    UINT result = TX_QUEUE_EMPTY;
+
+    pthread_mutex_lock(&queue_ptr->lock);
+    while (queue_ptr->count == 0 && blocking) {
+        if (!Block(&queue_ptr->changed, &queue_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (queue_ptr->count != 0) {
+        memcpy(destination_ptr, &queue_ptr->storage[queue_ptr->head * queue_ptr->messageSize],
+               queue_ptr->messageSize * sizeof(ULONG));
+        queue_ptr->head = (queue_ptr->head + 1) % queue_ptr->capacity;
+        queue_ptr->count--;
+        pthread_cond_broadcast(&queue_ptr->changed);
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&queue_ptr->lock);
+    return result;
+}
+
+UINT tx_event_flags_create(TX_EVENT_FLAGS_GROUP *group_ptr, CHAR *name_ptr)
+{
+    (void)name_ptr;
+    pthread_mutex_init(&group_ptr->lock, NULL);
+    InitCondition(&group_ptr->changed);
+    group_ptr->flags = 0;
+    return TX_SUCCESS;
+}
+
+static bool FlagsSatisfied(ULONG flags, ULONG requested, UINT option)
+{
+    return (option & TX_AND) ? (flags & requested) == requested : (flags & requested) != 0;
+}
+
+UINT tx_event_flags_get(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG requested_flags,
+                        UINT get_option, ULONG *actual_flags_ptr, ULONG wait_option)
+{
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    UINT result = TX_NO_EVENTS;
+
+    pthread_mutex_lock(&group_ptr->lock);
+    while (!FlagsSatisfied(group_ptr->flags, requested_flags, get_option) && blocking) {
+        if (!Block(&group_ptr->changed, &group_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (FlagsSatisfied(group_ptr->flags, requested_flags, get_option)) {
+        *actual_flags_ptr = group_ptr->flags;
+        if (get_option & TX_OR_CLEAR) {
+            group_ptr->flags &= ~requested_flags;
+        }
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&group_ptr->lock);
+    return result;
+}
+
+UINT tx_event_flags_set(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG flags_to_set, UINT set_option)
+{
+    pthread_mutex_lock(&group_ptr->lock);
+    if (set_option == TX_AND) {
+        group_ptr->flags &= flags_to_set;
+    } else {
+        group_ptr->flags |= flags_to_set;
+    }
+    pthread_cond_broadcast(&group_ptr->changed);
+    pthread_mutex_unlock(&group_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_mutex_create(TX_MUTEX *mutex_ptr, CHAR *name_ptr, UINT inherit)
+{
+    (void)name_ptr;
+    (void)inherit;
+    pthread_mutex_init(&mutex_ptr->lock, NULL);
+    InitCondition(&mutex_ptr->released);
+    mutex_ptr->owned = false;
+    mutex_ptr->count = 0;
+    return TX_SUCCESS;
+}
+
+UINT tx_mutex_get(TX_MUTEX *mutex_ptr, ULONG wait_option)
+{
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    pthread_t self = pthread_self();
+    UINT result = TX_NOT_AVAILABLE;
+
+    pthread_mutex_lock(&mutex_ptr->lock);
+    if (mutex_ptr->owned && pthread_equal(mutex_ptr->owner, self)) {
+        mutex_ptr->count++;
+        pthread_mutex_unlock(&mutex_ptr->lock);
+        return TX_SUCCESS;
+    }
+    while (mutex_ptr->owned && blocking) {
+        if (!Block(&mutex_ptr->released, &mutex_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (!mutex_ptr->owned) {
+        mutex_ptr->owned = true;
+        mutex_ptr->owner = self;
+        mutex_ptr->count = 1;
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&mutex_ptr->lock);
+    return result;
+}
+
+UINT tx_mutex_put(TX_MUTEX *mutex_ptr)
+{
+    UINT result = TX_NOT_OWNED;
+
+    pthread_mutex_lock(&mutex_ptr->lock);
+    if (mutex_ptr->owned && pthread_equal(mutex_ptr->owner, pthread_self())) {
+        if (--mutex_ptr->count == 0) {
+            mutex_ptr->owned = false;
+            pthread_cond_signal(&mutex_ptr->released);
+        }
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&mutex_ptr->lock);
+    return result;
+}
+
+#define BYTE_POOL_OVERHEAD (sizeof(UCHAR *) + sizeof(ALIGN_TYPE))
+
+static ULONG RoundUpToAlignType(ULONG size)
+{
+    return (size + sizeof(ALIGN_TYPE) - 1) / sizeof(ALIGN_TYPE) * sizeof(ALIGN_TYPE);
+}
+
+UINT tx_byte_pool_create(TX_BYTE_POOL *pool_ptr, CHAR *name_ptr, VOID *pool_start,
+                         ULONG pool_size)
+{
+    (void)name_ptr;
+    pool_size = pool_size / sizeof(ALIGN_TYPE) * sizeof(ALIGN_TYPE);
+    if (pool_size < 2 * BYTE_POOL_OVERHEAD) {
+        return TX_NO_MEMORY;
+    }
+    pthread_mutex_init(&pool_ptr->lock, NULL);
+    pool_ptr->next = pool_start;
+    pool_ptr->available = pool_size - BYTE_POOL_OVERHEAD;
+    return TX_SUCCESS;
+}
+
+UINT tx_byte_allocate(TX_BYTE_POOL *pool_ptr, VOID **memory_ptr, ULONG memory_size,
+                      ULONG wait_option)
+{
+    ULONG size = RoundUpToAlignType(memory_size) + BYTE_POOL_OVERHEAD;
+    UINT result = TX_NO_MEMORY;
+
+    (void)wait_option;
+    pthread_mutex_lock(&pool_ptr->lock);
+    if (size <= pool_ptr->available) {
+        *memory_ptr = pool_ptr->next + BYTE_POOL_OVERHEAD;
+        pool_ptr->next += size;
+        pool_ptr->available -= size;
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&pool_ptr->lock);
+    return result;
+}
+
+UINT tx_block_pool_create(TX_BLOCK_POOL *pool_ptr, CHAR *name_ptr, ULONG block_size,
+                          VOID *pool_start, ULONG pool_size)
+{
+    ULONG stride = RoundUpToAlignType(block_size) + sizeof(UCHAR *);
+    UCHAR *block = pool_start;
+
+    (void)name_ptr;
+    pthread_mutex_init(&pool_ptr->lock, NULL);
+    InitCondition(&pool_ptr->released);
+    pool_ptr->blockSize = RoundUpToAlignType(block_size);
+    pool_ptr->total = pool_ptr->available = pool_size / stride;
+    pool_ptr->free = NULL;
+    // Linked from the end, so that blocks are handed out in address order.
+    for (ULONG i = pool_ptr->total; i > 0; i--) {
+        block = (UCHAR *)pool_start + (i - 1) * stride;
+        memcpy(block, &pool_ptr->free, sizeof(UCHAR *));
+        pool_ptr->free = block;
+    }
+    return pool_ptr->total > 0 ? TX_SUCCESS : TX_NO_MEMORY;
+}
+
+UINT tx_block_allocate(TX_BLOCK_POOL *pool_ptr, VOID **block_ptr, ULONG wait_option)
+{
+    bool blocking = wait_option != TX_NO_WAIT && currentThread != NULL;
+    struct timespec deadline = Deadline(wait_option);
+    UINT result = TX_NO_MEMORY;
+
+    pthread_mutex_lock(&pool_ptr->lock);
+    while (pool_ptr->free == NULL && blocking) {
+        if (!Block(&pool_ptr->released, &pool_ptr->lock,
+                   wait_option == TX_WAIT_FOREVER ? NULL : &deadline)) {
+            break;
+        }
+    }
+    if (pool_ptr->free != NULL) {
+        UCHAR *block = pool_ptr->free;
+        memcpy(&pool_ptr->free, block, sizeof(UCHAR *));
+        memcpy(block, &pool_ptr, sizeof(pool_ptr));
+        pool_ptr->available--;
+        *block_ptr = block + sizeof(UCHAR *);
+        result = TX_SUCCESS;
+    }
+    pthread_mutex_unlock(&pool_ptr->lock);
+    return result;
+}
+
+UINT tx_block_release(VOID *block_ptr)
+{
+    UCHAR *block = (UCHAR *)block_ptr - sizeof(UCHAR *);
+    TX_BLOCK_POOL *pool_ptr;
+
+    memcpy(&pool_ptr, block, sizeof(pool_ptr));
+    pthread_mutex_lock(&pool_ptr->lock);
+    memcpy(block, &pool_ptr->free, sizeof(UCHAR *));
+    pool_ptr->free = block;
+    pool_ptr->available++;
+    pthread_cond_signal(&pool_ptr->released);
+    pthread_mutex_unlock(&pool_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_block_pool_info_get(TX_BLOCK_POOL *pool_ptr, CHAR **name, ULONG *available_blocks,
+                            ULONG *total_blocks, TX_THREAD **first_suspended,
+                            ULONG *suspended_count, TX_BLOCK_POOL **next_pool)
+{
+    pthread_mutex_lock(&pool_ptr->lock);
+    if (name != TX_NULL) {
+        *name = TX_NULL;
+    }
+    if (available_blocks != TX_NULL) {
+        *available_blocks = pool_ptr->available;
+    }
+    if (total_blocks != TX_NULL) {
+        *total_blocks = pool_ptr->total;
+    }
+    if (first_suspended != TX_NULL) {
+        *first_suspended = TX_NULL;
+    }
+    if (suspended_count != TX_NULL) {
+        *suspended_count = 0;
+    }
+    if (next_pool != TX_NULL) {
+        *next_pool = TX_NULL;
+    }
+    pthread_mutex_unlock(&pool_ptr->lock);
+    return TX_SUCCESS;
+}
+
+// Runs a timer's expirations while it is active, starting over from its initial ticks
+// whenever it is changed, activated or deactivated.
+static void *TimerEntry(void *arg)
+{
+    TX_TIMER *timer = arg;
+
+    pthread_mutex_lock(&timer->lock);
+    for (;;) {
+        while (!timer->active) {
+            pthread_cond_wait(&timer->changed, &timer->lock);
+        }
+
+        uint64_t generation = timer->generation;
+        ULONG ticks = timer->initialTicks;
+        while (timer->active && timer->generation == generation) {
+            struct timespec deadline = Deadline(ticks);
+            if (pthread_cond_timedwait(&timer->changed, &timer->lock, &deadline) != ETIMEDOUT) {
+                continue;
+            }
+            if (timer->rescheduleTicks == 0) {
+                timer->active = false;
+            }
+            ticks = timer->rescheduleTicks;
+            // Not while holding the lock, the function may change the timer.
+            pthread_mutex_unlock(&timer->lock);
+            timer->expire(timer->input);
+            pthread_mutex_lock(&timer->lock);
+        }
+    }
+    return NULL;
+}
+
+UINT tx_timer_create(TX_TIMER *timer_ptr, CHAR *name_ptr, VOID (*expiration_function)(ULONG),
+                     ULONG expiration_input, ULONG initial_ticks, ULONG reschedule_ticks,
+                     UINT auto_activate)
+{
+    (void)name_ptr;
+    pthread_mutex_init(&timer_ptr->lock, NULL);
+    InitCondition(&timer_ptr->changed);
+    timer_ptr->expire = expiration_function;
+    timer_ptr->input = expiration_input;
+    timer_ptr->initialTicks = initial_ticks;
+    timer_ptr->rescheduleTicks = reschedule_ticks;
+    timer_ptr->active = auto_activate == TX_AUTO_ACTIVATE;
+    timer_ptr->generation = 0;
+    if (pthread_create(&timer_ptr->thread, NULL, TimerEntry, timer_ptr) != 0) {
+        return TX_THREAD_ERROR;
+    }
+    pthread_detach(timer_ptr->thread);
+    return TX_SUCCESS;
+}
+
+static UINT TimerUpdate(TX_TIMER *timer_ptr, bool active)
+{
+    pthread_mutex_lock(&timer_ptr->lock);
+    timer_ptr->active = active;
+    timer_ptr->generation++;
+    pthread_cond_broadcast(&timer_ptr->changed);
+    pthread_mutex_unlock(&timer_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_timer_activate(TX_TIMER *timer_ptr)
+{
+    return TimerUpdate(timer_ptr, true);
+}
+
+UINT tx_timer_deactivate(TX_TIMER *timer_ptr)
+{
+    return TimerUpdate(timer_ptr, false);
+}
+
+UINT tx_timer_change(TX_TIMER *timer_ptr, ULONG initial_ticks, ULONG reschedule_ticks)
+{
+    pthread_mutex_lock(&timer_ptr->lock);
+    timer_ptr->initialTicks = initial_ticks;
+    timer_ptr->rescheduleTicks = reschedule_ticks;
+    pthread_mutex_unlock(&timer_ptr->lock);
+    // ThreadX only changes a deactivated timer, which stays so.
+    return TX_SUCCESS;
+}
+
+unsigned int __get_ipsr_value(void)
+{
+    return currentIpsr;
+}
+
+volatile uint32_t *HostTx_SysTickReload(void)
+{
+    return &sysTickReload;
+}
+
+volatile uint32_t *HostTx_SysTickCurrent(void)
+{
+    uint64_t reload = (uint64_t)sysTickReload + 1;
+    sysTickCurrent = (uint32_t)(reload - 1 - (NowNs() % TICK_NS) * reload / TICK_NS);
+    return &sysTickCurrent;
+}
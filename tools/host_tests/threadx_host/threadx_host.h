@@ -0,0 +1,37 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Threads and interrupts for the host ThreadX stand-in in tx_api.h.
+
+#ifndef THREADX_HOST_H
+#define THREADX_HOST_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/// <summary>
+/// Starts a ThreadX thread, which waits for the core before it runs entry, and gives the core
+/// up when entry returns.
+/// </summary>
+int HostTx_CreateThread(pthread_t *thread, void *(*entry)(void *), void *arg);
+
+/// <summary>
+/// Starts an interrupt which runs handler after delayUs, preempting whichever thread holds the
+/// core. Join the returned thread to wait for the handler to have run.
+/// </summary>
+int HostTx_RaiseInterrupt(pthread_t *interrupt, unsigned delayUs, void (*handler)(void *),
+                          void *arg);
+
+/// <summary>
+/// Blocks the calling ThreadX thread for delayUs, giving up the core, as waiting for a
+/// hardware interrupt would.
+/// </summary>
+void HostTx_WaitUs(unsigned delayUs);
+
+/// <summary>
+/// Returns how long ThreadX threads have held the core in total, in nanoseconds. Only a ThreadX
+/// thread may call it.
+/// </summary>
+uint64_t HostTx_CoreBusyNs(void);
+
+#endif // #ifndef THREADX_HOST_H
@@ -0,0 +1,181 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the parts of the ThreadX API used by the MHAL OS abstraction layer and the
+// real-time demo, on pthreads. It models the single Cortex-M4 core: a ThreadX thread runs only
+// while it holds the core, which tx_thread_sleep and the blocking calls give up, as ThreadX
+// would schedule another thread. Priorities are not modelled: a thread keeps the core until it
+// blocks. Interrupts and timer expirations run on threads of their own, which never need the
+// core. See threadx_host.h for creating threads and raising interrupts.
+
+#ifndef TX_API_H
+#define TX_API_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef char CHAR;
+typedef unsigned char UCHAR;
+typedef unsigned int UINT;
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef void VOID;
+typedef uint32_t ALIGN_TYPE; // as on the Cortex-M4 port, where ULONG is 32 bits
+
+#define TX_NO_WAIT ((ULONG)0)
+#define TX_WAIT_FOREVER ((ULONG)0xFFFFFFFFUL)
+#define TX_NULL ((void *)0)
+#define TX_SUCCESS ((UINT)0x00)
+#define TX_NO_EVENTS ((UINT)0x07)
+#define TX_QUEUE_EMPTY ((UINT)0x0A)
+#define TX_QUEUE_FULL ((UINT)0x0B)
+#define TX_NO_INSTANCE ((UINT)0x0D)
+#define TX_THREAD_ERROR ((UINT)0x0E)
+#define TX_NO_MEMORY ((UINT)0x10)
+#define TX_NOT_AVAILABLE ((UINT)0x1D)
+#define TX_NOT_OWNED ((UINT)0x1E)
+#define TX_CEILING_EXCEEDED ((UINT)0x21)
+#define TX_OR ((UINT)0)
+#define TX_OR_CLEAR ((UINT)1)
+#define TX_AND ((UINT)2)
+#define TX_AND_CLEAR ((UINT)3)
+#define TX_NO_INHERIT ((UINT)0)
+#define TX_INHERIT ((UINT)1)
+#define TX_NO_ACTIVATE ((UINT)0)
+#define TX_AUTO_ACTIVATE ((UINT)1)
+#define TX_1_ULONG ((UINT)1)
+#define TX_NO_TIME_SLICE ((ULONG)0)
+#define TX_AUTO_START ((UINT)1)
+
+#ifndef TX_TIMER_TICKS_PER_SECOND
+#define TX_TIMER_TICKS_PER_SECOND ((ULONG)100)
+#endif
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+    ULONG count;
+} TX_SEMAPHORE;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ULONG *storage;
+    UINT messageSize; // in ULONGs
+    ULONG capacity, head, count;
+} TX_QUEUE;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ULONG flags;
+} TX_EVENT_FLAGS_GROUP;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    bool owned;
+    pthread_t owner;
+    UINT count; // nested gets by the owner
+} TX_MUTEX;
+
+typedef struct {
+    pthread_mutex_t lock;
+    UCHAR *next; // first byte not allocated yet
+    ULONG available;
+} TX_BYTE_POOL;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    UCHAR *free; // first free block, each starts with the next
+    ULONG blockSize, total, available;
+} TX_BLOCK_POOL;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    VOID (*expire)(ULONG);
+    ULONG input;
+    ULONG initialTicks, rescheduleTicks;
+    bool active;
+    uint64_t generation; // counts changes, a waiting timer thread starts over on one
+    pthread_t thread;
+} TX_TIMER;
+
+typedef struct TX_THREAD_STRUCT {
+    void *(*entry)(void *);
+    void *arg;
+    VOID (*txEntry)(ULONG);
+    ULONG txInput;
+    bool allocated; // by HostTx_CreateThread
+    pthread_t thread;
+} TX_THREAD;
+
+// Defines the application with the core held, then gives it to the threads. Never returns, as
+// the threads run from then on.
+_Noreturn VOID tx_kernel_enter(VOID);
+VOID tx_application_define(VOID *first_unused_memory);
+
+// Ticks since tx_kernel_enter.
+ULONG tx_time_get(VOID);
+
+UINT tx_thread_create(TX_THREAD *thread_ptr, CHAR *name_ptr, VOID (*entry_function)(ULONG),
+                      ULONG entry_input, VOID *stack_start, ULONG stack_size, UINT priority,
+                      UINT preempt_threshold, ULONG time_slice, UINT auto_start);
+TX_THREAD *tx_thread_identify(void);
+UINT tx_thread_sleep(ULONG timer_ticks);
+UINT tx_semaphore_create(TX_SEMAPHORE *semaphore_ptr, CHAR *name_ptr, ULONG initial_count);
+UINT tx_semaphore_delete(TX_SEMAPHORE *semaphore_ptr);
+UINT tx_semaphore_get(TX_SEMAPHORE *semaphore_ptr, ULONG wait_option);
+UINT tx_semaphore_put(TX_SEMAPHORE *semaphore_ptr);
+UINT tx_semaphore_ceiling_put(TX_SEMAPHORE *semaphore_ptr, ULONG ceiling);
+UINT tx_queue_create(TX_QUEUE *queue_ptr, CHAR *name_ptr, UINT message_size,
+                     VOID *queue_start, ULONG queue_size);
+UINT tx_queue_delete(TX_QUEUE *queue_ptr);
+UINT tx_queue_send(TX_QUEUE *queue_ptr, VOID *source_ptr, ULONG wait_option);
+UINT tx_queue_receive(TX_QUEUE *queue_ptr, VOID *destination_ptr, ULONG wait_option);
+UINT tx_event_flags_create(TX_EVENT_FLAGS_GROUP *group_ptr, CHAR *name_ptr);
+UINT tx_event_flags_get(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG requested_flags,
+                        UINT get_option, ULONG *actual_flags_ptr, ULONG wait_option);
+UINT tx_event_flags_set(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG flags_to_set, UINT set_option);
+UINT tx_mutex_create(TX_MUTEX *mutex_ptr, CHAR *name_ptr, UINT inherit);
+UINT tx_mutex_get(TX_MUTEX *mutex_ptr, ULONG wait_option);
+UINT tx_mutex_put(TX_MUTEX *mutex_ptr);
+
+// Byte pool allocations are never freed, and do not wait. Each takes the ThreadX overhead, a
+// block header of a pointer and an ALIGN_TYPE, and the pool keeps one more at its end.
+UINT tx_byte_pool_create(TX_BYTE_POOL *pool_ptr, CHAR *name_ptr, VOID *pool_start,
+                         ULONG pool_size);
+UINT tx_byte_allocate(TX_BYTE_POOL *pool_ptr, VOID **memory_ptr, ULONG memory_size,
+                      ULONG wait_option);
+
+// Block pools lay blocks out as ThreadX does, with a pointer to the pool in front of each.
+// tx_block_pool_info_get reports the blocks only: no name, suspended threads or pool list.
+UINT tx_block_pool_create(TX_BLOCK_POOL *pool_ptr, CHAR *name_ptr, ULONG block_size,
+                          VOID *pool_start, ULONG pool_size);
+UINT tx_block_allocate(TX_BLOCK_POOL *pool_ptr, VOID **block_ptr, ULONG wait_option);
+UINT tx_block_release(VOID *block_ptr);
+UINT tx_block_pool_info_get(TX_BLOCK_POOL *pool_ptr, CHAR **name, ULONG *available_blocks,
+                            ULONG *total_blocks, TX_THREAD **first_suspended,
+                            ULONG *suspended_count, TX_BLOCK_POOL **next_pool);
+
+// Timers run their expiration function on a thread of their own.
+UINT tx_timer_create(TX_TIMER *timer_ptr, CHAR *name_ptr, VOID (*expiration_function)(ULONG),
+                     ULONG expiration_input, ULONG initial_ticks, ULONG reschedule_ticks,
+                     UINT auto_activate);
+UINT tx_timer_activate(TX_TIMER *timer_ptr);
+UINT tx_timer_deactivate(TX_TIMER *timer_ptr);
+UINT tx_timer_change(TX_TIMER *timer_ptr, ULONG initial_ticks, ULONG reschedule_ticks);
+
+// Non-zero while an interrupt handler runs, as the Cortex-M IPSR register.
+unsigned int __get_ipsr_value(void);
+
+// SysTick, counting down from one reload per tick in step with the host clock.
+volatile uint32_t *HostTx_SysTickReload(void);
+volatile uint32_t *HostTx_SysTickCurrent(void);
+#define OSAI_SYST_RVR HostTx_SysTickReload()
+#define OSAI_SYST_CVR HostTx_SysTickCurrent()
+
+#endif // #ifndef TX_API_H
@@ -0,0 +1,140 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Batch case: the real-time side's cost per message when it drains bursts of small messages
+// with DequeueBatch at several budgets, against one DequeueData per message. It runs on one
+// thread: the high-level side writes a burst, then the real-time side drains it, so the
+// cycle counts only hold ring and doorbell work. Each DequeueBatch is followed by one
+// Intercore_ReleaseRead on its last block; DequeueData releases every block.
+//
+// Doorbells per message counts the "message received" writes to SW_TX_INT_PORT.
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sim_common.h"
+
+#define BATCH_MESSAGE_SIZE 16
+/// <summary>
+/// Messages the high-level side writes before the real-time side drains them, if they fit.
+/// </summary>
+#define BATCH_BURST 32
+
+typedef struct {
+    // 0 for DequeueData, otherwise the DequeueBatch budget.
+    uint32_t budget;
+    uint32_t messages;
+
+    uint32_t received;
+    uint32_t batches;
+    uint32_t errors;
+    uint64_t rtCycles;
+    uint32_t doorbells;
+} BatchRun;
+
+static void Drain(BatchRun *run)
+{
+    IntercoreBlock blocks[BATCH_BURST];
+    uint8_t message[MAX_MESSAGE_SIZE];
+
+    for (;;) {
+        uint64_t start = Cycles();
+        uint32_t count;
+        bool valid = true;
+
+        if (run->budget == 0) {
+            uint32_t size = sizeof(message);
+            if (DequeueData(outbound, inbound, bufSize, message, &size) != 0) {
+                return;
+            }
+            valid = Sim_CheckMessage(message, size, BATCH_MESSAGE_SIZE, run->received, NULL);
+            count = 1;
+        } else {
+            count = DequeueBatch(outbound, inbound, bufSize, blocks, run->budget);
+            if (count == 0) {
+                return;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t size = Intercore_BlockSize(&blocks[i]);
+                if (size > sizeof(message)) {
+                    valid = false;
+                    break;
+                }
+                Intercore_CopyFromBlock(&blocks[i], 0, message, size);
+                valid = valid && Sim_CheckMessage(message, size, BATCH_MESSAGE_SIZE,
+                                                  run->received + i, NULL);
+            }
+            Intercore_ReleaseRead(outbound, bufSize, &blocks[count - 1]);
+        }
+
+        run->rtCycles += Cycles() - start;
+        if (!valid && run->errors++ == 0) {
+            fprintf(stderr, "batch: message %" PRIu32 ": bad size, sequence or contents\n",
+                    run->received);
+        }
+        run->received += count;
+        run->batches++;
+    }
+}
+
+static int RunBudget(BatchRun *run)
+{
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t writePosition = 0;
+    uint32_t sequence = 0;
+
+    if (Sim_SetUpRings() != 0) {
+        return -1;
+    }
+
+    // Nothing drains the ring while a burst is written, so it must fit.
+    uint32_t burst = (bufSize - RINGBUFFER_ALIGNMENT) /
+                     Sim_RoundUp(sizeof(uint32_t) + BATCH_MESSAGE_SIZE);
+    if (burst > BATCH_BURST) {
+        burst = BATCH_BURST;
+    }
+
+    uint32_t doorbellsBefore = __atomic_load_n(&doorbellsReceived, __ATOMIC_RELAXED);
+    while (sequence < run->messages) {
+        for (uint32_t i = 0; i < burst && sequence < run->messages; i++, sequence++) {
+            Sim_FillMessage(message, BATCH_MESSAGE_SIZE, sequence);
+            Sim_HlSend(&writePosition, message, BATCH_MESSAGE_SIZE);
+        }
+        Drain(run);
+    }
+    run->doorbells = __atomic_load_n(&doorbellsReceived, __ATOMIC_RELAXED) - doorbellsBefore;
+
+    if (run->received != run->messages) {
+        run->errors++;
+    }
+
+    printf("%-12s %6" PRIu32 " %11.1f %13.3f %12.1f%s\n",
+           run->budget == 0 ? "DequeueData" : "DequeueBatch", run->budget == 0 ? 1 : run->budget,
+           run->received ? (double)run->rtCycles / run->received : 0,
+           run->received ? (double)run->doorbells / run->received : 0,
+           run->batches ? (double)run->received / run->batches : 0,
+           run->errors ? "  FAILED" : "");
+
+    return run->errors ? -1 : 0;
+}
+
+int BatchCase_Run(uint32_t messages)
+{
+    static const uint32_t budgets[] = {0, 1, 8, 32};
+    int failed = 0;
+
+    printf("batch: %" PRIu32 " messages of %d bytes in bursts of %d, real-time side cost in "
+           CYCLES_UNIT "\n",
+           messages, BATCH_MESSAGE_SIZE, BATCH_BURST);
+    printf("%-12s %6s %11s %13s %12s\n", "api", "budget", "cycles/msg", "doorbells/msg",
+           "blocks/batch");
+
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+        BatchRun run = {.budget = budgets[b], .messages = messages};
+        if (RunBudget(&run) != 0) {
+            failed = -1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,322 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host simulator and benchmark for the shared buffer protocol in mt3620-intercore.c.
+//
+// Two BufferHeader rings are mapped in shared memory below 4 GB, since the mailbox setup
+// commands carry 32-bit addresses, and handed to GetIntercoreBuffers through the simulated
+// mailbox. The real-time side runs the unmodified ring code, the high-level side follows the
+// same protocol directly on the rings, and every message is checked. The cases are:
+//
+//   ring       messages/s, MB/s of payload, p50/p99 latency from enqueue to dequeue, and
+//              ring occupancy, in each direction for several message sizes
+//   wake       receive latency when the real-time thread sleeps until the mailbox interrupt,
+//              against polling
+//   zerocopy   MB/s and real-time side cycles per message, building and checking messages
+//              in place in the shared buffer, against copying with EnqueueData/DequeueData
+//   batch      real-time side cycles and doorbells per message draining bursts with
+//              DequeueBatch at budgets 1, 8 and 32, against DequeueData
+//   setup      time until the sensor thread runs while the real-time side waits for the
+//              mailbox setup, spinning or sleeping
+//
+// Usage: intercore_sim [--quick] [--messages N] [--buffer-log2 N] [--case NAME]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_common.h"
+
+/// <summary>Blocks the real-time consumer takes per DequeueBatch.</summary>
+#define BATCH_SIZE 8
+
+typedef struct {
+    bool rtToHl;
+    uint32_t messageSize;
+    uint32_t messages;
+
+    // Filled in by the consumer, and the producer's waits for space.
+    uint64_t *latencyNs;
+    uint32_t received;
+    uint32_t errors;
+    uint64_t occupancySum;
+    uint32_t occupancySamples;
+    uint32_t occupancyMax;
+    uint32_t producerWaits;
+} SimCase;
+
+static const uint32_t messageSizes[] = {16, 64, 256, 1024};
+
+// Checks a message against the next expected sequence number and records its latency.
+static void CheckMessage(SimCase *simCase, const uint8_t *message, uint32_t size)
+{
+    uint64_t latencyNs = 0;
+
+    if (!Sim_CheckMessage(message, size, simCase->messageSize, simCase->received, &latencyNs)) {
+        if (simCase->errors++ == 0) {
+            fprintf(stderr, "message %" PRIu32 ": bad size, sequence or contents\n",
+                    simCase->received);
+        }
+    }
+
+    simCase->latencyNs[simCase->received++] = latencyNs;
+}
+
+static void RecordOccupancy(SimCase *simCase, uint32_t used)
+{
+    simCase->occupancySum += used;
+    simCase->occupancySamples++;
+    if (used > simCase->occupancyMax) {
+        simCase->occupancyMax = used;
+    }
+}
+
+// Real-time core sending: EnqueueData, waiting for the space interrupt when full.
+static void *RtProducer(void *arg)
+{
+    SimCase *simCase = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+
+    for (uint32_t sequence = 0; sequence < simCase->messages; sequence++) {
+        Sim_FillMessage(message, simCase->messageSize, sequence);
+        for (;;) {
+            Sim_StampMessage(message);
+            if (EnqueueData(inbound, outbound, bufSize, message, simCase->messageSize) == 0) {
+                break;
+            }
+            simCase->producerWaits++;
+            Event_Wait(&rtSpace);
+        }
+    }
+
+    return NULL;
+}
+
+// High-level side receiving: reads every complete block, then moves its read position and
+// raises the received interrupt once.
+static void *HlConsumer(void *arg)
+{
+    SimCase *simCase = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t readPosition = 0;
+
+    while (simCase->received < simCase->messages) {
+        uint32_t writePosition = __atomic_load_n(&outbound->writePosition, __ATOMIC_ACQUIRE);
+        if (writePosition == readPosition) {
+            Event_Wait(&hlReceive);
+            continue;
+        }
+
+        RecordOccupancy(simCase, Sim_Used(writePosition, readPosition));
+
+        while (readPosition != writePosition) {
+            uint32_t size = Sim_HlReceive(&readPosition, message);
+            if (size == UINT32_MAX) {
+                simCase->errors++;
+                return NULL;
+            }
+            CheckMessage(simCase, message, size);
+        }
+
+        Sim_HlRelease(readPosition);
+    }
+
+    return NULL;
+}
+
+// High-level side sending.
+static void *HlProducer(void *arg)
+{
+    SimCase *simCase = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t writePosition = 0;
+
+    for (uint32_t sequence = 0; sequence < simCase->messages; sequence++) {
+        Sim_FillMessage(message, simCase->messageSize, sequence);
+        simCase->producerWaits += Sim_HlSend(&writePosition, message, simCase->messageSize);
+    }
+
+    return NULL;
+}
+
+// Real-time core receiving: DequeueBatch, then one release for the whole batch, as the
+// ThreadX demo does.
+static void *RtConsumer(void *arg)
+{
+    SimCase *simCase = arg;
+    IntercoreBlock blocks[BATCH_SIZE];
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t count;
+
+    while (simCase->received < simCase->messages) {
+        uint32_t used = Sim_Used(__atomic_load_n(&inbound->writePosition, __ATOMIC_ACQUIRE),
+                                 outbound->readPosition);
+
+        count = DequeueBatch(outbound, inbound, bufSize, blocks, BATCH_SIZE);
+        if (count == 0) {
+            Event_Wait(&rtReceive);
+            continue;
+        }
+
+        RecordOccupancy(simCase, used);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t size = Intercore_BlockSize(&blocks[i]);
+            if (size > sizeof(message)) {
+                simCase->errors++;
+                return NULL;
+            }
+            Intercore_CopyFromBlock(&blocks[i], 0, message, size);
+            CheckMessage(simCase, message, size);
+        }
+        Intercore_ReleaseRead(outbound, bufSize, &blocks[count - 1]);
+    }
+
+    return NULL;
+}
+
+static int RunCase(SimCase *simCase)
+{
+    pthread_t producer, consumer;
+    IntercoreStats before, after;
+    double p50, p99;
+
+    if (Sim_SetUpRings() != 0) {
+        return -1;
+    }
+
+    simCase->latencyNs = calloc(simCase->messages, sizeof(uint64_t));
+    if (simCase->latencyNs == NULL) {
+        return -1;
+    }
+
+    Intercore_GetStats(&before);
+    uint64_t start = NowNs();
+    pthread_create(&consumer, NULL, simCase->rtToHl ? HlConsumer : RtConsumer, simCase);
+    pthread_create(&producer, NULL, simCase->rtToHl ? RtProducer : HlProducer, simCase);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    double seconds = (double)(NowNs() - start) / 1e9;
+    Intercore_GetStats(&after);
+
+    if (after.invalidPosition != before.invalidPosition) {
+        fprintf(stderr, "ring code saw %" PRIu32 " invalid positions\n",
+                after.invalidPosition - before.invalidPosition);
+        simCase->errors++;
+    }
+    if (simCase->received != simCase->messages) {
+        simCase->errors++;
+    }
+
+    uint32_t n = simCase->received;
+    Sim_Percentiles(simCase->latencyNs, n, &p50, &p99);
+    double meanOccupancy = simCase->occupancySamples
+                               ? (double)simCase->occupancySum / simCase->occupancySamples
+                               : 0;
+
+    printf("%-6s %5d %5" PRIu32 " %10.0f %8.2f %9.1f %9.1f %7.1f%% %7.1f%% %8" PRIu32 "%s\n",
+           simCase->rtToHl ? "rt>hl" : "hl>rt", RINGBUFFER_ALIGNMENT, simCase->messageSize,
+           n / seconds, (double)n * simCase->messageSize / seconds / 1e6, p50 / 1000,
+           p99 / 1000, 100.0 * meanOccupancy / bufSize, 100.0 * simCase->occupancyMax / bufSize,
+           simCase->producerWaits, simCase->errors ? "  FAILED" : "");
+
+    free(simCase->latencyNs);
+    return simCase->errors ? -1 : 0;
+}
+
+// Throughput and latency in both directions, for each message size.
+static int RingCase_Run(uint32_t messages)
+{
+    int failed = 0;
+
+    printf("buffer %u bytes, %" PRIu32 " messages per case, latency in us, occupancy of %u "
+           "data bytes\n",
+           1u << bufferLog2, messages, (1u << bufferLog2) - (unsigned)sizeof(BufferHeader));
+    printf("%-6s %5s %5s %10s %8s %9s %9s %8s %8s %8s\n", "dir", "align", "size", "msgs/s",
+           "MB/s", "p50", "p99", "occ", "occ max", "waits");
+
+    for (int direction = 0; direction < 2; direction++) {
+        for (size_t s = 0; s < sizeof(messageSizes) / sizeof(messageSizes[0]); s++) {
+            SimCase simCase = {.rtToHl = direction == 0,
+                               .messageSize = messageSizes[s],
+                               .messages = messages};
+
+            // A message must fit with its size word and the alignment slack.
+            if (sizeof(uint32_t) + messageSizes[s] + RINGBUFFER_ALIGNMENT >
+                (1u << bufferLog2) - sizeof(BufferHeader)) {
+                continue;
+            }
+
+            if (RunCase(&simCase) != 0) {
+                failed = -1;
+            }
+        }
+    }
+
+    return failed;
+}
+
+static const struct {
+    const char *name;
+    int (*run)(uint32_t messages);
+} cases[] = {
+    {"ring", RingCase_Run},
+    {"wake", WakeCase_Run},
+    {"zerocopy", ZeroCopyCase_Run},
+    {"batch", BatchCase_Run},
+    {"setup", SetupCase_Run},
+};
+
+int main(int argc, char **argv)
+{
+    uint32_t messages = 100000;
+    const char *only = NULL;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            messages = 2000;
+        } else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--buffer-log2") == 0 && i + 1 < argc) {
+            bufferLog2 = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--quick] [--messages N] [--buffer-log2 N] [--case NAME]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (bufferLog2 < 8 || bufferLog2 > 20) {
+        fprintf(stderr, "--buffer-log2 must be 8 to 20\n");
+        return 2;
+    }
+
+    if (Sim_Init() != 0) {
+        return 1;
+    }
+
+    bool found = false;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        if (only != NULL && strcmp(only, cases[c].name) != 0) {
+            continue;
+        }
+        if (found) {
+            printf("\n");
+        }
+        found = true;
+        if (cases[c].run(messages) != 0) {
+            failed = 1;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "unknown case %s\n", only);
+        return 2;
+    }
+
+    return failed;
+}
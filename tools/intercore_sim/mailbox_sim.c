@@ -0,0 +1,170 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mailbox_sim.h"
+#include "mt3620-baremetal.h"
+#include "mt3620.h"
+
+#define FIFO_DEPTH 16
+
+static pthread_mutex_t registerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t interruptLock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+    uint32_t command;
+    uint32_t data;
+} fifo[FIFO_DEPTH];
+static uint32_t fifoHead, fifoCount;
+static uint32_t swRxIntEnable, swRxIntStatus;
+
+static NVIC_IRQ_Handler swIrqHandler;
+static void (*peerHandler)(uint32_t bits);
+
+static void UnknownRegister(const char *access, uintptr_t baseAddr, size_t offset)
+{
+    fprintf(stderr, "mailbox_sim: %s of unsimulated register 0x%08lx\n", access,
+            (unsigned long)(baseAddr + offset));
+    abort();
+}
+
+void CM4_Install_NVIC(int irqn, int prior, int edgetr, NVIC_IRQ_Handler handler, int enable)
+{
+    (void)prior;
+    (void)edgetr;
+    (void)enable;
+
+    if (irqn != CM4_IRQ_A7N2M4_SW) {
+        fprintf(stderr, "mailbox_sim: interrupt %d is not simulated\n", irqn);
+        abort();
+    }
+    swIrqHandler = handler;
+}
+
+uint32_t ReadReg32(uintptr_t baseAddr, size_t offset)
+{
+    uint32_t value = 0;
+
+    if (baseAddr != MAILBOX_SIM_BASE) {
+        UnknownRegister("read", baseAddr, offset);
+    }
+
+    pthread_mutex_lock(&registerLock);
+    switch (offset) {
+    case 0x18:
+        value = swRxIntEnable;
+        break;
+    case 0x1C:
+        value = swRxIntStatus;
+        break;
+    case 0x50:
+        // CMD_POP0 pops the entry, DATA_POP0 is read first.
+        if (fifoCount > 0) {
+            value = fifo[fifoHead].command;
+            fifoHead = (fifoHead + 1) % FIFO_DEPTH;
+            fifoCount--;
+        }
+        break;
+    case 0x54:
+        if (fifoCount > 0) {
+            value = fifo[fifoHead].data;
+        }
+        break;
+    case 0x58:
+        value = fifoCount;
+        break;
+    default:
+        pthread_mutex_unlock(&registerLock);
+        UnknownRegister("read", baseAddr, offset);
+    }
+    pthread_mutex_unlock(&registerLock);
+
+    return value;
+}
+
+void WriteReg32(uintptr_t baseAddr, size_t offset, uint32_t value)
+{
+    void (*handler)(uint32_t) = NULL;
+
+    if (baseAddr != MAILBOX_SIM_BASE) {
+        UnknownRegister("write", baseAddr, offset);
+    }
+
+    pthread_mutex_lock(&registerLock);
+    switch (offset) {
+    case 0x14:
+        handler = peerHandler;
+        break;
+    case 0x18:
+        swRxIntEnable = value;
+        break;
+    case 0x1C:
+        swRxIntStatus &= ~value;
+        break;
+    default:
+        pthread_mutex_unlock(&registerLock);
+        UnknownRegister("write", baseAddr, offset);
+    }
+    pthread_mutex_unlock(&registerLock);
+
+    if (handler != NULL) {
+        handler(value);
+    }
+}
+
+void MailboxSim_Reset(void)
+{
+    pthread_mutex_lock(&registerLock);
+    fifoHead = 0;
+    fifoCount = 0;
+    swRxIntEnable = 0;
+    swRxIntStatus = 0;
+    pthread_mutex_unlock(&registerLock);
+}
+
+void MailboxSim_PushCommand(uint32_t command, uint32_t data)
+{
+    pthread_mutex_lock(&registerLock);
+    if (fifoCount == FIFO_DEPTH) {
+        pthread_mutex_unlock(&registerLock);
+        fprintf(stderr, "mailbox_sim: FIFO overflow\n");
+        abort();
+    }
+    fifo[(fifoHead + fifoCount) % FIFO_DEPTH].command = command;
+    fifo[(fifoHead + fifoCount) % FIFO_DEPTH].data = data;
+    fifoCount++;
+    pthread_mutex_unlock(&registerLock);
+}
+
+void MailboxSim_RaiseInterrupt(uint32_t bits)
+{
+    bool pending;
+
+    pthread_mutex_lock(&registerLock);
+    swRxIntStatus |= bits;
+    pthread_mutex_unlock(&registerLock);
+
+    // Level triggered: the handler runs again until it has cleared every enabled bit.
+    pthread_mutex_lock(&interruptLock);
+    do {
+        pthread_mutex_lock(&registerLock);
+        pending = (swRxIntStatus & swRxIntEnable) != 0 && swIrqHandler != NULL;
+        pthread_mutex_unlock(&registerLock);
+
+        if (pending) {
+            swIrqHandler();
+        }
+    } while (pending);
+    pthread_mutex_unlock(&interruptLock);
+}
+
+void MailboxSim_SetPeerHandler(void (*handler)(uint32_t bits))
+{
+    pthread_mutex_lock(&registerLock);
+    peerHandler = handler;
+    pthread_mutex_unlock(&registerLock);
+}
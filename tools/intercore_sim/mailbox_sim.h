@@ -0,0 +1,40 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Simulated MT3620 mailbox at 0x21050000, as seen by the real-time core. It backs ReadReg32
+// and WriteReg32 for mt3620-intercore.c:
+//
+//   0x14 SW_TX_INT_PORT   write, signals the high-level side (bit 0 sent, bit 1 received)
+//   0x18 SW_RX_INT_EN     read and write
+//   0x1C SW_RX_INT_STS    read, write 1 to clear
+//   0x50 CMD_POP0         read, pops the FIFO
+//   0x54 DATA_POP0        read
+//   0x58 FIFO_POP_CNT     read
+//
+// The high-level side is played by the simulator, which pushes the setup commands and raises
+// the software interrupts. The interrupt handler installed with CM4_Install_NVIC runs on the
+// raising thread, one invocation at a time, as it would preempt the real-time core.
+
+#ifndef MAILBOX_SIM_H
+#define MAILBOX_SIM_H
+
+#include <stdint.h>
+
+#define MAILBOX_SIM_BASE 0x21050000
+
+/// <summary>Empties the FIFO and clears the interrupt state, keeping the installed handler.</summary>
+void MailboxSim_Reset(void);
+
+/// <summary>Queues a command for the real-time core, as the high-level side does during setup.</summary>
+void MailboxSim_PushCommand(uint32_t command, uint32_t data);
+
+/// <summary>
+/// Raises SW_RX_INT bits on the real-time core, and runs its handler while any enabled bit
+/// is pending.
+/// </summary>
+void MailboxSim_RaiseInterrupt(uint32_t bits);
+
+/// <summary>Sets the function called with the bits the real-time core writes to SW_TX_INT_PORT.</summary>
+void MailboxSim_SetPeerHandler(void (*handler)(uint32_t bits));
+
+#endif // #ifndef MAILBOX_SIM_H
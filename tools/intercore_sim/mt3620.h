@@ -0,0 +1,21 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Host stand-in for the MT3620 BSP header, with only what mt3620-intercore.c uses. The
+// interrupt it installs is raised by the simulated mailbox, see mailbox_sim.h.
+
+#ifndef MT3620_H
+#define MT3620_H
+
+#define TRUE 1
+#define FALSE 0
+
+#define DEFAULT_PRI 5
+#define IRQ_LEVEL_TRIGGER 0x01
+#define CM4_IRQ_A7N2M4_SW 11
+
+typedef void (*NVIC_IRQ_Handler)(void);
+
+void CM4_Install_NVIC(int irqn, int prior, int edgetr, NVIC_IRQ_Handler handler, int enable);
+
+#endif // #ifndef MT3620_H
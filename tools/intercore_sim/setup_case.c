@@ -0,0 +1,167 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Setup case: how long the sensor thread waits to run while thread_inter_core waits for the
+// high-level side to set the mailbox up. The real-time core is modelled as one CPU that a
+// thread must hold to run: thread_inter_core holds it from the start, and only gives it up
+// in the wait callback or the back-off sleep, as tx_thread_sleep would. The sensor thread
+// records when it first gets the CPU. The high-level side pushes the setup commands after
+// SETUP_HL_DELAY_TICKS.
+//
+//   spin      GetIntercoreBuffers, which polls FIFO_POP_CNT without yielding
+//   sleep     GetIntercoreBuffersWait, sleeping one tick whenever the mailbox is empty
+//   bounded   the demo's loop: attempts of SETUP_WAITS ticks, backing off between them
+//
+// Ticks are 1 ms rather than ThreadX's 10 ms, so the case runs quickly.
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "mailbox_sim.h"
+#include "sim_common.h"
+
+#define SETUP_TICK_US 1000
+/// <summary>Same as INTER_CORE_SETUP_WAITS in the demo.</summary>
+#define SETUP_WAITS 100
+/// <summary>Same as INTER_CORE_SETUP_BACKOFF_MAX in the demo.</summary>
+#define SETUP_BACKOFF_MAX 1000
+/// <summary>Longer than one bounded attempt, so the retry path runs.</summary>
+#define SETUP_HL_DELAY_TICKS 250
+
+typedef enum { SETUP_SPIN, SETUP_SLEEP, SETUP_BOUNDED } SetupMode;
+
+typedef struct {
+    const char *name;
+    SetupMode mode;
+
+    uint64_t start;
+    uint64_t sensorNs;
+    uint64_t setupNs;
+    uint64_t releasedNs;
+    uint32_t attempts;
+    int result;
+} SetupRun;
+
+static pthread_mutex_t core = PTHREAD_MUTEX_INITIALIZER;
+static SimEvent coreTaken;
+static SetupRun *currentRun;
+
+// Gives the modelled CPU up for a number of ticks, as tx_thread_sleep does.
+static void SleepTicks(uint32_t ticks)
+{
+    uint64_t released = NowNs();
+
+    pthread_mutex_unlock(&core);
+    SleepUs(ticks * SETUP_TICK_US);
+    pthread_mutex_lock(&core);
+    currentRun->releasedNs += NowNs() - released;
+}
+
+static void SetupWait(void)
+{
+    SleepTicks(1);
+}
+
+static void *InterCoreThread(void *arg)
+{
+    SetupRun *run = arg;
+    uint32_t backoff = SETUP_WAITS;
+
+    pthread_mutex_lock(&core);
+    run->start = NowNs();
+    Event_Signal(&coreTaken);
+
+    switch (run->mode) {
+    case SETUP_SPIN:
+        run->attempts = 1;
+        run->result = GetIntercoreBuffers(&outbound, &inbound, &bufSize);
+        break;
+    case SETUP_SLEEP:
+        run->attempts = 1;
+        run->result = GetIntercoreBuffersWait(&outbound, &inbound, &bufSize, SetupWait, 0);
+        break;
+    case SETUP_BOUNDED:
+        for (;;) {
+            run->attempts++;
+            run->result =
+                GetIntercoreBuffersWait(&outbound, &inbound, &bufSize, SetupWait, SETUP_WAITS);
+            if (run->result == 0) {
+                break;
+            }
+            SleepTicks(backoff);
+            backoff = backoff * 2 > SETUP_BACKOFF_MAX ? SETUP_BACKOFF_MAX : backoff * 2;
+        }
+        break;
+    }
+
+    run->setupNs = NowNs() - run->start;
+    pthread_mutex_unlock(&core);
+    return NULL;
+}
+
+static void *SensorThread(void *arg)
+{
+    SetupRun *run = arg;
+
+    pthread_mutex_lock(&core);
+    run->sensorNs = NowNs() - run->start;
+    pthread_mutex_unlock(&core);
+    return NULL;
+}
+
+static int RunMode(SetupRun *run)
+{
+    pthread_t interCore, sensor;
+
+    MailboxSim_Reset();
+    currentRun = run;
+
+    pthread_create(&interCore, NULL, InterCoreThread, run);
+    while (!Event_Wait(&coreTaken)) {
+    }
+    pthread_create(&sensor, NULL, SensorThread, run);
+
+    SleepUs(SETUP_HL_DELAY_TICKS * SETUP_TICK_US);
+    Sim_PushSetup();
+
+    pthread_join(interCore, NULL);
+    pthread_join(sensor, NULL);
+
+    bool failed = run->result != 0 || bufSize != (1u << bufferLog2) - sizeof(BufferHeader);
+    // Once setup yields, the sensor thread must get to run long before the mailbox is set up.
+    if (run->mode != SETUP_SPIN && run->sensorNs >= run->setupNs) {
+        failed = true;
+    }
+
+    uint64_t held = run->setupNs - run->releasedNs;
+    printf("%-8s %10.2f %10.1f %9" PRIu32 " %9.1f%%%s\n", run->name, run->sensorNs / 1e6,
+           run->setupNs / 1e6, run->attempts, 100.0 * held / run->setupNs,
+           failed ? "  FAILED" : "");
+
+    return failed ? -1 : 0;
+}
+
+int SetupCase_Run(uint32_t messages)
+{
+    SetupRun runs[] = {
+        {.name = "spin", .mode = SETUP_SPIN},
+        {.name = "sleep", .mode = SETUP_SLEEP},
+        {.name = "bounded", .mode = SETUP_BOUNDED},
+    };
+    int failed = 0;
+
+    (void)messages;
+    Event_Init(&coreTaken);
+
+    printf("setup: mailbox set up after %d ticks of %d us, times in ms from thread start\n",
+           SETUP_HL_DELAY_TICKS, SETUP_TICK_US);
+    printf("%-8s %10s %10s %9s %10s\n", "mode", "sensor", "setup", "attempts", "cpu held");
+
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        if (RunMode(&runs[r]) != 0) {
+            failed = -1;
+        }
+    }
+
+    return failed;
+}
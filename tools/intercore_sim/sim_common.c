@@ -0,0 +1,306 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "mailbox_sim.h"
+#include "sim_common.h"
+
+uint32_t bufferLog2 = 12;
+BufferHeader *outbound, *inbound;
+uint32_t bufSize;
+
+SimEvent rtReceive, rtSpace, hlReceive, hlSpace;
+uint32_t doorbellsSent, doorbellsReceived;
+
+static uint8_t *sharedMemory;
+
+uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+uint32_t NowUs(void)
+{
+    return (uint32_t)(NowNs() / 1000);
+}
+
+uint64_t Cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return NowNs();
+#endif
+}
+
+void SleepUs(uint32_t us)
+{
+    struct timespec delay = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+    nanosleep(&delay, NULL);
+}
+
+void Event_Init(SimEvent *event)
+{
+    pthread_mutex_init(&event->lock, NULL);
+    pthread_cond_init(&event->cond, NULL);
+    event->count = 0;
+}
+
+void Event_Signal(SimEvent *event)
+{
+    pthread_mutex_lock(&event->lock);
+    event->count++;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->lock);
+}
+
+bool Event_Wait(SimEvent *event)
+{
+    struct timespec deadline;
+    bool signalled;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += WAIT_TIMEOUT_US * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&event->lock);
+    while (event->count == 0) {
+        if (pthread_cond_timedwait(&event->cond, &event->lock, &deadline) != 0) {
+            break;
+        }
+    }
+    signalled = event->count != 0;
+    event->count = 0;
+    pthread_mutex_unlock(&event->lock);
+
+    return signalled;
+}
+
+static void RtReceiveHandler(void)
+{
+    Event_Signal(&rtReceive);
+}
+
+static void RtSpaceHandler(void)
+{
+    Event_Signal(&rtSpace);
+}
+
+static void PeerHandler(uint32_t bits)
+{
+    if (bits & SW_INT_MSG_SENT) {
+        __atomic_add_fetch(&doorbellsSent, 1, __ATOMIC_RELAXED);
+        Event_Signal(&hlReceive);
+    }
+    if (bits & SW_INT_MSG_RECEIVED) {
+        __atomic_add_fetch(&doorbellsReceived, 1, __ATOMIC_RELAXED);
+        Event_Signal(&hlSpace);
+    }
+}
+
+int Sim_Init(void)
+{
+    size_t ringSize = (size_t)1 << bufferLog2;
+    void *hint = (void *)SHARED_BASE_HINT;
+
+    Event_Init(&rtReceive);
+    Event_Init(&rtSpace);
+    Event_Init(&hlReceive);
+    Event_Init(&hlSpace);
+    MailboxSim_SetPeerHandler(PeerHandler);
+    Intercore_SetClock(NowUs);
+
+    sharedMemory = mmap(hint, 2 * ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                        -1, 0);
+    if (sharedMemory == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if ((uintptr_t)sharedMemory + 2 * ringSize > UINT32_MAX) {
+        fprintf(stderr, "shared memory mapped above 4 GB at %p\n", (void *)sharedMemory);
+        return -1;
+    }
+
+    return 0;
+}
+
+void Sim_PushSetup(void)
+{
+    size_t ringSize = (size_t)1 << bufferLog2;
+    uint32_t outboundBase = (uint32_t)(uintptr_t)sharedMemory;
+    uint32_t inboundBase = (uint32_t)(uintptr_t)(sharedMemory + ringSize);
+
+    memset(sharedMemory, 0, 2 * ringSize);
+    MailboxSim_PushCommand(0xba5e0001, outboundBase | bufferLog2);
+    MailboxSim_PushCommand(0xba5e0002, inboundBase | bufferLog2);
+    MailboxSim_PushCommand(0xba5e0003, 0);
+}
+
+int Sim_SetUpRings(void)
+{
+    MailboxSim_Reset();
+    Sim_PushSetup();
+
+    if (GetIntercoreBuffers(&outbound, &inbound, &bufSize) != 0) {
+        fprintf(stderr, "GetIntercoreBuffers failed\n");
+        return -1;
+    }
+
+    SetIntercoreReceiveHandler(RtReceiveHandler);
+    SetIntercoreSpaceHandler(RtSpaceHandler);
+    return 0;
+}
+
+uint8_t *Sim_DataArea(BufferHeader *header)
+{
+    return (uint8_t *)(header + 1);
+}
+
+uint32_t Sim_RoundUp(uint32_t value)
+{
+    return (value + (RINGBUFFER_ALIGNMENT - 1)) & ~(uint32_t)(RINGBUFFER_ALIGNMENT - 1);
+}
+
+uint32_t Sim_Used(uint32_t writePosition, uint32_t readPosition)
+{
+    return writePosition >= readPosition ? writePosition - readPosition
+                                         : writePosition - readPosition + bufSize;
+}
+
+void Sim_FillMessage(uint8_t *message, uint32_t size, uint32_t sequence)
+{
+    memcpy(message, &sequence, sizeof(sequence));
+    for (uint32_t i = MESSAGE_HEADER_SIZE; i < size; i++) {
+        message[i] = (uint8_t)(sequence * 31 + i);
+    }
+}
+
+void Sim_StampMessage(uint8_t *message)
+{
+    uint64_t now = NowNs();
+    memcpy(message + 4, &now, sizeof(now));
+}
+
+bool Sim_CheckMessage(const uint8_t *message, uint32_t size, uint32_t expectedSize,
+                      uint32_t sequence, uint64_t *latencyNs)
+{
+    uint32_t actualSequence;
+    uint64_t sent;
+    uint8_t mismatch = 0;
+
+    if (size != expectedSize || size < MESSAGE_HEADER_SIZE) {
+        return false;
+    }
+
+    memcpy(&actualSequence, message, sizeof(actualSequence));
+    memcpy(&sent, message + 4, sizeof(sent));
+    if (latencyNs != NULL) {
+        *latencyNs = NowNs() - sent;
+    }
+
+    // No early exit, so the loop vectorizes like the in-place checks it is compared with.
+    for (uint32_t i = MESSAGE_HEADER_SIZE; i < size; i++) {
+        mismatch |= (uint8_t)(message[i] ^ (uint8_t)(sequence * 31 + i));
+    }
+
+    return actualSequence == sequence && mismatch == 0;
+}
+
+uint32_t Sim_HlSend(uint32_t *writePosition, uint8_t *message, uint32_t size)
+{
+    uint8_t *data = Sim_DataArea(inbound);
+    uint32_t position = *writePosition;
+    uint32_t waits = 0;
+
+    for (;;) {
+        uint32_t readPosition = __atomic_load_n(&outbound->readPosition, __ATOMIC_ACQUIRE);
+        uint32_t avail = readPosition <= position ? readPosition - position + bufSize
+                                                  : readPosition - position;
+        if (avail >= sizeof(uint32_t) + size + RINGBUFFER_ALIGNMENT) {
+            break;
+        }
+        waits++;
+        Event_Wait(&hlSpace);
+    }
+
+    Sim_StampMessage(message);
+    memcpy(data + position, &size, sizeof(size));
+    uint32_t start = position + sizeof(uint32_t);
+    uint32_t toEnd = bufSize - start < size ? bufSize - start : size;
+    memcpy(data + start, message, toEnd);
+    memcpy(data, message + toEnd, size - toEnd);
+
+    position = Sim_RoundUp(position + sizeof(uint32_t) + size);
+    if (position >= bufSize) {
+        position -= bufSize;
+    }
+    *writePosition = position;
+
+    __atomic_store_n(&inbound->writePosition, position, __ATOMIC_RELEASE);
+    MailboxSim_RaiseInterrupt(SW_INT_MSG_SENT);
+    return waits;
+}
+
+uint32_t Sim_HlReceive(uint32_t *readPosition, uint8_t *message)
+{
+    uint8_t *data = Sim_DataArea(outbound);
+    uint32_t position = *readPosition;
+    uint32_t size;
+
+    if (__atomic_load_n(&outbound->writePosition, __ATOMIC_ACQUIRE) == position) {
+        return 0;
+    }
+
+    memcpy(&size, data + position, sizeof(size));
+    if (size > MAX_MESSAGE_SIZE) {
+        fprintf(stderr, "block of %" PRIu32 " bytes at %" PRIu32 "\n", size, position);
+        return UINT32_MAX;
+    }
+
+    uint32_t start = position + sizeof(uint32_t);
+    uint32_t toEnd = bufSize - start < size ? bufSize - start : size;
+    memcpy(message, data + start, toEnd);
+    memcpy(message + toEnd, data, size - toEnd);
+
+    position = Sim_RoundUp(position + sizeof(uint32_t) + size);
+    if (position >= bufSize) {
+        position -= bufSize;
+    }
+    *readPosition = position;
+    return size;
+}
+
+void Sim_HlRelease(uint32_t readPosition)
+{
+    __atomic_store_n(&inbound->readPosition, readPosition, __ATOMIC_RELEASE);
+    MailboxSim_RaiseInterrupt(SW_INT_MSG_RECEIVED);
+}
+
+static int CompareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void Sim_Percentiles(uint64_t *values, uint32_t count, double *p50, double *p99)
+{
+    qsort(values, count, sizeof(uint64_t), CompareU64);
+    *p50 = count ? (double)values[count / 2] : 0;
+    *p99 = count ? (double)values[(uint64_t)count * 99 / 100] : 0;
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Shared state and helpers for the intercore_sim cases: the rings as the real-time core sees
+// them, the wake-up events behind the simulated interrupts, the high-level side of the ring
+// protocol, and numbered, timestamped test messages.
+
+#ifndef SIM_COMMON_H
+#define SIM_COMMON_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mt3620-intercore.h"
+
+/// <summary>Raised on the real-time core when the high-level side has written a message.</summary>
+#define SW_INT_MSG_SENT (1U << 0)
+/// <summary>Raised on the real-time core when the high-level side has read a message.</summary>
+#define SW_INT_MSG_RECEIVED (1U << 1)
+
+/// <summary>Where the rings are mapped, if the address is free.</summary>
+#define SHARED_BASE_HINT 0x30000000UL
+/// <summary>Longest wait for a wake-up, so a missed one only costs time.</summary>
+#define WAIT_TIMEOUT_US 1000
+/// <summary>Sequence number, then enqueue time in nanoseconds.</summary>
+#define MESSAGE_HEADER_SIZE 12
+/// <summary>Largest message any case sends.</summary>
+#define MAX_MESSAGE_SIZE 1024
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+} SimEvent;
+
+extern uint32_t bufferLog2;
+extern BufferHeader *outbound, *inbound;    // as the real-time core sees them
+extern uint32_t bufSize;
+
+// Real-time side wake-ups, from the simulated interrupt, and high-level side wake-ups, from
+// the real-time core writing SW_TX_INT_PORT.
+extern SimEvent rtReceive, rtSpace, hlReceive, hlSpace;
+
+/// <summary>Number of times the real-time core has written each SW_TX_INT_PORT bit.</summary>
+extern uint32_t doorbellsSent, doorbellsReceived;
+
+uint64_t NowNs(void);
+uint32_t NowUs(void);
+
+/// <summary>Time stamp counter where the host has one, otherwise nanoseconds.</summary>
+uint64_t Cycles(void);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CYCLES_UNIT "TSC cycles"
+#else
+#define CYCLES_UNIT "ns"
+#endif
+
+void SleepUs(uint32_t us);
+
+void Event_Init(SimEvent *event);
+void Event_Signal(SimEvent *event);
+
+/// <summary>
+/// Waits until signalled or WAIT_TIMEOUT_US has passed, and consumes the signals.
+/// </summary>
+/// <returns>true if the event was signalled.</returns>
+bool Event_Wait(SimEvent *event);
+
+/// <summary>Initializes the events and the mailbox, and maps the shared memory.</summary>
+int Sim_Init(void);
+
+/// <summary>Clears both rings and pushes the setup commands, as the high-level side does.</summary>
+void Sim_PushSetup(void);
+
+/// <summary>
+/// Sets up both rings through GetIntercoreBuffers and installs handlers which signal
+/// rtReceive and rtSpace.
+/// </summary>
+int Sim_SetUpRings(void);
+
+uint8_t *Sim_DataArea(BufferHeader *header);
+uint32_t Sim_RoundUp(uint32_t value);
+
+/// <summary>Bytes between two positions of a ring.</summary>
+uint32_t Sim_Used(uint32_t writePosition, uint32_t readPosition);
+
+void Sim_FillMessage(uint8_t *message, uint32_t size, uint32_t sequence);
+void Sim_StampMessage(uint8_t *message);
+
+/// <summary>Checks a message's size, sequence number and contents.</summary>
+/// <param name="latencyNs">If not NULL, receives the time since the message was stamped.</param>
+bool Sim_CheckMessage(const uint8_t *message, uint32_t size, uint32_t expectedSize,
+                      uint32_t sequence, uint64_t *latencyNs);
+
+/// <summary>
+/// Writes a block to the inbound ring as the high-level side does, waiting on hlSpace while
+/// it does not fit with the same slack the ring code keeps, then raises the sent interrupt.
+/// The message is stamped just before it is written.
+/// </summary>
+/// <param name="writePosition">The high-level side's write position, updated.</param>
+/// <returns>Number of waits for space.</returns>
+uint32_t Sim_HlSend(uint32_t *writePosition, uint8_t *message, uint32_t size);
+
+/// <summary>
+/// Copies the next block out of the outbound ring, without publishing the read position.
+/// </summary>
+/// <param name="readPosition">The high-level side's read position, advanced past the block.
+/// </param>
+/// <returns>Block size, 0 if the ring is empty, or UINT32_MAX if the block is too large.</returns>
+uint32_t Sim_HlReceive(uint32_t *readPosition, uint8_t *message);
+
+/// <summary>
+/// Publishes the high-level side's read position and raises the received interrupt.
+/// </summary>
+void Sim_HlRelease(uint32_t readPosition);
+
+/// <summary>Sorts values and gets the median and 99th percentile.</summary>
+void Sim_Percentiles(uint64_t *values, uint32_t count, double *p50, double *p99);
+
+// Cases other than ring throughput, each returning 0 if every check passed.
+
+/// <summary>Receive latency with the mailbox interrupt, against polling.</summary>
+int WakeCase_Run(uint32_t messages);
+
+/// <summary>
+/// Zero-copy reserve/commit and peek/release, against EnqueueData and DequeueData.
+/// </summary>
+int ZeroCopyCase_Run(uint32_t messages);
+
+/// <summary>Per-message cost of DequeueBatch at several budgets, against DequeueData.</summary>
+int BatchCase_Run(uint32_t messages);
+
+/// <summary>Time until another thread runs while the real-time side waits for setup.</summary>
+int SetupCase_Run(uint32_t messages);
+
+#endif // #ifndef SIM_COMMON_H
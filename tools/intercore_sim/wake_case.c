@@ -0,0 +1,157 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Wake case: how long a message waits in the inbound ring before the real-time thread picks
+// it up. The high-level side sends one message at a time after a random gap, and the
+// real-time thread either sleeps until the handler installed with SetIntercoreReceiveHandler
+// signals it, as thread_inter_core does, or polls DequeueData with a sleep in between, as it
+// did before. The demo polled every 25 ThreadX ticks (250 ms); the polling rows use shorter
+// intervals so the case runs quickly, and their latency scales with the interval.
+//
+// Latency is from the high-level side writing the block to DequeueData returning it. Wakes
+// per message counts every time the real-time thread resumes, with or without data.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_common.h"
+
+#define WAKE_MESSAGE_SIZE 16
+/// <summary>Upper limit on messages per mode, since every message is paced by a sleep.</summary>
+#define WAKE_MESSAGES_MAX 1000
+/// <summary>Longest gap between messages, the same in every mode.</summary>
+#define WAKE_GAP_US 10000
+/// <summary>Longest time the sender waits for a message to be picked up.</summary>
+#define WAKE_DELIVERY_TIMEOUT_US 2000000
+
+typedef struct {
+    const char *name;
+    // 0 to sleep until the receive interrupt, otherwise the polling interval.
+    uint32_t pollUs;
+    uint32_t messages;
+
+    uint64_t *latencyNs;
+    uint32_t received;
+    uint32_t wakes;
+    uint32_t errors;
+    bool stop;
+} WakeRun;
+
+static void *RtReceiver(void *arg)
+{
+    WakeRun *run = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+
+    while (!__atomic_load_n(&run->stop, __ATOMIC_ACQUIRE)) {
+        uint32_t size = sizeof(message);
+        if (DequeueData(outbound, inbound, bufSize, message, &size) == 0) {
+            uint32_t sequence = run->received;
+            if (!Sim_CheckMessage(message, size, WAKE_MESSAGE_SIZE, sequence,
+                                  &run->latencyNs[sequence])) {
+                run->errors++;
+            }
+            __atomic_store_n(&run->received, sequence + 1, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        if (run->pollUs != 0) {
+            SleepUs(run->pollUs);
+            run->wakes++;
+        } else if (Event_Wait(&rtReceive)) {
+            // A timed-out wait only guards the simulator against a lost wake-up; the ThreadX
+            // thread waits forever, so it is not counted.
+            run->wakes++;
+        }
+    }
+
+    return NULL;
+}
+
+static int RunMode(WakeRun *run)
+{
+    pthread_t receiver;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t writePosition = 0;
+    unsigned int seed = 1;
+    double p50, p99;
+
+    if (Sim_SetUpRings() != 0) {
+        return -1;
+    }
+    if (run->pollUs != 0) {
+        SetIntercoreReceiveHandler(NULL);
+    }
+
+    run->latencyNs = calloc(run->messages, sizeof(uint64_t));
+    if (run->latencyNs == NULL) {
+        return -1;
+    }
+
+    pthread_create(&receiver, NULL, RtReceiver, run);
+    for (uint32_t sequence = 0; sequence < run->messages; sequence++) {
+        // A random gap, so that messages land at every point of the polling interval.
+        SleepUs((uint32_t)rand_r(&seed) % WAKE_GAP_US);
+
+        Sim_FillMessage(message, WAKE_MESSAGE_SIZE, sequence);
+        Sim_HlSend(&writePosition, message, WAKE_MESSAGE_SIZE);
+
+        uint64_t deadline = NowNs() + (uint64_t)WAKE_DELIVERY_TIMEOUT_US * 1000;
+        while (__atomic_load_n(&run->received, __ATOMIC_ACQUIRE) <= sequence) {
+            if (NowNs() > deadline) {
+                fprintf(stderr, "wake: message %" PRIu32 " was not picked up\n", sequence);
+                run->errors++;
+                break;
+            }
+            SleepUs(50);
+        }
+        if (run->errors != 0) {
+            break;
+        }
+    }
+    __atomic_store_n(&run->stop, true, __ATOMIC_RELEASE);
+    pthread_join(receiver, NULL);
+
+    if (run->received != run->messages) {
+        run->errors++;
+    }
+
+    Sim_Percentiles(run->latencyNs, run->received, &p50, &p99);
+    printf("%-10s %6" PRIu32 " %9.1f %9.1f %9.2f%s\n", run->name, run->received, p50 / 1000,
+           p99 / 1000, run->received ? (double)run->wakes / run->received : 0,
+           run->errors ? "  FAILED" : "");
+
+    free(run->latencyNs);
+    return run->errors ? -1 : 0;
+}
+
+int WakeCase_Run(uint32_t messages)
+{
+    WakeRun runs[] = {
+        {.name = "irq", .pollUs = 0},
+        {.name = "poll 1ms", .pollUs = 1000},
+        {.name = "poll 10ms", .pollUs = 10000},
+    };
+    int failed = 0;
+
+    messages /= 10;
+    if (messages > WAKE_MESSAGES_MAX) {
+        messages = WAKE_MESSAGES_MAX;
+    } else if (messages == 0) {
+        messages = 1;
+    }
+
+    printf("wake: %" PRIu32 " messages of %d bytes per mode, latency in us from write to "
+           "DequeueData\n",
+           messages, WAKE_MESSAGE_SIZE);
+    printf("%-10s %6s %9s %9s %9s\n", "mode", "msgs", "p50", "p99", "wakes/msg");
+
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        runs[r].messages = messages;
+        if (RunMode(&runs[r]) != 0) {
+            failed = -1;
+        }
+    }
+
+    return failed;
+}
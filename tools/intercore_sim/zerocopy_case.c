@@ -0,0 +1,269 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Zero-copy case: the real-time side builds or checks each message either in a local buffer,
+// copied by EnqueueData or DequeueData, or in place in the shared buffer, through
+// Intercore_ReserveWrite/Intercore_CommitWrite or Intercore_PeekRead/Intercore_ReleaseRead.
+// Both variants write or read every byte of the message once, so the difference is the copy.
+//
+// MB/s is payload over the whole run. Cycles per message is the median cost of the real-time
+// side's calls, from reserving or peeking to committing or releasing, without its waits for
+// space or data; the median leaves out messages during which the host preempted the thread.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_common.h"
+
+typedef struct {
+    bool rtToHl;
+    bool zeroCopy;
+    uint32_t messageSize;
+    uint32_t messages;
+
+    uint32_t received;
+    uint32_t errors;
+    // Real-time side cost of each message.
+    uint64_t *rtCycles;
+} ZeroCopyRun;
+
+static const uint32_t zeroCopySizes[] = {64, 256, 1024};
+
+// Writes a test message straight into a reserved block, across both segments. The segment
+// pointers are copied to locals, since byte stores through them could otherwise alias the
+// block and stop the loops from being vectorized.
+static void FillBlock(const IntercoreBlock *block, uint32_t size, uint32_t sequence)
+{
+    uint8_t header[MESSAGE_HEADER_SIZE];
+    uint8_t *seg0 = block->seg0, *seg1 = block->seg1;
+    uint32_t seg0Size = block->seg0Size < size ? block->seg0Size : size;
+    uint8_t base = (uint8_t)(sequence * 31);
+
+    Sim_FillMessage(header, MESSAGE_HEADER_SIZE, sequence);
+    Sim_StampMessage(header);
+    Intercore_CopyToBlock(block, 0, header, MESSAGE_HEADER_SIZE);
+
+    for (uint32_t i = MESSAGE_HEADER_SIZE; i < seg0Size; i++) {
+        seg0[i] = (uint8_t)(base + i);
+    }
+    for (uint32_t i = seg0Size > MESSAGE_HEADER_SIZE ? seg0Size : MESSAGE_HEADER_SIZE; i < size;
+         i++) {
+        seg1[i - seg0Size] = (uint8_t)(base + i);
+    }
+}
+
+// Checks a test message in place, across both segments.
+static bool CheckBlock(const IntercoreBlock *block, uint32_t expectedSize, uint32_t sequence)
+{
+    uint8_t header[MESSAGE_HEADER_SIZE];
+    const uint8_t *seg0 = block->seg0, *seg1 = block->seg1;
+    uint32_t seg0Size = block->seg0Size;
+    uint32_t size = Intercore_BlockSize(block);
+    uint8_t base = (uint8_t)(sequence * 31);
+    uint8_t mismatch = 0;
+    uint32_t actualSequence;
+
+    if (size != expectedSize || size < MESSAGE_HEADER_SIZE) {
+        return false;
+    }
+
+    Intercore_CopyFromBlock(block, 0, header, MESSAGE_HEADER_SIZE);
+    memcpy(&actualSequence, header, sizeof(actualSequence));
+    if (actualSequence != sequence) {
+        return false;
+    }
+
+    for (uint32_t i = MESSAGE_HEADER_SIZE; i < seg0Size; i++) {
+        mismatch |= (uint8_t)(seg0[i] ^ (uint8_t)(base + i));
+    }
+    for (uint32_t i = seg0Size > MESSAGE_HEADER_SIZE ? seg0Size : MESSAGE_HEADER_SIZE; i < size;
+         i++) {
+        mismatch |= (uint8_t)(seg1[i - seg0Size] ^ (uint8_t)(base + i));
+    }
+
+    return mismatch == 0;
+}
+
+static void *RtProducer(void *arg)
+{
+    ZeroCopyRun *run = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    IntercoreBlock block;
+    uint32_t size = run->messageSize;
+
+    for (uint32_t sequence = 0; sequence < run->messages; sequence++) {
+        for (;;) {
+            uint64_t start = Cycles();
+            if (run->zeroCopy) {
+                if (Intercore_ReserveWrite(inbound, outbound, bufSize, size, &block) == 0) {
+                    FillBlock(&block, size, sequence);
+                    Intercore_CommitWrite(outbound, bufSize, &block, size);
+                    run->rtCycles[sequence] = Cycles() - start;
+                    break;
+                }
+            } else {
+                Sim_FillMessage(message, size, sequence);
+                Sim_StampMessage(message);
+                if (EnqueueData(inbound, outbound, bufSize, message, size) == 0) {
+                    run->rtCycles[sequence] = Cycles() - start;
+                    break;
+                }
+            }
+            Event_Wait(&rtSpace);
+        }
+    }
+
+    return NULL;
+}
+
+static void *HlConsumer(void *arg)
+{
+    ZeroCopyRun *run = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t readPosition = 0;
+
+    while (run->received < run->messages) {
+        uint32_t size = Sim_HlReceive(&readPosition, message);
+        if (size == 0) {
+            Event_Wait(&hlReceive);
+            continue;
+        }
+        if (size == UINT32_MAX) {
+            run->errors++;
+            return NULL;
+        }
+        if (!Sim_CheckMessage(message, size, run->messageSize, run->received, NULL)) {
+            run->errors++;
+        }
+        run->received++;
+
+        // Release once the ring is drained, as the high-level application does per event.
+        if (__atomic_load_n(&outbound->writePosition, __ATOMIC_ACQUIRE) == readPosition) {
+            Sim_HlRelease(readPosition);
+        }
+    }
+
+    return NULL;
+}
+
+static void *HlProducer(void *arg)
+{
+    ZeroCopyRun *run = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint32_t writePosition = 0;
+
+    for (uint32_t sequence = 0; sequence < run->messages; sequence++) {
+        Sim_FillMessage(message, run->messageSize, sequence);
+        Sim_HlSend(&writePosition, message, run->messageSize);
+    }
+
+    return NULL;
+}
+
+static void *RtConsumer(void *arg)
+{
+    ZeroCopyRun *run = arg;
+    uint8_t message[MAX_MESSAGE_SIZE];
+    IntercoreBlock block;
+
+    while (run->received < run->messages) {
+        uint64_t start = Cycles();
+        bool valid;
+
+        if (run->zeroCopy) {
+            if (Intercore_PeekRead(outbound, inbound, bufSize, &block) != 0) {
+                Event_Wait(&rtReceive);
+                continue;
+            }
+            valid = CheckBlock(&block, run->messageSize, run->received);
+            Intercore_ReleaseRead(outbound, bufSize, &block);
+        } else {
+            uint32_t size = sizeof(message);
+            if (DequeueData(outbound, inbound, bufSize, message, &size) != 0) {
+                Event_Wait(&rtReceive);
+                continue;
+            }
+            valid = Sim_CheckMessage(message, size, run->messageSize, run->received, NULL);
+        }
+
+        run->rtCycles[run->received] = Cycles() - start;
+        if (!valid && run->errors++ == 0) {
+            fprintf(stderr, "zerocopy: message %" PRIu32 ": bad size, sequence or contents\n",
+                    run->received);
+        }
+        run->received++;
+    }
+
+    return NULL;
+}
+
+static int RunVariant(ZeroCopyRun *run)
+{
+    pthread_t producer, consumer;
+    IntercoreStats before, after;
+    double p50, p99;
+
+    if (Sim_SetUpRings() != 0) {
+        return -1;
+    }
+
+    run->rtCycles = calloc(run->messages, sizeof(uint64_t));
+    if (run->rtCycles == NULL) {
+        return -1;
+    }
+
+    Intercore_GetStats(&before);
+    uint64_t start = NowNs();
+    pthread_create(&consumer, NULL, run->rtToHl ? HlConsumer : RtConsumer, run);
+    pthread_create(&producer, NULL, run->rtToHl ? RtProducer : HlProducer, run);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    double seconds = (double)(NowNs() - start) / 1e9;
+    Intercore_GetStats(&after);
+
+    if (after.invalidPosition != before.invalidPosition || run->received != run->messages) {
+        run->errors++;
+    }
+
+    Sim_Percentiles(run->rtCycles, run->messages, &p50, &p99);
+    printf("%-6s %-5s %5" PRIu32 " %9.2f %11.0f%s\n", run->rtToHl ? "rt>hl" : "hl>rt",
+           run->zeroCopy ? "zero" : "copy", run->messageSize,
+           (double)run->received * run->messageSize / seconds / 1e6,
+           p50, run->errors ? "  FAILED" : "");
+
+    free(run->rtCycles);
+    return run->errors ? -1 : 0;
+}
+
+int ZeroCopyCase_Run(uint32_t messages)
+{
+    int failed = 0;
+
+    printf("zerocopy: %" PRIu32 " messages per variant, real-time side cost in " CYCLES_UNIT
+           "\n",
+           messages);
+    printf("%-6s %-5s %5s %9s %11s\n", "dir", "api", "size", "MB/s", "cycles/msg");
+
+    for (int direction = 0; direction < 2; direction++) {
+        for (size_t s = 0; s < sizeof(zeroCopySizes) / sizeof(zeroCopySizes[0]); s++) {
+            if (sizeof(uint32_t) + zeroCopySizes[s] + RINGBUFFER_ALIGNMENT >
+                (1u << bufferLog2) - sizeof(BufferHeader)) {
+                continue;
+            }
+
+            for (int zeroCopy = 0; zeroCopy < 2; zeroCopy++) {
+                ZeroCopyRun run = {.rtToHl = direction == 0,
+                                   .zeroCopy = zeroCopy != 0,
+                                   .messageSize = zeroCopySizes[s],
+                                   .messages = messages};
+                if (RunVariant(&run) != 0) {
+                    failed = -1;
+                }
+            }
+        }
+    }
+
+    return failed;
+}